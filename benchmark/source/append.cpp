@@ -0,0 +1,58 @@
+#include "benchmarks.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fmt/format.h>
+#include <numeric>
+#include <pinedb/btree.h>
+#include <pinedb/bufferpool.h>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace pinedb;
+
+namespace
+{
+    // Inserts the keys into a new tree whose pool holds all its pages, and prints the insert
+    // rate and how full the leaves are
+    void insert(const std::vector<uint64_t> &keys, const char *order)
+    {
+        auto frames = static_cast<int>(keys.size() / 100 + 64);
+        MemoryStorageBackend storage(4096);
+        LRUCacheReplacer<frame_id_type> cache_replacer(frames);
+        BufferPool pool(frames, storage, cache_replacer);
+        BTree<uint64_t> tree(pool, BTree<uint64_t>::create(pool));
+        auto start = std::chrono::steady_clock::now();
+        for (auto key : keys)
+            tree.insert(key, key);
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+        uint64_t leaves = 0;
+        for (page_id_type page_id = tree.get_root_page_id(); page_id != 0;)
+        {
+            BTreeNode<uint64_t> node(pool.fetch_page(page_id));
+            leaves += node.is_leaf();
+            page_id = node.is_leaf() ? node.get_next_leaf() : node.child(0);
+        }
+        fmt::println("{:<10} {:>10.3f} Mops/s   height {}   {:>8} leaves {:>6.1f}% full", order,
+                     static_cast<double>(keys.size()) / elapsed.count() / 1e6, tree.height(),
+                     leaves,
+                     100.0 * static_cast<double>(keys.size())
+                         / static_cast<double>(leaves * tree.get_max_leaf_keys()));
+    }
+} // namespace
+
+// Usage:
+//  append [keys]
+int run_append_benchmark(int argc, char **argv)
+{
+    uint64_t n = argc >= 1 ? std::stoull(argv[0]) : 5000000;
+    fmt::println("{} keys", n);
+    std::vector<uint64_t> keys(n);
+    std::iota(keys.begin(), keys.end(), 0);
+    insert(keys, "increasing");
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(7));
+    insert(keys, "random");
+    return 0;
+}
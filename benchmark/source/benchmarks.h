@@ -0,0 +1,25 @@
+#ifndef PINEDB_BENCHMARKS_H
+#define PINEDB_BENCHMARKS_H
+
+// Each benchmark receives the command line arguments which follow the benchmark name, and
+// returns the exit code of the program
+
+int run_replacer_benchmark(int argc, char **argv);
+
+int run_datapacker_benchmark(int argc, char **argv);
+
+int run_nodesearch_benchmark(int argc, char **argv);
+
+int run_concurrentbtree_benchmark(int argc, char **argv);
+
+int run_rangescan_benchmark(int argc, char **argv);
+
+int run_multiget_benchmark(int argc, char **argv);
+
+int run_append_benchmark(int argc, char **argv);
+
+int run_hashindex_benchmark(int argc, char **argv);
+
+int run_swizzle_benchmark(int argc, char **argv);
+
+#endif // PINEDB_BENCHMARKS_H
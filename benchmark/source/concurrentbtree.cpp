@@ -0,0 +1,126 @@
+#include "benchmarks.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fmt/format.h>
+#include <mutex>
+#include <pinedb/btree.h>
+#include <pinedb/bufferpool.h>
+#include <pinedb/concurrentbtree.h>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace pinedb;
+
+namespace
+{
+    struct Workload
+    {
+        uint64_t keys;
+        uint64_t operations;
+        uint32_t lookup_percent;
+    };
+
+    // Runs `operation(rng)` `operations` times on each thread, and returns the total
+    // number of operations per second
+    template <typename Fn> double run_threads(int threads, uint64_t operations, Fn operation)
+    {
+        std::vector<std::thread> workers;
+        auto start = std::chrono::steady_clock::now();
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.emplace_back(
+                [&, t]()
+                {
+                    std::mt19937_64 rng(static_cast<uint64_t>(t) + 1);
+                    for (uint64_t i = 0; i < operations; ++i)
+                        operation(rng);
+                });
+        }
+        for (auto &worker : workers)
+            worker.join();
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+        return static_cast<double>(operations) * threads / elapsed.count();
+    }
+
+    // Tree of `keys` even keys, the odd keys are inserted by the workload
+    page_id_type load_tree(BufferPool &pool, uint64_t keys)
+    {
+        uint64_t next = 0;
+        return BTree<uint64_t>::bulk_load(pool,
+                                          [&](uint64_t &key, uint64_t &value)
+                                          {
+                                              if (next == keys)
+                                                  return false;
+                                              key = value = 2 * next++;
+                                              return true;
+                                          });
+    }
+
+    void benchmark_threads(const Workload &workload, int threads)
+    {
+        auto frames = static_cast<int>(workload.keys / 100 + 1000);
+        uint64_t found = 0;
+        {
+            // Every operation holds a mutex around a single threaded BTree
+            MemoryStorageBackend storage(4096);
+            LRUCacheReplacer<frame_id_type> cache_replacer(frames);
+            BufferPool pool(frames, storage, cache_replacer);
+            BTree<uint64_t> tree(pool, load_tree(pool, workload.keys));
+            std::mutex mutex;
+            auto ops = run_threads(threads, workload.operations,
+                                   [&](std::mt19937_64 &rng)
+                                   {
+                                       auto key = rng() % (2 * workload.keys);
+                                       uint64_t value;
+                                       std::lock_guard<std::mutex> guard(mutex);
+                                       if (rng() % 100 < workload.lookup_percent)
+                                           found += tree.search(key & ~1ULL, value);
+                                       else
+                                           tree.insert(key | 1, key);
+                                   });
+            fmt::println("{:<28} {:>3} threads {:>10.3f} Mops/s", "BTree with a mutex", threads,
+                         ops / 1e6);
+        }
+        {
+            MemoryStorageBackend storage(4096);
+            LRUCacheReplacer<frame_id_type> cache_replacer(frames);
+            BufferPool pool(frames, storage, cache_replacer);
+            ConcurrentBTree<uint64_t> tree(pool, load_tree(pool, workload.keys));
+            std::atomic<uint64_t> concurrent_found(0);
+            auto ops = run_threads(threads, workload.operations,
+                                   [&](std::mt19937_64 &rng)
+                                   {
+                                       auto key = rng() % (2 * workload.keys);
+                                       uint64_t value;
+                                       if (rng() % 100 < workload.lookup_percent)
+                                           concurrent_found += tree.search(key & ~1ULL, value);
+                                       else
+                                           tree.insert(key | 1, key);
+                                   });
+            fmt::println("{:<28} {:>3} threads {:>10.3f} Mops/s   ({} lookups found)",
+                         "ConcurrentBTree", threads, ops / 1e6, found + concurrent_found);
+        }
+    }
+} // namespace
+
+// Usage:
+//  concurrentbtree [keys] [operations_per_thread] [lookup_percent] [max_threads]
+int run_concurrentbtree_benchmark(int argc, char **argv)
+{
+    Workload workload;
+    workload.keys = argc >= 1 ? std::stoull(argv[0]) : 1000000;
+    workload.operations = argc >= 2 ? std::stoull(argv[1]) : 200000;
+    workload.lookup_percent = argc >= 3 ? static_cast<uint32_t>(std::stoul(argv[2])) : 90;
+    auto max_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    if (argc >= 4)
+        max_threads = std::stoi(argv[3]);
+    fmt::println("{} keys, {} operations per thread, {}% lookups and {}% inserts", workload.keys,
+                 workload.operations, workload.lookup_percent, 100 - workload.lookup_percent);
+    for (int threads = 1; threads <= max_threads; threads *= 2)
+        benchmark_threads(workload, threads);
+    return 0;
+}
@@ -0,0 +1,287 @@
+#include "benchmarks.h"
+
+#include <chrono>
+#include <fmt/format.h>
+#include <pinedb/datapacker.h>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace datapacker;
+
+namespace
+{
+    // Calls `fn(i)` for every index, `count` times over, and returns the time per call
+    template <typename Fn> double ns_per_op(size_t count, int repeat, Fn fn)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeat; ++r)
+        {
+            for (size_t i = 0; i < count; ++i)
+                fn(i);
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return static_cast<double>(
+                   std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count())
+               / static_cast<double>(count * repeat);
+    }
+
+    template <typename T> std::vector<T> random_values(size_t count)
+    {
+        std::mt19937_64 rng(42);
+        std::vector<T> values(count);
+        if constexpr (std::is_floating_point<T>::value)
+        {
+            std::uniform_real_distribution<T> dist(-1e6, 1e6);
+            for (auto &value : values)
+                value = dist(rng);
+        }
+        else
+        {
+            std::uniform_int_distribution<T> dist;
+            for (auto &value : values)
+                value = dist(rng);
+        }
+        return values;
+    }
+
+    template <typename C> void print_result(const std::string &name, double ns, C checksum)
+    {
+        // The checksum is printed so that the compiler cannot remove the benchmarked code
+        fmt::println("{:<36} {:>8.2f} ns/op   (checksum {})", name, ns, checksum);
+    }
+
+    template <typename T> void benchmark_integer(const std::string &type_name, size_t count,
+                                                 int repeat)
+    {
+        auto values = random_values<T>(count);
+        std::vector<uint8_t> buffer(count * sizeof(T));
+        uint64_t checksum = 0;
+
+        auto ns = ns_per_op(count, repeat, [&](size_t i)
+                            { bytes::encode_le(buffer.data() + i * sizeof(T), values[i]); });
+        print_result("encode_le<" + type_name + ">", ns, buffer[count / 2] + 0);
+
+        ns = ns_per_op(count, repeat,
+                       [&](size_t i)
+                       {
+                           T value;
+                           bytes::decode_le(buffer.data() + i * sizeof(T), value);
+                           checksum += static_cast<uint64_t>(value);
+                       });
+        print_result("decode_le<" + type_name + ">", ns, checksum);
+
+        ns = ns_per_op(count, repeat, [&](size_t i)
+                       { bytes::encode_be(buffer.data() + i * sizeof(T), values[i]); });
+        print_result("encode_be<" + type_name + ">", ns, buffer[count / 2] + 0);
+
+        ns = ns_per_op(count, repeat,
+                       [&](size_t i)
+                       {
+                           T value;
+                           bytes::decode_be(buffer.data() + i * sizeof(T), value);
+                           checksum += static_cast<uint64_t>(value);
+                       });
+        print_result("decode_be<" + type_name + ">", ns, checksum);
+    }
+
+    template <typename T, unsigned bits, unsigned expbits>
+    void benchmark_real(const std::string &type_name, size_t count, int repeat)
+    {
+        auto values = random_values<T>(count);
+        std::vector<uint8_t> buffer(count * sizeof(T));
+        double checksum = 0;
+
+        auto ns = ns_per_op(count, repeat, [&](size_t i)
+                            { bytes::encode<endian::little>(buffer.data() + i * sizeof(T),
+                                                            values[i]); });
+        print_result("encode<" + type_name + ">", ns, buffer[count / 2] + 0);
+
+        ns = ns_per_op(count, repeat,
+                       [&](size_t i)
+                       {
+                           T value;
+                           bytes::decode<endian::little>(buffer.data() + i * sizeof(T), value);
+                           checksum += value;
+                       });
+        print_result("decode<" + type_name + ">", ns, checksum);
+
+        // The portable encoder, used on platforms which are not IEEE754
+        std::vector<uint64_t> packed(count);
+        ns = ns_per_op(count, repeat,
+                       [&](size_t i) { packed[i] = internal::pack754<bits, expbits>(values[i]); });
+        print_result("pack754<" + type_name + ">", ns, packed[count / 2]);
+
+        checksum = 0;
+        ns = ns_per_op(count, repeat,
+                       [&](size_t i)
+                       {
+                           auto value = internal::unpack754<bits, expbits>(packed[i]);
+                           checksum += static_cast<T>(value);
+                       });
+        print_result("unpack754<" + type_name + ">", ns, checksum);
+    }
+
+    // Compares encode_array/decode_array against encoding one element at a time
+    template <typename T, endian endianness>
+    void benchmark_array(const std::string &name, size_t count, int repeat)
+    {
+        auto values = random_values<T>(count);
+        std::vector<uint8_t> buffer(count * sizeof(T));
+        std::vector<T> decoded(count);
+
+        auto ns = ns_per_op(1, repeat,
+                            [&](size_t)
+                            {
+                                for (size_t i = 0; i < count; ++i)
+                                    bytes::encode<endianness>(buffer.data() + i * sizeof(T),
+                                                              values[i]);
+                            });
+        print_result("scalar encode " + name, ns / static_cast<double>(count),
+                     buffer[count / 2] + 0);
+
+        ns = ns_per_op(1, repeat, [&](size_t)
+                       { bytes::encode_array<endianness>(buffer.data(), values.data(), count); });
+        fmt::println("{:<36} {:>8.2f} ns/op   ({:.2f} GB/s)", "encode_array " + name,
+                     ns / static_cast<double>(count),
+                     static_cast<double>(count * sizeof(T)) / ns);
+
+        ns = ns_per_op(1, repeat, [&](size_t)
+                       { bytes::decode_array<endianness>(buffer.data(), decoded.data(), count); });
+        fmt::println("{:<36} {:>8.2f} ns/op   ({:.2f} GB/s)", "decode_array " + name,
+                     ns / static_cast<double>(count),
+                     static_cast<double>(count * sizeof(T)) / ns);
+    }
+
+    // Compares the compressed block encodings against plain fixed width encoding, for sorted
+    // values with small gaps, the usual shape of page ids and keys
+    void benchmark_blocks(size_t count, int repeat)
+    {
+        std::mt19937_64 rng(42);
+        std::uniform_int_distribution<uint64_t> gap(0, 100);
+        std::vector<uint64_t> values(count);
+        uint64_t value = 1ULL << 40;
+        for (auto &v : values)
+            v = value += gap(rng);
+        std::vector<uint8_t> buffer(count * bytes::max_varint_length<uint64_t> + 16);
+        std::vector<uint64_t> decoded(count);
+
+        auto report = [&](const std::string &name, double ns, int length)
+        {
+            fmt::println("{:<36} {:>8.2f} ns/op   ({:.2f} bytes/value)", name,
+                         ns / static_cast<double>(count),
+                         static_cast<double>(length) / static_cast<double>(count));
+        };
+
+        int length = 0;
+        auto ns = ns_per_op(1, repeat, [&](size_t)
+                            { length = bytes::encode_delta_block(buffer.data(), values.data(),
+                                                                 count); });
+        report("encode_delta_block", ns, length);
+        ns = ns_per_op(1, repeat, [&](size_t)
+                       { bytes::decode_delta_block(buffer.data(), decoded.data(), count); });
+        report("decode_delta_block", ns, length);
+
+        ns = ns_per_op(1, repeat, [&](size_t)
+                       { length = bytes::encode_for_block(buffer.data(), values.data(), count); });
+        report("encode_for_block", ns, length);
+        ns = ns_per_op(1, repeat, [&](size_t)
+                       { bytes::decode_for_block(buffer.data(), decoded.data(), count); });
+        report("decode_for_block", ns, length);
+
+        ns = ns_per_op(1, repeat, [&](size_t)
+                       { bytes::decode_array<endian::little>(buffer.data(), decoded.data(),
+                                                             count); });
+        report("decode_array (fixed width)", ns, static_cast<int>(count * sizeof(uint64_t)));
+    }
+
+    // Serializes every value to a stringstream, one at a time
+    void benchmark_stream(size_t count, int repeat)
+    {
+        auto values = random_values<uint64_t>(count);
+        uint64_t checksum = 0;
+
+        auto ns = ns_per_op(1, repeat,
+                            [&](size_t)
+                            {
+                                std::stringstream ss;
+                                for (const auto value : values)
+                                    stream::write<endian::little>(ss, value);
+                                checksum += ss.str().size();
+                            });
+        print_result("stream::write<uint64_t>", ns / static_cast<double>(count), checksum);
+
+        ns = ns_per_op(1, repeat,
+                       [&](size_t)
+                       {
+                           std::stringstream ss;
+                           {
+                               stream::StreamWriter writer(ss);
+                               for (const auto value : values)
+                                   writer.write<endian::little>(value);
+                           }
+                           checksum += ss.str().size();
+                       });
+        print_result("StreamWriter::write<uint64_t>", ns / static_cast<double>(count), checksum);
+
+        std::stringstream source;
+        {
+            stream::StreamWriter writer(source);
+            for (const auto value : values)
+                writer.write<endian::little>(value);
+        }
+        auto data = source.str();
+        ns = ns_per_op(1, repeat,
+                       [&](size_t)
+                       {
+                           std::stringstream ss(data);
+                           uint64_t value = 0;
+                           for (size_t i = 0; i < count; ++i)
+                           {
+                               stream::read<endian::little>(ss, value);
+                               checksum += value;
+                           }
+                       });
+        print_result("stream::read<uint64_t>", ns / static_cast<double>(count), checksum);
+
+        ns = ns_per_op(1, repeat,
+                       [&](size_t)
+                       {
+                           std::stringstream ss(data);
+                           stream::StreamReader reader(ss);
+                           uint64_t value = 0;
+                           for (size_t i = 0; i < count; ++i)
+                           {
+                               reader.read<endian::little>(value);
+                               checksum += value;
+                           }
+                       });
+        print_result("StreamReader::read<uint64_t>", ns / static_cast<double>(count), checksum);
+    }
+} // namespace
+
+// Usage:
+//  datapacker [number_of_values] [repeat]
+int run_datapacker_benchmark(int argc, char **argv)
+{
+    size_t count = argc >= 1 ? std::stoull(argv[0]) : 1 << 16;
+    int repeat = argc >= 2 ? std::stoi(argv[1]) : 100;
+    fmt::println("Host byte order is {}known, floats are {}IEEE754",
+                 internal::host_endian_known ? "" : "not ",
+                 internal::float_is_iec559 && internal::double_is_iec559 ? "" : "not ");
+
+    benchmark_integer<uint16_t>("uint16_t", count, repeat);
+    benchmark_integer<uint32_t>("uint32_t", count, repeat);
+    benchmark_integer<uint64_t>("uint64_t", count, repeat);
+    benchmark_real<float, 32, 8>("float", count, repeat);
+    benchmark_real<double, 64, 11>("double", count, repeat);
+    benchmark_array<uint16_t, endian::big>("uint16_t big endian", count, repeat);
+    benchmark_array<uint32_t, endian::big>("uint32_t big endian", count, repeat);
+    benchmark_array<uint64_t, endian::big>("uint64_t big endian", count, repeat);
+    benchmark_array<uint64_t, endian::little>("uint64_t little endian", count, repeat);
+    benchmark_array<double, endian::little>("double", count, repeat);
+    benchmark_blocks(count, repeat);
+    benchmark_stream(count, repeat / 10 + 1);
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include "benchmarks.h"
+
+#include <chrono>
+#include <fmt/format.h>
+#include <pinedb/btree.h>
+#include <pinedb/bufferpool.h>
+#include <pinedb/hashindex.h>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace pinedb;
+
+namespace
+{
+    // Runs `search` on every key, and prints the time and the pages fetched per lookup
+    template <typename Search>
+    void lookup(BufferPool &pool, const std::vector<uint64_t> &keys, const char *name,
+                Search search)
+    {
+        uint64_t fetches = 0, found = 0;
+        pool.set_trace_hook([&](page_id_type) { ++fetches; });
+        auto start = std::chrono::steady_clock::now();
+        for (auto key : keys)
+            found += search(key);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        pool.set_trace_hook({});
+        auto lookups = static_cast<double>(keys.size());
+        fmt::println(
+            "{:<10} {:>8.1f} ns/lookup {:>6.2f} pages/lookup ({} found)", name,
+            static_cast<double>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count())
+                / lookups,
+            static_cast<double>(fetches) / lookups, found);
+    }
+} // namespace
+
+// Usage:
+//  hashindex [keys] [lookups]
+int run_hashindex_benchmark(int argc, char **argv)
+{
+    uint64_t n = argc >= 1 ? std::stoull(argv[0]) : 2000000;
+    uint64_t lookups = argc >= 2 ? std::stoull(argv[1]) : 2000000;
+    auto frames = static_cast<int>(n / 50 + 1000);
+    MemoryStorageBackend storage(4096);
+    LRUCacheReplacer<frame_id_type> cache_replacer(frames);
+    BufferPool pool(frames, storage, cache_replacer);
+
+    uint64_t next = 0;
+    BTree<uint64_t> tree(pool, BTree<uint64_t>::bulk_load(pool,
+                                                          [&](uint64_t &key, uint64_t &value)
+                                                          {
+                                                              if (next == n)
+                                                                  return false;
+                                                              key = value = 2 * next++;
+                                                              return true;
+                                                          }));
+    HashIndex<uint64_t> index(pool, HashIndex<uint64_t>::create(pool));
+    for (uint64_t key = 0; key < 2 * n; key += 2)
+        index.insert(key, key);
+    fmt::println("{} keys, {} lookups, B+ tree height {}, hash index global depth {}", n, lookups,
+                 tree.height(), index.get_global_depth());
+
+    // The indexes hold the even keys, so half of the keys which are looked up are not in them,
+    // and those are spread over all the leaves of the B+ tree
+    std::mt19937_64 rng(7);
+    std::vector<uint64_t> keys(lookups);
+    for (auto &key : keys)
+        key = rng() % (2 * n);
+    uint64_t value;
+    lookup(pool, keys, "BTree", [&](uint64_t key) { return tree.search(key, value); });
+    lookup(pool, keys, "HashIndex", [&](uint64_t key) { return index.search(key, value); });
+    return 0;
+}
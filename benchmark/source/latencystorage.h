@@ -0,0 +1,54 @@
+#ifndef PINEDB_LATENCYSTORAGE_H
+#define PINEDB_LATENCYSTORAGE_H
+
+#include <atomic>
+#include <chrono>
+#include <pinedb/storage.h>
+#include <thread>
+#include <vector>
+
+// Memory backend which waits like a device would before every read request, so that the
+// benchmarks which use it are bound by reads. Pages with consecutive ids which are read together
+// are one request
+class LatencyStorageBackend : public pinedb::MemoryStorageBackend
+{
+    std::chrono::microseconds latency;
+    std::chrono::microseconds transfer;
+
+  public:
+    std::atomic<int> requests{0};
+
+    LatencyStorageBackend(pinedb::page_size_type page_sz, std::chrono::microseconds latency,
+                          std::chrono::microseconds transfer)
+        : MemoryStorageBackend(page_sz), latency(latency), transfer(transfer)
+    {
+    }
+
+    bool read_page(pinedb::page_id_type page_id, uint8_t *buffer) override
+    {
+        ++requests;
+        std::this_thread::sleep_for(latency + transfer);
+        return MemoryStorageBackend::read_page(page_id, buffer);
+    }
+
+    bool read_pages(const std::vector<pinedb::page_id_type> &page_ids,
+                    const std::vector<uint8_t *> &buffers) override
+    {
+        auto wait = std::chrono::microseconds(0);
+        bool status = true;
+        for (size_t i = 0; i < page_ids.size(); ++i)
+        {
+            if (i == 0 || page_ids[i] != page_ids[i - 1] + 1)
+            {
+                ++requests;
+                wait += latency;
+            }
+            wait += transfer;
+            status = MemoryStorageBackend::read_page(page_ids[i], buffers[i]) && status;
+        }
+        std::this_thread::sleep_for(wait);
+        return status;
+    }
+};
+
+#endif // PINEDB_LATENCYSTORAGE_H
@@ -0,0 +1,31 @@
+#include "benchmarks.h"
+
+#include <fmt/format.h>
+#include <functional>
+#include <map>
+#include <string>
+
+auto main(int argc, char **argv) -> int
+{
+    const std::map<std::string, std::function<int(int, char **)>> benchmarks = {
+        {"replacer", run_replacer_benchmark},
+        {"datapacker", run_datapacker_benchmark},
+        {"nodesearch", run_nodesearch_benchmark},
+        {"concurrentbtree", run_concurrentbtree_benchmark},
+        {"rangescan", run_rangescan_benchmark},
+        {"multiget", run_multiget_benchmark},
+        {"append", run_append_benchmark},
+        {"hashindex", run_hashindex_benchmark},
+        {"swizzle", run_swizzle_benchmark},
+    };
+
+    if (argc < 2 || benchmarks.find(argv[1]) == benchmarks.end())
+    {
+        fmt::println("Usage: {} <benchmark> [args...]", argv[0]);
+        fmt::println("Available benchmarks:");
+        for (const auto &benchmark : benchmarks)
+            fmt::println("    {}", benchmark.first);
+        return 1;
+    }
+    return benchmarks.at(argv[1])(argc - 2, argv + 2);
+}
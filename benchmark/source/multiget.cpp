@@ -0,0 +1,104 @@
+#include "benchmarks.h"
+#include "latencystorage.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fmt/format.h>
+#include <pinedb/btree.h>
+#include <pinedb/bufferpool.h>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace pinedb;
+
+namespace
+{
+    struct Workload
+    {
+        uint64_t keys;
+        size_t batch_size;
+        int batches;
+    };
+
+    // Looks up random batches of keys one at a time and with `multi_get`, the pool either holds
+    // the whole tree, or starts empty and holds 1% of it
+    void lookup(const Workload &workload, StorageBackend &storage, page_id_type root_page_id,
+                int frames, const char *name)
+    {
+        for (bool batched : {false, true})
+        {
+            LRUCacheReplacer<frame_id_type> cache_replacer(frames);
+            BufferPool pool(frames, storage, cache_replacer);
+            BTree<uint64_t> tree(pool, root_page_id);
+            std::mt19937_64 rng(7);
+            std::vector<uint64_t> keys(workload.batch_size), values;
+            std::vector<bool> found;
+            uint64_t total_found = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (int b = 0; b < workload.batches; ++b)
+            {
+                for (auto &key : keys)
+                    key = rng() % workload.keys;
+                if (batched)
+                {
+                    total_found += tree.multi_get(keys, values, found);
+                    continue;
+                }
+                uint64_t value;
+                for (auto key : keys)
+                    total_found += tree.search(key, value);
+            }
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            auto lookups = static_cast<double>(workload.batch_size) * workload.batches;
+            fmt::println("{:<6} {:<10} {:>10.1f} ns/key ({} found)", name,
+                         batched ? "multi_get" : "search",
+                         static_cast<double>(
+                             std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count())
+                             / lookups,
+                         total_found);
+        }
+    }
+
+    page_id_type load_tree(StorageBackend &storage, uint64_t keys)
+    {
+        auto frames = static_cast<int>(keys / 200 + 64);
+        LRUCacheReplacer<frame_id_type> cache_replacer(frames);
+        BufferPool pool(frames, storage, cache_replacer);
+        uint64_t next = 0;
+        auto root_page_id = BTree<uint64_t>::bulk_load(pool,
+                                                       [&](uint64_t &key, uint64_t &value)
+                                                       {
+                                                           if (next == keys)
+                                                               return false;
+                                                           key = value = next++;
+                                                           return true;
+                                                       });
+        pool.flush_all();
+        return root_page_id;
+    }
+} // namespace
+
+// Usage:
+//  multiget [keys] [batch_size] [batches] [read_latency_us]
+int run_multiget_benchmark(int argc, char **argv)
+{
+    Workload workload;
+    workload.keys = argc >= 1 ? std::stoull(argv[0]) : 1000000;
+    workload.batch_size = argc >= 2 ? std::stoul(argv[1]) : 500;
+    workload.batches = argc >= 3 ? std::stoi(argv[2]) : 200;
+    auto latency = std::chrono::microseconds(argc >= 4 ? std::stoi(argv[3]) : 100);
+    fmt::println("{} keys, {} batches of {} keys, {} us per read request", workload.keys,
+                 workload.batches, workload.batch_size, latency.count());
+
+    MemoryStorageBackend memory(4096);
+    auto root_page_id = load_tree(memory, workload.keys);
+    lookup(workload, memory, root_page_id, static_cast<int>(workload.keys / 200 + 64), "warm");
+
+    // Fewer batches are run, as every lookup reads pages
+    LatencyStorageBackend slow(4096, latency, std::chrono::microseconds(2));
+    root_page_id = load_tree(slow, workload.keys);
+    workload.batches = std::max(1, workload.batches / 20);
+    lookup(workload, slow, root_page_id, static_cast<int>(workload.keys / 20000 + 64), "cold");
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include "benchmarks.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fmt/format.h>
+#include <pinedb/datapacker.h>
+#include <pinedb/nodesearch.h>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace pinedb;
+
+namespace
+{
+    // Returns the time per call of `fn(needle)`, for every needle
+    template <typename T, typename Fn>
+    double ns_per_search(const std::vector<T> &needles, int repeat, Fn fn)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeat; ++r)
+        {
+            for (const auto needle : needles)
+                fn(needle);
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return static_cast<double>(
+                   std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count())
+               / static_cast<double>(needles.size() * repeat);
+    }
+
+    template <typename T> T random_key(std::mt19937_64 &rng)
+    {
+        if constexpr (std::is_floating_point<T>::value)
+            return static_cast<T>(std::uniform_real_distribution<double>(-1e6, 1e6)(rng));
+        else
+            return static_cast<T>(rng());
+    }
+
+    // Searches a node of `n` sorted keys with std::lower_bound, and with every supported kernel
+    template <typename T>
+    void benchmark_type(const std::string &type_name, uint32_t n, size_t lookups, int repeat)
+    {
+        std::mt19937_64 rng(42);
+        std::vector<T> keys(n);
+        for (auto &key : keys)
+            key = random_key<T>(rng);
+        std::sort(keys.begin(), keys.end());
+        // The keys as they are stored in a B+ tree page
+        std::vector<uint8_t> node(n * sizeof(T));
+        for (uint32_t i = 0; i < n; ++i)
+            datapacker::bytes::encode<datapacker::endian::little>(node.data() + i * sizeof(T),
+                                                                  keys[i]);
+        std::vector<T> needles(lookups);
+        for (auto &needle : needles)
+            needle = random_key<T>(rng);
+
+        uint64_t checksum = 0;
+        auto ns = ns_per_search(needles, repeat,
+                                [&](T needle)
+                                {
+                                    checksum += static_cast<uint64_t>(
+                                        std::lower_bound(keys.begin(), keys.end(), needle)
+                                        - keys.begin());
+                                });
+        // The checksum is printed so that the compiler cannot remove the searches
+        fmt::println("{:<36} {:>8.2f} ns/op   (checksum {})", "std::lower_bound<" + type_name + ">",
+                     ns, checksum);
+
+        for (auto kernel : {SearchKernel::SCALAR, SearchKernel::SSE2, SearchKernel::AVX2,
+                            SearchKernel::NEON})
+        {
+            if (!NodeSearch::is_supported(kernel))
+                continue;
+            checksum = 0;
+            ns = ns_per_search(needles, repeat,
+                               [&](T needle)
+                               {
+                                   checksum += NodeSearch::lower_bound(node.data(), n, needle,
+                                                                       kernel);
+                               });
+            fmt::println("{:<36} {:>8.2f} ns/op   (checksum {})",
+                         std::string(NodeSearch::kernel_name(kernel)) + "<" + type_name + ">", ns,
+                         checksum);
+        }
+    }
+} // namespace
+
+// Usage:
+//  nodesearch [keys_per_node] [lookups] [repeat]
+int run_nodesearch_benchmark(int argc, char **argv)
+{
+    uint32_t n = argc >= 1 ? static_cast<uint32_t>(std::stoul(argv[0])) : 500;
+    size_t lookups = argc >= 2 ? std::stoull(argv[1]) : 1 << 16;
+    int repeat = argc >= 3 ? std::stoi(argv[2]) : 20;
+    fmt::println("{} keys per node, best kernel is {}", n,
+                 NodeSearch::kernel_name(NodeSearch::best_kernel()));
+
+    benchmark_type<uint8_t>("uint8_t", n, lookups, repeat);
+    benchmark_type<int8_t>("int8_t", n, lookups, repeat);
+    benchmark_type<uint16_t>("uint16_t", n, lookups, repeat);
+    benchmark_type<int16_t>("int16_t", n, lookups, repeat);
+    benchmark_type<uint32_t>("uint32_t", n, lookups, repeat);
+    benchmark_type<int32_t>("int32_t", n, lookups, repeat);
+    benchmark_type<uint64_t>("uint64_t", n, lookups, repeat);
+    benchmark_type<int64_t>("int64_t", n, lookups, repeat);
+    benchmark_type<float>("float", n, lookups, repeat);
+    benchmark_type<double>("double", n, lookups, repeat);
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include "benchmarks.h"
+#include "latencystorage.h"
+
+#include <chrono>
+#include <fmt/format.h>
+#include <pinedb/btree.h>
+#include <pinedb/bufferpool.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace pinedb;
+
+namespace
+{
+    // Scans the whole tree from a pool which does not contain any of its pages
+    void scan(LatencyStorageBackend &storage, page_id_type root_page_id, int frames,
+              bool forward, uint32_t prefetch_leaves)
+    {
+        LRUCacheReplacer<frame_id_type> cache_replacer(frames);
+        BufferPool pool(frames, storage, cache_replacer);
+        BTree<uint64_t> tree(pool, root_page_id);
+        storage.requests = 0;
+        uint64_t key, value, sum = 0, keys = 0;
+        auto start = std::chrono::steady_clock::now();
+        auto iter = forward ? tree.begin(prefetch_leaves) : tree.end(prefetch_leaves);
+        while (forward ? iter.next(key, value) : iter.prev(key, value))
+        {
+            sum += value;
+            ++keys;
+        }
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+        fmt::println("{:<9} prefetch {:>3} leaves {:>10.1f} ms {:>10.2f} Mkeys/s {:>8} read "
+                     "requests (checksum {})",
+                     forward ? "forward" : "backward", prefetch_leaves, elapsed.count() * 1e3,
+                     static_cast<double>(keys) / elapsed.count() / 1e6, storage.requests, sum);
+    }
+} // namespace
+
+// Usage:
+//  rangescan [keys] [frames] [read_latency_us] [transfer_us]
+int run_rangescan_benchmark(int argc, char **argv)
+{
+    uint64_t keys = argc >= 1 ? std::stoull(argv[0]) : 1000000;
+    int frames = argc >= 2 ? std::stoi(argv[1]) : 1024;
+    auto latency = std::chrono::microseconds(argc >= 3 ? std::stoi(argv[2]) : 100);
+    auto transfer = std::chrono::microseconds(argc >= 4 ? std::stoi(argv[3]) : 2);
+
+    LatencyStorageBackend storage(4096, latency, transfer);
+    page_id_type root_page_id;
+    {
+        LRUCacheReplacer<frame_id_type> cache_replacer(frames);
+        BufferPool pool(frames, storage, cache_replacer);
+        uint64_t next = 0;
+        root_page_id = BTree<uint64_t>::bulk_load(pool,
+                                                  [&](uint64_t &key, uint64_t &value)
+                                                  {
+                                                      if (next == keys)
+                                                          return false;
+                                                      key = next;
+                                                      value = next++;
+                                                      return true;
+                                                  });
+        pool.flush_all();
+    }
+    fmt::println("{} keys, {} frames, {} us per read request and {} us per page", keys, frames,
+                 latency.count(), transfer.count());
+    for (bool forward : {true, false})
+    {
+        for (uint32_t prefetch_leaves : {0u, 8u, 32u})
+            scan(storage, root_page_id, frames, forward, prefetch_leaves);
+    }
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include "benchmarks.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fmt/format.h>
+#include <functional>
+#include <memory>
+#include <pinedb/cachereplacer.h>
+#include <pinedb/tracereplay.h>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+using namespace pinedb;
+
+namespace
+{
+    using replacer_factory
+        = std::function<std::unique_ptr<CacheReplacer<frame_id_type>>(int number_of_frames)>;
+
+    // Add new cache replacement policies here so that they are included in the benchmark
+    const std::vector<std::pair<std::string, replacer_factory>> replacers = {
+        {"LRU",
+         [](int number_of_frames)
+         { return std::make_unique<LRUCacheReplacer<frame_id_type>>(number_of_frames); }},
+    };
+
+    void print_header()
+    {
+        fmt::println("{:<24} {:<8} {:>10} {:>10} {:>12} {:>10}", "trace", "policy", "frames",
+                     "hit ratio", "evictions", "ns/op");
+    }
+
+    void replay_all(const std::string &trace_name, const trace::trace_type &trace,
+                    const std::vector<int> &pool_sizes)
+    {
+        for (const auto number_of_frames : pool_sizes)
+        {
+            for (const auto &replacer : replacers)
+            {
+                auto cache_replacer = replacer.second(number_of_frames);
+                auto start = std::chrono::steady_clock::now();
+                auto stats = replay_trace(trace, number_of_frames, *cache_replacer);
+                auto elapsed = std::chrono::steady_clock::now() - start;
+                auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+                fmt::println("{:<24} {:<8} {:>10} {:>10.4f} {:>12} {:>10.1f}", trace_name,
+                             replacer.first, number_of_frames, stats.hit_ratio(), stats.evictions,
+                             stats.accesses == 0 ? 0.0
+                                                 : static_cast<double>(ns)
+                                                       / static_cast<double>(stats.accesses));
+            }
+        }
+    }
+
+    // Pool sizes as a fraction of the number of distinct pages in the trace
+    std::vector<int> default_pool_sizes(page_id_type number_of_pages)
+    {
+        std::vector<int> sizes;
+        for (const auto percent : {1, 5, 10, 25, 50})
+        {
+            sizes.push_back(std::max(1, number_of_pages * percent / 100));
+        }
+        return sizes;
+    }
+
+    int run_synthetic(page_id_type number_of_pages, size_t length)
+    {
+        auto pool_sizes = default_pool_sizes(number_of_pages);
+        print_header();
+        replay_all("uniform", trace::uniform(number_of_pages, length), pool_sizes);
+        for (const auto skew : {0.5, 0.8, 0.99, 1.2})
+        {
+            replay_all(fmt::format("zipfian(s={})", skew),
+                       trace::zipfian(number_of_pages, length, skew), pool_sizes);
+        }
+        replay_all("sequential", trace::sequential_scan(number_of_pages), pool_sizes);
+        replay_all("looping", trace::looping(number_of_pages, length), pool_sizes);
+        replay_all("scan+hot(10%, p=0.5)",
+                   trace::scan_hot_mix(number_of_pages, std::max(1, number_of_pages / 10), length,
+                                       0.5),
+                   pool_sizes);
+        return 0;
+    }
+
+    int run_recorded(const std::string &file_path, const std::vector<int> &frames)
+    {
+        trace::trace_type trace;
+        if (!trace::load(file_path, trace))
+        {
+            fmt::println("Could not read trace from \"{}\"", file_path);
+            return 1;
+        }
+        std::unordered_set<page_id_type> distinct(trace.begin(), trace.end());
+        fmt::println("Trace \"{}\": {} accesses, {} distinct pages", file_path, trace.size(),
+                     distinct.size());
+        print_header();
+        replay_all(file_path, trace,
+                   frames.empty() ? default_pool_sizes(static_cast<page_id_type>(distinct.size()))
+                                  : frames);
+        return 0;
+    }
+} // namespace
+
+// Usage:
+//  replacer [number_of_pages] [trace_length]         replays the synthetic traces
+//  replacer --trace <file> [number_of_frames ...]    replays a trace recorded from a BufferPool
+int run_replacer_benchmark(int argc, char **argv)
+{
+    try
+    {
+        if (argc >= 1 && std::string(argv[0]) == "--trace")
+        {
+            if (argc < 2)
+            {
+                fmt::println("Usage: replacer --trace <file> [number_of_frames ...]");
+                return 1;
+            }
+            std::vector<int> frames;
+            for (int i = 2; i < argc; ++i)
+                frames.push_back(std::stoi(argv[i]));
+            return run_recorded(argv[1], frames);
+        }
+        page_id_type number_of_pages = argc >= 1 ? std::stoi(argv[0]) : 10000;
+        size_t length = argc >= 2 ? std::stoull(argv[1]) : 1000 * 1000;
+        return run_synthetic(number_of_pages, length);
+    }
+    catch (std::exception &e)
+    {
+        fmt::println("Error while running benchmark: {}", e.what());
+        return 1;
+    }
+}
@@ -0,0 +1,85 @@
+#include "benchmarks.h"
+
+#include <chrono>
+#include <fmt/format.h>
+#include <pinedb/btree.h>
+#include <pinedb/bufferpool.h>
+#include <random>
+#include <string>
+
+using namespace pinedb;
+
+namespace
+{
+    // Counts the pages which are read from storage
+    class CountingStorageBackend : public MemoryStorageBackend
+    {
+      public:
+        uint64_t reads = 0;
+
+        using MemoryStorageBackend::MemoryStorageBackend;
+
+        bool read_page(page_id_type page_id, uint8_t *buffer) override
+        {
+            ++reads;
+            return MemoryStorageBackend::read_page(page_id, buffer);
+        }
+    };
+
+    // Searches random keys in the tree through a new pool with the given number of frames
+    void search(CountingStorageBackend &storage, page_id_type root_page_id, uint64_t keys,
+                uint64_t lookups, int frames, const char *name)
+    {
+        LRUCacheReplacer<frame_id_type> cache_replacer(frames);
+        BufferPool pool(frames, storage, cache_replacer);
+        BTree<uint64_t> tree(pool, root_page_id);
+        std::mt19937_64 rng(7);
+        uint64_t value, found = 0;
+        // The first pass reads the pages into the pool
+        for (uint64_t i = 0; i < lookups; ++i)
+            found += tree.search(rng() % keys, value);
+        storage.reads = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < lookups; ++i)
+            found += tree.search(rng() % keys, value);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        fmt::println(
+            "{:<8} {:>8} frames {:>10.1f} ns/lookup {:>8.3f} pages read/lookup ({} found)", name,
+            frames,
+            static_cast<double>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count())
+                / static_cast<double>(lookups),
+            static_cast<double>(storage.reads) / static_cast<double>(lookups), found);
+    }
+} // namespace
+
+// Usage:
+//  swizzle [keys] [lookups]
+int run_swizzle_benchmark(int argc, char **argv)
+{
+    uint64_t keys = argc >= 1 ? std::stoull(argv[0]) : 2000000;
+    uint64_t lookups = argc >= 2 ? std::stoull(argv[1]) : 2000000;
+    fmt::println("{} keys, {} lookups", keys, lookups);
+
+    CountingStorageBackend storage(4096);
+    auto frames = static_cast<int>(keys / 200 + 64);
+    page_id_type root_page_id;
+    {
+        LRUCacheReplacer<frame_id_type> cache_replacer(frames);
+        BufferPool pool(frames, storage, cache_replacer);
+        uint64_t next = 0;
+        root_page_id = BTree<uint64_t>::bulk_load(pool,
+                                                  [&](uint64_t &key, uint64_t &value)
+                                                  {
+                                                      if (next == keys)
+                                                          return false;
+                                                      key = value = next++;
+                                                      return true;
+                                                  });
+        pool.flush_all();
+    }
+    search(storage, root_page_id, keys, lookups, frames, "cached");
+    // A quarter of the leaves fit in the pool, with the internal nodes
+    search(storage, root_page_id, keys, lookups, frames / 4 + 64, "partial");
+    return 0;
+}
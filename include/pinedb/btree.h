@@ -3,13 +3,523 @@
 
 #include "bufferpool.h"
 #include "datapacker.h"
+#include "nodesearch.h"
+#include "record.h"
 
 #include <assert.h>
 #include <functional>
 #include <math.h>
+#include <tuple>
 #include <type_traits>
+#include <vector>
 
+// Disk based B+ tree which maps fixed width keys to 64 bit values (such as a packed RecordId),
+// see BTreeDesign.md for the page format. The tree is a template over the key type, and is
+// instantiated for each of the fixed width column types, so that the node layout and key
+// comparisons are fixed at compile time. Keys are unique.
+//
+// The page id of the root does not change, when the root is split its contents are moved to a
+// new page, so the tree is always opened with the page id returned by `create`.
 namespace pinedb
 {
+    /**
+     * View of a B+ tree page. Internal nodes store `n` keys followed by `n + 1` child page ids,
+     * leaf nodes store `n` keys followed by `n` values. Keys are stored in little endian
+     */
+    template <typename Key> class BTreeNode
+    {
+        uint8_t *page;
+
+        template <typename T> T read(size_t offset) const
+        {
+            T value;
+            datapacker::bytes::decode<datapacker::endian::little>(page + offset, value);
+            return value;
+        }
+
+        template <typename T> void write(size_t offset, T value)
+        {
+            datapacker::bytes::encode<datapacker::endian::little>(page + offset, value);
+        }
+
+        // Start of the values or child page ids
+        size_t links_offset() const
+        {
+            return HEADER_SIZE + static_cast<size_t>(get_max_keys()) * sizeof(Key);
+        }
+
+      public:
+        static constexpr uint8_t INTERNAL_PAGE_TYPE = 0x1;
+        static constexpr uint8_t LEAF_PAGE_TYPE = 0x2;
+        static constexpr int HEADER_SIZE = 32;
+        static constexpr size_t NEXT_LEAF_OFFSET = 16;
+        static constexpr size_t NUMBER_OF_KEYS_OFFSET = 20;
+        static constexpr size_t MAX_KEYS_OFFSET = 24;
+        static constexpr size_t KEY_TYPE_OFFSET = 28;
+
+        explicit BTreeNode(uint8_t *page) : page(page) {}
+
+        /**
+         * Largest number of keys which fit in a leaf or an internal node of the given page size
+         */
+        static uint32_t capacity(page_size_type page_size, bool leaf)
+        {
+            size_t available = static_cast<size_t>(page_size) - HEADER_SIZE;
+            if (leaf)
+                return static_cast<uint32_t>(available / (sizeof(Key) + sizeof(uint64_t)));
+            return static_cast<uint32_t>((available - sizeof(page_id_type))
+                                         / (sizeof(Key) + sizeof(page_id_type)));
+        }
+
+        void init(page_id_type page_id, bool leaf, uint32_t max_keys);
+
+        bool is_leaf() const { return page[0] == LEAF_PAGE_TYPE; }
+
+        uint8_t get_key_type() const { return page[KEY_TYPE_OFFSET]; }
+
+        uint32_t size() const { return read<uint32_t>(NUMBER_OF_KEYS_OFFSET); }
+
+        void set_size(uint32_t n) { write(NUMBER_OF_KEYS_OFFSET, n); }
+
+        uint32_t get_max_keys() const { return read<uint32_t>(MAX_KEYS_OFFSET); }
+
+        page_id_type get_next_leaf() const { return read<page_id_type>(NEXT_LEAF_OFFSET); }
+
+        void set_next_leaf(page_id_type page_id) { write(NEXT_LEAF_OFFSET, page_id); }
+
+        Key key(uint32_t i) const { return read<Key>(HEADER_SIZE + i * sizeof(Key)); }
+
+        void set_key(uint32_t i, Key key) { write(HEADER_SIZE + i * sizeof(Key), key); }
+
+        uint64_t value(uint32_t i) const
+        {
+            return read<uint64_t>(links_offset() + i * sizeof(uint64_t));
+        }
+
+        void set_value(uint32_t i, uint64_t value)
+        {
+            write(links_offset() + i * sizeof(uint64_t), value);
+        }
+
+        page_id_type child(uint32_t i) const
+        {
+            return read<page_id_type>(links_offset() + i * sizeof(page_id_type));
+        }
+
+        void set_child(uint32_t i, page_id_type page_id)
+        {
+            write(links_offset() + i * sizeof(page_id_type), page_id);
+        }
+
+        /**
+         * Index of the first key which is not less than `key`, `size()` if there is none
+         */
+        uint32_t lower_bound(Key key) const
+        {
+            return NodeSearch::lower_bound(page + HEADER_SIZE, size(), key);
+        }
+
+        /**
+         * Index of the first key which is greater than `key`, which is also the index of the
+         * child of an internal node that can contain `key`
+         */
+        uint32_t upper_bound(Key key) const
+        {
+            return NodeSearch::upper_bound(page + HEADER_SIZE, size(), key);
+        }
+
+        /**
+         * Same as `lower_bound`, searching only the keys from index `first`
+         */
+        uint32_t lower_bound(Key key, uint32_t first) const
+        {
+            return first
+                   + NodeSearch::lower_bound(page + HEADER_SIZE + first * sizeof(Key),
+                                             size() - first, key);
+        }
+
+        /**
+         * Same as `upper_bound`, searching only the keys from index `first`
+         */
+        uint32_t upper_bound(Key key, uint32_t first) const
+        {
+            return first
+                   + NodeSearch::upper_bound(page + HEADER_SIZE + first * sizeof(Key),
+                                             size() - first, key);
+        }
+
+        /**
+         * Inserts a key and a value into a leaf at position `i`, the node should not be full
+         */
+        void insert_value(uint32_t i, Key key, uint64_t value);
+
+        /**
+         * Inserts a key at position `i` and a child at position `i + 1` into an internal node,
+         * the node should not be full
+         */
+        void insert_child(uint32_t i, Key key, page_id_type child);
+
+        /**
+         * Removes the key and the value at position `i` of a leaf
+         */
+        void remove_value(uint32_t i);
+
+        /**
+         * Removes the key at position `i` and the child at position `child_index` (`i` or
+         * `i + 1`) of an internal node
+         */
+        void remove_child(uint32_t i, uint32_t child_index);
+
+        /**
+         * Moves the keys of the node from index `mid` into `right`, which is initialized as a new
+         * node of the same kind. A leaf is linked to `right`, an internal node moves the key at
+         * `mid` into the parent. `mid` should be less than the number of keys, and more than 0
+         * for a leaf
+         * @return separator of the two nodes, which is inserted into the parent
+         */
+        Key split(BTreeNode &right, page_id_type right_page_id, uint32_t mid);
+
+        /**
+         * Moves the upper half of the keys of the node into `right`
+         */
+        Key split(BTreeNode &right, page_id_type right_page_id)
+        {
+            return split(right, right_page_id, size() / 2);
+        }
+    };
+
+    template <typename Key> class BTree
+    {
+        static_assert(std::is_arithmetic<Key>::value, "B+ tree keys should be fixed width");
+
+        BufferPool &pool;
+        page_id_type root_page_id;
+        uint32_t max_leaf_keys;
+        uint32_t max_internal_keys;
+        // Last leaf of the tree, found by the last insert which reached it, -1 if it is not known
+        page_id_type rightmost_leaf;
+
+        // Copy of a page, used when more than one page is modified
+        using PageCopy = std::vector<uint8_t>;
+
+        uint8_t *fetch(page_id_type page_id);
+
+        // Fetches child `i` of the internal node `page`, which was fetched last, through the
+        // swizzle slot of the child, so that a descent through pages which are in the pool does
+        // not look up the page table
+        uint8_t *fetch_child(uint8_t *page, uint32_t i);
+
+        PageCopy read_copy(page_id_type page_id);
+
+        void write_copy(page_id_type page_id, const PageCopy &copy);
+
+        page_id_type new_page();
+
+        // Maximum number of keys in leaf and internal nodes, for `max_keys` given to `create`
+        static void node_sizes(BufferPool &pool, uint32_t max_keys, uint32_t &leaf,
+                               uint32_t &internal);
+
+        // Result of inserting into a subtree, if the root of the subtree was split, the
+        // separator and the new right node have to be inserted into the parent
+        struct Split
+        {
+            bool split;
+            Key separator;
+            page_id_type right_page_id;
+        };
+
+        // `page` is the node `page_id`, `rightmost` is true if the node is the last node of its
+        // level
+        bool insert_into(page_id_type page_id, uint8_t *page, Key key, uint64_t value,
+                         Split &split, bool rightmost);
+
+        // Splits a full node into itself and a new right node, and returns the split. A node
+        // which is split by a key larger than all its keys, at the right edge of the tree, keeps
+        // as many keys as a bulk loaded node, as the next keys are likely to be larger too
+        Split split_node(page_id_type page_id, bool append);
+
+        // Inserts the key into the right-most leaf, without descending the tree, if the leaf is
+        // known, the key is larger than all its keys and the leaf is not full
+        bool append_to_rightmost(Key key, uint64_t value);
+
+        bool remove_from(page_id_type page_id, uint8_t *page, Key key);
+
+        uint32_t min_keys(bool leaf) const
+        {
+            return leaf ? max_leaf_keys / 2 : (max_internal_keys - 1) / 2;
+        }
+
+        // Fixes the child at `child_index` of the internal node, which has too few keys, by
+        // borrowing a key from a sibling or by merging it with a sibling
+        void rebalance(page_id_type page_id, uint32_t child_index);
+
+        // Finds the leaf which can contain the key, and stores its page id in `page_id`
+        uint8_t *find_leaf(Key key, page_id_type &page_id);
+
+        // Keys of a `multi_get`, `order` holds the indices of the keys sorted by key
+        struct MultiGet
+        {
+            const std::vector<Key> &keys;
+            std::vector<size_t> order;
+            std::vector<uint64_t> &values;
+            std::vector<bool> &found;
+            size_t count;
+        };
+
+        // Finds the keys `order[first, last)` in the subtree whose root is `page_id`
+        void multi_get_from(page_id_type page_id, MultiGet &batch, size_t first, size_t last);
+
+      public:
+        /**
+         * Creates an empty tree
+         * @param max_keys maximum number of keys in a node, 0 to fit as many as possible in a
+         * page. Smaller nodes are useful for testing
+         * @return page id of the root, which is used to open the tree
+         * @throws std::runtime_error if a page could not be created
+         * @throws std::logic_error if `max_keys` is less than 3 or does not fit in a page
+         */
+        static page_id_type create(BufferPool &pool, uint32_t max_keys = 0);
+
+        // Leaves and internal nodes built by `bulk_load` are filled to 90%, so that the first
+        // inserts into them do not split them
+        static constexpr double DEFAULT_FILL_FACTOR = 0.9;
+
+        /**
+         * Builds a tree from entries which are sorted by key. The leaves are filled one after
+         * the other and linked, and the internal levels are built bottom up, so every page is
+         * written once, in the order in which it is created. Use BTreeSorter to sort the entries
+         * first if they are not sorted
+         * @param next reads the next entry, returns false after the last entry
+         * @param fill_factor fraction of the keys of a node which are filled, the last two nodes
+         * of a level share their keys so that neither has too few keys
+         * @param max_keys same as `create`
+         * @return page id of the root
+         * @throws std::logic_error if the keys are not increasing, or the fill factor is not in
+         * (0, 1], the pages which were created are not deleted in that case
+         */
+        static page_id_type bulk_load(BufferPool &pool,
+                                      const std::function<bool(Key &, uint64_t &)> &next,
+                                      double fill_factor = DEFAULT_FILL_FACTOR,
+                                      uint32_t max_keys = 0);
+
+        /**
+         * @throws std::logic_error if the key is NaN, which cannot be ordered
+         */
+        static void check_key(Key key);
+
+        /**
+         * Opens the tree whose root is `root_page_id`
+         * @throws std::runtime_error if the page is not the root of a tree with keys of type
+         * `Key`
+         */
+        BTree(BufferPool &pool, page_id_type root_page_id);
+
+        page_id_type get_root_page_id() const { return root_page_id; }
+
+        uint32_t get_max_leaf_keys() const { return max_leaf_keys; }
+
+        uint32_t get_max_internal_keys() const { return max_internal_keys; }
+
+        /**
+         * Finds the value of the key
+         * @return false if the key is not in the tree
+         */
+        bool search(Key key, uint64_t &value);
+
+        /**
+         * Finds the values of many keys with one descent of the tree. The keys are sorted, so
+         * neighbouring keys share the nodes on their path and each node is read once, and the
+         * children of a node which are needed by the batch are prefetched a few at a time ahead
+         * of the one which is read
+         * @param values resized to the number of keys, value of each key which is found, 0 for
+         * the others
+         * @param found resized to the number of keys, whether each key was found
+         * @return number of keys which were found, NaN keys are never found
+         */
+        size_t multi_get(const std::vector<Key> &keys, std::vector<uint64_t> &values,
+                         std::vector<bool> &found);
+
+        /**
+         * Inserts the key, splitting the nodes which are full. A key larger than every key in
+         * the tree is appended to the right-most leaf without descending the tree when the leaf
+         * has room for it, and when the leaf is full it is split unevenly, so that keys inserted
+         * in increasing order leave the nodes filled to `DEFAULT_FILL_FACTOR`
+         * @return false if the key is already in the tree, the value is not changed in that case
+         * @throws std::logic_error if the key is NaN
+         */
+        bool insert(Key key, uint64_t value);
+
+        /**
+         * Changes the value of a key which is in the tree
+         * @return false if the key is not in the tree
+         */
+        bool update(Key key, uint64_t value);
+
+        /**
+         * Removes the key, nodes with too few keys borrow from or are merged with a sibling
+         * @return false if the key is not in the tree
+         */
+        bool remove(Key key);
+
+        /**
+         * Number of levels in the tree, 1 if the root is a leaf
+         */
+        int height();
+
+        // Number of leaves which an iterator prefetches ahead of the leaf which it reads
+        static constexpr uint32_t DEFAULT_PREFETCH_LEAVES = 8;
+
+        /**
+         * Iterates over the keys in either direction. The iterator is a position between two
+         * keys, `next` reads the key after it and `prev` the key before it. The iterator keeps
+         * the path from the root to its leaf, the next leaves are the next children of the
+         * parent of the leaf, so they are prefetched into the buffer pool while the leaf is read.
+         * The tree should not be modified while it is iterated
+         */
+        class Iterator
+        {
+            friend class BTree;
+
+            // Internal node on the path to the leaf, and the index of the child which is followed
+            struct Level
+            {
+                page_id_type page_id;
+                uint32_t child;
+            };
+
+            BTree &tree;
+            std::vector<Level> path;
+            page_id_type page_id;
+            uint32_t index;
+            uint32_t prefetch_leaves;
+            // The children of the parent of the leaf up to `prefetched_until`, in the direction
+            // of the iteration, have been prefetched
+            page_id_type prefetched_parent;
+            bool prefetched_forward;
+            int64_t prefetched_until;
+
+            Iterator(BTree &tree, uint32_t prefetch_leaves)
+                : tree(tree), page_id(0), index(0), prefetch_leaves(prefetch_leaves),
+                  prefetched_parent(-1), prefetched_forward(true), prefetched_until(0)
+            {
+            }
+
+            // Moves to the position in the leaf chosen by `position`, which also chooses the
+            // child of each internal node on the way to the leaf
+            void seek(bool forward,
+                      const std::function<uint32_t(const BTreeNode<Key> &)> &position);
+
+            // Moves to the start of the next leaf, or the end of the previous leaf
+            bool step(bool forward);
+
+            // Prefetches the leaves after (or before) the leaf, which have not been prefetched
+            void prefetch(bool forward);
+
+          public:
+            /**
+             * Reads the next key and value
+             * @return false if there are no more keys
+             */
+            bool next(Key &key, uint64_t &value);
+
+            /**
+             * Reads the previous key and value
+             * @return false if there are no more keys
+             */
+            bool prev(Key &key, uint64_t &value);
+        };
+
+        /**
+         * Iterator before the smallest key
+         * @param prefetch_leaves number of leaves to prefetch, 0 to disable prefetching
+         */
+        Iterator begin(uint32_t prefetch_leaves = DEFAULT_PREFETCH_LEAVES);
+
+        /**
+         * Iterator after the largest key, for reading the keys in decreasing order with `prev`
+         */
+        Iterator end(uint32_t prefetch_leaves = DEFAULT_PREFETCH_LEAVES);
+
+        /**
+         * Iterator before the first key which is not less than `key`, `prev` reads the last key
+         * which is less than `key`
+         */
+        Iterator lower_bound(Key key, uint32_t prefetch_leaves = DEFAULT_PREFETCH_LEAVES);
+    };
+
+    /**
+     * External merge sort of the entries of a B+ tree, to bulk load a tree from unsorted entries.
+     * Entries are sorted in memory until there are `memory_entries` of them, then the sorted run
+     * is written to a chain of temporary pages. The runs are merged when the entries are read,
+     * and each run page is deleted once it has been read
+     */
+    template <typename Key> class BTreeSorter
+    {
+        // Position of the next entry of a run
+        struct Cursor
+        {
+            page_id_type page_id;
+            uint32_t index;
+        };
+
+        BufferPool &pool;
+        size_t memory_entries;
+        std::vector<std::pair<Key, uint64_t>> entries;
+        // First page of every run
+        std::vector<page_id_type> runs;
+        std::vector<Cursor> cursors;
+        // Next entry of each run which is being merged, the smallest key is on top
+        std::vector<std::tuple<Key, uint64_t, size_t>> heap;
+        bool reading;
+        size_t position;
+
+        uint32_t entries_per_page() const
+        {
+            return static_cast<uint32_t>((static_cast<size_t>(pool.page_size()) - HEADER_SIZE)
+                                         / (sizeof(Key) + sizeof(uint64_t)));
+        }
+
+        // Writes the sorted entries in memory as a run
+        void spill();
+
+        // Reads the next entry of a run into the heap, deleting the pages which have been read
+        void advance(size_t run);
+
+      public:
+        static constexpr uint8_t RUN_PAGE_TYPE = 0x52;
+        // Common page header, followed by the page id of the next page of the run and the number
+        // of entries in the page
+        static constexpr int HEADER_SIZE = 24;
+
+        /**
+         * @param memory_entries number of entries which are sorted in memory
+         */
+        BTreeSorter(BufferPool &pool, size_t memory_entries = 1 << 20);
+
+        BTreeSorter(const BTreeSorter &) = delete;
+        BTreeSorter &operator=(const BTreeSorter &) = delete;
+
+        /**
+         * Deletes the run pages which have not been read
+         */
+        ~BTreeSorter();
+
+        /**
+         * Adds an entry, keys need not be unique
+         * @throws std::logic_error if the entries are being read
+         */
+        void add(Key key, uint64_t value);
+
+        /**
+         * Reads the entries in order of their keys, no entries can be added after the first call
+         * @return false after the last entry
+         */
+        bool next(Key &key, uint64_t &value);
+
+        /**
+         * Number of runs which were written to pages
+         */
+        size_t number_of_runs() const { return runs.size(); }
+    };
 } // namespace pinedb
-#endif // A_BTREE_H
\ No newline at end of file
+#endif // A_BTREE_H
@@ -1,15 +1,40 @@
 #ifndef PINEDB_BUFFERPOOL_H
 #define PINEDB_BUFFERPOOL_H
 #include "cachereplacer.h"
+#include "latch.h"
 #include "storage.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 // Class which implements a buffer pool manager
 // Uses storage backend to read and write pages, this class also implements
 // caching and frame to page mappings
+//
+// The pool can be used by many threads. The page table, the free frames and the cache replacer
+// are protected by a mutex which is held only for the duration of a call. Every frame also has an
+// OptimisticLatch, which the pool holds while the frame does not contain a valid page (from the
+// time it is evicted until it is filled again), so a thread which reads a page optimistically
+// sees the version of the frame change if the page is evicted. A frame whose latch is held by a
+// writer is not evicted.
+//
+// Pages can be prefetched, they are then read by a background thread into a frame which is mapped
+// to the page and latched until the read completes. A fetch of a page which is being prefetched
+// waits for the read. The storage backend is used by one thread at a time.
+//
+// References from a page to its children can be swizzled, every frame has swizzle slots which
+// hold the frames of the children of its page which were fetched with `fetch_child`. A child
+// which is in the pool is found by reading the slot and checking the latch of the child's frame,
+// without taking the mutex or looking up the page table. The pages themselves always hold page
+// ids. A frame which is referenced by a swizzle slot is unswizzled instead of being evicted, and
+// is evicted when the replacer chooses it again, unless it was fetched again in the meantime.
 namespace pinedb
 {
     class BufferPool
@@ -24,6 +49,40 @@ namespace pinedb
         // TODO: Simple free frame management, implex more complex schemes such as bitmap later
         std::vector<frame_id_type> free_frames;
         std::vector<bool> dirty_frames;
+        std::vector<OptimisticLatch> latches;
+        std::mutex mutex;
+        // Held while the storage backend is used, the prefetch thread reads pages without holding
+        // `mutex`, so that pages in the pool can be fetched while it reads
+        std::mutex storage_mutex;
+        // Frames which are being read by the prefetch thread
+        std::vector<bool> loading_frames;
+        std::deque<std::pair<page_id_type, frame_id_type>> prefetch_queue;
+        // Pages which are queued or being read
+        int prefetching = 0;
+        bool stopping = false;
+        std::condition_variable prefetch_ready;
+        std::condition_variable prefetch_done;
+        // Started by the first prefetch
+        std::thread prefetcher;
+        // Called with the page id of every page which is fetched or created, used to record
+        // access traces
+        std::function<void(page_id_type)> trace_hook;
+        // Set while `trace_hook` is not empty, `fetch_child` then takes the mutex to call it
+        std::atomic<bool> tracing;
+        // Page held by each frame, -1 if there is none, read by `fetch_child` without the mutex
+        std::vector<std::atomic<page_id_type>> frame_pages;
+        // A page holds at most this many child references
+        uint32_t slots_per_frame;
+        // Swizzle slots of the frames, slot `i` of a frame holds the frame of the child which is
+        // referenced by slot `i` of its page, -1 if the child is not swizzled. The slots of a
+        // frame are allocated when a child is first swizzled into them, and are kept until the
+        // pool is destroyed, as `fetch_child` reads them without the mutex
+        std::vector<std::atomic<std::atomic<frame_id_type> *>> swizzle_slots;
+        std::vector<std::unique_ptr<std::atomic<frame_id_type>[]>> slot_storage;
+        // The slots of a frame from this one on are not swizzled
+        std::vector<uint32_t> swizzled_end;
+        // Frame and slot of the swizzle slot which holds the frame, -1 if there is none
+        std::vector<std::pair<frame_id_type, uint32_t>> swizzled_by;
 
         // Returns the pointer in the buffer corresponding to the frame
         inline auto get_buffer_ptr(frame_id_type frameid)
@@ -31,22 +90,100 @@ namespace pinedb
             return buffer.data() + (frameid * storage_backend.page_size());
         }
 
+        // Returns the frame which holds the page, `page` is a pointer returned by `fetch_page`
+        inline frame_id_type frame_of(const uint8_t *page) const
+        {
+            return static_cast<frame_id_type>(static_cast<size_t>(page - buffer.data())
+                                              / storage_backend.page_size());
+        }
+
+        // Records that the frame holds the page, and removes the record
+        void map_page(page_id_type pageid, frame_id_type frameid);
+        void unmap_page(page_id_type pageid, frame_id_type frameid);
+
+        // Clears the swizzle slot which holds the frame
+        void unswizzle(frame_id_type frameid);
+
+        // Clears the swizzle slots of the frame
+        void unswizzle_children(frame_id_type frameid);
+
         /**
-         * Evicts a frame
+         * Evicts a frame whose latch is not held, the latch of the frame is then held until the
+         * frame is reused
          * @return true if a frame could be evicted, otherwise false
          */
         bool evict();
 
+        /**
+         * Removes a frame from the free frames, evicting a frame if there are none
+         * @return -1 if all the frames are in use
+         */
+        frame_id_type take_free_frame();
+
+        bool flush_frame(page_id_type pageid, frame_id_type frameid);
+
+        // Fetches the page with `mutex` held
+        // @return -1 if the page could not be read, otherwise its frame
+        frame_id_type fetch_frame(std::unique_lock<std::mutex> &lock, page_id_type pageid);
+
+        // Waits until the page is not being prefetched, and returns its frame
+        std::map<page_id_type, frame_id_type>::iterator
+        find_loaded(std::unique_lock<std::mutex> &lock, page_id_type pageid);
+
+        // Reads the queued pages, run by the prefetch thread
+        void prefetch_loop();
+
       public:
         BufferPool(int number_of_frames, StorageBackend &storage_backend,
                    CacheReplacer<frame_id_type> &cache_replacer);
 
+        BufferPool(const BufferPool &) = delete;
+        BufferPool &operator=(const BufferPool &) = delete;
+
+        /**
+         * Stops the prefetch thread, pages which are queued are not read
+         */
+        ~BufferPool();
+
+        // At most this fraction of the frames are used by pages which are being prefetched, so
+        // prefetching is disabled in pools with less than 4 frames
+        static constexpr int PREFETCH_FRAMES_DIVISOR = 4;
+
         /**
          * Fetches the page with the given page id
          * @return nullptr if the page is not found, otherwise a `uint8_t*` pointing to the page
          * data
          */
         uint8_t *fetch_page(page_id_type pageid);
+
+        /**
+         * Fetches the child `child_pageid` which is referenced by slot `slot` of the page
+         * `parent`, a pointer returned by `fetch_page` or `fetch_child` after which no other page
+         * was fetched. The reference is swizzled, the next fetch of the slot returns the frame of
+         * the child without taking the mutex, looking up the page table or updating the cache
+         * replacer, until the child is evicted or the parent is marked dirty. The mutex is taken
+         * while a trace hook is set, or when the latch of the child's frame is held by a writer.
+         * A modified page should be marked dirty before it is used as a parent again, as its
+         * children may have moved to other slots
+         * @return nullptr if the page is not found, otherwise a pointer to the page data
+         */
+        uint8_t *fetch_child(const uint8_t *parent, uint32_t slot, page_id_type child_pageid);
+
+        /**
+         * Starts reading the page into the pool in the background if it is not in the pool, so
+         * that it is in memory when it is fetched. It is only a hint, nothing is done if too many
+         * pages are being prefetched or if no frame can be evicted, and errors are ignored
+         * @return true if the page is in the pool or is being read
+         */
+        bool prefetch_page(page_id_type pageid);
+
+        /**
+         * Frame of the page if it is in the pool, without counting it as an access. The page can
+         * be evicted at any time, so the pointer should only be used for hints such as CPU cache
+         * prefetches
+         * @return nullptr if the page is not in the pool or is being read
+         */
+        const uint8_t *resident_page(page_id_type pageid);
         /**
          * Deletes the page with the given page id
          */
@@ -60,6 +197,21 @@ namespace pinedb
          */
         page_id_type new_page();
 
+        /**
+         * Creates a new page whose latch is held for writing, so that it cannot be evicted before
+         * it is filled, release it with `latch(page).write_unlock()`
+         * @return nullptr if the page could not be created
+         */
+        uint8_t *new_latched_page(page_id_type &pageid);
+
+        /**
+         * Latch of the frame which holds the page, `page` is a pointer returned by `fetch_page`
+         */
+        OptimisticLatch &latch(const uint8_t *page)
+        {
+            return latches[frame_of(page)];
+        }
+
         /**
          * Pins the page with the given page id, which ensures that the page
          * is not evicted before being unpinned.
@@ -76,7 +228,8 @@ namespace pinedb
 
         /**
          * Sets the page as dirty, i.e. data has been modified, this has to be called
-         * by all functions which have modified the page data.
+         * by all functions which have modified the page data. The swizzle slots of the page are
+         * cleared.
          * @return true if the page is in the buffer pool, otherwise false
          */
         bool set_dirty(page_id_type pageid);
@@ -86,6 +239,17 @@ namespace pinedb
          */
         void flush_all();
 
+        /**
+         * Sets a function which is called with the page id on every `fetch_page`, `fetch_child` and
+         * `new_page`, pass an empty function to stop tracing
+         */
+        void set_trace_hook(std::function<void(page_id_type)> hook)
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            trace_hook = std::move(hook);
+            tracing = static_cast<bool>(trace_hook);
+        }
+
         // Returns the page size of the buffer pool
         page_size_type page_size() const { return storage_backend.page_size(); }
     };
@@ -0,0 +1,125 @@
+#ifndef PINEDB_CATALOG_H
+#define PINEDB_CATALOG_H
+#include "bufferpool.h"
+#include "page.h"
+#include "record.h"
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// In memory copy of the table metadata pages. The catalog is loaded once by following the chain
+// of table metadata pages which starts at the `sys_tables` page, and every change to a table is
+// written to both the cache and the pages, so lookups never have to read a page.
+namespace pinedb
+{
+    struct TableInfo
+    {
+        std::string name;
+        // Page which holds the TableMetadataPage of this table
+        page_id_type metadata_page_id;
+        // Page which contains the records of the table, 0 if the table has no data
+        page_id_type table_page_id;
+        // Views of the interned column names, they are valid as long as the catalog is
+        std::vector<std::string_view> column_names;
+        RecordLayout layout;
+        TableStorage storage;
+    };
+
+    class Catalog
+    {
+        BufferPool &pool;
+        page_id_type sys_tables_page_id;
+        std::unordered_map<std::string, TableInfo> tables;
+        // Tables in the order of the metadata page chain
+        std::vector<const TableInfo *> table_order;
+        // Every column name is stored once, TableInfo refers to them with views
+        std::unordered_set<std::string> interned_names;
+
+        std::string_view intern(const std::string &s);
+
+        // Returns the data of a metadata page (after the page header), the pointer is valid only
+        // till the next page is fetched
+        uint8_t *fetch_metadata(page_id_type page_id);
+
+        void load();
+
+        TableInfo &find_mutable(const std::string &name);
+
+        // Writes the table information to its metadata page
+        void write_metadata(const TableInfo &info);
+
+      public:
+        static constexpr page_id_type SYS_TABLES_PAGE_ID = 0;
+        static constexpr const char *SYS_TABLES_NAME = "sys_tables";
+
+        /**
+         * Loads the catalog from the chain of metadata pages starting at `sys_tables_page_id`. If
+         * the page does not exist, a new `sys_tables` page is created (on a new disk database
+         * this is page 0)
+         * @throws std::runtime_error if the pages are not table metadata pages, or if the page
+         * size is too small to hold a table metadata page
+         */
+        explicit Catalog(BufferPool &pool, page_id_type sys_tables_page_id = SYS_TABLES_PAGE_ID);
+
+        page_id_type get_sys_tables_page_id() const { return sys_tables_page_id; }
+
+        /**
+         * @return nullptr if there is no table with the given name
+         */
+        const TableInfo *find(const std::string &name) const
+        {
+            auto iter = tables.find(name);
+            return iter == tables.end() ? nullptr : &iter->second;
+        }
+
+        /**
+         * Tables in the order in which they were created
+         */
+        const std::vector<const TableInfo *> &list_tables() const { return table_order; }
+
+        size_t number_of_tables() const { return table_order.size(); }
+
+        /**
+         * Creates a table with the given `(name, type)` columns, and appends its metadata page to
+         * the chain
+         * @throws std::runtime_error if a table with the name exists, or if the name, the columns
+         * or their types are invalid
+         */
+        const TableInfo &create_table(const std::string &name,
+                                      const std::vector<std::pair<std::string, char>> &columns,
+                                      TableStorage storage = TableStorage::ROW);
+
+        /**
+         * Removes the table from the catalog and deletes its metadata page, the pages of its
+         * records are not deleted
+         * @return false if there is no table with the name
+         */
+        bool drop_table(const std::string &name);
+
+        /**
+         * @throws std::runtime_error if there is no table with `name`, or if `new_name` is
+         * invalid or in use
+         */
+        const TableInfo &rename_table(const std::string &name, const std::string &new_name);
+
+        /**
+         * Appends a column to a table which does not have any data, since the existing records
+         * are not rewritten
+         * @throws std::runtime_error if the table does not exist, the column is invalid or if
+         * the table has data
+         */
+        const TableInfo &add_column(const std::string &name, const std::string &column_name,
+                                    char type);
+
+        /**
+         * Sets the page which contains the records of the table
+         * @throws std::runtime_error if the table does not exist
+         */
+        void set_table_page_id(const std::string &name, page_id_type page_id);
+    };
+}; // namespace pinedb
+#endif // PINEDB_CATALOG_H
@@ -0,0 +1,95 @@
+#ifndef PINEDB_CONCURRENTBTREE_H
+#define PINEDB_CONCURRENTBTREE_H
+
+#include "btree.h"
+#include "bufferpool.h"
+#include "latch.h"
+
+// B+ tree which can be used by many threads at once, using optimistic lock coupling on the
+// latches of the buffer pool frames. It uses the same pages as `BTree<Key>`, so a tree which was
+// created or bulk loaded by `BTree` can be opened by `ConcurrentBTree`, but the two should not be
+// used on the same tree at the same time.
+//
+// A lookup does not acquire any latch: it reads the version of a node, reads the node, and checks
+// that the version did not change before it follows the child, so if a node was modified or its
+// frame was evicted while it was read, the lookup starts again from the root. A writer upgrades
+// the version it read of the nodes which it modifies to an exclusive latch, which fails if the
+// node changed. Full nodes are split on the way down, so a split latches only the node and its
+// parent, and the parent always has space for the separator. Nodes are not merged when keys are
+// removed, so leaves may be left with few or no keys.
+namespace pinedb
+{
+    template <typename Key> class ConcurrentBTree
+    {
+        BufferPool &pool;
+        page_id_type root_page_id;
+        uint32_t max_internal_keys;
+
+        // A node which is read optimistically, with the version of its frame
+        struct Frame
+        {
+            page_id_type page_id;
+            uint8_t *page;
+            OptimisticLatch *latch;
+            uint64_t version;
+        };
+
+        // Fetches the node and reads its version, `restart` is set if a writer holds the latch or
+        // the frame now holds another page
+        Frame open(page_id_type page_id, bool &restart);
+
+        // Splits the latched full node into itself and a new right node, and inserts the
+        // separator into the latched parent, or moves both halves to new nodes if it is the root
+        void split(Frame *parent, Frame &node);
+
+        // Each operation is attempted until it does not have to restart
+        bool try_search(Key key, uint64_t &value, bool &found);
+
+        bool try_insert(Key key, uint64_t value, bool &inserted);
+
+        // Finds the leaf which can contain the key and latches it for writing
+        bool try_latch_leaf(Key key, Frame &leaf);
+
+      public:
+        /**
+         * Opens the tree whose root is `root_page_id`, create it with `BTree<Key>::create`
+         * @throws std::runtime_error if the page is not the root of a tree with keys of type
+         * `Key`
+         */
+        ConcurrentBTree(BufferPool &pool, page_id_type root_page_id);
+
+        page_id_type get_root_page_id() const { return root_page_id; }
+
+        /**
+         * Finds the value of the key
+         * @return false if the key is not in the tree
+         */
+        bool search(Key key, uint64_t &value);
+
+        /**
+         * Inserts the key, splitting the full nodes on the path to its leaf
+         * @return false if the key is already in the tree, the value is not changed in that case
+         * @throws std::logic_error if the key is NaN
+         * @throws std::runtime_error if a page could not be created
+         */
+        bool insert(Key key, uint64_t value);
+
+        /**
+         * Changes the value of a key which is in the tree
+         * @return false if the key is not in the tree
+         */
+        bool update(Key key, uint64_t value);
+
+        /**
+         * Removes the key from its leaf, the leaf is not merged with its siblings
+         * @return false if the key is not in the tree
+         */
+        bool remove(Key key);
+
+        /**
+         * Number of levels in the tree, 1 if the root is a leaf
+         */
+        int height();
+    };
+}; // namespace pinedb
+#endif // PINEDB_CONCURRENTBTREE_H
@@ -14,16 +14,36 @@
  */
 #ifndef A_DATAPACKER_H
 #define A_DATAPACKER_H
+#include <algorithm>
+#include <array>
 #include <inttypes.h>
 #include <istream>
+#include <limits>
 #include <ostream>
 #include <stddef.h>
+#include <stdexcept>
 #include <stdint.h>
 #include <string.h>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <utility>
 #include <vector>
+#if defined(_MSC_VER)
+#    include <stdlib.h>
+#endif
+
+// SIMD kernels used to byte swap arrays, x86 kernels are selected at runtime based on the CPU,
+// NEON is always available on aarch64. Define DATAPACKER_NO_SIMD to use the scalar loops only
+#if !defined(DATAPACKER_NO_SIMD)
+#    if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#        define DATAPACKER_X86_SIMD
+#        include <immintrin.h>
+#    elif defined(__aarch64__) && defined(__ARM_NEON)
+#        define DATAPACKER_NEON
+#        include <arm_neon.h>
+#    endif
+#endif
 
 namespace datapacker
 {
@@ -68,6 +88,411 @@ namespace datapacker
         template <unsigned bits, unsigned expbits> uint64_t pack754(long double f);
 
         template <unsigned bits, unsigned expbits> long double unpack754(uint64_t i);
+
+// Detect the byte order of the host at compile time, if it cannot be determined (or if
+// DATAPACKER_NO_ENDIAN_FAST_PATH is defined), the portable byte by byte encoders are used
+#if !defined(DATAPACKER_NO_ENDIAN_FAST_PATH)
+#    if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)                               \
+        && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#        define DATAPACKER_HOST_LITTLE_ENDIAN
+#    elif defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__)                                \
+        && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#        define DATAPACKER_HOST_BIG_ENDIAN
+#    elif defined(_MSC_VER)                                                                        \
+        && (defined(_M_IX86) || defined(_M_X64) || defined(_M_ARM) || defined(_M_ARM64))
+#        define DATAPACKER_HOST_LITTLE_ENDIAN
+#    endif
+#endif
+
+#if defined(DATAPACKER_HOST_LITTLE_ENDIAN)
+        constexpr bool host_endian_known = true;
+        constexpr endian host_endian = endian::little;
+#elif defined(DATAPACKER_HOST_BIG_ENDIAN)
+        constexpr bool host_endian_known = true;
+        constexpr endian host_endian = endian::big;
+#else
+        constexpr bool host_endian_known = false;
+        constexpr endian host_endian = endian::little;
+#endif
+
+        // On IEEE-754 platforms floats and doubles are encoded by reinterpreting their bits, the
+        // portable pack754/unpack754 is used otherwise (or if DATAPACKER_NO_FLOAT_FAST_PATH is
+        // defined)
+#if !defined(DATAPACKER_NO_FLOAT_FAST_PATH)
+        constexpr bool float_is_iec559
+            = std::numeric_limits<float>::is_iec559 && sizeof(float) == sizeof(uint32_t);
+        constexpr bool double_is_iec559
+            = std::numeric_limits<double>::is_iec559 && sizeof(double) == sizeof(uint64_t);
+#else
+        constexpr bool float_is_iec559 = false;
+        constexpr bool double_is_iec559 = false;
+#endif
+
+        template <size_t N> struct uint_of_size;
+
+        template <> struct uint_of_size<2>
+        {
+            using type = uint16_t;
+        };
+
+        template <> struct uint_of_size<4>
+        {
+            using type = uint32_t;
+        };
+
+        template <> struct uint_of_size<8>
+        {
+            using type = uint64_t;
+        };
+
+        inline uint16_t byteswap(uint16_t value)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            return __builtin_bswap16(value);
+#elif defined(_MSC_VER)
+            return _byteswap_ushort(value);
+#else
+            return static_cast<uint16_t>((value >> 8) | (value << 8));
+#endif
+        }
+
+        inline uint32_t byteswap(uint32_t value)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            return __builtin_bswap32(value);
+#elif defined(_MSC_VER)
+            return _byteswap_ulong(value);
+#else
+            return ((value & 0xFF000000u) >> 24) | ((value & 0x00FF0000u) >> 8)
+                   | ((value & 0x0000FF00u) << 8) | ((value & 0x000000FFu) << 24);
+#endif
+        }
+
+        inline uint64_t byteswap(uint64_t value)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            return __builtin_bswap64(value);
+#elif defined(_MSC_VER)
+            return _byteswap_uint64(value);
+#else
+            return (static_cast<uint64_t>(byteswap(static_cast<uint32_t>(value))) << 32)
+                   | byteswap(static_cast<uint32_t>(value >> 32));
+#endif
+        }
+
+        /**
+         * Stores `value` in the buffer with the given byte order using a single (unaligned) store,
+         * and a byte swap if the host has the other byte order. Only used if `host_endian_known`
+         */
+        template <endian endianness, typename T> inline void store(uint8_t *buffer, T value)
+        {
+            typename uint_of_size<sizeof(T)>::type val;
+            memcpy(&val, &value, sizeof(T));
+            if constexpr (endianness != host_endian)
+                val = byteswap(val);
+            memcpy(buffer, &val, sizeof(T));
+        }
+
+        /**
+         * Loads a value stored with the given byte order from the buffer, see `store`
+         */
+        template <endian endianness, typename T> inline void load(const uint8_t *buffer, T &value)
+        {
+            typename uint_of_size<sizeof(T)>::type val;
+            memcpy(&val, buffer, sizeof(T));
+            if constexpr (endianness != host_endian)
+                val = byteswap(val);
+            memcpy(&value, &val, sizeof(T));
+        }
+
+        /**
+         * Copies `n` values of `size` bytes each from `src` to `dst`, reversing the bytes of every
+         * value
+         */
+        template <size_t size>
+        inline void byteswap_copy_scalar(uint8_t *dst, const uint8_t *src, size_t n)
+        {
+            typename uint_of_size<size>::type val;
+            for (size_t i = 0; i < n; ++i)
+            {
+                memcpy(&val, src + i * size, size);
+                val = byteswap(val);
+                memcpy(dst + i * size, &val, size);
+            }
+        }
+
+#if defined(DATAPACKER_X86_SIMD)
+        // Shuffle control which reverses the bytes of every `size` byte value, pshufb only uses
+        // the low 4 bits of each index, so the same mask works for both 128 bit lanes of AVX2
+        template <size_t size> struct byteswap_shuffle_mask
+        {
+            uint8_t bytes[32];
+
+            constexpr byteswap_shuffle_mask() : bytes()
+            {
+                for (size_t i = 0; i < 32; ++i)
+                    bytes[i] = static_cast<uint8_t>((i / size) * size + (size - 1 - i % size));
+            }
+        };
+
+        template <size_t size>
+        __attribute__((target("ssse3"))) inline void
+        byteswap_copy_ssse3(uint8_t *dst, const uint8_t *src, size_t n)
+        {
+            constexpr byteswap_shuffle_mask<size> shuffle;
+            const __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i *>(shuffle.bytes));
+            size_t nbytes = n * size;
+            size_t i = 0;
+            for (; i + 16 <= nbytes; i += 16)
+            {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_shuffle_epi8(v, mask));
+            }
+            byteswap_copy_scalar<size>(dst + i, src + i, (nbytes - i) / size);
+        }
+
+        template <size_t size>
+        __attribute__((target("avx2"))) inline void
+        byteswap_copy_avx2(uint8_t *dst, const uint8_t *src, size_t n)
+        {
+            constexpr byteswap_shuffle_mask<size> shuffle;
+            const __m256i mask
+                = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(shuffle.bytes));
+            size_t nbytes = n * size;
+            size_t i = 0;
+            for (; i + 32 <= nbytes; i += 32)
+            {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                                    _mm256_shuffle_epi8(v, mask));
+            }
+            byteswap_copy_scalar<size>(dst + i, src + i, (nbytes - i) / size);
+        }
+
+        enum class simd_level
+        {
+            scalar = 0,
+            ssse3 = 1,
+            avx2 = 2
+        };
+
+        // The CPU is queried only once
+        inline simd_level cpu_simd_level()
+        {
+            static const simd_level level = __builtin_cpu_supports("avx2")    ? simd_level::avx2
+                                            : __builtin_cpu_supports("ssse3") ? simd_level::ssse3
+                                                                              : simd_level::scalar;
+            return level;
+        }
+#endif
+
+#if defined(DATAPACKER_NEON)
+        template <size_t size>
+        inline void byteswap_copy_neon(uint8_t *dst, const uint8_t *src, size_t n)
+        {
+            size_t nbytes = n * size;
+            size_t i = 0;
+            for (; i + 16 <= nbytes; i += 16)
+            {
+                uint8x16_t v = vld1q_u8(src + i);
+                if constexpr (size == 2)
+                    v = vrev16q_u8(v);
+                else if constexpr (size == 4)
+                    v = vrev32q_u8(v);
+                else
+                    v = vrev64q_u8(v);
+                vst1q_u8(dst + i, v);
+            }
+            byteswap_copy_scalar<size>(dst + i, src + i, (nbytes - i) / size);
+        }
+#endif
+
+        /**
+         * Copies `n` values of `size` bytes each from `src` to `dst`, reversing the bytes of every
+         * value, using the widest SIMD instructions supported by the CPU
+         */
+        template <size_t size> inline void byteswap_copy(uint8_t *dst, const uint8_t *src, size_t n)
+        {
+#if defined(DATAPACKER_X86_SIMD)
+            switch (cpu_simd_level())
+            {
+            case simd_level::avx2:
+                return byteswap_copy_avx2<size>(dst, src, n);
+            case simd_level::ssse3:
+                return byteswap_copy_ssse3<size>(dst, src, n);
+            default:
+                return byteswap_copy_scalar<size>(dst, src, n);
+            }
+#elif defined(DATAPACKER_NEON)
+            byteswap_copy_neon<size>(dst, src, n);
+#else
+            byteswap_copy_scalar<size>(dst, src, n);
+#endif
+        }
+
+        /**
+         * True if an array of T can be encoded/decoded as a block of memory, with a byte swap of
+         * every value if the host byte order is different from the encoded byte order
+         */
+        template <typename T>
+        constexpr bool is_bulk_codable
+            = (std::is_integral<T>::value
+               && (sizeof(T) == 1
+                   || (host_endian_known && (sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8))))
+              || (host_endian_known && is_float<T>::value && float_is_iec559)
+              || (host_endian_known && is_double<T>::value && double_is_iec559);
+
+        // Integers are encoded in the requested byte order, floats and doubles are always little
+        // endian
+        template <endian endianness, typename T>
+        constexpr endian encoded_byte_order
+            = std::is_integral<T>::value ? endianness : endian::little;
+
+        // Maps signed integers to unsigned integers so that values with a small magnitude have
+        // a small encoding, 0 -> 0, -1 -> 1, 1 -> 2, -2 -> 3 ...
+        inline uint64_t zigzag_encode(int64_t value)
+        {
+            return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+        }
+
+        inline int64_t zigzag_decode(uint64_t value)
+        {
+            return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+        }
+
+        // Converts an integer to the unsigned value which is written as a varint, signed
+        // integers are zigzag encoded
+        template <typename T> inline uint64_t to_varint_value(T value)
+        {
+            if constexpr (std::is_signed<T>::value)
+                return zigzag_encode(static_cast<int64_t>(value));
+            else
+                return static_cast<uint64_t>(value);
+        }
+
+        template <typename T> inline T from_varint_value(uint64_t value)
+        {
+            if constexpr (std::is_signed<T>::value)
+                return static_cast<T>(zigzag_decode(value));
+            else
+                return static_cast<T>(value);
+        }
+
+        // Number of bits needed to represent value, 0 for 0
+        inline unsigned bit_width(uint64_t value)
+        {
+            unsigned bits = 0;
+            while (value)
+            {
+                ++bits;
+                value >>= 1;
+            }
+            return bits;
+        }
+
+        inline uint64_t read_u64_le(const uint8_t *buffer)
+        {
+            uint64_t value = 0;
+            if constexpr (host_endian_known)
+            {
+                load<endian::little>(buffer, value);
+            }
+            else
+            {
+                for (int i = 7; i >= 0; --i)
+                    value = (value << 8) | buffer[i];
+            }
+            return value;
+        }
+
+        // Number of values in a block which is decoded by the unrolled frame of reference decoder
+        constexpr size_t FOR_BLOCK_LENGTH = 128;
+
+        /**
+         * Unpacks 128 values of `bits` bits each, 128 * bits is always a multiple of 64, so the
+         * packed data is read one 64 bit word at a time
+         */
+        template <unsigned bits> inline void unpack_block(const uint8_t *src, uint64_t *out)
+        {
+            if constexpr (bits == 0)
+            {
+                for (size_t i = 0; i < FOR_BLOCK_LENGTH; ++i)
+                    out[i] = 0;
+            }
+            else
+            {
+                uint64_t words[2 * bits];
+                for (unsigned k = 0; k < 2 * bits; ++k)
+                    words[k] = read_u64_le(src + 8 * k);
+                constexpr uint64_t mask = bits == 64 ? ~0ULL : (1ULL << bits) - 1;
+                for (unsigned i = 0; i < FOR_BLOCK_LENGTH; ++i)
+                {
+                    const unsigned offset = i * bits;
+                    const unsigned word = offset / 64;
+                    const unsigned shift = offset % 64;
+                    uint64_t value = words[word] >> shift;
+                    if (shift + bits > 64)
+                        value |= words[word + 1] << (64 - shift);
+                    out[i] = value & mask;
+                }
+            }
+        }
+
+        using unpack_block_function = void (*)(const uint8_t *, uint64_t *);
+
+        template <size_t... bits>
+        constexpr std::array<unpack_block_function, sizeof...(bits)>
+        make_unpack_block_table(std::index_sequence<bits...>)
+        {
+            return {&unpack_block<bits>...};
+        }
+
+        // unpack_block_table[b] unpacks a block of values which are `b` bits wide
+        inline constexpr auto unpack_block_table
+            = make_unpack_block_table(std::make_index_sequence<65>{});
+
+        // Packs `n` values of `bits` bits each into `dst`, least significant bit first
+        inline void pack_bits(uint8_t *dst, const uint64_t *values, size_t n, unsigned bits)
+        {
+            memset(dst, 0, (n * bits + 7) / 8);
+            size_t bit_position = 0;
+            for (size_t i = 0; i < n; ++i)
+            {
+                uint64_t value = values[i];
+                unsigned remaining = bits;
+                while (remaining > 0)
+                {
+                    unsigned byte_offset = bit_position % 8;
+                    unsigned take = std::min(8 - byte_offset, remaining);
+                    dst[bit_position / 8] |= static_cast<uint8_t>(
+                        (value & ((1u << take) - 1)) << byte_offset);
+                    value >>= take;
+                    remaining -= take;
+                    bit_position += take;
+                }
+            }
+        }
+
+        // Unpacks `n` values of `bits` bits each from `src`, the counterpart of pack_bits
+        inline void unpack_bits(const uint8_t *src, uint64_t *values, size_t n, unsigned bits)
+        {
+            size_t bit_position = 0;
+            for (size_t i = 0; i < n; ++i)
+            {
+                uint64_t value = 0;
+                unsigned filled = 0;
+                while (filled < bits)
+                {
+                    unsigned byte_offset = bit_position % 8;
+                    unsigned take = std::min(8 - byte_offset, bits - filled);
+                    uint64_t chunk = (src[bit_position / 8] >> byte_offset) & ((1u << take) - 1);
+                    value |= chunk << filled;
+                    filled += take;
+                    bit_position += take;
+                }
+                values[i] = value;
+            }
+        }
     } // namespace internal
 
     /**
@@ -92,8 +517,16 @@ namespace datapacker
 
         inline int encode_float(uint8_t *buffer, float f)
         {
-            uint64_t encoded = internal::pack754<32, 8>(f);
-            uint32_t result = static_cast<uint32_t>(encoded & 0xFFFFFFFF);
+            uint32_t result;
+            if constexpr (internal::float_is_iec559)
+            {
+                memcpy(&result, &f, sizeof(float));
+            }
+            else
+            {
+                uint64_t encoded = internal::pack754<32, 8>(f);
+                result = static_cast<uint32_t>(encoded & 0xFFFFFFFF);
+            }
             encode_le(buffer, result);
             return sizeof(float);
         }
@@ -107,7 +540,11 @@ namespace datapacker
          */
         inline int encode_double(uint8_t *buffer, double f)
         {
-            uint64_t encoded = internal::pack754<64, 11>(f);
+            uint64_t encoded;
+            if constexpr (internal::double_is_iec559)
+                memcpy(&encoded, &f, sizeof(double));
+            else
+                encoded = internal::pack754<64, 11>(f);
             encode_le(buffer, encoded);
             return sizeof(double);
         }
@@ -123,7 +560,10 @@ namespace datapacker
         {
             uint32_t i;
             decode_le(buffer, i);
-            f = static_cast<float>(internal::unpack754<32, 8>(static_cast<uint64_t>(i)));
+            if constexpr (internal::float_is_iec559)
+                memcpy(&f, &i, sizeof(float));
+            else
+                f = static_cast<float>(internal::unpack754<32, 8>(static_cast<uint64_t>(i)));
             return sizeof(float);
         }
 
@@ -138,7 +578,10 @@ namespace datapacker
         {
             uint64_t i;
             decode_le(buffer, i);
-            f = static_cast<double>(internal::unpack754<64, 11>(i));
+            if constexpr (internal::double_is_iec559)
+                memcpy(&f, &i, sizeof(double));
+            else
+                f = static_cast<double>(internal::unpack754<64, 11>(i));
             return sizeof(double);
         }
 
@@ -161,6 +604,11 @@ namespace datapacker
         {
             static_assert(std::is_integral<T>::value);
             static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+            if constexpr (internal::host_endian_known && sizeof(T) > 1)
+            {
+                internal::store<endian::big>(buffer, value);
+                return sizeof(T);
+            }
             buffer[0] = static_cast<uint8_t>((value >> (8 * sizeof(T) - 8)) & 0xFF);
             if constexpr (sizeof(T) >= 2)
             {
@@ -200,6 +648,11 @@ namespace datapacker
         {
             static_assert(std::is_integral<T>::value);
             static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+            if constexpr (internal::host_endian_known && sizeof(T) > 1)
+            {
+                internal::store<endian::little>(buffer, value);
+                return sizeof(T);
+            }
             buffer[0] = static_cast<uint8_t>(value & 0xFF);
             if constexpr (sizeof(T) >= 2)
             {
@@ -241,6 +694,11 @@ namespace datapacker
         {
             static_assert(std::is_integral<T>::value);
             static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+            if constexpr (internal::host_endian_known && sizeof(T) > 1)
+            {
+                internal::load<endian::little>(buffer, value);
+                return sizeof(T);
+            }
             // Perform the decoding in unsigned type only, then convert it to the type of T
             using uT = std::make_unsigned_t<T>;
             uT val = 0;
@@ -287,6 +745,11 @@ namespace datapacker
         {
             static_assert(std::is_integral<T>::value);
             static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+            if constexpr (internal::host_endian_known && sizeof(T) > 1)
+            {
+                internal::load<endian::big>(buffer, value);
+                return sizeof(T);
+            }
             // Perform the decoding in unsigned type only, then convert it to the type of T
             using uT = std::make_unsigned_t<T>;
             uT val = 0;
@@ -337,8 +800,9 @@ namespace datapacker
         template <typename T, typename... Args>
         inline int encode_le(uint8_t *buffer, T value, Args... args)
         {
-            auto nbytes = encode_le(buffer, value);
-            return nbytes + encode_le(buffer + sizeof(T), args...);
+            int nbytes = encode_le(buffer, value);
+            ((nbytes += encode_le(buffer + nbytes, args)), ...);
+            return nbytes;
         }
 
         /**
@@ -355,8 +819,9 @@ namespace datapacker
         template <typename T, typename... Args>
         inline int encode_be(uint8_t *buffer, T value, Args... args)
         {
-            auto nbytes = encode_be(buffer, value);
-            return nbytes + encode_be(buffer + sizeof(T), args...);
+            int nbytes = encode_be(buffer, value);
+            ((nbytes += encode_be(buffer + nbytes, args)), ...);
+            return nbytes;
         }
 
         /**
@@ -374,8 +839,9 @@ namespace datapacker
         template <typename T, typename... Args>
         inline int decode_le(uint8_t *buffer, T &value, Args &...args)
         {
-            auto nbytes = decode_le(buffer, value);
-            return nbytes + decode_le(buffer + sizeof(T), args...);
+            int nbytes = decode_le(buffer, value);
+            ((nbytes += decode_le(buffer + nbytes, args)), ...);
+            return nbytes;
         }
 
         /**
@@ -394,8 +860,9 @@ namespace datapacker
         template <typename T, typename... Args>
         inline int decode_be(uint8_t *buffer, T &value, Args &...args)
         {
-            auto nbytes = decode_be(buffer, value);
-            return nbytes + decode_be(buffer + sizeof(T), args...);
+            int nbytes = decode_be(buffer, value);
+            ((nbytes += decode_be(buffer + nbytes, args)), ...);
+            return nbytes;
         }
 
         /**
@@ -474,15 +941,89 @@ namespace datapacker
         template <endian endianness, typename T, typename... Args>
         inline int encode(uint8_t *buffer, T value, Args... args)
         {
-            auto nbytes = encode<endianness, T>(buffer, value);
-            return nbytes + encode<endianness>(buffer + sizeof(T), args...);
+            int nbytes = encode<endianness, T>(buffer, value);
+            ((nbytes += encode<endianness>(buffer + nbytes, args)), ...);
+            return nbytes;
         }
 
         template <endian endianness, typename T, typename... Args>
         inline int decode(uint8_t *buffer, T &value, Args &...args)
         {
-            auto nbytes = decode<endianness, T>(buffer, value);
-            return nbytes + decode<endianness>(buffer + sizeof(T), args...);
+            int nbytes = decode<endianness, T>(buffer, value);
+            ((nbytes += decode<endianness>(buffer + nbytes, args)), ...);
+            return nbytes;
+        }
+
+        /**
+         * @brief Encodes `n` elements of an array into a buffer, without a length prefix
+         *
+         * Integers, floats and doubles are copied as a single block when the encoded byte order is
+         * the same as the byte order of the host, otherwise the bytes of every element are swapped
+         * using SIMD instructions where available. Other types are encoded element by element.
+         * @tparam endianness The endianness to use for encoding
+         * @tparam T The type of the elements in the array
+         * @param buffer The buffer where the encoded data will be stored
+         * @param arr The array of elements to encode
+         * @param n The number of elements in the array
+         * @return The total number of bytes written to the buffer
+         * @note buffer should be of size atleast equal to `sizeof(T) * n`
+         */
+        template <endian endianness, typename T>
+        inline int encode_array(uint8_t *buffer, const T *arr, size_t n)
+        {
+            using uT = std::remove_cv_t<T>;
+            if constexpr (internal::is_bulk_codable<uT>)
+            {
+                if (n == 0)
+                    return 0;
+                if constexpr (sizeof(T) == 1
+                              || internal::encoded_byte_order<endianness, uT>
+                                     == internal::host_endian)
+                    memcpy(buffer, arr, n * sizeof(T));
+                else
+                    internal::byteswap_copy<sizeof(T)>(
+                        buffer, reinterpret_cast<const uint8_t *>(arr), n);
+            }
+            else
+            {
+                for (size_t i = 0; i < n; ++i)
+                    encode<endianness, uT>(buffer + i * sizeof(T), arr[i]);
+            }
+            return static_cast<int>(n * sizeof(T));
+        }
+
+        /**
+         * @brief Decodes `n` elements of an array from a buffer, the counterpart of
+         * `encode_array`
+         * @tparam endianness The endianness of the data
+         * @tparam T The type of the elements in the array
+         * @param buffer The buffer containing the encoded elements
+         * @param arr Pointer to the array where the decoded elements will be stored
+         * @param n The number of elements to decode
+         * @return The total number of bytes read from the buffer
+         * @note buffer should be of size atleast equal to `sizeof(T) * n`
+         */
+        template <endian endianness, typename T>
+        inline int decode_array(uint8_t *buffer, T *arr, size_t n)
+        {
+            if constexpr (internal::is_bulk_codable<T>)
+            {
+                if (n == 0)
+                    return 0;
+                if constexpr (sizeof(T) == 1
+                              || internal::encoded_byte_order<endianness, T>
+                                     == internal::host_endian)
+                    memcpy(arr, buffer, n * sizeof(T));
+                else
+                    internal::byteswap_copy<sizeof(T)>(reinterpret_cast<uint8_t *>(arr), buffer,
+                                                       n);
+            }
+            else
+            {
+                for (size_t i = 0; i < n; ++i)
+                    decode<endianness, T>(buffer + i * sizeof(T), arr[i]);
+            }
+            return static_cast<int>(n * sizeof(T));
         }
 
         /**
@@ -501,15 +1042,7 @@ namespace datapacker
         inline int encode_length_prefixed(uint8_t *buffer, T *arr, U n)
         {
             encode<endianness, U>(buffer, n);
-
-            buffer += sizeof(U);
-
-            for (U i = 0; i < n; ++i)
-            {
-                encode<endianness, T>(buffer, arr[i]);
-                buffer += sizeof(T);
-            }
-            return sizeof(U) + static_cast<int>(n * sizeof(T));
+            return sizeof(U) + encode_array<endianness>(buffer + sizeof(U), arr, n);
         }
 
         /**
@@ -535,14 +1068,7 @@ namespace datapacker
                 return -1;
             }
 
-            buffer += sizeof(U);
-
-            for (U i = 0; i < arr_length; ++i)
-            {
-                decode<endianness, T>(buffer, arr[i]);
-                buffer += sizeof(T);
-            }
-            return sizeof(U) + static_cast<int>(arr_length * sizeof(T));
+            return sizeof(U) + decode_array<endianness>(buffer + sizeof(U), arr, arr_length);
         }
 
         /**
@@ -626,6 +1152,319 @@ namespace datapacker
             v = std::move(vec);
             return bytes_read;
         }
+
+        /**
+         * @brief Decodes a length-prefixed string without copying it, the view points into
+         * `buffer`
+         * @tparam endianness Endianness of the length in the buffer
+         * @param buffer The buffer containing the length-prefixed string to decode
+         * @param buffer_size Number of bytes which can be read from `buffer`
+         * @param s View which is set to the characters of the string
+         * @return The total number of bytes read from the buffer, or -1 if the string does not fit
+         * in `buffer_size`
+         * @note The view is valid only as long as `buffer` is not modified or freed
+         */
+        template <endian endianness>
+        inline int decode_length_prefixed_view(uint8_t *buffer, size_t buffer_size,
+                                               std::string_view &s)
+        {
+            size_t sz = 0;
+            if (buffer_size < sizeof(size_t))
+                return -1;
+            decode<endianness>(buffer, sz);
+            if (sz > buffer_size - sizeof(size_t))
+                return -1;
+            s = std::string_view(reinterpret_cast<const char *>(buffer + sizeof(size_t)), sz);
+            return static_cast<int>(sizeof(size_t) + sz);
+        }
+
+        /**
+         * @brief A read only view over `n` encoded values of type `T` in a buffer. Elements are
+         * decoded when they are accessed, so the buffer does not have to be aligned
+         */
+        template <endian endianness, typename T> class array_view
+        {
+          public:
+            array_view() = default;
+
+            array_view(uint8_t *data, size_t n) : encoded(data), n(n) {}
+
+            size_t size() const { return n; }
+
+            bool empty() const { return n == 0; }
+
+            /**
+             * Pointer to the encoded bytes of the first element
+             */
+            uint8_t *data() const { return encoded; }
+
+            T operator[](size_t i) const
+            {
+                T value;
+                decode<endianness>(encoded + i * sizeof(T), value);
+                return value;
+            }
+
+            /**
+             * Decodes all the elements into `arr`, which should have space for `size()` elements
+             */
+            void copy_to(T *arr) const { decode_array<endianness>(encoded, arr, n); }
+
+          private:
+            uint8_t *encoded = nullptr;
+            size_t n = 0;
+        };
+
+        /**
+         * @brief Decodes a length-prefixed array written by `encode_length_prefixed` without
+         * copying it
+         * @param buffer The buffer containing the length-prefixed array to decode
+         * @param buffer_size Number of bytes which can be read from `buffer`
+         * @param v View which is set to the elements of the array
+         * @return The total number of bytes read from the buffer, or -1 if the array does not fit
+         * in `buffer_size`
+         */
+        template <endian endianness, typename T>
+        inline int decode_length_prefixed_view(uint8_t *buffer, size_t buffer_size,
+                                               array_view<endianness, T> &v)
+        {
+            static_assert(std::is_arithmetic<T>::value);
+            size_t sz = 0;
+            if (buffer_size < sizeof(size_t))
+                return -1;
+            decode<endianness>(buffer, sz);
+            if (sz > (buffer_size - sizeof(size_t)) / sizeof(T))
+                return -1;
+            v = array_view<endianness, T>(buffer + sizeof(size_t), sz);
+            return static_cast<int>(sizeof(size_t) + sz * sizeof(T));
+        }
+
+        /**
+         * Maximum number of bytes used by `encode_varint` to encode a value of type `T`
+         */
+        template <typename T> constexpr int max_varint_length = (8 * sizeof(T) + 6) / 7;
+
+        /**
+         * @brief Returns the number of bytes used by `encode_varint` to encode `value`
+         */
+        template <typename T> inline int varint_length(T value)
+        {
+            static_assert(std::is_integral<T>::value);
+            uint64_t val = internal::to_varint_value(value);
+            int length = 1;
+            while (val >= 0x80)
+            {
+                val >>= 7;
+                ++length;
+            }
+            return length;
+        }
+
+        /**
+         * @brief Encodes an integer as a LEB128 varint, 7 bits are stored in every byte, and the
+         * high bit is set on all bytes except the last one. Signed integers are zigzag encoded
+         * first, so that negative numbers with a small magnitude also have a short encoding
+         * @param buffer Pointer to buffer which will be used to store the encoded data
+         * @param value Value to be encoded
+         * @return Number of bytes written to the buffer
+         * @note `buffer` should have size atleast equal to `max_varint_length<T>`
+         *
+         * Example usage:
+         * @code
+         * uint8_t buffer[max_varint_length<uint32_t>];
+         * encode_varint(buffer, 300u); // writes 0xAC 0x02
+         * @endcode
+         */
+        template <typename T> inline int encode_varint(uint8_t *buffer, T value)
+        {
+            static_assert(std::is_integral<T>::value);
+            uint64_t val = internal::to_varint_value(value);
+            int length = 0;
+            while (val >= 0x80)
+            {
+                buffer[length++] = static_cast<uint8_t>(val | 0x80);
+                val >>= 7;
+            }
+            buffer[length++] = static_cast<uint8_t>(val);
+            return length;
+        }
+
+        /**
+         * @brief Decodes a varint written by `encode_varint`
+         * @param buffer Pointer to buffer which contains the encoded data
+         * @param value Where the decoded value will be stored
+         * @return Number of bytes read from the buffer, or -1 if the encoded value is longer than
+         * `max_varint_length<T>` bytes or does not fit in `T`
+         */
+        template <typename T> inline int decode_varint(uint8_t *buffer, T &value)
+        {
+            static_assert(std::is_integral<T>::value);
+            // Values are decoded as uint64_t, then range checked for narrower types
+            uint64_t val = 0;
+            int length = 0;
+            unsigned shift = 0;
+            while (true)
+            {
+                if (length == max_varint_length<T>)
+                    return -1;
+                uint8_t byte = buffer[length++];
+                uint64_t chunk = byte & 0x7F;
+                if (shift == 63 && chunk > 1)
+                    return -1;
+                val |= chunk << shift;
+                if (!(byte & 0x80))
+                    break;
+                shift += 7;
+            }
+            if constexpr (sizeof(T) < sizeof(uint64_t))
+            {
+                if (val >> (8 * sizeof(T)) != 0)
+                    return -1;
+            }
+            value = internal::from_varint_value<T>(val);
+            return length;
+        }
+
+        /**
+         * @brief Encodes `n` values as varints of the difference between each value and the
+         * previous one (the first value is stored as is). Differences are zigzag encoded, so the
+         * values need not be sorted, but sorted or clustered values give the smallest output
+         * @param buffer Pointer to buffer which will be used to store the encoded data
+         * @param values Values to be encoded
+         * @param n Number of values
+         * @return Number of bytes written to the buffer
+         * @note `buffer` should have size atleast equal to `n * max_varint_length<uint64_t>`
+         */
+        template <typename T>
+        inline int encode_delta_block(uint8_t *buffer, const T *values, size_t n)
+        {
+            static_assert(std::is_integral<T>::value);
+            int length = 0;
+            uint64_t previous = 0;
+            for (size_t i = 0; i < n; ++i)
+            {
+                // The difference is computed with wraparound, which is undone when decoding
+                uint64_t current = static_cast<uint64_t>(values[i]);
+                int64_t delta = static_cast<int64_t>(current - previous);
+                length += encode_varint(buffer + length, delta);
+                previous = current;
+            }
+            return length;
+        }
+
+        /**
+         * @brief Decodes `n` values written by `encode_delta_block`
+         * @return Number of bytes read from the buffer, or -1 if the data is malformed
+         */
+        template <typename T> inline int decode_delta_block(uint8_t *buffer, T *values, size_t n)
+        {
+            static_assert(std::is_integral<T>::value);
+            int length = 0;
+            uint64_t previous = 0;
+            for (size_t i = 0; i < n; ++i)
+            {
+                int64_t delta;
+                int bytes_read = decode_varint(buffer + length, delta);
+                if (bytes_read == -1)
+                    return -1;
+                length += bytes_read;
+                previous += static_cast<uint64_t>(delta);
+                values[i] = static_cast<T>(previous);
+            }
+            return length;
+        }
+
+        /**
+         * @brief Returns the number of bytes used by `encode_for_block` to encode `values`
+         */
+        template <typename T> inline int for_block_length(const T *values, size_t n)
+        {
+            if (n == 0)
+                return 0;
+            auto [min, max] = std::minmax_element(values, values + n);
+            uint64_t range = static_cast<uint64_t>(*max) - static_cast<uint64_t>(*min);
+            return varint_length(*min) + 1
+                   + static_cast<int>((n * internal::bit_width(range) + 7) / 8);
+        }
+
+        /**
+         * @brief Encodes `n` values using frame of reference, the smallest value is stored as a
+         * varint, followed by the number of bits `b` needed for the largest difference from it,
+         * followed by the difference of every value from the smallest, packed into `b` bits each
+         *
+         * ```
+         * | min (varint) | b (1 byte) | n * b bits, least significant bit first |
+         * ```
+         * Blocks of `FOR_BLOCK_LENGTH` (128) values are decoded with an unrolled decoder
+         * @param buffer Pointer to buffer which will be used to store the encoded data
+         * @param values Values to be encoded
+         * @param n Number of values, it is not stored in the buffer
+         * @return Number of bytes written to the buffer
+         * @note `buffer` should have size atleast equal to `for_block_length(values, n)`
+         */
+        template <typename T>
+        inline int encode_for_block(uint8_t *buffer, const T *values, size_t n)
+        {
+            static_assert(std::is_integral<T>::value);
+            if (n == 0)
+                return 0;
+            auto [min, max] = std::minmax_element(values, values + n);
+            uint64_t reference = static_cast<uint64_t>(*min);
+            unsigned bits = internal::bit_width(static_cast<uint64_t>(*max) - reference);
+
+            int length = encode_varint(buffer, *min);
+            buffer[length++] = static_cast<uint8_t>(bits);
+
+            // Values are packed 128 at a time, every block starts at a byte boundary
+            uint64_t offsets[internal::FOR_BLOCK_LENGTH];
+            for (size_t position = 0; position < n; position += internal::FOR_BLOCK_LENGTH)
+            {
+                size_t count = std::min(internal::FOR_BLOCK_LENGTH, n - position);
+                for (size_t i = 0; i < count; ++i)
+                    offsets[i] = static_cast<uint64_t>(values[position + i]) - reference;
+                internal::pack_bits(buffer + length + position * bits / 8, offsets, count, bits);
+            }
+            return length + static_cast<int>((n * bits + 7) / 8);
+        }
+
+        /**
+         * @brief Decodes `n` values written by `encode_for_block`
+         * @return Number of bytes read from the buffer, or -1 if the data is malformed
+         */
+        template <typename T> inline int decode_for_block(uint8_t *buffer, T *values, size_t n)
+        {
+            static_assert(std::is_integral<T>::value);
+            if (n == 0)
+                return 0;
+            T min;
+            int length = decode_varint(buffer, min);
+            if (length == -1)
+                return -1;
+            unsigned bits = buffer[length++];
+            if (bits > 8 * sizeof(T))
+                return -1;
+            uint64_t reference = static_cast<uint64_t>(min);
+
+            uint64_t offsets[internal::FOR_BLOCK_LENGTH];
+            size_t position = 0;
+            uint8_t *packed = buffer + length;
+            // Full blocks of 128 values start at a byte boundary, since 128 * bits is a multiple
+            // of 8
+            for (; position + internal::FOR_BLOCK_LENGTH <= n;
+                 position += internal::FOR_BLOCK_LENGTH)
+            {
+                internal::unpack_block_table[bits](packed + position * bits / 8, offsets);
+                for (size_t i = 0; i < internal::FOR_BLOCK_LENGTH; ++i)
+                    values[position + i] = static_cast<T>(reference + offsets[i]);
+            }
+            if (position < n)
+            {
+                internal::unpack_bits(packed + position * bits / 8, offsets, n - position, bits);
+                for (size_t i = 0; i < n - position; ++i)
+                    values[position + i] = static_cast<T>(reference + offsets[i]);
+            }
+            return length + static_cast<int>((n * bits + 7) / 8);
+        }
     } // namespace bytes
 
     /**
@@ -638,26 +1477,29 @@ namespace datapacker
         template <endian endianness, typename T>
         inline std::ostream &write(std::ostream &os, T value)
         {
-            std::vector<uint8_t> buffer;
-            // Allocate a buffer of necessary size
+            // Scalars are encoded on the stack, only strings and vectors need a buffer
             if constexpr (std::is_integral<T>::value || std::is_floating_point<T>::value)
             {
-                buffer.resize(sizeof(T));
-                bytes::encode<endianness>(buffer.data(), value);
+                uint8_t buffer[sizeof(T)];
+                bytes::encode<endianness>(buffer, value);
+                return os.write(reinterpret_cast<const char *>(buffer), sizeof(T));
             }
             // If T is a const string literal
             else if constexpr (std::is_same<T, const char *>::value)
             {
                 size_t str_size = strlen(value);
-                buffer.resize(sizeof(size_t) + str_size);
+                std::vector<uint8_t> buffer(sizeof(size_t) + str_size);
                 bytes::encode_length_prefixed<endianness>(buffer.data(), value, str_size);
+                return os.write(reinterpret_cast<const char *>(buffer.data()), buffer.size());
             }
             // If T is a vector or a string, also allocate memory of sizeof(size_t) for the length
             else if constexpr (std::is_same<T, std::string>::value
                                || std::is_same<T, std::vector<typename T::value_type>>::value)
             {
-                buffer.resize(sizeof(size_t) + value.size() * sizeof(typename T::value_type));
+                std::vector<uint8_t> buffer(sizeof(size_t)
+                                            + value.size() * sizeof(typename T::value_type));
                 bytes::encode_length_prefixed<endianness>(buffer.data(), value);
+                return os.write(reinterpret_cast<const char *>(buffer.data()), buffer.size());
             }
             else
             {
@@ -665,27 +1507,24 @@ namespace datapacker
                               "Invalid type passed to write, can only encode integers, real "
                               "numbers, vectors, and strings");
             }
-            return os.write(reinterpret_cast<const char *>(buffer.data()), buffer.size());
         }
 
         template <endian endianness, typename T> inline std::istream &
         read(std::istream &is, T &value, size_t max_elements = DEFAULT_MAX_NUMBER_OF_ELEMENTS)
         {
-            std::vector<uint8_t> buffer;
-            // Allocate a buffer of necessary size
             if constexpr (std::is_integral<T>::value || std::is_floating_point<T>::value)
             {
-                buffer.resize(sizeof(T));
-                is.read(reinterpret_cast<char *>(buffer.data()), buffer.size());
+                uint8_t buffer[sizeof(T)];
+                is.read(reinterpret_cast<char *>(buffer), sizeof(T));
                 if (!is)
                     return is;
-                bytes::decode<endianness>(buffer.data(), value);
+                bytes::decode<endianness>(buffer, value);
             }
             // If T is a vector or a string, also allocate memory of sizeof(size_t) for the length
             else if constexpr (std::is_same<T, std::string>::value
                                || std::is_same<T, std::vector<typename T::value_type>>::value)
             {
-                buffer.resize(sizeof(size_t));
+                std::vector<uint8_t> buffer(sizeof(size_t));
                 is.read(reinterpret_cast<char *>(buffer.data()), buffer.size());
                 if (!is)
                     return is;
@@ -717,13 +1556,470 @@ namespace datapacker
             return is;
         }
 
+        /**
+         * Writes an integer as a varint, see `bytes::encode_varint`
+         */
+        template <typename T> inline std::ostream &write_varint(std::ostream &os, T value)
+        {
+            uint8_t buffer[bytes::max_varint_length<T>];
+            int length = bytes::encode_varint(buffer, value);
+            return os.write(reinterpret_cast<const char *>(buffer), length);
+        }
+
+        /**
+         * Reads a varint written by `write_varint`, throws `std::runtime_error` if the varint is
+         * malformed
+         */
+        template <typename T> inline std::istream &read_varint(std::istream &is, T &value)
+        {
+            uint8_t buffer[bytes::max_varint_length<T>];
+            int length = 0;
+            do
+            {
+                if (length == bytes::max_varint_length<T>)
+                {
+                    throw std::runtime_error("Varint is too long, read failed");
+                }
+                auto ch = is.get();
+                if (!is)
+                    return is;
+                buffer[length++] = static_cast<uint8_t>(ch);
+            } while (buffer[length - 1] & 0x80);
+
+            if (bytes::decode_varint(buffer, value) == -1)
+            {
+                throw std::runtime_error("Varint does not fit in the type, read failed");
+            }
+            return is;
+        }
+
+        /**
+         * Writes the number of values as a varint, followed by the values encoded as deltas, see
+         * `bytes::encode_delta_block`
+         */
+        template <typename T>
+        inline std::ostream &write_delta_block(std::ostream &os, const std::vector<T> &values)
+        {
+            write_varint(os, values.size());
+            uint64_t previous = 0;
+            for (const auto value : values)
+            {
+                uint64_t current = static_cast<uint64_t>(value);
+                write_varint(os, static_cast<int64_t>(current - previous));
+                previous = current;
+            }
+            return os;
+        }
+
+        /**
+         * Reads values written by `write_delta_block`
+         */
+        template <typename T>
+        inline std::istream &read_delta_block(std::istream &is, std::vector<T> &values,
+                                              size_t max_elements = DEFAULT_MAX_NUMBER_OF_ELEMENTS)
+        {
+            size_t sz = 0;
+            if (!read_varint(is, sz))
+                return is;
+            if (sz > max_elements)
+            {
+                throw std::runtime_error(
+                    "Data contains more elements than max_elements, read failed");
+            }
+            std::vector<T> result(sz);
+            uint64_t previous = 0;
+            for (auto &value : result)
+            {
+                int64_t delta;
+                if (!read_varint(is, delta))
+                    return is;
+                previous += static_cast<uint64_t>(delta);
+                value = static_cast<T>(previous);
+            }
+            values = std::move(result);
+            return is;
+        }
+
+        /**
+         * Writes the number of values as a varint, followed by the values encoded using frame
+         * of reference, see `bytes::encode_for_block`
+         */
+        template <typename T>
+        inline std::ostream &write_for_block(std::ostream &os, const std::vector<T> &values)
+        {
+            write_varint(os, values.size());
+            std::vector<uint8_t> buffer(bytes::for_block_length(values.data(), values.size()));
+            bytes::encode_for_block(buffer.data(), values.data(), values.size());
+            return os.write(reinterpret_cast<const char *>(buffer.data()), buffer.size());
+        }
+
+        /**
+         * Reads values written by `write_for_block`
+         */
+        template <typename T>
+        inline std::istream &read_for_block(std::istream &is, std::vector<T> &values,
+                                            size_t max_elements = DEFAULT_MAX_NUMBER_OF_ELEMENTS)
+        {
+            size_t sz = 0;
+            if (!read_varint(is, sz))
+                return is;
+            if (sz > max_elements)
+            {
+                throw std::runtime_error(
+                    "Data contains more elements than max_elements, read failed");
+            }
+            if (sz == 0)
+            {
+                values.clear();
+                return is;
+            }
+            T min;
+            if (!read_varint(is, min))
+                return is;
+            auto bits = is.get();
+            if (!is)
+                return is;
+            if (static_cast<size_t>(bits) > 8 * sizeof(T))
+            {
+                throw std::runtime_error("Invalid bit width in block, read failed");
+            }
+
+            // Rebuild the block in memory, then decode it
+            std::vector<uint8_t> buffer(bytes::max_varint_length<T> + 1 + (sz * bits + 7) / 8);
+            int length = bytes::encode_varint(buffer.data(), min);
+            buffer[length++] = static_cast<uint8_t>(bits);
+            is.read(reinterpret_cast<char *>(buffer.data() + length), (sz * bits + 7) / 8);
+            if (!is)
+                return is;
+            std::vector<T> result(sz);
+            bytes::decode_for_block(buffer.data(), result.data(), sz);
+            values = std::move(result);
+            return is;
+        }
+        /**
+         * Buffered writer over an `ostream`. Values are encoded straight into a fixed size buffer,
+         * which is written to the stream in large chunks, so no memory is allocated per value.
+         * The data written is compatible with `read` and `read_varint`, and with `StreamReader`
+         * @note The buffer is flushed when the writer is destroyed, call `flush` to check for
+         * errors
+         */
+        class StreamWriter
+        {
+          public:
+            static constexpr size_t BUFFER_SIZE = 16 * 1024;
+
+            explicit StreamWriter(std::ostream &os) : os(os) {}
+
+            StreamWriter(const StreamWriter &) = delete;
+            StreamWriter &operator=(const StreamWriter &) = delete;
+
+            ~StreamWriter() { flush(); }
+
+            /**
+             * Writes an integer, real number, string or vector, in the same format as `write`
+             */
+            template <endian endianness, typename T> StreamWriter &write(const T &value)
+            {
+                if constexpr (std::is_integral<T>::value || std::is_floating_point<T>::value)
+                {
+                    position += bytes::encode<endianness>(reserve(sizeof(T)), value);
+                }
+                // Strings, string views and string literals
+                else if constexpr (std::is_convertible<const T &, std::string_view>::value)
+                {
+                    std::string_view str = value;
+                    write<endianness>(str.size());
+                    write_bytes(str.data(), str.size());
+                }
+                else if constexpr (std::is_same<T, std::vector<typename T::value_type>>::value)
+                {
+                    write<endianness>(value.size());
+                    write_array<endianness>(value.data(), value.size());
+                }
+                else
+                {
+                    static_assert(internal::False<T>{},
+                                  "Invalid type passed to write, can only encode integers, real "
+                                  "numbers, vectors, and strings");
+                }
+                return *this;
+            }
+
+            /**
+             * Writes `n` elements without a length prefix, see `bytes::encode_array`
+             */
+            template <endian endianness, typename T>
+            StreamWriter &write_array(const T *arr, size_t n)
+            {
+                // Encode as many elements as fit in the buffer at a time
+                while (n > 0)
+                {
+                    reserve(sizeof(T));
+                    size_t count = std::min(n, (BUFFER_SIZE - position) / sizeof(T));
+                    position += bytes::encode_array<endianness>(buffer + position, arr, count);
+                    arr += count;
+                    n -= count;
+                }
+                return *this;
+            }
+
+            /**
+             * Writes an integer as a varint, see `bytes::encode_varint`
+             */
+            template <typename T> StreamWriter &write_varint(T value)
+            {
+                position += bytes::encode_varint(reserve(bytes::max_varint_length<T>), value);
+                return *this;
+            }
+
+            /**
+             * Writes raw bytes, large writes bypass the buffer
+             */
+            StreamWriter &write_bytes(const void *data, size_t n)
+            {
+                if (n >= BUFFER_SIZE)
+                {
+                    flush();
+                    os.write(static_cast<const char *>(data), static_cast<std::streamsize>(n));
+                    flushed += n;
+                    return *this;
+                }
+                memcpy(reserve(n), data, n);
+                position += n;
+                return *this;
+            }
+
+            /**
+             * Writes the buffered data to the stream, but does not flush the stream itself
+             */
+            StreamWriter &flush()
+            {
+                if (position > 0)
+                {
+                    os.write(reinterpret_cast<const char *>(buffer),
+                             static_cast<std::streamsize>(position));
+                    flushed += position;
+                    position = 0;
+                }
+                return *this;
+            }
+
+            /**
+             * Total number of bytes written, including those which are still in the buffer
+             */
+            size_t bytes_written() const { return flushed + position; }
+
+            explicit operator bool() const { return static_cast<bool>(os); }
 
+          private:
+            // Returns a pointer to atleast `n` free bytes in the buffer, `n` <= BUFFER_SIZE
+            uint8_t *reserve(size_t n)
+            {
+                if (BUFFER_SIZE - position < n)
+                    flush();
+                return buffer + position;
+            }
+
+            std::ostream &os;
+            uint8_t buffer[BUFFER_SIZE];
+            size_t position = 0;
+            size_t flushed = 0;
+        };
+
+        /**
+         * Buffered reader over an `istream`, the counterpart of `StreamWriter`. Data is read from
+         * the stream in large chunks into a fixed size buffer and decoded from there.
+         * Like an `istream`, the reader converts to false once a read fails, and later reads do
+         * nothing
+         * @note The reader reads ahead, so the position of the underlying stream is past the
+         * values which have been read
+         */
+        class StreamReader
+        {
+          public:
+            static constexpr size_t BUFFER_SIZE = 16 * 1024;
+
+            explicit StreamReader(std::istream &is) : is(is) {}
+
+            StreamReader(const StreamReader &) = delete;
+            StreamReader &operator=(const StreamReader &) = delete;
+
+            /**
+             * Reads an integer, real number, string or vector written by `write` or `StreamWriter`
+             * @throws std::runtime_error if a string or vector has more than `max_elements`
+             * elements
+             */
+            template <endian endianness, typename T>
+            StreamReader &read(T &value, size_t max_elements = DEFAULT_MAX_NUMBER_OF_ELEMENTS)
+            {
+                if constexpr (std::is_integral<T>::value || std::is_floating_point<T>::value)
+                {
+                    if (fill(sizeof(T)) < sizeof(T))
+                        return fail();
+                    begin += bytes::decode<endianness>(buffer + begin, value);
+                }
+                else if constexpr (std::is_same<T, std::string>::value
+                                   || std::is_same<T, std::vector<typename T::value_type>>::value)
+                {
+                    size_t sz = 0;
+                    if (!read<endianness>(sz))
+                        return *this;
+                    if (sz > max_elements)
+                    {
+                        throw std::runtime_error(
+                            "Data contains more elements than max_elements, read failed");
+                    }
+                    T result;
+                    result.resize(sz);
+                    if (!read_array<endianness>(result.data(), sz))
+                        return *this;
+                    value = std::move(result);
+                }
+                else
+                {
+                    static_assert(internal::False<T>{},
+                                  "Invalid type passed to read, can only decode integers, real "
+                                  "numbers, vectors, and strings");
+                }
+                return *this;
+            }
+
+            /**
+             * Reads `n` elements written by `StreamWriter::write_array`
+             */
+            template <endian endianness, typename T> StreamReader &read_array(T *arr, size_t n)
+            {
+                while (n > 0)
+                {
+                    if (fill(sizeof(T)) < sizeof(T))
+                        return fail();
+                    size_t count = std::min(n, (end - begin) / sizeof(T));
+                    begin += bytes::decode_array<endianness>(buffer + begin, arr, count);
+                    arr += count;
+                    n -= count;
+                }
+                return *this;
+            }
+
+            /**
+             * Reads a length prefixed string without copying it, the view points into the buffer
+             * of the reader and is valid only until the next read
+             * @throws std::runtime_error if the string is longer than `max_length`, or if it does
+             * not fit in the buffer
+             */
+            template <endian endianness>
+            StreamReader &read_view(std::string_view &s,
+                                    size_t max_length = BUFFER_SIZE - sizeof(size_t))
+            {
+                size_t sz = 0;
+                if (!read<endianness>(sz))
+                    return *this;
+                if (sz > max_length || sz > BUFFER_SIZE)
+                {
+                    throw std::runtime_error("String is too long to be read as a view");
+                }
+                if (fill(sz) < sz)
+                    return fail();
+                s = std::string_view(reinterpret_cast<const char *>(buffer + begin), sz);
+                begin += sz;
+                return *this;
+            }
+
+            /**
+             * Reads a varint written by `StreamWriter::write_varint` or `write_varint`
+             * @throws std::runtime_error if the varint is malformed
+             */
+            template <typename T> StreamReader &read_varint(T &value)
+            {
+                size_t available = fill(bytes::max_varint_length<T>);
+                size_t length = 0;
+                while (length < available && (buffer[begin + length] & 0x80))
+                    ++length;
+                if (length == available)
+                {
+                    if (available < static_cast<size_t>(bytes::max_varint_length<T>))
+                        return fail();
+                    throw std::runtime_error("Varint is too long, read failed");
+                }
+                int bytes_read = bytes::decode_varint(buffer + begin, value);
+                if (bytes_read == -1)
+                {
+                    throw std::runtime_error("Varint does not fit in the type, read failed");
+                }
+                begin += static_cast<size_t>(bytes_read);
+                return *this;
+            }
+
+            /**
+             * Reads `n` raw bytes, large reads bypass the buffer
+             */
+            StreamReader &read_bytes(void *data, size_t n)
+            {
+                auto out = static_cast<uint8_t *>(data);
+                size_t buffered = std::min(n, end - begin);
+                memcpy(out, buffer + begin, buffered);
+                begin += buffered;
+                out += buffered;
+                n -= buffered;
+                if (n >= BUFFER_SIZE)
+                {
+                    is.read(reinterpret_cast<char *>(out), static_cast<std::streamsize>(n));
+                    if (static_cast<size_t>(is.gcount()) < n)
+                        return fail();
+                }
+                else if (n > 0)
+                {
+                    if (fill(n) < n)
+                        return fail();
+                    memcpy(out, buffer + begin, n);
+                    begin += n;
+                }
+                return *this;
+            }
+
+            explicit operator bool() const { return !failed; }
+
+          private:
+            // Makes atleast `n` bytes available in the buffer if the stream has them, `n` <=
+            // BUFFER_SIZE. Returns the number of bytes available
+            size_t fill(size_t n)
+            {
+                if (failed)
+                    return 0;
+                if (end - begin >= n)
+                    return end - begin;
+                // Move the unread bytes to the front, then read as much as fits
+                memmove(buffer, buffer + begin, end - begin);
+                end -= begin;
+                begin = 0;
+                while (end < n && is)
+                {
+                    is.read(reinterpret_cast<char *>(buffer + end),
+                            static_cast<std::streamsize>(BUFFER_SIZE - end));
+                    end += static_cast<size_t>(is.gcount());
+                }
+                return end;
+            }
+
+            StreamReader &fail()
+            {
+                failed = true;
+                return *this;
+            }
+
+            std::istream &is;
+            uint8_t buffer[BUFFER_SIZE];
+            size_t begin = 0;
+            size_t end = 0;
+            bool failed = false;
+        };
     } // namespace stream
 
     namespace internal
     {
         // Code taken from https://beej.us/guide/bgnet/source/examples/ieee754.c
-        // Does not support NaN and infinity
+        // Does not support NaN, infinity, negative zero and subnormal numbers, it is only used on
+        // platforms where float/double are not IEEE754
 
         /**
          * This function packs a double as an unsigned 64 bit integer, which can be written to a
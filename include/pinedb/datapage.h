@@ -0,0 +1,167 @@
+#ifndef PINEDB_DATAPAGE_H
+#define PINEDB_DATAPAGE_H
+#include "common.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Slotted page which stores variable length tuples. Tuples are stored after the header and grow
+// towards the end of the page, the slot directory starts at the end of the page and grows towards
+// the start. A tuple is addressed by its slot number, which does not change when the tuples are
+// moved around within the page, see BTreeDesign.md for the page format.
+namespace pinedb
+{
+    /**
+     * Identifies a row in a heap file, the slot number is stable across updates and compactions
+     */
+    struct RecordId
+    {
+        page_id_type page_id;
+        uint16_t slot;
+
+        bool operator==(const RecordId &other) const
+        {
+            return page_id == other.page_id && slot == other.slot;
+        }
+
+        bool operator!=(const RecordId &other) const { return !(*this == other); }
+
+        // Packed form used as the value in B+ tree leaf pages
+        uint64_t to_uint64() const
+        {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 16) | slot;
+        }
+
+        static RecordId from_uint64(uint64_t value)
+        {
+            return {static_cast<page_id_type>(static_cast<uint32_t>(value >> 16)),
+                    static_cast<uint16_t>(value & 0xFFFF)};
+        }
+    };
+
+    class DataPage
+    {
+        uint8_t *page;
+        page_size_type page_size;
+
+        uint16_t read_u16(size_t offset) const;
+        void write_u16(size_t offset, uint16_t value);
+
+        size_t slot_position(uint16_t slot) const
+        {
+            return static_cast<size_t>(page_size) - SLOT_SIZE * (static_cast<size_t>(slot) + 1);
+        }
+
+        uint16_t slot_offset(uint16_t slot) const { return read_u16(slot_position(slot)); }
+
+        uint16_t slot_length_and_flags(uint16_t slot) const
+        {
+            return read_u16(slot_position(slot) + 2);
+        }
+
+        void set_slot(uint16_t slot, uint16_t offset, uint16_t length_and_flags);
+
+        // Start of the slot directory, which is also the end of the free space
+        size_t free_space_end() const
+        {
+            return static_cast<size_t>(page_size) - SLOT_SIZE * number_of_slots();
+        }
+
+        uint16_t get_free_space_start() const;
+        void set_free_space_start(uint16_t offset);
+        uint16_t get_fragmented_bytes() const;
+        void set_fragmented_bytes(uint16_t bytes);
+
+        // Returns the offset of `length` contiguous free bytes, compacting the page if needed.
+        // `new_slots` is the number of slots which will be added to the directory
+        int allocate(uint16_t length, int new_slots);
+
+      public:
+        static constexpr uint8_t PAGE_TYPE = 0x44;
+        // Size of the common page header followed by the data page header
+        static constexpr int HEADER_SIZE = 32;
+        static constexpr int SLOT_SIZE = 4;
+        // Every tuple takes atleast these many bytes, so that it can be replaced with a
+        // forwarding address
+        static constexpr uint16_t MIN_TUPLE_ALLOCATION = 6;
+        // The two high bits of the length in a slot are used for flags
+        static constexpr uint16_t MAX_TUPLE_LENGTH = 0x3FFF;
+        // The tuple contains the RecordId where the row has been moved to
+        static constexpr uint16_t FLAG_FORWARDED = 0x8000;
+        // The tuple was moved here from another page, it is reachable only through the forwarding
+        // tuple, so that sequential scans do not return it twice
+        static constexpr uint16_t FLAG_MOVED_IN = 0x4000;
+        static constexpr uint16_t MAX_PAGE_SIZE = 0xFFFF;
+
+        /**
+         * `page` is the whole page, including the common page header
+         */
+        DataPage(uint8_t *page, page_size_type page_size) : page(page), page_size(page_size) {}
+
+        /**
+         * Writes the header of an empty data page
+         */
+        void init(page_id_type page_id);
+
+        uint16_t number_of_slots() const;
+
+        page_id_type get_next_page_id() const;
+
+        void set_next_page_id(page_id_type page_id);
+
+        /**
+         * First page of the free space map of the heap file, only used in the first page of the
+         * heap file
+         */
+        page_id_type get_free_space_map_page_id() const;
+
+        void set_free_space_map_page_id(page_id_type page_id);
+
+        /**
+         * Largest tuple which can be inserted into the page, after compaction
+         */
+        size_t max_insert_length() const;
+
+        /**
+         * Inserts a tuple, reusing a free slot if there is one
+         * @return slot number of the tuple, or -1 if the tuple does not fit in the page
+         */
+        int insert(const uint8_t *data, uint16_t length, uint16_t flags = 0);
+
+        /**
+         * @return false if the slot does not contain a tuple, otherwise `data` points to the tuple
+         * in the page, valid till the page is modified
+         */
+        bool get(uint16_t slot, const uint8_t *&data, uint16_t &length) const;
+
+        /**
+         * Flags of the tuple in the slot, 0 if the slot is free
+         */
+        uint16_t get_flags(uint16_t slot) const
+        {
+            if (slot >= number_of_slots())
+                return 0;
+            return slot_length_and_flags(slot) & (FLAG_FORWARDED | FLAG_MOVED_IN);
+        }
+
+        /**
+         * Replaces the tuple in place, the page is compacted if the tuple has grown and there
+         * is not enough contiguous space
+         * @return false if the slot is free or if the tuple does not fit, the page is not
+         * modified in that case
+         */
+        bool update(uint16_t slot, const uint8_t *data, uint16_t length, uint16_t flags = 0);
+
+        /**
+         * Frees the slot, the space used by the tuple is reclaimed by the next compaction
+         */
+        bool remove(uint16_t slot);
+
+        /**
+         * Moves all the tuples together to the start of the page, so that the free space is
+         * contiguous. Slot numbers do not change
+         */
+        void compact();
+    };
+}; // namespace pinedb
+#endif // PINEDB_DATAPAGE_H
@@ -0,0 +1,150 @@
+#ifndef PINEDB_DICTIONARY_H
+#define PINEDB_DICTIONARY_H
+#include <stddef.h>
+#include <stdint.h>
+#include <string_view>
+#include <vector>
+
+// Dictionary encoding for the values of a column in a page, meant for string and small integer
+// columns with few distinct values (such as a status or a country). The distinct values are
+// stored once in a sorted dictionary, and every value is replaced by its code, the position of
+// the value in the dictionary. Codes are stored either bit packed, using as few bits as the size
+// of the dictionary needs, or as runs of equal codes when the values are sorted or repetitive,
+// whichever is smaller. See BTreeDesign.md for the format.
+//
+// Since the dictionary is sorted, codes compare in the same order as the values, so equality and
+// range predicates are evaluated by comparing codes, without decoding the values.
+namespace pinedb
+{
+    enum class DictionaryEncoding : uint8_t
+    {
+        // Codes are bit packed
+        PACKED = 1,
+        // Codes are stored as (code, run length) pairs
+        RUN_LENGTH = 2
+    };
+
+    class DictionaryEncoder
+    {
+      public:
+        // Columns with more distinct values are not dictionary encoded
+        static constexpr size_t MAX_DICTIONARY_SIZE = 256;
+        static constexpr size_t HEADER_SIZE = 6;
+
+        /**
+         * Appends the encoded values to `out`
+         * @return false if there are more than `max_dictionary_size` distinct values or more
+         * than UINT16_MAX values, `out` is not modified in that case
+         */
+        static bool encode(const std::vector<std::string_view> &values, std::vector<uint8_t> &out,
+                           size_t max_dictionary_size = MAX_DICTIONARY_SIZE);
+
+        static bool encode(const std::vector<int64_t> &values, std::vector<uint8_t> &out,
+                           size_t max_dictionary_size = MAX_DICTIONARY_SIZE);
+    };
+
+    /**
+     * Read only view of a dictionary encoded column, the encoded bytes should be valid as long as
+     * the view is used
+     */
+    class DictionaryColumn
+    {
+        const uint8_t *codes;
+        size_t codes_length;
+        DictionaryEncoding encoding;
+        bool strings;
+        uint16_t number_of_values;
+        uint8_t width;
+        std::vector<std::string_view> string_dictionary;
+        std::vector<int64_t> integer_dictionary;
+        // Row at which each run starts, for run length encoded columns
+        std::vector<uint16_t> run_starts;
+        std::vector<uint16_t> run_codes;
+
+      public:
+        /**
+         * @throws std::runtime_error if the encoded bytes are malformed
+         */
+        DictionaryColumn(const uint8_t *data, size_t length);
+
+        DictionaryEncoding get_encoding() const { return encoding; }
+
+        bool has_strings() const { return strings; }
+
+        size_t size() const { return number_of_values; }
+
+        size_t dictionary_size() const
+        {
+            return strings ? string_dictionary.size() : integer_dictionary.size();
+        }
+
+        /**
+         * Number of bits used by a packed code
+         */
+        int code_width() const { return width; }
+
+        std::string_view string_at(uint32_t code) const { return string_dictionary.at(code); }
+
+        int64_t integer_at(uint32_t code) const { return integer_dictionary.at(code); }
+
+        /**
+         * @return the code of the value, or -1 if the value is not in the dictionary
+         */
+        int find(std::string_view value) const;
+        int find(int64_t value) const;
+
+        /**
+         * @return the code of the first dictionary value which is not less than `value`, which is
+         * the dictionary size if there is no such value
+         */
+        uint32_t lower_bound(std::string_view value) const;
+        uint32_t lower_bound(int64_t value) const;
+
+        /**
+         * Code of the value in a row
+         */
+        uint32_t code(size_t row) const;
+
+        /**
+         * Calls `f(row)` for every row whose code is in `[first_code, last_code)`, in the order of
+         * the rows. For a run length encoded column this takes time proportional to the number
+         * of runs and matching rows
+         */
+        template <typename F>
+        void for_each_in_range(uint32_t first_code, uint32_t last_code, F f) const
+        {
+            if (encoding == DictionaryEncoding::RUN_LENGTH)
+            {
+                for (size_t i = 0; i < run_starts.size(); ++i)
+                {
+                    if (run_codes[i] < first_code || run_codes[i] >= last_code)
+                        continue;
+                    size_t end = i + 1 < run_starts.size() ? run_starts[i + 1] : number_of_values;
+                    for (size_t row = run_starts[i]; row < end; ++row)
+                        f(row);
+                }
+                return;
+            }
+            for (size_t row = 0; row < number_of_values; ++row)
+            {
+                auto c = code(row);
+                if (c >= first_code && c < last_code)
+                    f(row);
+            }
+        }
+
+        /**
+         * Calls `f(row)` for every row whose code is `c`
+         */
+        template <typename F> void for_each_equal(uint32_t c, F f) const
+        {
+            for_each_in_range(c, c + 1, f);
+        }
+
+        /**
+         * Number of rows whose code is in `[first_code, last_code)`
+         */
+        size_t count_in_range(uint32_t first_code, uint32_t last_code) const;
+    };
+}; // namespace pinedb
+#endif // PINEDB_DICTIONARY_H
@@ -14,6 +14,7 @@ typedef SSIZE_T ssize_t;
 #else
 #    include <fcntl.h>
 #    include <sys/types.h>
+#    include <sys/uio.h>
 #    include <unistd.h>
 #endif
 #include <string>
@@ -62,6 +63,11 @@ class FileHandle
 #endif
     }
 
+#ifndef _WIN32
+    // Reads into many buffers with one call, not available on Windows
+    ssize_t readv(const struct iovec *iov, int count) { return ::readv(fd, iov, count); }
+#endif
+
     ssize_t write(const void *buffer, size_t size)
     {
 #ifdef _WIN32
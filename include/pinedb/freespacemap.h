@@ -0,0 +1,81 @@
+#ifndef PINEDB_FREESPACEMAP_H
+#define PINEDB_FREESPACEMAP_H
+#include "bufferpool.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Free space map of a heap file, used to find a page with enough free space for a new row
+// without reading the data pages.
+//
+// The free space of every heap page is stored as a 1 byte category, a page with category `c` has
+// atleast `c * page_size / 256` free bytes. Each free space map page stores the categories of a
+// range of heap pages as the leaves of a binary tree, where every node is the maximum of its
+// children, so a page with enough free space is found by walking down from the root. The roots of
+// all the free space map pages are the leaves of a similar tree kept in memory, so a search
+// takes O(log n) time.
+namespace pinedb
+{
+    class FreeSpaceMap
+    {
+        BufferPool &pool;
+        page_id_type first_page_id;
+        std::vector<page_id_type> map_pages;
+        // Tree over the roots of the map pages, its leaves are the map pages
+        std::vector<uint8_t> top;
+        size_t top_leaves;
+        size_t leaves_per_page;
+        size_t category_size;
+
+        uint8_t *fetch(page_id_type page_id);
+
+        // Appends a new page to the map, and returns its page id
+        page_id_type add_page();
+
+        void set_top(size_t map_page_index, uint8_t value);
+
+      public:
+        static constexpr uint8_t PAGE_TYPE = 0x46;
+        // Common page header, followed by the page id of the next page in the map
+        static constexpr int HEADER_SIZE = 32;
+
+        /**
+         * Opens the map whose first page is `first_page_id`, or an empty map if it is 0, in which
+         * case pages are created when they are needed
+         */
+        FreeSpaceMap(BufferPool &pool, page_id_type first_page_id);
+
+        /**
+         * Page id of the first page of the map, 0 if the map does not have any page
+         */
+        page_id_type get_first_page_id() const { return first_page_id; }
+
+        /**
+         * Number of heap pages whose free space is stored in one page of the map
+         */
+        size_t get_leaves_per_page() const { return leaves_per_page; }
+
+        /**
+         * Category which is stored for a page with `free_bytes` free bytes
+         */
+        uint8_t category(size_t free_bytes) const;
+
+        /**
+         * Records the free space of the heap page at position `index` of the heap file
+         */
+        void set(size_t index, size_t free_bytes);
+
+        /**
+         * @return the category stored for the heap page at position `index`
+         */
+        uint8_t get(size_t index);
+
+        /**
+         * Finds a heap page which has atleast `needed` free bytes, as per the map
+         * @return position of the page in the heap file, or -1 if there is no such page
+         */
+        int64_t find(size_t needed);
+    };
+}; // namespace pinedb
+#endif // PINEDB_FREESPACEMAP_H
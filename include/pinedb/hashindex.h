@@ -0,0 +1,247 @@
+#ifndef PINEDB_HASHINDEX_H
+#define PINEDB_HASHINDEX_H
+
+#include "bufferpool.h"
+#include "datapacker.h"
+#include "nodesearch.h"
+#include "record.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+#include <vector>
+
+// Disk based extendible hash index which maps fixed width keys to 64 bit values, for columns
+// which are only looked up by equality. Keys are unique, and are not kept in any order.
+//
+// The low `global depth` bits of the hash of a key select a slot of the directory, which holds
+// the page id of the bucket of the key. A bucket with local depth `d` is shared by the
+// `2^(global depth - d)` slots which have the same low `d` bits. A full bucket is split into two
+// buckets of depth `d + 1`, the directory is doubled first if `d` is the global depth. The
+// directory is stored in directory pages, whose page ids are listed in the header page.
+//
+// The directory is read into memory when the index is opened, and changes are written to both,
+// so a lookup reads only the bucket, whatever the number of keys. Only one HashIndex object
+// should be open for an index at a time. See BTreeDesign.md for the page formats.
+namespace pinedb
+{
+    /**
+     * View of a bucket page of a hash index, which stores `n` sorted keys followed by their `n`
+     * values, like a B+ tree leaf, so that a key is found with `NodeSearch`. Keys are stored in
+     * little endian
+     */
+    template <typename Key> class HashBucket
+    {
+        uint8_t *page;
+
+        template <typename T> T read(size_t offset) const
+        {
+            T value;
+            datapacker::bytes::decode<datapacker::endian::little>(page + offset, value);
+            return value;
+        }
+
+        template <typename T> void write(size_t offset, T value)
+        {
+            datapacker::bytes::encode<datapacker::endian::little>(page + offset, value);
+        }
+
+        size_t values_offset() const
+        {
+            return HEADER_SIZE + static_cast<size_t>(get_max_entries()) * sizeof(Key);
+        }
+
+      public:
+        static constexpr uint8_t PAGE_TYPE = 0x68;
+        static constexpr int HEADER_SIZE = 32;
+        static constexpr size_t LOCAL_DEPTH_OFFSET = 16;
+        static constexpr size_t NUMBER_OF_ENTRIES_OFFSET = 20;
+        static constexpr size_t MAX_ENTRIES_OFFSET = 24;
+        static constexpr size_t KEY_TYPE_OFFSET = 28;
+
+        explicit HashBucket(uint8_t *page) : page(page) {}
+
+        /**
+         * Largest number of entries which fit in a bucket of the given page size
+         */
+        static uint32_t capacity(page_size_type page_size)
+        {
+            return static_cast<uint32_t>((static_cast<size_t>(page_size) - HEADER_SIZE)
+                                         / (sizeof(Key) + sizeof(uint64_t)));
+        }
+
+        void init(page_id_type page_id, uint32_t local_depth, uint32_t max_entries);
+
+        uint8_t get_key_type() const { return page[KEY_TYPE_OFFSET]; }
+
+        uint32_t get_local_depth() const { return read<uint32_t>(LOCAL_DEPTH_OFFSET); }
+
+        void set_local_depth(uint32_t depth) { write(LOCAL_DEPTH_OFFSET, depth); }
+
+        uint32_t size() const { return read<uint32_t>(NUMBER_OF_ENTRIES_OFFSET); }
+
+        uint32_t get_max_entries() const { return read<uint32_t>(MAX_ENTRIES_OFFSET); }
+
+        Key key(uint32_t i) const { return read<Key>(HEADER_SIZE + i * sizeof(Key)); }
+
+        uint64_t value(uint32_t i) const
+        {
+            return read<uint64_t>(values_offset() + i * sizeof(uint64_t));
+        }
+
+        void set_value(uint32_t i, uint64_t value)
+        {
+            write(values_offset() + i * sizeof(uint64_t), value);
+        }
+
+        /**
+         * Index of the first key which is not less than `key`, `size()` if there is none
+         */
+        uint32_t lower_bound(Key key) const
+        {
+            return NodeSearch::lower_bound(page + HEADER_SIZE, size(), key);
+        }
+
+        /**
+         * Index of the entry with the key, `size()` if there is none
+         */
+        uint32_t find(Key key) const
+        {
+            auto i = lower_bound(key);
+            return i < size() && this->key(i) == key ? i : size();
+        }
+
+        /**
+         * Inserts an entry at position `i`, the bucket should not be full
+         */
+        void insert(uint32_t i, Key key, uint64_t value);
+
+        /**
+         * Removes the entry at position `i`
+         */
+        void remove(uint32_t i);
+    };
+
+    template <typename Key> class HashIndex
+    {
+        static_assert(std::is_arithmetic<Key>::value, "hash index keys should be fixed width");
+
+        BufferPool &pool;
+        page_id_type header_page_id;
+        uint32_t max_entries;
+        // Number of slots in a directory page, which is also the most directory pages the header
+        // page lists
+        uint32_t slots_per_page;
+        uint32_t global_depth;
+        // Copy of the slots of the directory, and the page ids of the directory pages
+        std::vector<page_id_type> directory;
+        std::vector<page_id_type> directory_pages;
+
+        // Copy of a page, used when more than one page is modified
+        using PageCopy = std::vector<uint8_t>;
+
+        uint8_t *fetch(page_id_type page_id);
+
+        // Changes a slot of the directory, in memory and in its directory page
+        void set_slot(uint64_t slot, page_id_type bucket_page_id);
+
+        // Page id of the bucket which can contain a key with the given hash
+        page_id_type find_bucket(uint64_t key_hash) const
+        {
+            return directory[key_hash & mask(global_depth)];
+        }
+
+        static uint64_t mask(uint32_t depth) { return (uint64_t(1) << depth) - 1; }
+
+        // Doubles the number of slots of the directory, the new slots point to the same buckets
+        // as the slots they are copied from
+        void grow_directory();
+
+        // Splits the full bucket of a key with the given hash, its entries whose hash has the
+        // bit `local depth` set are moved to a new bucket
+        void split_bucket(page_id_type page_id, uint64_t key_hash);
+
+        // Merges an empty bucket into the bucket it was split from, if that bucket was not split
+        // again since, so that removing keys frees pages
+        void merge_bucket(page_id_type page_id, uint64_t key_hash);
+
+      public:
+        static constexpr uint8_t HEADER_PAGE_TYPE = 0x48;
+        static constexpr uint8_t DIRECTORY_PAGE_TYPE = 0x64;
+        static constexpr int HEADER_SIZE = 32;
+        static constexpr size_t GLOBAL_DEPTH_OFFSET = 16;
+        static constexpr size_t NUMBER_OF_DIRECTORY_PAGES_OFFSET = 20;
+        static constexpr size_t MAX_ENTRIES_OFFSET = 24;
+        static constexpr size_t KEY_TYPE_OFFSET = 28;
+
+        /**
+         * Creates an empty index, with one bucket
+         * @param max_entries maximum number of entries in a bucket, 0 to fit as many as possible
+         * in a page. Smaller buckets are useful for testing
+         * @return page id of the header page, which is used to open the index
+         * @throws std::runtime_error if a page could not be created
+         * @throws std::logic_error if `max_entries` is less than 2 or does not fit in a page
+         */
+        static page_id_type create(BufferPool &pool, uint32_t max_entries = 0);
+
+        /**
+         * Hash of a key, equal keys (such as 0.0 and -0.0) have the same hash
+         */
+        static uint64_t hash(Key key);
+
+        /**
+         * @throws std::logic_error if the key cannot be stored in the index (NaN)
+         */
+        static void check_key(Key key);
+
+        /**
+         * Opens the index whose header page is `header_page_id`
+         * @throws std::runtime_error if the page is not the header page of an index with keys of
+         * type `Key`
+         */
+        HashIndex(BufferPool &pool, page_id_type header_page_id);
+
+        page_id_type get_header_page_id() const { return header_page_id; }
+
+        uint32_t get_max_entries() const { return max_entries; }
+
+        /**
+         * Number of bits of the hash which select a slot of the directory
+         */
+        uint32_t get_global_depth() const { return global_depth; }
+
+        /**
+         * Largest global depth, when a full bucket has this local depth it cannot be split
+         */
+        uint32_t get_max_global_depth() const;
+
+        /**
+         * @return true if the key was found, in which case its value is stored in `value`
+         */
+        bool search(Key key, uint64_t &value);
+
+        /**
+         * Inserts the key, splitting the buckets which are full
+         * @return false if the key is already in the index, the value is not changed in that case
+         * @throws std::runtime_error if the bucket of the key is full and the directory cannot
+         * grow, which happens when more than `max_entries` keys would have the same low
+         * `get_max_global_depth()` bits of their hash. This is checked before any bucket is
+         * split, so the index is not changed in that case
+         */
+        bool insert(Key key, uint64_t value);
+
+        /**
+         * Changes the value of the key
+         * @return false if the key is not in the index
+         */
+        bool update(Key key, uint64_t value);
+
+        /**
+         * Removes the key, a bucket which becomes empty is merged with the bucket it was split
+         * from. The directory does not shrink
+         * @return false if the key is not in the index
+         */
+        bool remove(Key key);
+    };
+}; // namespace pinedb
+#endif // PINEDB_HASHINDEX_H
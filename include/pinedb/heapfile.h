@@ -0,0 +1,113 @@
+#ifndef PINEDB_HEAPFILE_H
+#define PINEDB_HEAPFILE_H
+#include "bufferpool.h"
+#include "datapage.h"
+#include "freespacemap.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+// An unordered collection of rows, stored in a chain of data pages. Rows are identified by
+// their RecordId, which does not change when the row is updated. If an updated row does not fit
+// in its page anymore, it is moved to another page and a forwarding address is left in its
+// place. New rows are inserted into the first page which has enough space as per the free space
+// map, so that the space freed by deletes is reused before the file grows.
+namespace pinedb
+{
+    class HeapFile
+    {
+        BufferPool &pool;
+        page_id_type first_page_id;
+        // New pages are appended after the last page of the chain
+        page_id_type last_page_id;
+        // Page ids in the order of the chain, the position of a page is its index in the free
+        // space map
+        std::vector<page_id_type> pages;
+        std::unordered_map<page_id_type, uint32_t> page_positions;
+        FreeSpaceMap free_space_map;
+
+        // Returns the page, throws std::runtime_error if it could not be fetched
+        uint8_t *fetch(page_id_type page_id);
+
+        // Records the free space of a page in the free space map
+        void set_free_space(page_id_type page_id, size_t free_bytes);
+
+        // Inserts the tuple into a page which has space for it, or into a new page at the end of
+        // the chain
+        RecordId insert_tuple(const uint8_t *data, uint16_t length, uint16_t flags);
+
+        // Moves a row which does not fit in its page, `home` is the slot which the RecordId
+        // refers to, and `current` is where the row is currently stored
+        void move_row(const RecordId &home, const RecordId &current, const uint8_t *data,
+                      uint16_t length);
+
+      public:
+        /**
+         * Creates an empty heap file
+         * @return page id of the first page, which is used to open the heap file
+         * @throws std::runtime_error if a page could not be created
+         */
+        static page_id_type create(BufferPool &pool);
+
+        /**
+         * Opens the heap file whose first page is `first_page_id`
+         */
+        HeapFile(BufferPool &pool, page_id_type first_page_id);
+
+        page_id_type get_first_page_id() const { return first_page_id; }
+
+        /**
+         * Largest row which can be stored in the heap file
+         */
+        size_t max_row_length() const;
+
+        /**
+         * @throws std::runtime_error if the row is longer than `max_row_length()`
+         */
+        RecordId insert(const uint8_t *data, size_t length);
+
+        /**
+         * Copies the row into `row`, the capacity of `row` is reused
+         * @return false if there is no row with the given id
+         */
+        bool get(const RecordId &rid, std::vector<uint8_t> &row);
+
+        /**
+         * Replaces the row, the RecordId of the row does not change
+         * @return false if there is no row with the given id
+         * @throws std::runtime_error if the row is longer than `max_row_length()`
+         */
+        bool update(const RecordId &rid, const uint8_t *data, size_t length);
+
+        /**
+         * @return false if there is no row with the given id
+         */
+        bool remove(const RecordId &rid);
+
+        /**
+         * Sequential scan over all the rows, in the order of the pages and slots
+         */
+        class Iterator
+        {
+            HeapFile &heap;
+            page_id_type page_id;
+            uint16_t slot;
+
+          public:
+            Iterator(HeapFile &heap, page_id_type page_id) : heap(heap), page_id(page_id), slot(0)
+            {
+            }
+
+            /**
+             * Reads the next row into `row`
+             * @return false if there are no more rows
+             */
+            bool next(RecordId &rid, std::vector<uint8_t> &row);
+        };
+
+        Iterator scan() { return Iterator(*this, first_page_id); }
+    };
+}; // namespace pinedb
+#endif // PINEDB_HEAPFILE_H
@@ -0,0 +1,179 @@
+#ifndef PINEDB_KEYENCODER_H
+#define PINEDB_KEYENCODER_H
+#include "datapacker.h"
+#include "record.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Normalized keys are byte strings whose order, compared with memcmp, is the order of the values
+// which were encoded, so keys of any column type, and keys of many columns, are compared the same
+// way without knowing their types.
+//
+// - Integers are stored in big endian, with the sign bit flipped for signed integers, so that
+//   negative numbers come first
+// - Floats and doubles are stored in big endian after the IEEE754 total order transform: the
+//   sign bit of positive numbers is flipped, and every bit of negative numbers is flipped. -0.0
+//   comes before 0.0, and NaN comes after infinity
+// - Strings are terminated by 0x00 0x01, and a 0x00 byte in the string is escaped as 0x00 0xFF,
+//   so a string comes before every longer string which starts with it
+//
+// A column of a composite key can be in descending order, in which case every byte of its
+// encoding is flipped. Since no encoding is a prefix of another encoding of the same type, the
+// columns which follow do not change the order.
+namespace pinedb
+{
+    class KeyEncoder
+    {
+        std::vector<uint8_t> bytes;
+
+        void append(const uint8_t *data, size_t length, bool descending);
+
+      public:
+        static constexpr uint8_t STRING_ESCAPE = 0x00;
+        static constexpr uint8_t STRING_TERMINATOR = 0x01;
+        static constexpr uint8_t ESCAPED_ZERO = 0xFF;
+
+        /**
+         * Unsigned integer whose order is the order of the values, for the fixed width types
+         */
+        template <typename T> static auto sortable_bits(T value)
+        {
+            static_assert(std::is_arithmetic<T>::value, "only fixed width values are supported");
+            if constexpr (std::is_floating_point<T>::value)
+            {
+                using U = typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type;
+                U bits;
+                memcpy(&bits, &value, sizeof(T));
+                constexpr U sign = static_cast<U>(1) << (sizeof(T) * 8 - 1);
+                return (bits & sign) ? static_cast<U>(~bits) : static_cast<U>(bits | sign);
+            }
+            else
+            {
+                using U = typename std::make_unsigned<T>::type;
+                auto bits = static_cast<U>(value);
+                if constexpr (std::is_signed<T>::value)
+                    bits = static_cast<U>(bits ^ (static_cast<U>(1) << (sizeof(T) * 8 - 1)));
+                return bits;
+            }
+        }
+
+        /**
+         * Inverse of `sortable_bits`
+         */
+        template <typename T, typename U> static T from_sortable_bits(U bits)
+        {
+            if constexpr (std::is_floating_point<T>::value)
+            {
+                constexpr U sign = static_cast<U>(1) << (sizeof(T) * 8 - 1);
+                bits = (bits & sign) ? static_cast<U>(bits ^ sign) : static_cast<U>(~bits);
+                T value;
+                memcpy(&value, &bits, sizeof(T));
+                return value;
+            }
+            else
+            {
+                if constexpr (std::is_signed<T>::value)
+                    bits = static_cast<U>(bits ^ (static_cast<U>(1) << (sizeof(T) * 8 - 1)));
+                return static_cast<T>(bits);
+            }
+        }
+
+        /**
+         * Appends a fixed width value to the key
+         */
+        template <typename T> KeyEncoder &add(T value, bool descending = false)
+        {
+            uint8_t buffer[sizeof(T)];
+            datapacker::bytes::encode_be(buffer, sortable_bits(value));
+            append(buffer, sizeof(T), descending);
+            return *this;
+        }
+
+        /**
+         * Appends a string to the key
+         */
+        KeyEncoder &add_string(std::string_view value, bool descending = false);
+
+        /**
+         * Appends the given columns of a record, in the given order
+         * @param descending columns which are in descending order, empty if all are ascending
+         * @throws std::logic_error if a string column is stored in overflow pages, since only
+         * its prefix is in the record
+         */
+        KeyEncoder &add_record(const RecordLayout &layout, const uint8_t *record,
+                               const std::vector<int> &columns,
+                               const std::vector<bool> &descending = {});
+
+        const std::vector<uint8_t> &get_bytes() const { return bytes; }
+
+        const uint8_t *data() const { return bytes.data(); }
+
+        /**
+         * The key as a byte string, used as the key of a StringBTree
+         */
+        std::string_view view() const
+        {
+            return {reinterpret_cast<const char *>(bytes.data()), bytes.size()};
+        }
+
+        size_t size() const { return bytes.size(); }
+
+        void clear() { bytes.clear(); }
+
+        /**
+         * The first 8 bytes of a key as a big endian integer, padded with zeros. If the prefixes
+         * of two keys are different, they are in the same order as the keys
+         */
+        static uint64_t prefix(const uint8_t *key, size_t length);
+
+        /**
+         * Compares two keys, a key comes before the longer keys which start with it
+         * @return negative if `a` comes before `b`, 0 if they are equal, otherwise positive
+         */
+        static int compare(const uint8_t *a, size_t a_length, const uint8_t *b, size_t b_length);
+    };
+
+    /**
+     * Reads the values of a normalized key, in the order in which they were added
+     */
+    class KeyDecoder
+    {
+        const uint8_t *key;
+        size_t length;
+        size_t position;
+
+        void read(uint8_t *out, size_t n, bool descending);
+
+      public:
+        KeyDecoder(const uint8_t *key, size_t length) : key(key), length(length), position(0) {}
+
+        /**
+         * @throws std::runtime_error if the key does not have enough bytes
+         */
+        template <typename T> T get(bool descending = false)
+        {
+            uint8_t buffer[sizeof(T)];
+            read(buffer, sizeof(T), descending);
+            decltype(KeyEncoder::sortable_bits(T())) bits;
+            datapacker::bytes::decode_be(buffer, bits);
+            return KeyEncoder::from_sortable_bits<T>(bits);
+        }
+
+        /**
+         * @throws std::runtime_error if the string is not terminated
+         */
+        std::string get_string(bool descending = false);
+
+        /**
+         * @return true if every value of the key has been read
+         */
+        bool at_end() const { return position == length; }
+    };
+}; // namespace pinedb
+#endif // PINEDB_KEYENCODER_H
@@ -0,0 +1,86 @@
+#ifndef PINEDB_LATCH_H
+#define PINEDB_LATCH_H
+
+#include <atomic>
+#include <stdint.h>
+#include <thread>
+
+// Latch for optimistic lock coupling. The latch is a version number which is odd while a writer
+// holds the latch, and is incremented when the writer releases it. A reader does not write to
+// the latch, it reads the version, reads the data without holding the latch, then checks that the
+// version did not change, and starts again if it did. So readers of a page do not block each
+// other, or write to a shared cache line, and only writers are serialized.
+namespace pinedb
+{
+    class OptimisticLatch
+    {
+        std::atomic<uint64_t> version;
+
+      public:
+        OptimisticLatch() : version(0) {}
+
+        OptimisticLatch(const OptimisticLatch &) = delete;
+        OptimisticLatch &operator=(const OptimisticLatch &) = delete;
+
+        /**
+         * Starts an optimistic read
+         * @param restart set to true if a writer holds the latch
+         * @return version which is checked with `validate` after the data is read
+         */
+        uint64_t read_lock(bool &restart) const
+        {
+            auto v = version.load(std::memory_order_acquire);
+            if (v & 1)
+            {
+                std::this_thread::yield();
+                restart = true;
+            }
+            return v;
+        }
+
+        /**
+         * Checks that the data which was read since `read_lock` returned `v` was not changed
+         * @param restart set to true if the data was changed, in which case it should not be used
+         */
+        void validate(uint64_t v, bool &restart) const
+        {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (version.load(std::memory_order_relaxed) != v)
+                restart = true;
+        }
+
+        /**
+         * Acquires the latch for writing if the data has not changed since `read_lock` returned
+         * `v`, so what was read is still valid
+         * @param restart set to true if the latch could not be acquired
+         */
+        void upgrade(uint64_t &v, bool &restart)
+        {
+            if (version.compare_exchange_strong(v, v + 1, std::memory_order_acquire))
+                v = v + 1;
+            else
+                restart = true;
+        }
+
+        /**
+         * @return false if the latch is held by a writer
+         */
+        bool try_write_lock()
+        {
+            auto v = version.load(std::memory_order_relaxed);
+            return (v & 1) == 0
+                   && version.compare_exchange_strong(v, v + 1, std::memory_order_acquire);
+        }
+
+        void write_lock()
+        {
+            while (!try_write_lock())
+                std::this_thread::yield();
+        }
+
+        void write_unlock() { version.fetch_add(1, std::memory_order_release); }
+
+        bool is_write_locked() const { return version.load(std::memory_order_relaxed) & 1; }
+    };
+}; // namespace pinedb
+#endif // PINEDB_LATCH_H
@@ -0,0 +1,67 @@
+#ifndef PINEDB_NODESEARCH_H
+#define PINEDB_NODESEARCH_H
+
+#include <stdint.h>
+
+// Search within the sorted, fixed width keys of a B+ tree node. The keys of a node are stored
+// next to each other in little endian, so on little endian hosts they can be compared directly with
+// vector instructions. A branchless binary search first narrows the keys down to `WINDOW_BYTES`
+// bytes (one cache line), then the keys of the window which are less than the search key are
+// counted with vector compares (32 keys per AVX2 compare for 8 bit keys, 4 for 64 bit keys), which
+// gives the position of the key since the keys are sorted. Nodes smaller than the window, and
+// hosts without a supported instruction set, use the branchless binary search till the end.
+//
+// The kernel is picked once at runtime from the instruction sets supported by the CPU.
+namespace pinedb
+{
+    enum class SearchKernel : uint8_t
+    {
+        SCALAR = 0,
+        SSE2 = 1,
+        AVX2 = 2,
+        NEON = 3
+    };
+
+    class NodeSearch
+    {
+      public:
+        // Size of the keys which are compared with vector instructions after the binary search
+        static constexpr uint32_t WINDOW_BYTES = 64;
+
+        /**
+         * Fastest kernel supported by the CPU, it is detected on the first call
+         */
+        static SearchKernel best_kernel();
+
+        /**
+         * @return true if the kernel is compiled in and the CPU supports it
+         */
+        static bool is_supported(SearchKernel kernel);
+
+        static const char *kernel_name(SearchKernel kernel);
+
+        /**
+         * Index of the first of the `n` sorted keys which is not less than `key`, `n` if there is
+         * none
+         * @param keys `n` little endian keys of type `T`, they need not be aligned
+         */
+        template <typename T> static uint32_t lower_bound(const uint8_t *keys, uint32_t n, T key);
+
+        /**
+         * Index of the first of the `n` sorted keys which is greater than `key`, `n` if there is
+         * none
+         */
+        template <typename T> static uint32_t upper_bound(const uint8_t *keys, uint32_t n, T key);
+
+        /**
+         * Same as `lower_bound`, using the given kernel, or the scalar search if the CPU does not
+         * support it. Used to compare the kernels
+         */
+        template <typename T>
+        static uint32_t lower_bound(const uint8_t *keys, uint32_t n, T key, SearchKernel kernel);
+
+        template <typename T>
+        static uint32_t upper_bound(const uint8_t *keys, uint32_t n, T key, SearchKernel kernel);
+    };
+}; // namespace pinedb
+#endif // PINEDB_NODESEARCH_H
@@ -0,0 +1,86 @@
+#ifndef PINEDB_OVERFLOW_H
+#define PINEDB_OVERFLOW_H
+#include "bufferpool.h"
+#include "record.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+
+// Storage for string values which are too large to be stored in a row. The value is stored in a
+// chain of overflow pages, and the row keeps only a pointer to the chain and a short prefix of
+// the value (see RecordLayout), so that rows stay small and a scan which does not need the whole
+// value never reads the overflow pages. Values are optionally compressed with a simple LZ77
+// compressor, and are stored compressed only if it saves space.
+namespace pinedb
+{
+    class OverflowStore
+    {
+        BufferPool &pool;
+        size_t inline_limit;
+        size_t prefix_length;
+        bool compression;
+
+        uint8_t *fetch(page_id_type page_id);
+
+        // Writes the bytes to a new chain of overflow pages, and returns its first page id
+        page_id_type write_chain(const uint8_t *data, size_t length);
+
+        // Reads the whole chain into `data`
+        void read_chain(page_id_type page_id, std::string &data);
+
+      public:
+        static constexpr uint8_t PAGE_TYPE = 0x4F;
+        // Common page header, followed by the next page id and the number of bytes in the page
+        static constexpr int HEADER_SIZE = 24;
+        // The value is stored compressed
+        static constexpr uint8_t FLAG_COMPRESSED = 0x1;
+        static constexpr size_t DEFAULT_INLINE_LIMIT = 256;
+        static constexpr size_t DEFAULT_PREFIX_LENGTH = 16;
+
+        /**
+         * Strings longer than `inline_limit` bytes are stored out of line with their first
+         * `prefix_length` bytes kept in the row
+         */
+        explicit OverflowStore(BufferPool &pool, size_t inline_limit = DEFAULT_INLINE_LIMIT,
+                               size_t prefix_length = DEFAULT_PREFIX_LENGTH,
+                               bool compression = true);
+
+        /**
+         * Stores the value in new overflow pages, the prefix of the result points into `value`
+         * @throws std::runtime_error if a page could not be created
+         */
+        ExternalString write(std::string_view value);
+
+        /**
+         * Reads the whole value of a string which is stored out of line
+         * @throws std::runtime_error if the overflow pages could not be read or are corrupt
+         */
+        void read(const ExternalString &external, std::string &value);
+
+        /**
+         * Deletes the overflow pages of the string
+         */
+        void remove(const ExternalString &external);
+
+        /**
+         * Sets a string field of the record, the string is stored out of line if it is longer
+         * than the inline limit
+         */
+        void set_string(RecordBuilder &builder, int index, std::string_view value);
+
+        /**
+         * Reads the whole value of a string field, whether it is stored in the record or not
+         */
+        void get_string(const RecordLayout &layout, const uint8_t *record, int index,
+                        std::string &value);
+
+        /**
+         * Deletes the overflow pages of every string of the record which is stored out of line,
+         * should be called when the record is deleted
+         */
+        void remove_strings(const RecordLayout &layout, const uint8_t *record);
+    };
+}; // namespace pinedb
+#endif // PINEDB_OVERFLOW_H
@@ -3,6 +3,7 @@
 
 #include "bufferpool.h"
 #include "datapacker.h"
+#include "record.h"
 
 namespace pinedb
 {
@@ -142,6 +143,17 @@ namespace pinedb
         }
     };
 
+    /**
+     * How the records of a table are stored in its data pages
+     */
+    enum class TableStorage : uint8_t
+    {
+        // Rows are stored one after the other in slotted pages, see HeapFile
+        ROW = 0,
+        // Each page stores its rows column by column, see PaxFile
+        PAX = 1
+    };
+
     class TableMetadataPage
     {
         uint8_t *buffer;
@@ -151,6 +163,13 @@ namespace pinedb
         static const int MAX_TABLE_NAME_LENGTH = 128;
         static const int MAX_NUMBER_OF_COLUMNS = 64;
         static const int MAX_COLUMN_NAME_LENGTH = 59;
+        // Offset of the page id of the next metadata page in the catalog, after the column names
+        static const int NEXT_PAGE_ID_OFFSET = MAX_TABLE_NAME_LENGTH + MAX_NUMBER_OF_COLUMNS
+                                               + sizeof(page_id_type)
+                                               + MAX_NUMBER_OF_COLUMNS * MAX_COLUMN_NAME_LENGTH;
+        static const int STORAGE_OFFSET = NEXT_PAGE_ID_OFFSET + sizeof(page_id_type);
+        // Number of bytes used by the metadata, excluding the page header
+        static const int METADATA_LENGTH = STORAGE_OFFSET + 1;
 
         // The buffer passed here is not the page buffer, but the page data buffer
         // which is after the page header
@@ -188,7 +207,18 @@ namespace pinedb
                                          page_id);
         }
 
-        int number_of_columns() const { return get_column_format().size(); }
+        // Counts the columns without decoding the format into a string
+        int number_of_columns() const
+        {
+            auto format = buffer + MAX_TABLE_NAME_LENGTH;
+            int count = 0;
+            while (count < MAX_NUMBER_OF_COLUMNS && format[count] != '\0')
+                ++count;
+            return count;
+        }
+
+        // The layout should be cached by the caller, it parses the column format every time
+        RecordLayout get_record_layout() const { return RecordLayout(get_column_format()); }
 
         page_id_type get_table_page_id() const
         {
@@ -198,6 +228,30 @@ namespace pinedb
             return page_id;
         }
 
+        // Metadata pages of all the tables form a chain starting from the sys_tables page, the
+        // last page has a next page id of 0
+        page_id_type get_next_page_id() const
+        {
+            page_id_type page_id = 0;
+            datapacker::bytes::decode_le(buffer + NEXT_PAGE_ID_OFFSET, page_id);
+            return page_id;
+        }
+
+        void set_next_page_id(page_id_type page_id)
+        {
+            datapacker::bytes::encode_le(buffer + NEXT_PAGE_ID_OFFSET, page_id);
+        }
+
+        TableStorage get_storage() const
+        {
+            return static_cast<TableStorage>(buffer[STORAGE_OFFSET]);
+        }
+
+        void set_storage(TableStorage storage)
+        {
+            buffer[STORAGE_OFFSET] = static_cast<uint8_t>(storage);
+        }
+
         std::string get_column_name(int index) const
         {
             if (index > MAX_NUMBER_OF_COLUMNS)
@@ -0,0 +1,106 @@
+#ifndef PINEDB_PAXFILE_H
+#define PINEDB_PAXFILE_H
+#include "bufferpool.h"
+#include "datapage.h"
+#include "paxpage.h"
+#include "record.h"
+#include "zonemap.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Storage for the records of a table in PAX layout, in a chain of PaxPages. Records are
+// appended to the last page, and are identified by a RecordId of their page and row number.
+// Analytic scans go over the pages with `for_each_page`, and read only the columns they need
+// from each page. A zone map of the pages is kept up to date on every insert, so that a scan
+// with a range predicate on a fixed width column can skip pages with `for_each_page_in_range`.
+namespace pinedb
+{
+    class PaxFile
+    {
+        BufferPool &pool;
+        RecordLayout layout;
+        page_id_type first_page_id;
+        // New records are appended to the last page of the chain
+        page_id_type last_page_id;
+        // Page ids in the order of the chain, the position of a page is its index in the zone
+        // map
+        std::vector<page_id_type> pages;
+        ZoneMap zone_map;
+
+        // Returns the page, throws std::runtime_error if it could not be fetched
+        uint8_t *fetch(page_id_type page_id);
+
+        // Creates an empty page, throws std::runtime_error if it could not be created
+        page_id_type new_page();
+
+        // Adds the record in the page at `position` to the zone map
+        void add_to_zone_map(size_t position, const uint8_t *record);
+
+      public:
+        /**
+         * Creates an empty PAX file for records with the given layout
+         * @return page id of the first page, which is used to open the file
+         * @throws std::runtime_error if a page could not be created
+         */
+        static page_id_type create(BufferPool &pool, const RecordLayout &layout);
+
+        /**
+         * Opens the PAX file whose first page is `first_page_id`
+         */
+        PaxFile(BufferPool &pool, const RecordLayout &layout, page_id_type first_page_id);
+
+        page_id_type get_first_page_id() const { return first_page_id; }
+
+        const RecordLayout &get_layout() const { return layout; }
+
+        const ZoneMap &get_zone_map() const { return zone_map; }
+
+        size_t number_of_pages() const { return pages.size(); }
+
+        /**
+         * Appends an encoded record
+         * @throws std::runtime_error if the record does not fit in an empty page
+         */
+        RecordId insert(const uint8_t *record);
+
+        /**
+         * Copies the record into `row`, the capacity of `row` is reused
+         * @return false if there is no record with the given id
+         */
+        bool get(const RecordId &rid, std::vector<uint8_t> &row);
+
+        /**
+         * Calls `f(page_id, page)` with a `const PaxPage &` for every page of the chain. The page
+         * is valid till `f` fetches another page
+         */
+        template <typename F> void for_each_page(F f)
+        {
+            for (auto page_id : pages)
+            {
+                PaxPage page(fetch(page_id), pool.page_size(), layout);
+                f(page_id, static_cast<const PaxPage &>(page));
+            }
+        }
+
+        /**
+         * Like `for_each_page`, but skips the pages which do not have a value of the column in
+         * `[low, high]` as per the zone map, without fetching them. The pages which are passed to
+         * `f` can still have rows outside the range
+         * @throws std::logic_error if the column does not store values of type `T`
+         */
+        template <typename T, typename F>
+        void for_each_page_in_range(int column, T low, T high, F f)
+        {
+            for (size_t i = 0; i < pages.size(); ++i)
+            {
+                if (!zone_map.may_contain(i, column, low, high))
+                    continue;
+                PaxPage page(fetch(pages[i]), pool.page_size(), layout);
+                f(pages[i], static_cast<const PaxPage &>(page));
+            }
+        }
+    };
+}; // namespace pinedb
+#endif // PINEDB_PAXFILE_H
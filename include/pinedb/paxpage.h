@@ -0,0 +1,156 @@
+#ifndef PINEDB_PAXPAGE_H
+#define PINEDB_PAXPAGE_H
+#include "common.h"
+#include "datapacker.h"
+#include "record.h"
+
+#include <stddef.h>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Page which stores its rows column by column (PAX, Partition Attributes Across). The page is
+// split into one minipage per column, and the values of a column are stored contiguously in its
+// minipage, so that a scan which reads a few columns touches only their minipages. Minipages are
+// placed in the order of the fields of the RecordLayout (widest first), so every value is aligned
+// to its width. String columns store a 4 byte slot in their minipage, and the bytes of the
+// strings are stored after the last minipage, see BTreeDesign.md for the page format.
+namespace pinedb
+{
+    class PaxPage
+    {
+        uint8_t *page;
+        page_size_type page_size;
+        const RecordLayout &layout;
+
+        uint16_t read_u16(size_t offset) const;
+        void write_u16(size_t offset, uint16_t value);
+
+        // Offset of the value of a column in a row
+        size_t value_offset(uint16_t row, int column) const
+        {
+            const auto &f = layout.field(column);
+            return HEADER_SIZE + static_cast<size_t>(get_capacity()) * f.offset
+                   + static_cast<size_t>(row) * f.width;
+        }
+
+        uint16_t get_free_space_start() const;
+        void set_free_space_start(uint16_t offset);
+
+        const FieldLayout &checked_field(int column, char format) const;
+
+      public:
+        static constexpr uint8_t PAGE_TYPE = 0x50;
+        // Size of the common page header followed by the PAX page header
+        static constexpr int HEADER_SIZE = 32;
+        // Number of bytes reserved for each string of a row by `default_capacity`
+        static constexpr size_t STRING_RESERVE = 16;
+        static constexpr uint16_t MAX_PAGE_SIZE = 0xFFFF;
+
+        /**
+         * `page` is the whole page, including the common page header. The layout should be
+         * valid as long as the page is used
+         */
+        PaxPage(uint8_t *page, page_size_type page_size, const RecordLayout &layout)
+            : page(page), page_size(page_size), layout(layout)
+        {
+        }
+
+        /**
+         * Number of rows which fit in a page, if every string has `STRING_RESERVE` bytes
+         */
+        static uint16_t default_capacity(const RecordLayout &layout, page_size_type page_size);
+
+        /**
+         * Writes the header of an empty page which holds atmost `capacity` rows
+         * @throws std::logic_error if the minipages do not fit in the page
+         */
+        void init(page_id_type page_id, uint16_t capacity);
+
+        uint16_t number_of_rows() const;
+
+        /**
+         * Maximum number of rows in the page, the size of the minipages depends on it
+         */
+        uint16_t get_capacity() const;
+
+        page_id_type get_next_page_id() const;
+
+        void set_next_page_id(page_id_type page_id);
+
+        /**
+         * First page of the zone map of the PAX file, only used in the first page of the file
+         */
+        page_id_type get_zone_map_page_id() const;
+
+        void set_zone_map_page_id(page_id_type page_id);
+
+        /**
+         * Appends an encoded record (see RecordLayout), strings stored out of line are copied as
+         * they are
+         * @return row number, or -1 if the page is full
+         */
+        int append(const uint8_t *record);
+
+        /**
+         * Reads a fixed width value
+         * @throws std::logic_error if the column does not store values of type `T`
+         */
+        template <typename T> T get(uint16_t row, int column) const
+        {
+            checked_field(column, RecordLayout::format_of<T>());
+            T value;
+            datapacker::bytes::decode<datapacker::endian::little>(page + value_offset(row, column),
+                                                                  value);
+            return value;
+        }
+
+        /**
+         * Returns a view of a string, which points into the page. For a string which is stored
+         * out of line, this is the prefix stored in the page
+         * @throws std::logic_error if the column is not a string
+         */
+        std::string_view get_string(uint16_t row, int column) const;
+
+        /**
+         * Start of the minipage of a column, values are stored in little endian, `width` bytes
+         * each
+         */
+        const uint8_t *column_data(int column) const { return page + value_offset(0, column); }
+
+        /**
+         * Calls `f(row, value)` for every value of a fixed width column, in the order of the rows
+         * @throws std::logic_error if the column does not store values of type `T`
+         */
+        template <typename T, typename F> void for_each(int column, F f) const
+        {
+            checked_field(column, RecordLayout::format_of<T>());
+            auto data = const_cast<uint8_t *>(column_data(column));
+            auto rows = number_of_rows();
+            for (uint16_t row = 0; row < rows; ++row)
+            {
+                T value;
+                datapacker::bytes::decode<datapacker::endian::little>(data + row * sizeof(T),
+                                                                      value);
+                f(row, value);
+            }
+        }
+
+        /**
+         * Dictionary encodes the values of a string or an integer column of upto 4 bytes in the
+         * page, see DictionaryEncoder
+         * @return false if the column cannot be encoded, such as when it has too many distinct
+         * values or strings stored out of line, `out` is not modified in that case
+         */
+        bool encode_column(int column, std::vector<uint8_t> &out) const;
+
+        /**
+         * Copies a row into `buffer` as an encoded record
+         * @return length of the record, or 0 if the row does not exist or `buffer` is too small
+         */
+        size_t get_record(uint16_t row, uint8_t *buffer, size_t capacity) const;
+    };
+}; // namespace pinedb
+#endif // PINEDB_PAXPAGE_H
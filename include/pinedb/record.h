@@ -0,0 +1,260 @@
+#ifndef PINEDB_RECORD_H
+#define PINEDB_RECORD_H
+#include "common.h"
+#include "datapacker.h"
+
+#include <stddef.h>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A RecordLayout is compiled once from the column format of a table, so that a field of a row
+// can be read or written with offset arithmetic, without parsing the format string again.
+//
+// Records are encoded in little endian and have two sections
+//
+// | fixed section | variable length section |
+//
+// The fixed section contains every fixed width field, and a 4 byte slot for every string field
+// (offset of the string from the start of the record and its length, 2 bytes each). Fields are
+// placed in decreasing order of their width (8, 4, 2, 1 bytes), so that every field is naturally
+// aligned relative to the start of the record without any padding. The variable length section
+// contains the bytes of the strings, in the order in which they were added to the record.
+//
+// A string which is too large to be stored in the record is stored in overflow pages (see
+// OverflowStore), and the high bit of the length in its slot is set. Its bytes in the variable
+// length section are then a pointer to the overflow pages (the length of the string, the first
+// overflow page id and flags, 9 bytes) followed by a prefix of the string.
+namespace pinedb
+{
+    /**
+     * A string stored out of line, as it is stored in the record
+     */
+    struct ExternalString
+    {
+        // Length of the whole string
+        uint32_t length;
+        // First page of the chain of overflow pages
+        page_id_type page_id;
+        // Flags set by the OverflowStore, such as whether the string is compressed
+        uint8_t flags;
+        // The first few bytes of the string, which are stored in the record
+        std::string_view prefix;
+    };
+
+    struct FieldLayout
+    {
+        // Format character of the column, see ColumnFormat
+        char format;
+        // Offset of the field (or of the string slot) from the start of the record
+        uint16_t offset;
+        // Number of bytes used in the fixed section
+        uint16_t width;
+        bool is_variable_length;
+    };
+
+    class RecordLayout
+    {
+        std::string format;
+        std::vector<FieldLayout> fields;
+        uint16_t fixed_length;
+        bool variable_length;
+
+      public:
+        // Width of the slot in the fixed section which points to a string
+        static constexpr uint16_t STRING_SLOT_WIDTH = 4;
+        // Records are addressed with 2 byte offsets
+        static constexpr size_t MAX_RECORD_LENGTH = UINT16_MAX;
+        // Set in the length of a string slot if the string is stored out of line
+        static constexpr uint16_t EXTERNAL_FLAG = 0x8000;
+        static constexpr size_t MAX_INLINE_STRING_LENGTH = 0x7FFF;
+        // Length of the pointer to the overflow pages, which is followed by the prefix
+        static constexpr uint16_t EXTERNAL_POINTER_LENGTH = 9;
+
+        /**
+         * Compiles the layout of a record with the given column format
+         * @throws std::runtime_error if the format string contains an invalid column type
+         */
+        explicit RecordLayout(const std::string &format);
+
+        /**
+         * Number of bytes used by a value of the column type `ch` in the fixed section, for
+         * strings this is the width of the slot
+         */
+        static uint16_t field_width(char ch);
+
+        /**
+         * Format character of the column type which stores values of type `T`
+         */
+        template <typename T> static constexpr char format_of()
+        {
+            if constexpr (std::is_same<T, uint8_t>::value)
+                return 'b';
+            else if constexpr (std::is_same<T, int8_t>::value)
+                return 'B';
+            else if constexpr (std::is_same<T, uint16_t>::value)
+                return 's';
+            else if constexpr (std::is_same<T, int16_t>::value)
+                return 'S';
+            else if constexpr (std::is_same<T, uint32_t>::value)
+                return 'i';
+            else if constexpr (std::is_same<T, int32_t>::value)
+                return 'I';
+            else if constexpr (std::is_same<T, uint64_t>::value)
+                return 'l';
+            else if constexpr (std::is_same<T, int64_t>::value)
+                return 'L';
+            else if constexpr (std::is_same<T, float>::value)
+                return 'f';
+            else if constexpr (std::is_same<T, double>::value)
+                return 'd';
+            else
+                static_assert(datapacker::internal::False<T>{},
+                              "Type does not correspond to any column type");
+        }
+
+        const std::string &get_format() const { return format; }
+
+        int number_of_columns() const { return static_cast<int>(fields.size()); }
+
+        const FieldLayout &field(int index) const { return fields.at(index); }
+
+        /**
+         * Length of the fixed section, this is also the length of a record which has no strings
+         * or only empty strings
+         */
+        uint16_t get_fixed_length() const { return fixed_length; }
+
+        bool has_variable_length() const { return variable_length; }
+
+        /**
+         * Number of bytes needed to encode a record whose strings have `string_bytes` bytes in
+         * total
+         */
+        size_t encoded_length(size_t string_bytes) const { return fixed_length + string_bytes; }
+
+        /**
+         * Reads a fixed width field of the record
+         * @throws std::logic_error if the column does not store values of type `T`
+         */
+        template <typename T> T get(const uint8_t *record, int index) const
+        {
+            const auto &f = checked_field(index, format_of<T>());
+            T value;
+            datapacker::bytes::decode<datapacker::endian::little>(
+                const_cast<uint8_t *>(record) + f.offset, value);
+            return value;
+        }
+
+        /**
+         * Writes a fixed width field of the record in place, the other fields are not modified
+         * @throws std::logic_error if the column does not store values of type `T`
+         */
+        template <typename T> void set(uint8_t *record, int index, T value) const
+        {
+            const auto &f = checked_field(index, format_of<T>());
+            datapacker::bytes::encode<datapacker::endian::little>(record + f.offset, value);
+        }
+
+        /**
+         * Returns a view of a string field, which points into the record. For a string which is
+         * stored out of line, this is the prefix of the string which is stored in the record
+         * @throws std::logic_error if the column is not a string
+         */
+        std::string_view get_string(const uint8_t *record, int index) const
+        {
+            const auto &f = checked_field(index, 'c');
+            uint16_t offset = 0, length = 0;
+            datapacker::bytes::decode_le(const_cast<uint8_t *>(record) + f.offset, offset,
+                                         length);
+            if (length & EXTERNAL_FLAG)
+            {
+                offset = static_cast<uint16_t>(offset + EXTERNAL_POINTER_LENGTH);
+                length = static_cast<uint16_t>((length & ~EXTERNAL_FLAG) - EXTERNAL_POINTER_LENGTH);
+            }
+            return std::string_view(reinterpret_cast<const char *>(record) + offset, length);
+        }
+
+        /**
+         * @return true if the string field is stored out of line
+         * @throws std::logic_error if the column is not a string
+         */
+        bool is_external(const uint8_t *record, int index) const
+        {
+            const auto &f = checked_field(index, 'c');
+            uint16_t length = 0;
+            datapacker::bytes::decode_le(const_cast<uint8_t *>(record) + f.offset + 2, length);
+            return length & EXTERNAL_FLAG;
+        }
+
+        /**
+         * Reads the pointer to the overflow pages of a string which is stored out of line
+         * @throws std::logic_error if the column is not a string, or if the string is stored in
+         * the record
+         */
+        ExternalString get_external(const uint8_t *record, int index) const;
+
+        /**
+         * Length of an encoded record, i.e. the end of its last string
+         */
+        size_t record_length(const uint8_t *record) const;
+
+      private:
+        const FieldLayout &checked_field(int index, char format) const
+        {
+            const auto &f = fields.at(index);
+            if (f.format != format)
+            {
+                throw std::logic_error("column " + std::to_string(index) + " has type '"
+                                       + std::string(1, f.format) + "', not '"
+                                       + std::string(1, format) + "'");
+            }
+            return f;
+        }
+    };
+
+    /**
+     * Encodes a record field by field into a buffer. Fixed width fields can be set in any order,
+     * strings are appended to the variable length section in the order in which they are set
+     */
+    class RecordBuilder
+    {
+        const RecordLayout &layout;
+        uint8_t *buffer;
+        size_t capacity;
+        size_t length;
+
+      public:
+        /**
+         * @throws std::runtime_error if the buffer cannot hold the fixed section
+         */
+        RecordBuilder(const RecordLayout &layout, uint8_t *buffer, size_t capacity);
+
+        template <typename T> RecordBuilder &set(int index, T value)
+        {
+            layout.set(buffer, index, value);
+            return *this;
+        }
+
+        /**
+         * Appends the string to the variable length section. Setting a string again appends a
+         * new copy, the space used by the old one is not reused
+         * @throws std::runtime_error if the string does not fit in the buffer
+         */
+        RecordBuilder &set_string(int index, std::string_view s);
+
+        /**
+         * Appends the pointer to a string which is stored out of line, followed by its prefix
+         * @throws std::runtime_error if it does not fit in the buffer
+         */
+        RecordBuilder &set_external_string(int index, const ExternalString &value);
+
+        /**
+         * Number of bytes of the buffer used by the record
+         */
+        size_t get_length() const { return length; }
+    };
+} // namespace pinedb
+#endif // PINEDB_RECORD_H
@@ -34,6 +34,14 @@ namespace pinedb
          */
         virtual bool read_page(page_id_type page_id, uint8_t *buffer) = 0;
 
+        /**
+         * Reads many pages, each into its own buffer. Backends which can read pages with
+         * consecutive ids in one request override it, by default the pages are read one at a time
+         * @return true if every page was read
+         */
+        virtual bool read_pages(const std::vector<page_id_type> &page_ids,
+                                const std::vector<uint8_t *> &buffers);
+
         /**
          * This method writes a page to the storage and copies the contents of the buffer
          * @param page_id id of the page to be written
@@ -81,6 +89,9 @@ namespace pinedb
         DiskStorageBackend(const std::string &file_path, page_size_type page_sz);
         page_id_type create_new_page();
         bool read_page(page_id_type page_id, uint8_t *buffer);
+        // Pages with consecutive ids are read with one `readv`
+        bool read_pages(const std::vector<page_id_type> &page_ids,
+                        const std::vector<uint8_t *> &buffers);
         bool write_page(page_id_type page_id, uint8_t *buffer);
         bool delete_page(page_id_type page_id);
         page_size_type page_size();
@@ -0,0 +1,342 @@
+#ifndef PINEDB_STRINGBTREE_H
+#define PINEDB_STRINGBTREE_H
+
+#include "bufferpool.h"
+#include "datapacker.h"
+
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Disk based B+ tree with variable length keys, which maps byte strings to 64 bit values. Keys
+// are compared with memcmp (a key comes before the longer keys which start with it), so string
+// keys and composite keys of many columns are stored as normalized keys built by `KeyEncoder`.
+//
+// Nodes are slotted pages: a fixed size slot for every key, in key order, points to the bytes of
+// the key, which are stored from the end of the page. The prefix which is common to all the keys
+// of a node is stored once, and only the remaining suffixes are stored in the slots. When a leaf
+// is split, the separator which is copied into the parent is the shortest prefix of the first key
+// of the right leaf which is greater than the last key of the left leaf, and the split point is
+// moved near the middle to find a short separator, so internal nodes have a high fan out.
+//
+// As for `BTree`, the page id of the root does not change.
+namespace pinedb
+{
+    /**
+     * View of a page of a StringBTree
+     */
+    class StringBTreeNode
+    {
+        uint8_t *page;
+        size_t page_size;
+
+        template <typename T> T read(size_t offset) const
+        {
+            T value;
+            datapacker::bytes::decode<datapacker::endian::little>(page + offset, value);
+            return value;
+        }
+
+        template <typename T> void write(size_t offset, T value)
+        {
+            datapacker::bytes::encode<datapacker::endian::little>(page + offset, value);
+        }
+
+        size_t slot_size() const { return is_leaf() ? LEAF_SLOT_SIZE : INTERNAL_SLOT_SIZE; }
+
+        size_t slot_offset(uint32_t i) const
+        {
+            return HEADER_SIZE + get_prefix_length() + i * slot_size();
+        }
+
+        uint32_t get_data_start() const { return read<uint32_t>(DATA_START_OFFSET); }
+
+        uint16_t get_prefix_length() const { return read<uint16_t>(PREFIX_LENGTH_OFFSET); }
+
+        // Compares the suffix of the key in slot `i` with `suffix`, whose head is `head`
+        int compare_suffix(uint32_t i, std::string_view suffix, uint32_t head) const;
+
+        // Position of `key` relative to the prefix: negative if it comes before every key which
+        // starts with the prefix, positive if after, otherwise 0 and `suffix` is set
+        int compare_prefix(std::string_view key, std::string_view &suffix) const;
+
+      public:
+        static constexpr uint8_t INTERNAL_PAGE_TYPE = 0x1;
+        static constexpr uint8_t LEAF_PAGE_TYPE = 0x2;
+        static constexpr uint8_t KEY_TYPE = 'c';
+        static constexpr int HEADER_SIZE = 32;
+        // Page id of the next leaf of a leaf, or of the first child of an internal node
+        static constexpr size_t NEXT_LEAF_OFFSET = 16;
+        static constexpr size_t NUMBER_OF_KEYS_OFFSET = 20;
+        static constexpr size_t DATA_START_OFFSET = 24;
+        static constexpr size_t KEY_TYPE_OFFSET = 28;
+        static constexpr size_t PREFIX_LENGTH_OFFSET = 30;
+        // Offset and length of the suffix, its head, and the value or the child page id
+        static constexpr size_t LEAF_SLOT_SIZE = 16;
+        static constexpr size_t INTERNAL_SLOT_SIZE = 12;
+        // Slot offsets and lengths are 16 bit
+        static constexpr page_size_type MAX_PAGE_SIZE = 1 << 16;
+
+        /**
+         * Keys, and values or child page ids of a node, which are used to rebuild it
+         */
+        struct Contents
+        {
+            std::vector<std::string> keys;
+            // Values of a leaf, or the `keys.size() + 1` child page ids of an internal node
+            std::vector<uint64_t> links;
+        };
+
+        StringBTreeNode(uint8_t *page, size_t page_size) : page(page), page_size(page_size) {}
+
+        /**
+         * Bytes of a page which can be used by the prefix, the slots and the keys
+         */
+        static size_t capacity(size_t page_size) { return page_size - HEADER_SIZE; }
+
+        /**
+         * Longest key, it is small enough that a node which is split always fits in two pages
+         */
+        static size_t max_key_size(size_t page_size)
+        {
+            return capacity(page_size) / 4 - LEAF_SLOT_SIZE;
+        }
+
+        /**
+         * Bytes used by the keys `[begin, end)` of a node with their slots, after the common
+         * prefix is removed
+         * @param keys sorted keys
+         */
+        static size_t space_needed(const std::vector<std::string> &keys, size_t begin, size_t end,
+                                   bool leaf);
+
+        /**
+         * First 4 bytes of a suffix as a big endian integer, padded with zeros. If the heads of
+         * two suffixes are different, they are in the same order as the suffixes
+         */
+        static uint32_t head(std::string_view suffix);
+
+        void init(page_id_type page_id, bool leaf);
+
+        bool is_leaf() const { return page[0] == LEAF_PAGE_TYPE; }
+
+        uint8_t get_key_type() const { return page[KEY_TYPE_OFFSET]; }
+
+        uint32_t size() const { return read<uint32_t>(NUMBER_OF_KEYS_OFFSET); }
+
+        page_id_type get_next_leaf() const { return read<page_id_type>(NEXT_LEAF_OFFSET); }
+
+        void set_next_leaf(page_id_type page_id) { write(NEXT_LEAF_OFFSET, page_id); }
+
+        /**
+         * Prefix which is common to all the keys of the node
+         */
+        std::string_view prefix() const
+        {
+            return {reinterpret_cast<const char *>(page + HEADER_SIZE), get_prefix_length()};
+        }
+
+        /**
+         * Key `i` without the common prefix
+         */
+        std::string_view suffix(uint32_t i) const
+        {
+            auto slot = slot_offset(i);
+            return {reinterpret_cast<const char *>(page + read<uint16_t>(slot)),
+                    read<uint16_t>(slot + 2)};
+        }
+
+        std::string key(uint32_t i) const
+        {
+            std::string key(prefix());
+            key += suffix(i);
+            return key;
+        }
+
+        /**
+         * @return true if key `i` is equal to `key`
+         */
+        bool has_key(uint32_t i, std::string_view key) const
+        {
+            auto p = prefix();
+            return key.size() >= p.size() && key.substr(0, p.size()) == p
+                   && key.substr(p.size()) == suffix(i);
+        }
+
+        uint64_t value(uint32_t i) const { return read<uint64_t>(slot_offset(i) + 8); }
+
+        void set_value(uint32_t i, uint64_t value) { write(slot_offset(i) + 8, value); }
+
+        page_id_type child(uint32_t i) const
+        {
+            return i == 0 ? read<page_id_type>(NEXT_LEAF_OFFSET)
+                          : read<page_id_type>(slot_offset(i - 1) + 8);
+        }
+
+        /**
+         * Bytes used by the prefix, the slots and the keys, without the space of removed keys
+         */
+        size_t used_space() const;
+
+        /**
+         * Index of the first key which is not less than `key`, `size()` if there is none
+         */
+        uint32_t lower_bound(std::string_view key) const;
+
+        /**
+         * Index of the first key which is greater than `key`, which is also the index of the
+         * child of an internal node that can contain `key`
+         */
+        uint32_t upper_bound(std::string_view key) const;
+
+        /**
+         * Inserts a key at position `i`, with a value in a leaf or with the child `i + 1` in an
+         * internal node, without moving the other keys
+         * @return false if the key does not start with the prefix of the node, or there is not
+         * enough free space, the node is rebuilt with `load` in that case
+         */
+        bool insert(uint32_t i, std::string_view key, uint64_t link);
+
+        /**
+         * Removes the key at position `i`, and the value or the child `i + 1`. The space of the
+         * key is reused when the node is rebuilt
+         */
+        void remove(uint32_t i);
+
+        Contents get_contents() const;
+
+        /**
+         * Rebuilds the node with the given keys, and the common prefix of the keys
+         * @throws std::logic_error if the keys do not fit in the page
+         */
+        void load(page_id_type page_id, bool leaf, const Contents &contents);
+    };
+
+    class StringBTree
+    {
+        BufferPool &pool;
+        page_id_type root_page_id;
+
+        uint8_t *fetch(page_id_type page_id);
+
+        StringBTreeNode node(page_id_type page_id);
+
+        // Rebuilds the page from the contents, keeping the next leaf of a leaf
+        void store(page_id_type page_id, bool leaf, const StringBTreeNode::Contents &contents,
+                   page_id_type next_leaf = 0);
+
+        void check_key(std::string_view key) const;
+
+        // Result of inserting into a subtree, if the root of the subtree was split, the
+        // separator and the new right node have to be inserted into the parent
+        struct Split
+        {
+            bool split;
+            std::string separator;
+            page_id_type right_page_id;
+        };
+
+        // Inserts the key and link at position `i` of a node, splitting it if it is full
+        Split insert_at(page_id_type page_id, uint32_t i, std::string_view key, uint64_t link);
+
+        bool insert_into(page_id_type page_id, std::string_view key, uint64_t value,
+                         Split &split);
+
+        bool remove_from(page_id_type page_id, std::string_view key);
+
+        // A node is rebalanced when it uses less than a quarter of the page
+        bool is_underfull(page_id_type page_id);
+
+        // Fixes the child at `child_index` of the internal node, which is underfull, by merging
+        // it with a sibling, or by moving keys from the sibling
+        void rebalance(page_id_type page_id, uint32_t child_index);
+
+        page_id_type find_leaf(std::string_view key);
+
+      public:
+        /**
+         * Creates an empty tree
+         * @return page id of the root, which is used to open the tree
+         * @throws std::runtime_error if a page could not be created
+         * @throws std::logic_error if the page size is larger than `MAX_PAGE_SIZE`
+         */
+        static page_id_type create(BufferPool &pool);
+
+        /**
+         * Opens the tree whose root is `root_page_id`
+         * @throws std::runtime_error if the page is not the root of a tree with string keys
+         */
+        StringBTree(BufferPool &pool, page_id_type root_page_id);
+
+        page_id_type get_root_page_id() const { return root_page_id; }
+
+        /**
+         * Longest key which can be inserted
+         */
+        size_t max_key_size() const { return StringBTreeNode::max_key_size(pool.page_size()); }
+
+        /**
+         * Finds the value of the key
+         * @return false if the key is not in the tree
+         */
+        bool search(std::string_view key, uint64_t &value);
+
+        /**
+         * Inserts the key, splitting the nodes which are full
+         * @return false if the key is already in the tree, the value is not changed in that case
+         * @throws std::logic_error if the key is longer than `max_key_size()`
+         */
+        bool insert(std::string_view key, uint64_t value);
+
+        /**
+         * Changes the value of a key which is in the tree
+         * @return false if the key is not in the tree
+         */
+        bool update(std::string_view key, uint64_t value);
+
+        /**
+         * Removes the key, nodes which are underfull are merged with or take keys from a sibling
+         * @return false if the key is not in the tree
+         */
+        bool remove(std::string_view key);
+
+        /**
+         * Number of levels in the tree, 1 if the root is a leaf
+         */
+        int height();
+
+        /**
+         * Iterates over the keys in increasing order, using the links between the leaves
+         */
+        class Iterator
+        {
+            StringBTree &tree;
+            page_id_type page_id;
+            uint32_t index;
+
+          public:
+            Iterator(StringBTree &tree, page_id_type page_id, uint32_t index)
+                : tree(tree), page_id(page_id), index(index)
+            {
+            }
+
+            /**
+             * Reads the next key and value
+             * @return false if there are no more keys
+             */
+            bool next(std::string &key, uint64_t &value);
+        };
+
+        /**
+         * Iterator from the smallest key
+         */
+        Iterator begin();
+
+        /**
+         * Iterator from the first key which is not less than `key`
+         */
+        Iterator lower_bound(std::string_view key);
+    };
+}; // namespace pinedb
+#endif // PINEDB_STRINGBTREE_H
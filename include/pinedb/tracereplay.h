@@ -0,0 +1,83 @@
+#ifndef PINEDB_TRACEREPLAY_H
+#define PINEDB_TRACEREPLAY_H
+#include "cachereplacer.h"
+#include "common.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Utilities to generate page access traces, and to replay them against a cache replacer
+// to find out the hit ratio of a replacement policy for a given pool size
+namespace pinedb
+{
+    namespace trace
+    {
+        using trace_type = std::vector<page_id_type>;
+
+        /**
+         * Every page in `[0, number_of_pages)` is equally likely to be accessed
+         */
+        trace_type uniform(page_id_type number_of_pages, size_t length, uint64_t seed = 42);
+
+        /**
+         * Page `i` is accessed with a probability proportional to `1 / (i + 1)^skew`, a skew of
+         * `0` is the same as a uniform trace, larger values concentrate accesses on fewer pages
+         */
+        trace_type zipfian(page_id_type number_of_pages, size_t length, double skew,
+                           uint64_t seed = 42);
+
+        /**
+         * Every page is accessed exactly once, in order
+         */
+        trace_type sequential_scan(page_id_type number_of_pages);
+
+        /**
+         * Repeated sequential scans over `[0, number_of_pages)`, till `length` pages are accessed
+         */
+        trace_type looping(page_id_type number_of_pages, size_t length);
+
+        /**
+         * The first `hot_pages` pages are accessed at random with a probability of
+         * `hot_probability`, the other accesses are a sequential scan over the remaining pages
+         */
+        trace_type scan_hot_mix(page_id_type number_of_pages, page_id_type hot_pages,
+                                size_t length, double hot_probability, uint64_t seed = 42);
+
+        /**
+         * Writes the trace to a text file, with one page id per line
+         * @return true if the trace was written, false otherwise
+         */
+        bool save(const std::string &file_path, const trace_type &trace);
+
+        /**
+         * Reads a trace written by `save`, the contents of `trace` are replaced
+         * @return true if the trace was read, false otherwise
+         */
+        bool load(const std::string &file_path, trace_type &trace);
+    } // namespace trace
+
+    struct ReplayStats
+    {
+        size_t accesses = 0;
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+
+        double hit_ratio() const
+        {
+            return accesses == 0 ? 0.0
+                                 : static_cast<double>(hits) / static_cast<double>(accesses);
+        }
+    };
+
+    /**
+     * Simulates a buffer pool of `number_of_frames` frames which uses `cache_replacer`,
+     * without reading or writing any pages. The replacer should not have been used before.
+     * @return Number of hits, misses and evictions when the trace was replayed
+     */
+    ReplayStats replay_trace(const trace::trace_type &trace, int number_of_frames,
+                             CacheReplacer<frame_id_type> &cache_replacer);
+} // namespace pinedb
+#endif // PINEDB_TRACEREPLAY_H
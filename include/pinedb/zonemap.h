@@ -0,0 +1,122 @@
+#ifndef PINEDB_ZONEMAP_H
+#define PINEDB_ZONEMAP_H
+#include "bufferpool.h"
+#include "datapacker.h"
+#include "record.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Summary of the values in each page of a table, used by scans with range predicates to skip
+// the pages which cannot have a matching row without fetching them. For every data page, the
+// zone map stores the number of rows and the minimum and maximum value of each fixed width
+// column. Entries are stored in zone map pages and cached in memory, every change is written to
+// both. Columns cannot be null, so no null count is stored.
+namespace pinedb
+{
+    class ZoneMap
+    {
+        BufferPool &pool;
+        RecordLayout layout;
+        page_id_type first_page_id;
+        std::vector<page_id_type> map_pages;
+        // Cached copy of the entries, in the same format as the pages
+        std::vector<uint8_t> entries;
+        size_t number_of_entries;
+        size_t entry_size;
+        size_t entries_per_page;
+        // Position of the summary of each column in an entry, -1 for strings
+        std::vector<int> summary_index;
+
+        uint8_t *fetch(page_id_type page_id);
+
+        // Appends a new page to the map
+        void add_page();
+
+        // Writes an entry from the cache to its page
+        void write_entry(size_t position);
+
+        size_t summary_offset(size_t position, int column) const
+        {
+            return position * entry_size + ROWS_SIZE + summary_index.at(column) * 2 * VALUE_SIZE;
+        }
+
+        template <typename T> T read_value(size_t offset) const
+        {
+            T value;
+            datapacker::bytes::decode<datapacker::endian::little>(
+                const_cast<uint8_t *>(entries.data()) + offset, value);
+            return value;
+        }
+
+      public:
+        static constexpr uint8_t PAGE_TYPE = 0x5A;
+        // Common page header, followed by the page id of the next page of the map
+        static constexpr int HEADER_SIZE = 32;
+        // Entries start with the number of rows
+        static constexpr size_t ROWS_SIZE = 4;
+        // Minimum and maximum are stored in 8 bytes each, whatever the width of the column
+        static constexpr size_t VALUE_SIZE = 8;
+
+        /**
+         * Opens the zone map whose first page is `first_page_id`, or an empty map if it is 0
+         * @throws std::runtime_error if an entry does not fit in a page
+         */
+        ZoneMap(BufferPool &pool, const RecordLayout &layout, page_id_type first_page_id);
+
+        /**
+         * Page id of the first page of the map, 0 if the map does not have any page
+         */
+        page_id_type get_first_page_id() const { return first_page_id; }
+
+        /**
+         * Number of data pages which have an entry
+         */
+        size_t size() const { return number_of_entries; }
+
+        /**
+         * Adds a record to the summary of the data page at `position`, creating entries up to
+         * it if needed
+         */
+        void add(size_t position, const uint8_t *record);
+
+        /**
+         * Number of rows in the data page, as per the map
+         */
+        uint32_t number_of_rows(size_t position) const;
+
+        /**
+         * Reads the minimum and maximum value of a column in a data page
+         * @return false if the page does not have any rows
+         * @throws std::logic_error if the column does not store values of type `T`
+         */
+        template <typename T> bool get(size_t position, int column, T &min, T &max) const
+        {
+            if (layout.field(column).format != RecordLayout::format_of<T>())
+            {
+                throw std::logic_error("column " + std::to_string(column) + " has type '"
+                                       + std::string(1, layout.field(column).format) + "'");
+            }
+            if (number_of_rows(position) == 0)
+                return false;
+            auto offset = summary_offset(position, column);
+            min = read_value<T>(offset);
+            max = read_value<T>(offset + VALUE_SIZE);
+            return true;
+        }
+
+        /**
+         * @return false if no row of the data page can have a value of the column in
+         * `[low, high]`, which means that the page can be skipped
+         */
+        template <typename T> bool may_contain(size_t position, int column, T low, T high) const
+        {
+            T min, max;
+            if (!get(position, column, min, max))
+                return false;
+            return !(max < low || high < min);
+        }
+    };
+}; // namespace pinedb
+#endif // PINEDB_ZONEMAP_H
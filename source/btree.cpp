@@ -0,0 +1,1189 @@
+#include <algorithm>
+#include <cmath>
+#include <pinedb/btree.h>
+#include <pinedb/page.h>
+#include <stdexcept>
+#include <string.h>
+
+using namespace pinedb;
+
+namespace
+{
+    uint8_t *fetch_page(BufferPool &pool, page_id_type page_id)
+    {
+        auto page = pool.fetch_page(page_id);
+        if (page == nullptr)
+        {
+            throw std::runtime_error("could not read B+ tree page " + std::to_string(page_id));
+        }
+        return page;
+    }
+
+    page_id_type create_page(BufferPool &pool)
+    {
+        auto page_id = pool.new_page();
+        if (page_id == -1)
+        {
+            throw std::runtime_error("could not create a B+ tree page");
+        }
+        return page_id;
+    }
+
+    // The entry with the smallest key is on top of the merge heap of a sorter
+    template <typename Key>
+    bool heap_order(const std::tuple<Key, uint64_t, size_t> &a,
+                    const std::tuple<Key, uint64_t, size_t> &b)
+    {
+        return std::get<0>(b) < std::get<0>(a);
+    }
+
+    // Loads the header of a node and the keys which the first steps of a binary search read
+    // into the CPU cache, for nodes whose size is at least half of `max_keys`. The page may be
+    // evicted, a prefetch of memory which has been reused does no harm
+    template <typename Key> void prefetch_node(const uint8_t *page, uint32_t max_keys)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(page);
+        for (uint32_t i = 1; i <= 8; ++i)
+            __builtin_prefetch(page + BTreeNode<Key>::HEADER_SIZE
+                               + static_cast<size_t>(max_keys) * i / 8 * sizeof(Key));
+#else
+        (void)page;
+        (void)max_keys;
+#endif
+    }
+
+    // Changes the page id in the header of a copy of a page, before it is written to another page
+    void set_page_id(std::vector<uint8_t> &copy, page_id_type page_id)
+    {
+        PageHeader header;
+        header.read(copy.data());
+        header.set_page_id(page_id);
+        header.write(copy.data());
+    }
+
+    // Builds a B+ tree bottom up from sorted entries. Each level has a node which is being
+    // filled, and the previous node of the level, which is written only when the next node is
+    // full, so that the last two nodes can share their keys when the input ends
+    template <typename Key> class BulkLoader
+    {
+        struct Node
+        {
+            page_id_type page_id = -1;
+            // Smallest key under the node, which is its separator in the parent
+            Key first{};
+            std::vector<Key> keys;
+            // Values of a leaf, or the child page ids of an internal node
+            std::vector<uint64_t> links;
+            page_id_type next_leaf = 0;
+
+            bool empty() const { return links.empty(); }
+        };
+
+        struct Level
+        {
+            Node previous;
+            Node current;
+        };
+
+        BufferPool &pool;
+        uint32_t max_leaf_keys;
+        uint32_t max_internal_keys;
+        uint32_t leaf_target;
+        uint32_t internal_target;
+        std::vector<Level> levels;
+        bool has_last_key;
+        Key last_key;
+
+        static uint32_t target(uint32_t max_keys, uint32_t min_keys, double fill_factor)
+        {
+            auto keys = static_cast<uint32_t>(std::ceil(max_keys * fill_factor));
+            return std::min(max_keys, std::max(min_keys, keys));
+        }
+
+        // Writes the node to its page, and flushes it so that the pages are written in the order
+        // in which they are built
+        void write(const Node &node, bool leaf)
+        {
+            BTreeNode<Key> n(fetch_page(pool, node.page_id));
+            n.init(node.page_id, leaf, leaf ? max_leaf_keys : max_internal_keys);
+            for (uint32_t i = 0; i < node.keys.size(); ++i)
+                n.set_key(i, node.keys[i]);
+            for (uint32_t i = 0; i < node.links.size(); ++i)
+            {
+                if (leaf)
+                    n.set_value(i, node.links[i]);
+                else
+                    n.set_child(i, static_cast<page_id_type>(node.links[i]));
+            }
+            n.set_size(static_cast<uint32_t>(node.keys.size()));
+            n.set_next_leaf(node.next_leaf);
+            pool.set_dirty(node.page_id);
+            pool.flush_page(node.page_id);
+        }
+
+        // Appends a key and a value to the leaf level, or a separator and a child to an internal
+        // level. A full node is replaced by a new node, and is added to the level above
+        void append(size_t level, Key key, uint64_t link)
+        {
+            bool leaf = level == 0;
+            if (levels.size() == level)
+                levels.emplace_back();
+            auto &current = levels[level].current;
+            if (!current.empty() && current.keys.size() == (leaf ? leaf_target : internal_target))
+            {
+                auto page_id = create_page(pool);
+                if (leaf)
+                    current.next_leaf = page_id;
+                auto &previous = levels[level].previous;
+                if (!previous.empty())
+                    write(previous, leaf);
+                previous = std::move(current);
+                current = Node();
+                current.page_id = page_id;
+                // The levels may be reallocated
+                append(level + 1, previous.first, static_cast<uint64_t>(previous.page_id));
+            }
+
+            auto &node = levels[level].current;
+            if (node.empty())
+            {
+                if (node.page_id == -1)
+                    node.page_id = create_page(pool);
+                node.first = key;
+                if (leaf)
+                    node.keys.push_back(key);
+            }
+            else
+            {
+                node.keys.push_back(key);
+            }
+            node.links.push_back(link);
+        }
+
+        // Gives the last node of a level enough keys, by merging it into the previous node if all
+        // the keys fit (the last node is then empty), or by dividing the keys evenly between them
+        void balance(size_t level)
+        {
+            bool leaf = level == 0;
+            auto &left = levels[level].previous;
+            auto &right = levels[level].current;
+            auto max_keys = leaf ? max_leaf_keys : max_internal_keys;
+            auto min_keys = leaf ? max_keys / 2 : (max_keys - 1) / 2;
+            if (left.empty() || right.keys.size() >= min_keys)
+                return;
+
+            std::vector<Key> keys(left.keys);
+            // The separator of the right node moves down when the nodes are internal
+            if (!leaf)
+                keys.push_back(right.first);
+            keys.insert(keys.end(), right.keys.begin(), right.keys.end());
+            std::vector<uint64_t> links(left.links);
+            links.insert(links.end(), right.links.begin(), right.links.end());
+
+            if (keys.size() <= max_keys)
+            {
+                left.keys = std::move(keys);
+                left.links = std::move(links);
+                left.next_leaf = right.next_leaf;
+                pool.delete_page(right.page_id);
+                right = Node();
+                return;
+            }
+            auto k = keys.size() / 2;
+            auto child_split = leaf ? k : k + 1;
+            left.keys.assign(keys.begin(), keys.begin() + k);
+            left.links.assign(links.begin(), links.begin() + child_split);
+            right.first = keys[k];
+            right.keys.assign(keys.begin() + (leaf ? k : k + 1), keys.end());
+            right.links.assign(links.begin() + child_split, links.end());
+        }
+
+      public:
+        BulkLoader(BufferPool &pool, uint32_t max_leaf_keys, uint32_t max_internal_keys,
+                   double fill_factor)
+            : pool(pool), max_leaf_keys(max_leaf_keys), max_internal_keys(max_internal_keys),
+              leaf_target(target(max_leaf_keys, max_leaf_keys / 2, fill_factor)),
+              internal_target(target(max_internal_keys, (max_internal_keys - 1) / 2, fill_factor)),
+              has_last_key(false), last_key()
+        {
+        }
+
+        void add(Key key, uint64_t value)
+        {
+            if (has_last_key && !(last_key < key))
+            {
+                throw std::logic_error("keys of a B+ tree bulk load should be increasing");
+            }
+            has_last_key = true;
+            last_key = key;
+            append(0, key, value);
+        }
+
+        /**
+         * Writes the remaining nodes
+         * @return page id of the root, -1 if no entries were added
+         */
+        page_id_type finish()
+        {
+            for (size_t level = 0; level < levels.size(); ++level)
+            {
+                bool leaf = level == 0;
+                balance(level);
+                auto &previous = levels[level].previous;
+                if (!previous.empty())
+                    write(previous, leaf);
+                // The last node was merged into the previous node, which is in the level above.
+                // If it is the only child of the level above, it is the root, and the node of the
+                // level above, which has no keys, is not written
+                if (levels[level].current.empty())
+                {
+                    auto &above = levels[level + 1];
+                    if (above.previous.empty() && above.current.links.size() == 1)
+                    {
+                        pool.delete_page(above.current.page_id);
+                        return previous.page_id;
+                    }
+                    continue;
+                }
+                // A node was added to the level above only if this level has more than one node
+                if (level + 1 == levels.size())
+                {
+                    write(levels[level].current, leaf);
+                    return levels[level].current.page_id;
+                }
+                auto current = std::move(levels[level].current);
+                write(current, leaf);
+                append(level + 1, current.first, static_cast<uint64_t>(current.page_id));
+            }
+            return -1;
+        }
+    };
+} // namespace
+
+template <typename Key>
+void BTreeNode<Key>::init(page_id_type page_id, bool leaf, uint32_t max_keys)
+{
+    PageHeader header;
+    header.set_page_type(leaf ? LEAF_PAGE_TYPE : INTERNAL_PAGE_TYPE);
+    header.set_page_id(page_id);
+    header.write(page);
+    memset(page + NEXT_LEAF_OFFSET, 0, HEADER_SIZE - NEXT_LEAF_OFFSET);
+    write(MAX_KEYS_OFFSET, max_keys);
+    page[KEY_TYPE_OFFSET] = static_cast<uint8_t>(RecordLayout::format_of<Key>());
+}
+
+template <typename Key> void BTreeNode<Key>::insert_value(uint32_t i, Key key, uint64_t value)
+{
+    auto n = size();
+    auto keys = page + HEADER_SIZE;
+    auto values = page + links_offset();
+    memmove(keys + (i + 1) * sizeof(Key), keys + i * sizeof(Key), (n - i) * sizeof(Key));
+    memmove(values + (i + 1) * sizeof(uint64_t), values + i * sizeof(uint64_t),
+            (n - i) * sizeof(uint64_t));
+    set_key(i, key);
+    set_value(i, value);
+    set_size(n + 1);
+}
+
+template <typename Key> void BTreeNode<Key>::insert_child(uint32_t i, Key key, page_id_type child)
+{
+    auto n = size();
+    auto keys = page + HEADER_SIZE;
+    auto children = page + links_offset();
+    memmove(keys + (i + 1) * sizeof(Key), keys + i * sizeof(Key), (n - i) * sizeof(Key));
+    memmove(children + (i + 2) * sizeof(page_id_type), children + (i + 1) * sizeof(page_id_type),
+            (n - i) * sizeof(page_id_type));
+    set_key(i, key);
+    set_child(i + 1, child);
+    set_size(n + 1);
+}
+
+template <typename Key> void BTreeNode<Key>::remove_value(uint32_t i)
+{
+    auto n = size();
+    auto keys = page + HEADER_SIZE;
+    auto values = page + links_offset();
+    memmove(keys + i * sizeof(Key), keys + (i + 1) * sizeof(Key), (n - i - 1) * sizeof(Key));
+    memmove(values + i * sizeof(uint64_t), values + (i + 1) * sizeof(uint64_t),
+            (n - i - 1) * sizeof(uint64_t));
+    set_size(n - 1);
+}
+
+template <typename Key> void BTreeNode<Key>::remove_child(uint32_t i, uint32_t child_index)
+{
+    auto n = size();
+    auto keys = page + HEADER_SIZE;
+    auto children = page + links_offset();
+    memmove(keys + i * sizeof(Key), keys + (i + 1) * sizeof(Key), (n - i - 1) * sizeof(Key));
+    memmove(children + child_index * sizeof(page_id_type),
+            children + (child_index + 1) * sizeof(page_id_type),
+            (n - child_index) * sizeof(page_id_type));
+    set_size(n - 1);
+}
+
+template <typename Key>
+Key BTreeNode<Key>::split(BTreeNode &right, page_id_type right_page_id, uint32_t mid)
+{
+    auto n = size();
+    Key separator;
+    right.init(right_page_id, is_leaf(), get_max_keys());
+    if (is_leaf())
+    {
+        // The right node gets the upper keys, and its first key is copied into the parent
+        for (uint32_t j = mid; j < n; ++j)
+            right.insert_value(j - mid, key(j), value(j));
+        right.set_next_leaf(get_next_leaf());
+        set_next_leaf(right_page_id);
+        set_size(mid);
+        separator = right.key(0);
+    }
+    else
+    {
+        // The middle key is moved into the parent
+        separator = key(mid);
+        right.set_child(0, child(mid + 1));
+        for (uint32_t j = mid + 1; j < n; ++j)
+            right.insert_child(j - mid - 1, key(j), child(j + 1));
+        set_size(mid);
+    }
+    return separator;
+}
+
+template <typename Key>
+void BTree<Key>::node_sizes(BufferPool &pool, uint32_t max_keys, uint32_t &leaf,
+                            uint32_t &internal)
+{
+    leaf = BTreeNode<Key>::capacity(pool.page_size(), true);
+    internal = BTreeNode<Key>::capacity(pool.page_size(), false);
+    if (leaf < 3)
+    {
+        throw std::logic_error("page size is too small for a B+ tree");
+    }
+    if (max_keys != 0 && (max_keys < 3 || max_keys > leaf))
+    {
+        throw std::logic_error("invalid number of keys in a B+ tree node");
+    }
+    if (max_keys != 0)
+    {
+        leaf = max_keys;
+        internal = max_keys;
+    }
+}
+
+template <typename Key> page_id_type BTree<Key>::create(BufferPool &pool, uint32_t max_keys)
+{
+    uint32_t max_leaf_keys, max_internal_keys;
+    node_sizes(pool, max_keys, max_leaf_keys, max_internal_keys);
+    auto page_id = pool.new_page();
+    auto page = page_id == -1 ? nullptr : pool.fetch_page(page_id);
+    if (page == nullptr)
+    {
+        throw std::runtime_error("could not create the root of the B+ tree");
+    }
+    BTreeNode<Key>(page).init(page_id, true, max_leaf_keys);
+    pool.set_dirty(page_id);
+    return page_id;
+}
+
+template <typename Key>
+page_id_type BTree<Key>::bulk_load(BufferPool &pool,
+                                   const std::function<bool(Key &, uint64_t &)> &next,
+                                   double fill_factor, uint32_t max_keys)
+{
+    if (!(fill_factor > 0 && fill_factor <= 1))
+    {
+        throw std::logic_error("fill factor of a B+ tree should be in (0, 1]");
+    }
+    uint32_t max_leaf_keys, max_internal_keys;
+    node_sizes(pool, max_keys, max_leaf_keys, max_internal_keys);
+    BulkLoader<Key> loader(pool, max_leaf_keys, max_internal_keys, fill_factor);
+    Key key;
+    uint64_t value;
+    while (next(key, value))
+    {
+        check_key(key);
+        loader.add(key, value);
+    }
+    auto root_page_id = loader.finish();
+    return root_page_id == -1 ? create(pool, max_keys) : root_page_id;
+}
+
+template <typename Key>
+BTree<Key>::BTree(BufferPool &pool, page_id_type root_page_id)
+    : pool(pool), root_page_id(root_page_id), max_leaf_keys(0), max_internal_keys(0),
+      rightmost_leaf(-1)
+{
+    auto page = fetch(root_page_id);
+    BTreeNode<Key> root(page);
+    bool is_node = page[0] == BTreeNode<Key>::LEAF_PAGE_TYPE
+                   || page[0] == BTreeNode<Key>::INTERNAL_PAGE_TYPE;
+    if (!is_node || root.get_key_type() != RecordLayout::format_of<Key>())
+    {
+        throw std::runtime_error("page " + std::to_string(root_page_id)
+                                 + " is not the root of a B+ tree with keys of type '"
+                                 + std::string(1, RecordLayout::format_of<Key>()) + "'");
+    }
+    auto leaf_capacity = BTreeNode<Key>::capacity(pool.page_size(), true);
+    auto internal_capacity = BTreeNode<Key>::capacity(pool.page_size(), false);
+    if (root.is_leaf())
+    {
+        // Nodes are as large as possible, unless a smaller size was given for both kinds
+        max_leaf_keys = root.get_max_keys();
+        max_internal_keys = max_leaf_keys == leaf_capacity ? internal_capacity : max_leaf_keys;
+        return;
+    }
+    max_internal_keys = root.get_max_keys();
+    page_id_type page_id = root.child(0);
+    while (true)
+    {
+        BTreeNode<Key> node(fetch(page_id));
+        if (node.is_leaf())
+        {
+            max_leaf_keys = node.get_max_keys();
+            break;
+        }
+        page_id = node.child(0);
+    }
+}
+
+template <typename Key> uint8_t *BTree<Key>::fetch(page_id_type page_id)
+{
+    return fetch_page(pool, page_id);
+}
+
+template <typename Key> uint8_t *BTree<Key>::fetch_child(uint8_t *page, uint32_t i)
+{
+    auto page_id = BTreeNode<Key>(page).child(i);
+    auto child = pool.fetch_child(page, i, page_id);
+    if (child == nullptr)
+    {
+        throw std::runtime_error("could not read B+ tree page " + std::to_string(page_id));
+    }
+    return child;
+}
+
+template <typename Key> typename BTree<Key>::PageCopy BTree<Key>::read_copy(page_id_type page_id)
+{
+    auto page = fetch(page_id);
+    return PageCopy(page, page + pool.page_size());
+}
+
+template <typename Key> void BTree<Key>::write_copy(page_id_type page_id, const PageCopy &copy)
+{
+    memcpy(fetch(page_id), copy.data(), copy.size());
+    pool.set_dirty(page_id);
+}
+
+template <typename Key> page_id_type BTree<Key>::new_page() { return create_page(pool); }
+
+template <typename Key> void BTree<Key>::check_key(Key key)
+{
+    if constexpr (std::is_floating_point<Key>::value)
+    {
+        if (std::isnan(key))
+        {
+            throw std::logic_error("NaN cannot be used as a B+ tree key");
+        }
+    }
+}
+
+template <typename Key> uint8_t *BTree<Key>::find_leaf(Key key, page_id_type &page_id)
+{
+    page_id = root_page_id;
+    auto page = fetch(page_id);
+    while (true)
+    {
+        BTreeNode<Key> node(page);
+        if (node.is_leaf())
+            return page;
+        auto i = node.upper_bound(key);
+        page_id = node.child(i);
+        page = fetch_child(page, i);
+    }
+}
+
+template <typename Key> bool BTree<Key>::search(Key key, uint64_t &value)
+{
+    page_id_type page_id;
+    BTreeNode<Key> leaf(find_leaf(key, page_id));
+    auto i = leaf.lower_bound(key);
+    if (i == leaf.size() || leaf.key(i) != key)
+        return false;
+    value = leaf.value(i);
+    return true;
+}
+
+template <typename Key>
+void BTree<Key>::multi_get_from(page_id_type page_id, MultiGet &batch, size_t first, size_t last)
+{
+    BTreeNode<Key> node(fetch(page_id));
+    if (node.is_leaf())
+    {
+        // The keys are sorted, so each search starts at the position of the previous key
+        uint32_t i = 0;
+        for (auto k = first; k < last; ++k)
+        {
+            auto index = batch.order[k];
+            i = node.lower_bound(batch.keys[index], i);
+            if (i < node.size() && node.key(i) == batch.keys[index])
+            {
+                batch.values[index] = node.value(i);
+                batch.found[index] = true;
+                ++batch.count;
+            }
+        }
+        return;
+    }
+
+    // Splits the keys between the children, the page ids are read before any child is fetched,
+    // which may evict the node
+    struct Child
+    {
+        page_id_type page_id;
+        size_t first;
+        size_t last;
+    };
+    std::vector<Child> children;
+    uint32_t child = 0;
+    for (auto k = first; k < last;)
+    {
+        child = node.upper_bound(batch.keys[batch.order[k]], child);
+        auto end = k + 1;
+        while (end < last
+               && (child == node.size() || batch.keys[batch.order[end]] < node.key(child)))
+            ++end;
+        children.push_back({node.child(child), k, end});
+        k = end;
+    }
+
+    // The children which are not in the pool are read ahead of the one which is searched, and
+    // the next child, which is usually in the pool, is loaded into the CPU cache while the
+    // current one is searched
+    size_t prefetched = 1;
+    for (size_t j = 0; j < children.size(); ++j)
+    {
+        for (; prefetched < children.size() && prefetched <= j + DEFAULT_PREFETCH_LEAVES;
+             ++prefetched)
+        {
+            if (!pool.prefetch_page(children[prefetched].page_id))
+                break;
+        }
+        if (j + 1 < children.size())
+        {
+            auto next = pool.resident_page(children[j + 1].page_id);
+            if (next != nullptr)
+                prefetch_node<Key>(next, std::max(max_leaf_keys, max_internal_keys));
+        }
+        multi_get_from(children[j].page_id, batch, children[j].first, children[j].last);
+    }
+}
+
+template <typename Key>
+size_t BTree<Key>::multi_get(const std::vector<Key> &keys, std::vector<uint64_t> &values,
+                             std::vector<bool> &found)
+{
+    values.assign(keys.size(), 0);
+    found.assign(keys.size(), false);
+    MultiGet batch{keys, {}, values, found, 0};
+    batch.order.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        // NaN cannot be sorted, and is never in the tree
+        if constexpr (std::is_floating_point<Key>::value)
+        {
+            if (std::isnan(keys[i]))
+                continue;
+        }
+        batch.order.push_back(i);
+    }
+    std::sort(batch.order.begin(), batch.order.end(),
+              [&keys](size_t a, size_t b) { return keys[a] < keys[b]; });
+    if (!batch.order.empty())
+        multi_get_from(root_page_id, batch, 0, batch.order.size());
+    return batch.count;
+}
+
+template <typename Key> bool BTree<Key>::update(Key key, uint64_t value)
+{
+    page_id_type page_id;
+    BTreeNode<Key> leaf(find_leaf(key, page_id));
+    auto i = leaf.lower_bound(key);
+    if (i == leaf.size() || leaf.key(i) != key)
+        return false;
+    leaf.set_value(i, value);
+    pool.set_dirty(page_id);
+    return true;
+}
+
+template <typename Key>
+typename BTree<Key>::Split BTree<Key>::split_node(page_id_type page_id, bool append)
+{
+    auto right_page_id = new_page();
+    auto left_copy = read_copy(page_id);
+    PageCopy right_copy(left_copy.size(), 0);
+    BTreeNode<Key> left(left_copy.data()), right(right_copy.data());
+    auto n = left.size();
+    auto mid = n / 2;
+    if (append)
+    {
+        auto keys = static_cast<uint32_t>(n * DEFAULT_FILL_FACTOR);
+        mid = std::min(n - 1, std::max(min_keys(left.is_leaf()), keys));
+    }
+    auto separator = left.split(right, right_page_id, mid);
+    write_copy(page_id, left_copy);
+    write_copy(right_page_id, right_copy);
+    return {true, separator, right_page_id};
+}
+
+template <typename Key>
+bool BTree<Key>::insert_into(page_id_type page_id, uint8_t *page, Key key, uint64_t value,
+                             Split &split, bool rightmost)
+{
+    split.split = false;
+    BTreeNode<Key> node(page);
+    if (node.is_leaf())
+    {
+        auto i = node.lower_bound(key);
+        if (i < node.size() && node.key(i) == key)
+            return false;
+        if (node.size() < node.get_max_keys())
+        {
+            node.insert_value(i, key, value);
+            pool.set_dirty(page_id);
+            if (rightmost)
+                rightmost_leaf = page_id;
+            return true;
+        }
+        split = split_node(page_id, rightmost && i == node.size());
+        if (rightmost)
+            rightmost_leaf = split.right_page_id;
+        auto target_page_id = key < split.separator ? page_id : split.right_page_id;
+        BTreeNode<Key> target(fetch(target_page_id));
+        target.insert_value(target.lower_bound(key), key, value);
+        pool.set_dirty(target_page_id);
+        return true;
+    }
+
+    auto i = node.upper_bound(key);
+    bool rightmost_child = rightmost && i == node.size();
+    Split child_split;
+    auto child_page_id = node.child(i);
+    if (!insert_into(child_page_id, fetch_child(page, i), key, value, child_split,
+                     rightmost_child))
+        return false;
+    if (!child_split.split)
+        return true;
+
+    BTreeNode<Key> parent(fetch(page_id));
+    if (parent.size() < parent.get_max_keys())
+    {
+        parent.insert_child(i, child_split.separator, child_split.right_page_id);
+        pool.set_dirty(page_id);
+        return true;
+    }
+    split = split_node(page_id, rightmost_child);
+    auto target_page_id
+        = child_split.separator < split.separator ? page_id : split.right_page_id;
+    BTreeNode<Key> target(fetch(target_page_id));
+    target.insert_child(target.upper_bound(child_split.separator), child_split.separator,
+                        child_split.right_page_id);
+    pool.set_dirty(target_page_id);
+    return true;
+}
+
+template <typename Key> bool BTree<Key>::append_to_rightmost(Key key, uint64_t value)
+{
+    if (rightmost_leaf == -1)
+        return false;
+    // The leaf may have become an internal node (the root), it is then found again by the descent
+    BTreeNode<Key> leaf(fetch(rightmost_leaf));
+    auto n = leaf.size();
+    if (!leaf.is_leaf() || leaf.get_next_leaf() != 0 || n == 0 || n == leaf.get_max_keys()
+        || !(leaf.key(n - 1) < key))
+        return false;
+    leaf.insert_value(n, key, value);
+    pool.set_dirty(rightmost_leaf);
+    return true;
+}
+
+template <typename Key> bool BTree<Key>::insert(Key key, uint64_t value)
+{
+    check_key(key);
+    if (append_to_rightmost(key, value))
+        return true;
+    Split split;
+    if (!insert_into(root_page_id, fetch(root_page_id), key, value, split, true))
+        return false;
+    if (split.split)
+    {
+        // Move the left half of the root to a new page, so that the root page id does not change
+        auto left_page_id = new_page();
+        auto copy = read_copy(root_page_id);
+        set_page_id(copy, left_page_id);
+        write_copy(left_page_id, copy);
+
+        BTreeNode<Key> root(fetch(root_page_id));
+        root.init(root_page_id, false, max_internal_keys);
+        root.set_child(0, left_page_id);
+        root.insert_child(0, split.separator, split.right_page_id);
+        pool.set_dirty(root_page_id);
+    }
+    return true;
+}
+
+template <typename Key> void BTree<Key>::rebalance(page_id_type page_id, uint32_t child_index)
+{
+    // The child is paired with its left sibling, or with its right sibling if it is the first
+    auto parent_copy = read_copy(page_id);
+    BTreeNode<Key> parent(parent_copy.data());
+    bool from_left = child_index > 0;
+    auto left_index = from_left ? child_index - 1 : child_index;
+    auto left_page_id = parent.child(left_index);
+    auto right_page_id = parent.child(left_index + 1);
+    auto left_copy = read_copy(left_page_id);
+    auto right_copy = read_copy(right_page_id);
+    BTreeNode<Key> left(left_copy.data()), right(right_copy.data());
+    bool leaf = left.is_leaf();
+    auto &sibling = from_left ? left : right;
+
+    if (sibling.size() > min_keys(leaf))
+    {
+        if (from_left && leaf)
+        {
+            auto last = left.size() - 1;
+            right.insert_value(0, left.key(last), left.value(last));
+            left.set_size(last);
+            parent.set_key(left_index, right.key(0));
+        }
+        else if (from_left)
+        {
+            // The separator moves down to the child, and the last key of the sibling moves up
+            auto last = left.size() - 1;
+            right.insert_child(0, parent.key(left_index), right.child(0));
+            right.set_child(0, left.child(last + 1));
+            parent.set_key(left_index, left.key(last));
+            left.set_size(last);
+        }
+        else if (leaf)
+        {
+            left.insert_value(left.size(), right.key(0), right.value(0));
+            right.remove_value(0);
+            parent.set_key(left_index, right.key(0));
+        }
+        else
+        {
+            left.insert_child(left.size(), parent.key(left_index), right.child(0));
+            parent.set_key(left_index, right.key(0));
+            right.remove_child(0, 0);
+        }
+        write_copy(left_page_id, left_copy);
+        write_copy(right_page_id, right_copy);
+        write_copy(page_id, parent_copy);
+        return;
+    }
+
+    // Merge the right node into the left node, and remove it from the parent
+    if (leaf)
+    {
+        for (uint32_t j = 0; j < right.size(); ++j)
+            left.insert_value(left.size(), right.key(j), right.value(j));
+        left.set_next_leaf(right.get_next_leaf());
+    }
+    else
+    {
+        left.insert_child(left.size(), parent.key(left_index), right.child(0));
+        for (uint32_t j = 0; j < right.size(); ++j)
+            left.insert_child(left.size(), right.key(j), right.child(j + 1));
+    }
+    parent.remove_child(left_index, left_index + 1);
+    write_copy(left_page_id, left_copy);
+    write_copy(page_id, parent_copy);
+    pool.delete_page(right_page_id);
+    rightmost_leaf = -1;
+}
+
+template <typename Key> bool BTree<Key>::remove_from(page_id_type page_id, uint8_t *page, Key key)
+{
+    BTreeNode<Key> node(page);
+    if (node.is_leaf())
+    {
+        auto i = node.lower_bound(key);
+        if (i == node.size() || node.key(i) != key)
+            return false;
+        node.remove_value(i);
+        pool.set_dirty(page_id);
+        return true;
+    }
+    auto i = node.upper_bound(key);
+    auto child_page_id = node.child(i);
+    if (!remove_from(child_page_id, fetch_child(page, i), key))
+        return false;
+    BTreeNode<Key> child(fetch(child_page_id));
+    if (child.size() < min_keys(child.is_leaf()))
+        rebalance(page_id, i);
+    return true;
+}
+
+template <typename Key> bool BTree<Key>::remove(Key key)
+{
+    if (!remove_from(root_page_id, fetch(root_page_id), key))
+        return false;
+    BTreeNode<Key> root(fetch(root_page_id));
+    if (!root.is_leaf() && root.size() == 0)
+    {
+        // The root has a single child, move the child into the root page
+        auto child_page_id = root.child(0);
+        auto copy = read_copy(child_page_id);
+        set_page_id(copy, root_page_id);
+        write_copy(root_page_id, copy);
+        pool.delete_page(child_page_id);
+        rightmost_leaf = -1;
+    }
+    return true;
+}
+
+template <typename Key> int BTree<Key>::height()
+{
+    int levels = 1;
+    page_id_type page_id = root_page_id;
+    while (true)
+    {
+        BTreeNode<Key> node(fetch(page_id));
+        if (node.is_leaf())
+            return levels;
+        page_id = node.child(0);
+        ++levels;
+    }
+}
+
+template <typename Key> bool BTree<Key>::Iterator::step(bool forward)
+{
+    // Finds the lowest node on the path which has a child after (or before) the one followed
+    auto level = path.size();
+    page_id_type child = 0;
+    while (level > 0)
+    {
+        auto &l = path[level - 1];
+        BTreeNode<Key> node(tree.fetch(l.page_id));
+        if (forward ? l.child < node.size() : l.child > 0)
+        {
+            l.child = forward ? l.child + 1 : l.child - 1;
+            child = node.child(l.child);
+            break;
+        }
+        --level;
+    }
+    if (level == 0)
+        return false;
+    path.resize(level);
+
+    // Follows the first (or last) children down to the leaf
+    while (true)
+    {
+        BTreeNode<Key> node(tree.fetch(child));
+        if (node.is_leaf())
+        {
+            index = forward ? 0 : node.size();
+            break;
+        }
+        auto i = forward ? 0 : node.size();
+        path.push_back({child, i});
+        child = node.child(i);
+    }
+    page_id = child;
+    prefetch(forward);
+    return true;
+}
+
+template <typename Key> void BTree<Key>::Iterator::prefetch(bool forward)
+{
+    if (path.empty() || prefetch_leaves == 0)
+        return;
+    const auto &parent = path.back();
+    int64_t child = parent.child;
+    int64_t step = forward ? 1 : -1;
+    if (parent.page_id != prefetched_parent || forward != prefetched_forward)
+    {
+        prefetched_parent = parent.page_id;
+        prefetched_forward = forward;
+        prefetched_until = child;
+    }
+
+    // The page ids are read before any page is prefetched, which may evict the parent
+    BTreeNode<Key> node(tree.fetch(parent.page_id));
+    int64_t last = forward ? std::min<int64_t>(child + prefetch_leaves, node.size())
+                           : std::max<int64_t>(child - prefetch_leaves, 0);
+    std::vector<page_id_type> leaves;
+    for (auto i = (forward ? std::max(child, prefetched_until) : std::min(child, prefetched_until))
+                  + step;
+         forward ? i <= last : i >= last; i += step)
+        leaves.push_back(node.child(static_cast<uint32_t>(i)));
+
+    // Leaves which the pool does not prefetch now are prefetched after the next leaf is read
+    for (auto leaf : leaves)
+    {
+        if (!tree.pool.prefetch_page(leaf))
+            break;
+        prefetched_until += step;
+    }
+}
+
+template <typename Key> bool BTree<Key>::Iterator::next(Key &key, uint64_t &value)
+{
+    while (true)
+    {
+        BTreeNode<Key> leaf(tree.fetch(page_id));
+        if (index < leaf.size())
+        {
+            key = leaf.key(index);
+            value = leaf.value(index);
+            ++index;
+            return true;
+        }
+        if (!step(true))
+            return false;
+    }
+}
+
+template <typename Key> bool BTree<Key>::Iterator::prev(Key &key, uint64_t &value)
+{
+    while (true)
+    {
+        BTreeNode<Key> leaf(tree.fetch(page_id));
+        if (index > 0)
+        {
+            --index;
+            key = leaf.key(index);
+            value = leaf.value(index);
+            return true;
+        }
+        if (!step(false))
+            return false;
+    }
+}
+
+template <typename Key>
+void BTree<Key>::Iterator::seek(bool forward,
+                                const std::function<uint32_t(const BTreeNode<Key> &)> &position)
+{
+    page_id = tree.root_page_id;
+    auto page = tree.fetch(page_id);
+    while (true)
+    {
+        BTreeNode<Key> node(page);
+        auto i = position(node);
+        if (node.is_leaf())
+        {
+            index = i;
+            break;
+        }
+        path.push_back({page_id, i});
+        page_id = node.child(i);
+        page = tree.fetch_child(page, i);
+    }
+    prefetch(forward);
+}
+
+template <typename Key> typename BTree<Key>::Iterator BTree<Key>::begin(uint32_t prefetch_leaves)
+{
+    Iterator iter(*this, prefetch_leaves);
+    iter.seek(true, [](const BTreeNode<Key> &) { return 0u; });
+    return iter;
+}
+
+template <typename Key> typename BTree<Key>::Iterator BTree<Key>::end(uint32_t prefetch_leaves)
+{
+    Iterator iter(*this, prefetch_leaves);
+    iter.seek(false, [](const BTreeNode<Key> &node) { return node.size(); });
+    return iter;
+}
+
+template <typename Key>
+typename BTree<Key>::Iterator BTree<Key>::lower_bound(Key key, uint32_t prefetch_leaves)
+{
+    Iterator iter(*this, prefetch_leaves);
+    iter.seek(true,
+              [key](const BTreeNode<Key> &node)
+              { return node.is_leaf() ? node.lower_bound(key) : node.upper_bound(key); });
+    return iter;
+}
+
+template <typename Key>
+BTreeSorter<Key>::BTreeSorter(BufferPool &pool, size_t memory_entries)
+    : pool(pool), memory_entries(std::max<size_t>(memory_entries, 1)), reading(false), position(0)
+{
+}
+
+template <typename Key> BTreeSorter<Key>::~BTreeSorter()
+{
+    std::vector<page_id_type> remaining;
+    if (reading)
+    {
+        for (const auto &cursor : cursors)
+            remaining.push_back(cursor.page_id);
+    }
+    else
+    {
+        remaining = runs;
+    }
+    for (auto page_id : remaining)
+    {
+        while (page_id != 0)
+        {
+            auto page = pool.fetch_page(page_id);
+            if (page == nullptr)
+                break;
+            page_id_type next_page_id;
+            datapacker::bytes::decode_le(page + 16, next_page_id);
+            pool.delete_page(page_id);
+            page_id = next_page_id;
+        }
+    }
+}
+
+template <typename Key> void BTreeSorter<Key>::spill()
+{
+    if (entries.empty())
+        return;
+    std::sort(entries.begin(), entries.end(),
+              [](const auto &a, const auto &b) { return a.first < b.first; });
+    auto per_page = entries_per_page();
+    auto page_id = create_page(pool);
+    runs.push_back(page_id);
+    for (size_t start = 0; start < entries.size(); start += per_page)
+    {
+        auto count = static_cast<uint32_t>(std::min<size_t>(per_page, entries.size() - start));
+        // The next page is created before the page is written, so that it is written once
+        page_id_type next_page_id = start + count < entries.size() ? create_page(pool) : 0;
+        auto page = fetch_page(pool, page_id);
+        PageHeader header;
+        header.set_page_type(RUN_PAGE_TYPE);
+        header.set_page_id(page_id);
+        header.write(page);
+        datapacker::bytes::encode_le(page + 16, next_page_id, count);
+        auto entry = page + HEADER_SIZE;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            datapacker::bytes::encode<datapacker::endian::little>(entry, entries[start + i].first);
+            datapacker::bytes::encode_le(entry + sizeof(Key), entries[start + i].second);
+            entry += sizeof(Key) + sizeof(uint64_t);
+        }
+        pool.set_dirty(page_id);
+        pool.flush_page(page_id);
+        page_id = next_page_id;
+    }
+    entries.clear();
+}
+
+template <typename Key> void BTreeSorter<Key>::advance(size_t run)
+{
+    auto &cursor = cursors[run];
+    while (cursor.page_id != 0)
+    {
+        auto page = fetch_page(pool, cursor.page_id);
+        page_id_type next_page_id;
+        uint32_t count;
+        datapacker::bytes::decode_le(page + 16, next_page_id, count);
+        if (cursor.index < count)
+        {
+            auto entry = page + HEADER_SIZE + cursor.index * (sizeof(Key) + sizeof(uint64_t));
+            Key key;
+            uint64_t value;
+            datapacker::bytes::decode<datapacker::endian::little>(entry, key);
+            datapacker::bytes::decode_le(entry + sizeof(Key), value);
+            ++cursor.index;
+            heap.emplace_back(key, value, run);
+            std::push_heap(heap.begin(), heap.end(), heap_order<Key>);
+            return;
+        }
+        pool.delete_page(cursor.page_id);
+        cursor = {next_page_id, 0};
+    }
+}
+
+template <typename Key> void BTreeSorter<Key>::add(Key key, uint64_t value)
+{
+    if (reading)
+    {
+        throw std::logic_error("entries cannot be added to a sorter which is being read");
+    }
+    entries.emplace_back(key, value);
+    if (entries.size() >= memory_entries)
+        spill();
+}
+
+template <typename Key> bool BTreeSorter<Key>::next(Key &key, uint64_t &value)
+{
+    if (!reading)
+    {
+        reading = true;
+        if (runs.empty())
+        {
+            std::sort(entries.begin(), entries.end(),
+                      [](const auto &a, const auto &b) { return a.first < b.first; });
+        }
+        else
+        {
+            spill();
+            for (auto page_id : runs)
+                cursors.push_back({page_id, 0});
+            for (size_t run = 0; run < runs.size(); ++run)
+                advance(run);
+        }
+    }
+    if (runs.empty())
+    {
+        if (position == entries.size())
+            return false;
+        key = entries[position].first;
+        value = entries[position].second;
+        ++position;
+        return true;
+    }
+    if (heap.empty())
+        return false;
+    std::pop_heap(heap.begin(), heap.end(), heap_order<Key>);
+    size_t run;
+    std::tie(key, value, run) = heap.back();
+    heap.pop_back();
+    advance(run);
+    return true;
+}
+
+namespace pinedb
+{
+    // One instantiation for each fixed width column type
+    template class BTreeNode<uint8_t>;
+    template class BTreeNode<int8_t>;
+    template class BTreeNode<uint16_t>;
+    template class BTreeNode<int16_t>;
+    template class BTreeNode<uint32_t>;
+    template class BTreeNode<int32_t>;
+    template class BTreeNode<uint64_t>;
+    template class BTreeNode<int64_t>;
+    template class BTreeNode<float>;
+    template class BTreeNode<double>;
+
+    template class BTree<uint8_t>;
+    template class BTree<int8_t>;
+    template class BTree<uint16_t>;
+    template class BTree<int16_t>;
+    template class BTree<uint32_t>;
+    template class BTree<int32_t>;
+    template class BTree<uint64_t>;
+    template class BTree<int64_t>;
+    template class BTree<float>;
+    template class BTree<double>;
+
+    template class BTreeSorter<uint8_t>;
+    template class BTreeSorter<int8_t>;
+    template class BTreeSorter<uint16_t>;
+    template class BTreeSorter<int16_t>;
+    template class BTreeSorter<uint32_t>;
+    template class BTreeSorter<int32_t>;
+    template class BTreeSorter<uint64_t>;
+    template class BTreeSorter<int64_t>;
+    template class BTreeSorter<float>;
+    template class BTreeSorter<double>;
+} // namespace pinedb
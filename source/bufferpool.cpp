@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <pinedb/bufferpool.h>
 #include <spdlog/spdlog.h>
 
@@ -6,7 +7,27 @@ using namespace pinedb;
 bool BufferPool::evict()
 {
     spdlog::info("Evicting a frame from the pool");
-    auto opt = cache_replacer.evict();
+    // Frames whose latch is held by a writer are given back to the replacer, and another frame is
+    // chosen. Fetches through a swizzle slot are not seen by the replacer, so a frame which is
+    // swizzled is unswizzled and given back to the replacer as if it was accessed, it is evicted
+    // when it is chosen again, unless it is fetched through its parent before that
+    std::vector<frame_id_type> latched;
+    std::optional<frame_id_type> opt;
+    while (true)
+    {
+        opt = cache_replacer.evict();
+        if (opt.has_value() && swizzled_by[opt.value()].first != -1)
+        {
+            unswizzle(opt.value());
+            cache_replacer.access(opt.value());
+            continue;
+        }
+        if (!opt.has_value() || latches[opt.value()].try_write_lock())
+            break;
+        latched.push_back(opt.value());
+    }
+    for (auto frame_id : latched)
+        cache_replacer.access(frame_id);
     if (!opt.has_value())
     {
         spdlog::warn("BufferPool has run out of memory, cannot evict frame to make space for a "
@@ -20,6 +41,7 @@ bool BufferPool::evict()
     if (dirty_frames[opt.value()])
     {
         spdlog::info("Frame {} is dirty, writing to storage", opt.value());
+        std::lock_guard<std::mutex> storage_guard(storage_mutex);
         bool status = storage_backend.write_page(pageid, get_buffer_ptr(opt.value()));
         if (!status)
         {
@@ -27,20 +49,86 @@ bool BufferPool::evict()
         }
         dirty_frames[opt.value()] = false;
     }
-    page_to_frame_map.erase(pageid);
-    frame_to_page_map.erase(opt.value());
+    unswizzle_children(opt.value());
+    unmap_page(pageid, opt.value());
     free_frames.push_back(opt.value());
     return true;
 }
 
+void BufferPool::map_page(page_id_type pageid, frame_id_type frameid)
+{
+    page_to_frame_map[pageid] = frameid;
+    frame_to_page_map[frameid] = pageid;
+    frame_pages[frameid].store(pageid, std::memory_order_release);
+}
+
+void BufferPool::unmap_page(page_id_type pageid, frame_id_type frameid)
+{
+    page_to_frame_map.erase(pageid);
+    frame_to_page_map.erase(frameid);
+    frame_pages[frameid].store(-1, std::memory_order_release);
+}
+
+void BufferPool::unswizzle(frame_id_type frameid)
+{
+    auto [parent, slot] = swizzled_by[frameid];
+    if (parent == -1)
+        return;
+    slot_storage[parent][slot].store(-1, std::memory_order_release);
+    swizzled_by[frameid].first = -1;
+}
+
+void BufferPool::unswizzle_children(frame_id_type frameid)
+{
+    for (uint32_t slot = 0; slot < swizzled_end[frameid]; ++slot)
+    {
+        auto child = slot_storage[frameid][slot].load(std::memory_order_relaxed);
+        if (child != -1)
+        {
+            swizzled_by[child].first = -1;
+            slot_storage[frameid][slot].store(-1, std::memory_order_release);
+        }
+    }
+    swizzled_end[frameid] = 0;
+}
+
+frame_id_type BufferPool::take_free_frame()
+{
+    if (free_frames.empty())
+    {
+        if (!evict())
+            return -1;
+    }
+    auto frame_id = free_frames.back();
+    free_frames.pop_back();
+    // Frames which have never been used are not latched yet
+    if (!latches[frame_id].is_write_locked())
+        latches[frame_id].write_lock();
+    return frame_id;
+}
+
 BufferPool::BufferPool(int number_of_frames, StorageBackend &storage_backend,
                        CacheReplacer<frame_id_type> &cache_replacer)
     : number_of_frames(number_of_frames),
       storage_backend(storage_backend),
       cache_replacer(cache_replacer),
       buffer(this->storage_backend.page_size() * number_of_frames, 0),
-      dirty_frames(number_of_frames, false)
+      dirty_frames(number_of_frames, false),
+      latches(number_of_frames),
+      loading_frames(number_of_frames, false),
+      tracing(false),
+      frame_pages(number_of_frames),
+      slots_per_frame(static_cast<uint32_t>(this->storage_backend.page_size()
+                                            / sizeof(page_id_type))),
+      swizzle_slots(number_of_frames),
+      slot_storage(number_of_frames),
+      swizzled_end(number_of_frames, 0),
+      swizzled_by(number_of_frames, {-1, 0})
 {
+    for (auto &pageid : frame_pages)
+        pageid.store(-1, std::memory_order_relaxed);
+    for (auto &slots : swizzle_slots)
+        slots.store(nullptr, std::memory_order_relaxed);
     free_frames.reserve(number_of_frames);
     for (auto i = 0; i < number_of_frames; ++i)
         free_frames.push_back(i);
@@ -48,71 +136,257 @@ BufferPool::BufferPool(int number_of_frames, StorageBackend &storage_backend,
     spdlog::set_level(spdlog::level::off);
 }
 
+BufferPool::~BufferPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        stopping = true;
+    }
+    prefetch_ready.notify_all();
+    if (prefetcher.joinable())
+        prefetcher.join();
+}
+
+std::map<page_id_type, frame_id_type>::iterator
+BufferPool::find_loaded(std::unique_lock<std::mutex> &lock, page_id_type pageid)
+{
+    auto iter = page_to_frame_map.find(pageid);
+    // The page may be evicted after it is read and before this thread wakes up, so it is looked
+    // up again
+    while (iter != page_to_frame_map.end() && loading_frames[iter->second])
+    {
+        prefetch_done.wait(lock);
+        iter = page_to_frame_map.find(pageid);
+    }
+    return iter;
+}
+
 uint8_t *BufferPool::fetch_page(page_id_type pageid)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    auto frame_id = fetch_frame(lock, pageid);
+    return frame_id == -1 ? nullptr : get_buffer_ptr(frame_id);
+}
+
+uint8_t *BufferPool::fetch_child(const uint8_t *parent, uint32_t slot, page_id_type child_pageid)
+{
+    auto parent_frame = frame_of(parent);
+    // The frame in the slot is used if it holds the child and is not being evicted or loaded,
+    // both of which the pool does with the latch of the frame held. The slot itself may be stale
+    auto slots = swizzle_slots[parent_frame].load(std::memory_order_acquire);
+    if (slots != nullptr && slot < slots_per_frame && !tracing.load(std::memory_order_relaxed))
+    {
+        auto frame_id = slots[slot].load(std::memory_order_acquire);
+        if (frame_id != -1)
+        {
+            bool restart = false;
+            auto version = latches[frame_id].read_lock(restart);
+            if (!restart && frame_pages[frame_id].load(std::memory_order_acquire) == child_pageid)
+            {
+                latches[frame_id].validate(version, restart);
+                if (!restart)
+                    return get_buffer_ptr(frame_id);
+            }
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (slots != nullptr && slot < slots_per_frame)
+    {
+        auto frame_id = slots[slot].load(std::memory_order_relaxed);
+        if (frame_id != -1 && frame_pages[frame_id].load(std::memory_order_relaxed) == child_pageid
+            && !loading_frames[frame_id])
+        {
+            if (trace_hook)
+                trace_hook(child_pageid);
+            return get_buffer_ptr(frame_id);
+        }
+    }
+
+    auto parent_pageid = frame_pages[parent_frame].load(std::memory_order_relaxed);
+    auto frame_id = fetch_frame(lock, child_pageid);
+    if (frame_id == -1)
+        return nullptr;
+    // The parent may have been evicted to make space for the child
+    if (parent_pageid == -1 || frame_pages[parent_frame] != parent_pageid
+        || slot >= slots_per_frame)
+        return get_buffer_ptr(frame_id);
+
+    // A frame is held by at most one swizzle slot
+    spdlog::info("Swizzling page {} in slot {} of page {}", child_pageid, slot, parent_pageid);
+    unswizzle(frame_id);
+    if (slot_storage[parent_frame] == nullptr)
+    {
+        slot_storage[parent_frame].reset(new std::atomic<frame_id_type>[slots_per_frame]);
+        for (uint32_t i = 0; i < slots_per_frame; ++i)
+            slot_storage[parent_frame][i].store(-1, std::memory_order_relaxed);
+        swizzle_slots[parent_frame].store(slot_storage[parent_frame].get(),
+                                          std::memory_order_release);
+    }
+    slot_storage[parent_frame][slot].store(frame_id, std::memory_order_release);
+    swizzled_end[parent_frame] = std::max(swizzled_end[parent_frame], slot + 1);
+    swizzled_by[frame_id] = {parent_frame, slot};
+    return get_buffer_ptr(frame_id);
+}
+
+frame_id_type BufferPool::fetch_frame(std::unique_lock<std::mutex> &lock, page_id_type pageid)
 {
     spdlog::info("Fetching page {}", pageid);
+    if (trace_hook)
+        trace_hook(pageid);
     // The page was found in the pool
-    auto iter = page_to_frame_map.find(pageid);
+    auto iter = find_loaded(lock, pageid);
     if (iter != page_to_frame_map.end())
     {
         spdlog::info("Page {} found in cache, mapped to {}", pageid, iter->second);
         cache_replacer.access(iter->second);
-        return get_buffer_ptr(iter->second);
+        return iter->second;
     }
 
     // A page fault has occured, read the page from the disk
     // Find a free frame to hold the read out page
-    if (free_frames.empty())
-    {
-        if (!evict())
-            return nullptr;
-    }
-    auto frame_id = free_frames.back();
-    free_frames.pop_back();
+    auto frame_id = take_free_frame();
+    if (frame_id == -1)
+        return -1;
 
     spdlog::info("Page fault occured, reading page {} to frame {}", pageid, frame_id);
-    bool status = storage_backend.read_page(pageid, get_buffer_ptr(frame_id));
+    bool status;
+    {
+        std::lock_guard<std::mutex> storage_guard(storage_mutex);
+        status = storage_backend.read_page(pageid, get_buffer_ptr(frame_id));
+    }
     if (!status)
     {
         // The page could not be read
         spdlog::info("Could not read page {}, freeing frame {}", pageid, frame_id);
         free_frames.push_back(frame_id);
-        return nullptr;
+        return -1;
     }
     cache_replacer.access(frame_id);
-    page_to_frame_map[pageid] = frame_id;
-    frame_to_page_map[frame_id] = pageid;
-    return get_buffer_ptr(frame_id);
+    map_page(pageid, frame_id);
+    latches[frame_id].write_unlock();
+    return frame_id;
+}
+
+bool BufferPool::prefetch_page(page_id_type pageid)
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    if (page_to_frame_map.find(pageid) != page_to_frame_map.end())
+        return true;
+    if (stopping || prefetching >= number_of_frames / PREFETCH_FRAMES_DIVISOR)
+        return false;
+    auto frame_id = take_free_frame();
+    if (frame_id == -1)
+        return false;
+
+    spdlog::info("Prefetching page {} to frame {}", pageid, frame_id);
+    // The frame stays latched until it is read, and is not in the cache replacer, so it is not
+    // evicted
+    map_page(pageid, frame_id);
+    loading_frames[frame_id] = true;
+    ++prefetching;
+    prefetch_queue.emplace_back(pageid, frame_id);
+    if (!prefetcher.joinable())
+        prefetcher = std::thread(&BufferPool::prefetch_loop, this);
+    prefetch_ready.notify_one();
+    return true;
+}
+
+const uint8_t *BufferPool::resident_page(page_id_type pageid)
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    auto iter = page_to_frame_map.find(pageid);
+    if (iter == page_to_frame_map.end() || loading_frames[iter->second])
+        return nullptr;
+    return get_buffer_ptr(iter->second);
+}
+
+void BufferPool::prefetch_loop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        prefetch_ready.wait(lock, [this]() { return stopping || !prefetch_queue.empty(); });
+        if (stopping)
+            return;
+        // All the queued pages are read together in order of their ids, so that the storage
+        // backend can read pages with consecutive ids with one request
+        std::vector<std::pair<page_id_type, frame_id_type>> batch(prefetch_queue.begin(),
+                                                                  prefetch_queue.end());
+        prefetch_queue.clear();
+        std::sort(batch.begin(), batch.end());
+        lock.unlock();
+
+        std::vector<page_id_type> page_ids;
+        std::vector<uint8_t *> buffers;
+        for (const auto &[pageid, frame_id] : batch)
+        {
+            page_ids.push_back(pageid);
+            buffers.push_back(get_buffer_ptr(frame_id));
+        }
+        std::vector<bool> status(batch.size(), true);
+        {
+            std::lock_guard<std::mutex> storage_guard(storage_mutex);
+            // If a page could not be read, the pages are read again one at a time to find it
+            if (!storage_backend.read_pages(page_ids, buffers))
+            {
+                for (size_t i = 0; i < batch.size(); ++i)
+                    status[i] = storage_backend.read_page(page_ids[i], buffers[i]);
+            }
+        }
+
+        lock.lock();
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+            auto [pageid, frame_id] = batch[i];
+            loading_frames[frame_id] = false;
+            --prefetching;
+            if (status[i])
+            {
+                cache_replacer.access(frame_id);
+                latches[frame_id].write_unlock();
+            }
+            else
+            {
+                spdlog::info("Could not prefetch page {}, freeing frame {}", pageid, frame_id);
+                unmap_page(pageid, frame_id);
+                free_frames.push_back(frame_id);
+            }
+        }
+        prefetch_done.notify_all();
+    }
 }
 
 bool BufferPool::delete_page(page_id_type pageid)
 {
+    std::unique_lock<std::mutex> lock(mutex);
     // If the page is mapped to a frame, free the frame
-    auto iter = page_to_frame_map.find(pageid);
+    auto iter = find_loaded(lock, pageid);
     if (iter != page_to_frame_map.end())
     {
-        frame_to_page_map.erase(iter->second);
-        cache_replacer.reset(iter->second);
-        free_frames.push_back(iter->second);
-        dirty_frames[iter->second] = false;
-        page_to_frame_map.erase(iter);
+        auto frame_id = iter->second;
+        // The page should not be latched by the caller. The latch is held before the frame is
+        // unmapped, as `fetch_child` checks it
+        latches[frame_id].try_write_lock();
+        unswizzle(frame_id);
+        unswizzle_children(frame_id);
+        cache_replacer.reset(frame_id);
+        unmap_page(pageid, frame_id);
+        free_frames.push_back(frame_id);
+        dirty_frames[frame_id] = false;
     }
+    std::lock_guard<std::mutex> storage_guard(storage_mutex);
     return storage_backend.delete_page(pageid);
 }
 
-bool BufferPool::flush_page(page_id_type pageid)
+bool BufferPool::flush_frame(page_id_type pageid, frame_id_type frameid)
 {
-    auto iter = page_to_frame_map.find(pageid);
-    if (iter == page_to_frame_map.end())
-    {
-        return false;
-    }
-    auto frameid = iter->second;
     // Check if the page is marked dirty
     if (dirty_frames[frameid])
     {
         dirty_frames[frameid] = false;
         cache_replacer.access(frameid);
+        std::lock_guard<std::mutex> storage_guard(storage_mutex);
         bool status = storage_backend.write_page(pageid, get_buffer_ptr(frameid));
         return status;
     }
@@ -120,33 +394,58 @@ bool BufferPool::flush_page(page_id_type pageid)
     return true;
 }
 
-page_id_type BufferPool::new_page()
+bool BufferPool::flush_page(page_id_type pageid)
+{
+    std::lock_guard<std::mutex> guard(mutex);
+    auto iter = page_to_frame_map.find(pageid);
+    if (iter == page_to_frame_map.end())
+    {
+        return false;
+    }
+    return flush_frame(pageid, iter->second);
+}
+
+uint8_t *BufferPool::new_latched_page(page_id_type &pageid)
 {
+    std::lock_guard<std::mutex> guard(mutex);
     spdlog::info("Creating new page");
     // Find a free frame to hold the new page
-    if (free_frames.empty())
+    auto frame_id = take_free_frame();
+    if (frame_id == -1)
     {
-        spdlog::info("No free frames for the new page, evicting a page");
-        if (!evict())
-            return -1;
+        spdlog::info("No free frames for the new page");
+        pageid = -1;
+        return nullptr;
     }
-    auto frame_id = free_frames.back();
-    free_frames.pop_back();
 
-    auto pageid = storage_backend.create_new_page();
+    {
+        std::lock_guard<std::mutex> storage_guard(storage_mutex);
+        pageid = storage_backend.create_new_page();
+    }
     spdlog::info("New page {} mapped to frame {}", pageid, frame_id);
+    if (trace_hook)
+        trace_hook(pageid);
     cache_replacer.access(frame_id);
-    page_to_frame_map[pageid] = frame_id;
-    frame_to_page_map[frame_id] = pageid;
+    map_page(pageid, frame_id);
     auto ptr = get_buffer_ptr(frame_id);
     // Zero fill the frame's location
     for (auto i = 0; i < storage_backend.page_size(); ++i)
         ptr[i] = 0;
+    return ptr;
+}
+
+page_id_type BufferPool::new_page()
+{
+    page_id_type pageid;
+    auto page = new_latched_page(pageid);
+    if (page != nullptr)
+        latch(page).write_unlock();
     return pageid;
 }
 
 bool BufferPool::set_dirty(page_id_type pageid)
 {
+    std::lock_guard<std::mutex> guard(mutex);
     auto iter = page_to_frame_map.find(pageid);
     if (iter == page_to_frame_map.end())
     {
@@ -155,18 +454,20 @@ bool BufferPool::set_dirty(page_id_type pageid)
 
     spdlog::info("Marking page {} (mapped to frame {}) as dirty", pageid, iter->second);
     dirty_frames[iter->second] = true;
+    unswizzle_children(iter->second);
     return true;
 }
 
 void BufferPool::flush_all()
 {
+    std::lock_guard<std::mutex> guard(mutex);
     spdlog::info("Flushing all frames");
     for (const auto &page_frame : page_to_frame_map)
     {
         if (dirty_frames[page_frame.second])
         {
             spdlog::info("Flushing page {} mapped to {}", page_frame.first, page_frame.second);
-            flush_page(page_frame.first);
+            flush_frame(page_frame.first, page_frame.second);
         }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,253 @@
+#include <algorithm>
+#include <pinedb/catalog.h>
+#include <pinedb/page.h>
+
+using namespace pinedb;
+
+namespace
+{
+    const int PAGE_HEADER_SIZE = 16;
+
+    void check_table_name(const std::string &name)
+    {
+        if (name.empty()
+            || name.size() > static_cast<size_t>(TableMetadataPage::MAX_TABLE_NAME_LENGTH))
+        {
+            throw std::runtime_error("table name should have between 1 and "
+                                     + std::to_string(TableMetadataPage::MAX_TABLE_NAME_LENGTH)
+                                     + " characters");
+        }
+    }
+
+    void check_column_name(const std::string &name)
+    {
+        if (name.empty()
+            || name.size() > static_cast<size_t>(TableMetadataPage::MAX_COLUMN_NAME_LENGTH))
+        {
+            throw std::runtime_error("column name should have between 1 and "
+                                     + std::to_string(TableMetadataPage::MAX_COLUMN_NAME_LENGTH)
+                                     + " characters");
+        }
+    }
+} // namespace
+
+Catalog::Catalog(BufferPool &pool, page_id_type sys_tables_page_id)
+    : pool(pool), sys_tables_page_id(sys_tables_page_id)
+{
+    if (pool.page_size() < PAGE_HEADER_SIZE + TableMetadataPage::METADATA_LENGTH)
+    {
+        throw std::runtime_error("page size is too small to hold table metadata");
+    }
+    if (pool.fetch_page(sys_tables_page_id) == nullptr)
+    {
+        // New database, create the sys_tables page which starts the chain
+        this->sys_tables_page_id = pool.new_page();
+        if (this->sys_tables_page_id == -1)
+        {
+            throw std::runtime_error("could not create the sys_tables page");
+        }
+        auto page = pool.fetch_page(this->sys_tables_page_id);
+        PageHeader header;
+        header.set_page_type(TableMetadataPage::PAGE_TYPE);
+        header.set_page_id(this->sys_tables_page_id);
+        TableMetadataPage meta(header.write(page));
+        meta.set_table_name(SYS_TABLES_NAME);
+        meta.set_next_page_id(0);
+        pool.set_dirty(this->sys_tables_page_id);
+    }
+    load();
+}
+
+uint8_t *Catalog::fetch_metadata(page_id_type page_id)
+{
+    auto page = pool.fetch_page(page_id);
+    if (page == nullptr)
+    {
+        throw std::runtime_error("could not read table metadata page " + std::to_string(page_id));
+    }
+    PageHeader header;
+    auto data = header.read(page);
+    if (header.get_page_type() != TableMetadataPage::PAGE_TYPE)
+    {
+        throw std::runtime_error("page " + std::to_string(page_id)
+                                 + " is not a table metadata page");
+    }
+    return data;
+}
+
+std::string_view Catalog::intern(const std::string &s)
+{
+    return *interned_names.insert(s).first;
+}
+
+void Catalog::load()
+{
+    page_id_type page_id = TableMetadataPage(fetch_metadata(sys_tables_page_id)).get_next_page_id();
+    while (page_id != 0)
+    {
+        TableMetadataPage meta(fetch_metadata(page_id));
+        auto name = meta.get_table_name();
+        if (meta.get_storage() != TableStorage::ROW && meta.get_storage() != TableStorage::PAX)
+        {
+            throw std::runtime_error("table \"" + name + "\" has an unknown storage format");
+        }
+        TableInfo info{name,
+                       page_id,
+                       meta.get_table_page_id(),
+                       {},
+                       meta.get_record_layout(),
+                       meta.get_storage()};
+        for (int i = 0; i < meta.number_of_columns(); ++i)
+            info.column_names.push_back(intern(meta.get_column_name(i)));
+        auto next_page_id = meta.get_next_page_id();
+
+        auto [iter, inserted] = tables.emplace(name, std::move(info));
+        if (!inserted)
+        {
+            throw std::runtime_error("table \"" + name + "\" is defined more than once");
+        }
+        table_order.push_back(&iter->second);
+        page_id = next_page_id;
+    }
+}
+
+TableInfo &Catalog::find_mutable(const std::string &name)
+{
+    auto iter = tables.find(name);
+    if (iter == tables.end())
+    {
+        throw std::runtime_error("table \"" + name + "\" does not exist");
+    }
+    return iter->second;
+}
+
+void Catalog::write_metadata(const TableInfo &info)
+{
+    TableMetadataPage meta(fetch_metadata(info.metadata_page_id));
+    meta.set_table_name(info.name);
+    meta.set_column_format(info.layout.get_format());
+    meta.set_table_page_id(info.table_page_id);
+    meta.set_storage(info.storage);
+    for (size_t i = 0; i < info.column_names.size(); ++i)
+        meta.set_column_name(static_cast<int>(i), std::string(info.column_names[i]));
+    pool.set_dirty(info.metadata_page_id);
+}
+
+const TableInfo &Catalog::create_table(const std::string &name,
+                                       const std::vector<std::pair<std::string, char>> &columns,
+                                       TableStorage storage)
+{
+    check_table_name(name);
+    if (name == SYS_TABLES_NAME || tables.count(name) != 0)
+    {
+        throw std::runtime_error("table \"" + name + "\" already exists");
+    }
+    if (columns.size() > static_cast<size_t>(TableMetadataPage::MAX_NUMBER_OF_COLUMNS))
+    {
+        throw std::runtime_error("a table can have at most "
+                                 + std::to_string(TableMetadataPage::MAX_NUMBER_OF_COLUMNS)
+                                 + " columns");
+    }
+    std::string format;
+    for (const auto &column : columns)
+    {
+        check_column_name(column.first);
+        format.push_back(column.second);
+    }
+    // Validates the column types
+    RecordLayout layout(format);
+
+    auto page_id = pool.new_page();
+    if (page_id == -1)
+    {
+        throw std::runtime_error("could not create a table metadata page");
+    }
+    PageHeader header;
+    header.set_page_type(TableMetadataPage::PAGE_TYPE);
+    header.set_page_id(page_id);
+    header.write(pool.fetch_page(page_id));
+
+    TableInfo info{name, page_id, 0, {}, std::move(layout), storage};
+    for (const auto &column : columns)
+        info.column_names.push_back(intern(column.first));
+    write_metadata(info);
+
+    // Link the page at the end of the chain
+    auto last_page_id
+        = table_order.empty() ? sys_tables_page_id : table_order.back()->metadata_page_id;
+    TableMetadataPage(fetch_metadata(last_page_id)).set_next_page_id(page_id);
+    pool.set_dirty(last_page_id);
+
+    auto iter = tables.emplace(name, std::move(info)).first;
+    table_order.push_back(&iter->second);
+    return iter->second;
+}
+
+bool Catalog::drop_table(const std::string &name)
+{
+    auto iter = tables.find(name);
+    if (iter == tables.end())
+        return false;
+    auto position = std::find(table_order.begin(), table_order.end(), &iter->second);
+    auto previous_page_id = position == table_order.begin()
+                                ? sys_tables_page_id
+                                : (*std::prev(position))->metadata_page_id;
+    auto page_id = iter->second.metadata_page_id;
+
+    // Unlink the page from the chain
+    auto next_page_id = TableMetadataPage(fetch_metadata(page_id)).get_next_page_id();
+    TableMetadataPage(fetch_metadata(previous_page_id)).set_next_page_id(next_page_id);
+    pool.set_dirty(previous_page_id);
+    pool.delete_page(page_id);
+
+    table_order.erase(position);
+    tables.erase(iter);
+    return true;
+}
+
+const TableInfo &Catalog::rename_table(const std::string &name, const std::string &new_name)
+{
+    check_table_name(new_name);
+    if (new_name == SYS_TABLES_NAME || tables.count(new_name) != 0)
+    {
+        throw std::runtime_error("table \"" + new_name + "\" already exists");
+    }
+    find_mutable(name);
+    auto node = tables.extract(name);
+    node.key() = new_name;
+    node.mapped().name = new_name;
+    // Node handles keep the address of the value, so table_order is still valid
+    auto &info = tables.insert(std::move(node)).position->second;
+    write_metadata(info);
+    return info;
+}
+
+const TableInfo &Catalog::add_column(const std::string &name, const std::string &column_name,
+                                     char type)
+{
+    auto &info = find_mutable(name);
+    check_column_name(column_name);
+    if (info.table_page_id != 0)
+    {
+        throw std::runtime_error("cannot add a column to table \"" + name
+                                 + "\" since it has data");
+    }
+    if (info.layout.number_of_columns() >= TableMetadataPage::MAX_NUMBER_OF_COLUMNS)
+    {
+        throw std::runtime_error("a table can have at most "
+                                 + std::to_string(TableMetadataPage::MAX_NUMBER_OF_COLUMNS)
+                                 + " columns");
+    }
+    info.layout = RecordLayout(info.layout.get_format() + type);
+    info.column_names.push_back(intern(column_name));
+    write_metadata(info);
+    return info;
+}
+
+void Catalog::set_table_page_id(const std::string &name, page_id_type page_id)
+{
+    auto &info = find_mutable(name);
+    info.table_page_id = page_id;
+    TableMetadataPage(fetch_metadata(info.metadata_page_id)).set_table_page_id(page_id);
+    pool.set_dirty(info.metadata_page_id);
+}
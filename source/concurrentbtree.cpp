@@ -0,0 +1,401 @@
+#include <pinedb/concurrentbtree.h>
+#include <pinedb/page.h>
+#include <stdexcept>
+#include <string.h>
+
+using namespace pinedb;
+
+namespace
+{
+    // Reads the fields of a node which may be changed by another thread while they are read. The
+    // size and the maximum number of keys are read once and checked, so that a node which is
+    // changed or replaced by another page cannot make the reads go out of the page. What is read
+    // is only used after the version of the frame is validated
+    template <typename Key> class NodeReader
+    {
+        uint8_t *page;
+        bool leaf;
+        bool valid;
+        uint32_t n;
+        uint32_t max_keys;
+
+        template <typename T> T read(size_t offset) const
+        {
+            T value;
+            datapacker::bytes::decode<datapacker::endian::little>(page + offset, value);
+            return value;
+        }
+
+        size_t links_offset() const
+        {
+            return BTreeNode<Key>::HEADER_SIZE + static_cast<size_t>(max_keys) * sizeof(Key);
+        }
+
+      public:
+        NodeReader(uint8_t *page, page_size_type page_size)
+            : page(page), leaf(page[0] == BTreeNode<Key>::LEAF_PAGE_TYPE),
+              n(read<uint32_t>(BTreeNode<Key>::NUMBER_OF_KEYS_OFFSET)),
+              max_keys(read<uint32_t>(BTreeNode<Key>::MAX_KEYS_OFFSET))
+        {
+            valid = (leaf || page[0] == BTreeNode<Key>::INTERNAL_PAGE_TYPE)
+                    && max_keys <= BTreeNode<Key>::capacity(page_size, leaf) && n <= max_keys;
+        }
+
+        bool is_valid() const { return valid; }
+
+        bool is_leaf() const { return leaf; }
+
+        bool is_full() const { return n == max_keys; }
+
+        uint32_t size() const { return n; }
+
+        Key key(uint32_t i) const
+        {
+            return read<Key>(BTreeNode<Key>::HEADER_SIZE + i * sizeof(Key));
+        }
+
+        uint64_t value(uint32_t i) const
+        {
+            return read<uint64_t>(links_offset() + i * sizeof(uint64_t));
+        }
+
+        page_id_type child(uint32_t i) const
+        {
+            return read<page_id_type>(links_offset() + i * sizeof(page_id_type));
+        }
+
+        uint32_t lower_bound(Key key) const
+        {
+            return NodeSearch::lower_bound(page + BTreeNode<Key>::HEADER_SIZE, n, key);
+        }
+
+        uint32_t upper_bound(Key key) const
+        {
+            return NodeSearch::upper_bound(page + BTreeNode<Key>::HEADER_SIZE, n, key);
+        }
+    };
+
+    // A node which does not look like a node is restarted if it was being changed, otherwise the
+    // tree is corrupt
+    template <typename Key>
+    void check_node(const NodeReader<Key> &reader, const OptimisticLatch &latch, uint64_t version,
+                    bool &restart)
+    {
+        if (reader.is_valid())
+            return;
+        latch.validate(version, restart);
+        if (!restart)
+        {
+            throw std::runtime_error("page of a concurrent B+ tree is not a B+ tree node");
+        }
+    }
+} // namespace
+
+template <typename Key>
+ConcurrentBTree<Key>::ConcurrentBTree(BufferPool &pool, page_id_type root_page_id)
+    : pool(pool), root_page_id(root_page_id),
+      max_internal_keys(BTree<Key>(pool, root_page_id).get_max_internal_keys())
+{
+}
+
+template <typename Key>
+typename ConcurrentBTree<Key>::Frame ConcurrentBTree<Key>::open(page_id_type page_id,
+                                                                bool &restart)
+{
+    auto page = pool.fetch_page(page_id);
+    if (page == nullptr)
+    {
+        throw std::runtime_error("could not read B+ tree page " + std::to_string(page_id));
+    }
+    Frame frame{page_id, page, &pool.latch(page), 0};
+    frame.version = frame.latch->read_lock(restart);
+    // The frame may have been evicted and filled with another page after it was fetched
+    PageHeader header;
+    header.read(page);
+    if (header.get_page_id() != page_id)
+        restart = true;
+    return frame;
+}
+
+template <typename Key> void ConcurrentBTree<Key>::split(Frame *parent, Frame &node)
+{
+    // The new pages are latched until they are filled, so they are not evicted
+    page_id_type right_page_id, left_page_id = -1;
+    auto right_page = pool.new_latched_page(right_page_id);
+    uint8_t *left_page = nullptr;
+    if (right_page != nullptr && parent == nullptr)
+    {
+        left_page = pool.new_latched_page(left_page_id);
+        if (left_page == nullptr)
+        {
+            pool.latch(right_page).write_unlock();
+            pool.delete_page(right_page_id);
+            right_page = nullptr;
+        }
+    }
+    if (right_page == nullptr)
+    {
+        node.latch->write_unlock();
+        if (parent != nullptr)
+            parent->latch->write_unlock();
+        throw std::runtime_error("could not create a B+ tree page");
+    }
+
+    BTreeNode<Key> right(right_page);
+    if (parent == nullptr)
+    {
+        // The root page id does not change, both halves of the root are moved to new pages
+        memcpy(left_page, node.page, pool.page_size());
+        PageHeader header;
+        header.read(left_page);
+        header.set_page_id(left_page_id);
+        header.write(left_page);
+        BTreeNode<Key> left(left_page);
+        auto separator = left.split(right, right_page_id);
+        BTreeNode<Key> root(node.page);
+        root.init(root_page_id, false, max_internal_keys);
+        root.set_child(0, left_page_id);
+        root.insert_child(0, separator, right_page_id);
+        pool.set_dirty(left_page_id);
+        pool.latch(left_page).write_unlock();
+    }
+    else
+    {
+        auto separator = BTreeNode<Key>(node.page).split(right, right_page_id);
+        BTreeNode<Key> p(parent->page);
+        p.insert_child(p.upper_bound(separator), separator, right_page_id);
+        pool.set_dirty(parent->page_id);
+    }
+    pool.set_dirty(right_page_id);
+    pool.set_dirty(node.page_id);
+    pool.latch(right_page).write_unlock();
+    node.latch->write_unlock();
+    if (parent != nullptr)
+        parent->latch->write_unlock();
+}
+
+template <typename Key>
+bool ConcurrentBTree<Key>::try_search(Key key, uint64_t &value, bool &found)
+{
+    bool restart = false;
+    auto node = open(root_page_id, restart);
+    if (restart)
+        return false;
+    while (true)
+    {
+        NodeReader<Key> reader(node.page, pool.page_size());
+        check_node(reader, *node.latch, node.version, restart);
+        if (restart)
+            return false;
+        if (reader.is_leaf())
+        {
+            auto i = reader.lower_bound(key);
+            found = i < reader.size() && reader.key(i) == key;
+            if (found)
+                value = reader.value(i);
+            node.latch->validate(node.version, restart);
+            return !restart;
+        }
+        auto child_page_id = reader.child(reader.upper_bound(key));
+        node.latch->validate(node.version, restart);
+        if (restart)
+            return false;
+        auto child = open(child_page_id, restart);
+        // The node has not changed since the child was found, so the child is still its child
+        node.latch->validate(node.version, restart);
+        if (restart)
+            return false;
+        node = child;
+    }
+}
+
+template <typename Key>
+bool ConcurrentBTree<Key>::try_insert(Key key, uint64_t value, bool &inserted)
+{
+    bool restart = false;
+    Frame parent{};
+    bool has_parent = false;
+    auto node = open(root_page_id, restart);
+    if (restart)
+        return false;
+    while (true)
+    {
+        NodeReader<Key> reader(node.page, pool.page_size());
+        check_node(reader, *node.latch, node.version, restart);
+        if (restart)
+            return false;
+        if (reader.is_full())
+        {
+            // The parent was not full when it was read, and it has not changed if it can be
+            // latched, so it has space for the separator
+            if (has_parent)
+            {
+                parent.latch->upgrade(parent.version, restart);
+                if (restart)
+                    return false;
+            }
+            node.latch->upgrade(node.version, restart);
+            if (restart)
+            {
+                if (has_parent)
+                    parent.latch->write_unlock();
+                return false;
+            }
+            split(has_parent ? &parent : nullptr, node);
+            // Start again from the root, which is simpler than finding the half to insert into
+            return false;
+        }
+        if (reader.is_leaf())
+        {
+            node.latch->upgrade(node.version, restart);
+            if (restart)
+                return false;
+            BTreeNode<Key> leaf(node.page);
+            auto i = leaf.lower_bound(key);
+            inserted = i == leaf.size() || leaf.key(i) != key;
+            if (inserted)
+            {
+                leaf.insert_value(i, key, value);
+                pool.set_dirty(node.page_id);
+            }
+            node.latch->write_unlock();
+            return true;
+        }
+        auto child_page_id = reader.child(reader.upper_bound(key));
+        node.latch->validate(node.version, restart);
+        if (restart)
+            return false;
+        auto child = open(child_page_id, restart);
+        node.latch->validate(node.version, restart);
+        if (restart)
+            return false;
+        parent = node;
+        has_parent = true;
+        node = child;
+    }
+}
+
+template <typename Key> bool ConcurrentBTree<Key>::try_latch_leaf(Key key, Frame &leaf)
+{
+    bool restart = false;
+    auto node = open(root_page_id, restart);
+    if (restart)
+        return false;
+    while (true)
+    {
+        NodeReader<Key> reader(node.page, pool.page_size());
+        check_node(reader, *node.latch, node.version, restart);
+        if (restart)
+            return false;
+        if (reader.is_leaf())
+        {
+            node.latch->upgrade(node.version, restart);
+            leaf = node;
+            return !restart;
+        }
+        auto child_page_id = reader.child(reader.upper_bound(key));
+        node.latch->validate(node.version, restart);
+        if (restart)
+            return false;
+        auto child = open(child_page_id, restart);
+        node.latch->validate(node.version, restart);
+        if (restart)
+            return false;
+        node = child;
+    }
+}
+
+template <typename Key> bool ConcurrentBTree<Key>::search(Key key, uint64_t &value)
+{
+    bool found = false;
+    while (!try_search(key, value, found))
+        ;
+    return found;
+}
+
+template <typename Key> bool ConcurrentBTree<Key>::insert(Key key, uint64_t value)
+{
+    BTree<Key>::check_key(key);
+    bool inserted = false;
+    while (!try_insert(key, value, inserted))
+        ;
+    return inserted;
+}
+
+template <typename Key> bool ConcurrentBTree<Key>::update(Key key, uint64_t value)
+{
+    Frame leaf{};
+    while (!try_latch_leaf(key, leaf))
+        ;
+    BTreeNode<Key> node(leaf.page);
+    auto i = node.lower_bound(key);
+    bool found = i < node.size() && node.key(i) == key;
+    if (found)
+    {
+        node.set_value(i, value);
+        pool.set_dirty(leaf.page_id);
+    }
+    leaf.latch->write_unlock();
+    return found;
+}
+
+template <typename Key> bool ConcurrentBTree<Key>::remove(Key key)
+{
+    Frame leaf{};
+    while (!try_latch_leaf(key, leaf))
+        ;
+    BTreeNode<Key> node(leaf.page);
+    auto i = node.lower_bound(key);
+    bool found = i < node.size() && node.key(i) == key;
+    if (found)
+    {
+        node.remove_value(i);
+        pool.set_dirty(leaf.page_id);
+    }
+    leaf.latch->write_unlock();
+    return found;
+}
+
+template <typename Key> int ConcurrentBTree<Key>::height()
+{
+    while (true)
+    {
+        bool restart = false;
+        int levels = 1;
+        auto node = open(root_page_id, restart);
+        while (!restart)
+        {
+            NodeReader<Key> reader(node.page, pool.page_size());
+            check_node(reader, *node.latch, node.version, restart);
+            if (restart)
+                break;
+            if (reader.is_leaf())
+            {
+                node.latch->validate(node.version, restart);
+                if (!restart)
+                    return levels;
+                break;
+            }
+            auto child_page_id = reader.child(0);
+            node.latch->validate(node.version, restart);
+            if (!restart)
+                node = open(child_page_id, restart);
+            ++levels;
+        }
+    }
+}
+
+namespace pinedb
+{
+    // One instantiation for each fixed width column type
+    template class ConcurrentBTree<uint8_t>;
+    template class ConcurrentBTree<int8_t>;
+    template class ConcurrentBTree<uint16_t>;
+    template class ConcurrentBTree<int16_t>;
+    template class ConcurrentBTree<uint32_t>;
+    template class ConcurrentBTree<int32_t>;
+    template class ConcurrentBTree<uint64_t>;
+    template class ConcurrentBTree<int64_t>;
+    template class ConcurrentBTree<float>;
+    template class ConcurrentBTree<double>;
+} // namespace pinedb
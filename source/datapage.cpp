@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <pinedb/datapacker.h>
+#include <pinedb/datapage.h>
+#include <pinedb/page.h>
+#include <stdexcept>
+#include <vector>
+
+using namespace pinedb;
+
+namespace
+{
+    // Offsets of the fields of the data page header, after the common page header
+    const size_t NUMBER_OF_SLOTS_OFFSET = 16;
+    const size_t FREE_SPACE_START_OFFSET = 18;
+    const size_t FRAGMENTED_BYTES_OFFSET = 20;
+    const size_t NEXT_PAGE_ID_OFFSET = 24;
+    const size_t FREE_SPACE_MAP_PAGE_ID_OFFSET = 28;
+
+    uint16_t allocation_size(uint16_t length)
+    {
+        return std::max(length, DataPage::MIN_TUPLE_ALLOCATION);
+    }
+} // namespace
+
+uint16_t DataPage::read_u16(size_t offset) const
+{
+    uint16_t value = 0;
+    datapacker::bytes::decode_le(page + offset, value);
+    return value;
+}
+
+void DataPage::write_u16(size_t offset, uint16_t value)
+{
+    datapacker::bytes::encode_le(page + offset, value);
+}
+
+void DataPage::set_slot(uint16_t slot, uint16_t offset, uint16_t length_and_flags)
+{
+    datapacker::bytes::encode_le(page + slot_position(slot), offset, length_and_flags);
+}
+
+uint16_t DataPage::number_of_slots() const { return read_u16(NUMBER_OF_SLOTS_OFFSET); }
+
+uint16_t DataPage::get_free_space_start() const { return read_u16(FREE_SPACE_START_OFFSET); }
+
+void DataPage::set_free_space_start(uint16_t offset) { write_u16(FREE_SPACE_START_OFFSET, offset); }
+
+uint16_t DataPage::get_fragmented_bytes() const { return read_u16(FRAGMENTED_BYTES_OFFSET); }
+
+void DataPage::set_fragmented_bytes(uint16_t bytes) { write_u16(FRAGMENTED_BYTES_OFFSET, bytes); }
+
+page_id_type DataPage::get_next_page_id() const
+{
+    page_id_type page_id = 0;
+    datapacker::bytes::decode_le(page + NEXT_PAGE_ID_OFFSET, page_id);
+    return page_id;
+}
+
+void DataPage::set_next_page_id(page_id_type page_id)
+{
+    datapacker::bytes::encode_le(page + NEXT_PAGE_ID_OFFSET, page_id);
+}
+
+page_id_type DataPage::get_free_space_map_page_id() const
+{
+    page_id_type page_id = 0;
+    datapacker::bytes::decode_le(page + FREE_SPACE_MAP_PAGE_ID_OFFSET, page_id);
+    return page_id;
+}
+
+void DataPage::set_free_space_map_page_id(page_id_type page_id)
+{
+    datapacker::bytes::encode_le(page + FREE_SPACE_MAP_PAGE_ID_OFFSET, page_id);
+}
+
+void DataPage::init(page_id_type page_id)
+{
+    if (page_size > MAX_PAGE_SIZE || page_size < HEADER_SIZE + 2 * SLOT_SIZE)
+    {
+        throw std::logic_error("page size is not supported by data pages");
+    }
+    PageHeader header;
+    header.set_page_type(PAGE_TYPE);
+    header.set_page_id(page_id);
+    header.write(page);
+    memset(page + NUMBER_OF_SLOTS_OFFSET, 0, HEADER_SIZE - NUMBER_OF_SLOTS_OFFSET);
+    set_free_space_start(HEADER_SIZE);
+}
+
+size_t DataPage::max_insert_length() const
+{
+    size_t available = free_space_end() - get_free_space_start() + get_fragmented_bytes();
+    // A new slot is needed if there is no free slot
+    bool has_free_slot = false;
+    for (uint16_t slot = 0; slot < number_of_slots() && !has_free_slot; ++slot)
+        has_free_slot = slot_offset(slot) == 0;
+    if (!has_free_slot)
+        available = available >= SLOT_SIZE ? available - SLOT_SIZE : 0;
+    return std::min<size_t>(available, MAX_TUPLE_LENGTH);
+}
+
+int DataPage::allocate(uint16_t length, int new_slots)
+{
+    size_t needed = static_cast<size_t>(allocation_size(length)) + new_slots * SLOT_SIZE;
+    size_t contiguous = free_space_end() - get_free_space_start();
+    if (contiguous < needed)
+    {
+        if (contiguous + get_fragmented_bytes() < needed)
+            return -1;
+        compact();
+    }
+    auto offset = get_free_space_start();
+    set_free_space_start(static_cast<uint16_t>(offset + allocation_size(length)));
+    return offset;
+}
+
+int DataPage::insert(const uint8_t *data, uint16_t length, uint16_t flags)
+{
+    if (length > MAX_TUPLE_LENGTH)
+        return -1;
+    auto slots = number_of_slots();
+    uint16_t slot = 0;
+    while (slot < slots && slot_offset(slot) != 0)
+        ++slot;
+    bool new_slot = slot == slots;
+
+    auto offset = allocate(length, new_slot ? 1 : 0);
+    if (offset == -1)
+        return -1;
+    if (new_slot)
+        write_u16(NUMBER_OF_SLOTS_OFFSET, static_cast<uint16_t>(slots + 1));
+    if (length > 0)
+        memcpy(page + offset, data, length);
+    set_slot(slot, static_cast<uint16_t>(offset), static_cast<uint16_t>(length | flags));
+    return slot;
+}
+
+bool DataPage::get(uint16_t slot, const uint8_t *&data, uint16_t &length) const
+{
+    if (slot >= number_of_slots() || slot_offset(slot) == 0)
+        return false;
+    data = page + slot_offset(slot);
+    length = slot_length_and_flags(slot) & MAX_TUPLE_LENGTH;
+    return true;
+}
+
+bool DataPage::update(uint16_t slot, const uint8_t *data, uint16_t length, uint16_t flags)
+{
+    if (slot >= number_of_slots() || slot_offset(slot) == 0 || length > MAX_TUPLE_LENGTH)
+        return false;
+    auto offset = slot_offset(slot);
+    auto old_allocation = allocation_size(slot_length_and_flags(slot) & MAX_TUPLE_LENGTH);
+
+    if (allocation_size(length) <= old_allocation)
+    {
+        // Shrinks or stays the same, the tuple is updated in place
+        if (length > 0)
+            memmove(page + offset, data, length);
+        set_fragmented_bytes(static_cast<uint16_t>(get_fragmented_bytes() + old_allocation
+                                                   - allocation_size(length)));
+        set_slot(slot, offset, static_cast<uint16_t>(length | flags));
+        return true;
+    }
+
+    size_t contiguous = free_space_end() - get_free_space_start();
+    if (contiguous + get_fragmented_bytes() + old_allocation < allocation_size(length))
+        return false;
+    // Free the old tuple, so that its space can be reused if the page has to be compacted
+    set_slot(slot, 0, 0);
+    set_fragmented_bytes(static_cast<uint16_t>(get_fragmented_bytes() + old_allocation));
+    auto new_offset = allocate(length, 0);
+    memcpy(page + new_offset, data, length);
+    set_slot(slot, static_cast<uint16_t>(new_offset), static_cast<uint16_t>(length | flags));
+    return true;
+}
+
+bool DataPage::remove(uint16_t slot)
+{
+    if (slot >= number_of_slots() || slot_offset(slot) == 0)
+        return false;
+    auto allocation = allocation_size(slot_length_and_flags(slot) & MAX_TUPLE_LENGTH);
+    set_fragmented_bytes(static_cast<uint16_t>(get_fragmented_bytes() + allocation));
+    set_slot(slot, 0, 0);
+    // Free slots at the end of the directory are returned to the free space
+    auto slots = number_of_slots();
+    while (slots > 0 && slot_offset(slots - 1) == 0)
+        --slots;
+    write_u16(NUMBER_OF_SLOTS_OFFSET, slots);
+    return true;
+}
+
+void DataPage::compact()
+{
+    // Move the tuples in the order of their offsets, so that a tuple is never overwritten before
+    // it is moved
+    std::vector<uint16_t> slots;
+    for (uint16_t slot = 0; slot < number_of_slots(); ++slot)
+    {
+        if (slot_offset(slot) != 0)
+            slots.push_back(slot);
+    }
+    std::sort(slots.begin(), slots.end(),
+              [this](uint16_t a, uint16_t b) { return slot_offset(a) < slot_offset(b); });
+
+    uint16_t position = HEADER_SIZE;
+    for (const auto slot : slots)
+    {
+        auto length_and_flags = slot_length_and_flags(slot);
+        auto allocation = allocation_size(length_and_flags & MAX_TUPLE_LENGTH);
+        memmove(page + position, page + slot_offset(slot), allocation);
+        set_slot(slot, position, length_and_flags);
+        position = static_cast<uint16_t>(position + allocation);
+    }
+    set_free_space_start(position);
+    set_fragmented_bytes(0);
+}
@@ -0,0 +1,282 @@
+#include <algorithm>
+#include <pinedb/datapacker.h>
+#include <pinedb/dictionary.h>
+#include <stdexcept>
+
+using namespace pinedb;
+
+namespace
+{
+    const uint8_t INTEGER_VALUES = 0;
+    const uint8_t STRING_VALUES = 1;
+
+    // Number of bits needed to store codes less than `dictionary_size`
+    uint8_t width_for(size_t dictionary_size)
+    {
+        uint8_t width = 0;
+        while ((size_t{1} << width) < dictionary_size)
+            ++width;
+        return width;
+    }
+
+    void append_varint(std::vector<uint8_t> &out, uint64_t value)
+    {
+        uint8_t buffer[datapacker::bytes::max_varint_length<uint64_t>];
+        auto length = datapacker::bytes::encode_varint(buffer, value);
+        out.insert(out.end(), buffer, buffer + length);
+    }
+
+    void append_value(std::vector<uint8_t> &out, std::string_view value, std::string_view)
+    {
+        append_varint(out, value.size());
+        out.insert(out.end(), value.begin(), value.end());
+    }
+
+    // Sorted integers are stored as the difference from the previous value
+    void append_value(std::vector<uint8_t> &out, int64_t value, int64_t previous)
+    {
+        append_varint(out, static_cast<uint64_t>(value) - static_cast<uint64_t>(previous));
+    }
+
+    template <typename T>
+    bool encode_values(const std::vector<T> &values, uint8_t value_type, std::vector<uint8_t> &out,
+                       size_t max_dictionary_size)
+    {
+        if (values.size() > UINT16_MAX)
+            return false;
+        std::vector<T> dictionary(values.begin(), values.end());
+        std::sort(dictionary.begin(), dictionary.end());
+        dictionary.erase(std::unique(dictionary.begin(), dictionary.end()), dictionary.end());
+        if (dictionary.size() > std::min<size_t>(max_dictionary_size, UINT16_MAX))
+            return false;
+
+        std::vector<uint16_t> codes(values.size());
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            codes[i] = static_cast<uint16_t>(
+                std::lower_bound(dictionary.begin(), dictionary.end(), values[i])
+                - dictionary.begin());
+        }
+        // Runs of equal codes, as (first row, end row)
+        std::vector<std::pair<size_t, size_t>> runs;
+        size_t run_length = 0;
+        for (size_t i = 0; i < codes.size();)
+        {
+            size_t end = i;
+            while (end < codes.size() && codes[end] == codes[i])
+                ++end;
+            runs.emplace_back(i, end);
+            run_length += datapacker::bytes::varint_length(static_cast<uint64_t>(codes[i]))
+                          + datapacker::bytes::varint_length(static_cast<uint64_t>(end - i));
+            i = end;
+        }
+
+        auto width = width_for(dictionary.size());
+        size_t packed_length = (values.size() * width + 7) / 8;
+        auto encoding = run_length < packed_length ? DictionaryEncoding::RUN_LENGTH
+                                                   : DictionaryEncoding::PACKED;
+
+        uint8_t header[DictionaryEncoder::HEADER_SIZE];
+        datapacker::bytes::encode_le(header, static_cast<uint8_t>(encoding), value_type,
+                                     static_cast<uint16_t>(values.size()),
+                                     static_cast<uint16_t>(dictionary.size()));
+        out.insert(out.end(), header, header + sizeof(header));
+        T previous{};
+        for (const auto &value : dictionary)
+        {
+            append_value(out, value, previous);
+            previous = value;
+        }
+
+        if (encoding == DictionaryEncoding::RUN_LENGTH)
+        {
+            for (const auto &[first, end] : runs)
+            {
+                append_varint(out, codes[first]);
+                append_varint(out, end - first);
+            }
+            return true;
+        }
+        // Codes are packed starting from the lowest bit of each byte
+        auto start = out.size();
+        out.resize(start + packed_length, 0);
+        for (size_t i = 0; i < codes.size(); ++i)
+        {
+            size_t bit = i * width;
+            uint32_t shifted = static_cast<uint32_t>(codes[i]) << (bit % 8);
+            for (size_t byte = bit / 8; shifted != 0; ++byte, shifted >>= 8)
+                out[start + byte] |= static_cast<uint8_t>(shifted);
+        }
+        return true;
+    }
+
+    class Reader
+    {
+        const uint8_t *data;
+        size_t length;
+        size_t position;
+
+      public:
+        Reader(const uint8_t *data, size_t length) : data(data), length(length), position(0) {}
+
+        [[noreturn]] static void malformed()
+        {
+            throw std::runtime_error("dictionary encoded column is malformed");
+        }
+
+        size_t get_position() const { return position; }
+
+        uint64_t varint()
+        {
+            // Copy the bytes, so that a truncated varint is not read past the end
+            uint8_t buffer[datapacker::bytes::max_varint_length<uint64_t>] = {};
+            auto available = std::min(sizeof(buffer), length - position);
+            memcpy(buffer, data + position, available);
+            uint64_t value = 0;
+            auto used = datapacker::bytes::decode_varint(buffer, value);
+            if (used == -1 || static_cast<size_t>(used) > available)
+                malformed();
+            position += used;
+            return value;
+        }
+
+        std::string_view bytes(size_t n)
+        {
+            if (n > length - position)
+                malformed();
+            auto view = std::string_view(reinterpret_cast<const char *>(data) + position, n);
+            position += n;
+            return view;
+        }
+    };
+} // namespace
+
+bool DictionaryEncoder::encode(const std::vector<std::string_view> &values,
+                               std::vector<uint8_t> &out, size_t max_dictionary_size)
+{
+    return encode_values(values, STRING_VALUES, out, max_dictionary_size);
+}
+
+bool DictionaryEncoder::encode(const std::vector<int64_t> &values, std::vector<uint8_t> &out,
+                               size_t max_dictionary_size)
+{
+    return encode_values(values, INTEGER_VALUES, out, max_dictionary_size);
+}
+
+DictionaryColumn::DictionaryColumn(const uint8_t *data, size_t length)
+{
+    if (length < DictionaryEncoder::HEADER_SIZE)
+        Reader::malformed();
+    uint8_t encoding_byte = 0, value_type = 0;
+    uint16_t dictionary_length = 0;
+    datapacker::bytes::decode_le(const_cast<uint8_t *>(data), encoding_byte, value_type,
+                                 number_of_values, dictionary_length);
+    encoding = static_cast<DictionaryEncoding>(encoding_byte);
+    if ((encoding != DictionaryEncoding::PACKED && encoding != DictionaryEncoding::RUN_LENGTH)
+        || (value_type != INTEGER_VALUES && value_type != STRING_VALUES)
+        || (number_of_values > 0 && dictionary_length == 0))
+        Reader::malformed();
+    strings = value_type == STRING_VALUES;
+    width = width_for(dictionary_length);
+
+    Reader reader(data + DictionaryEncoder::HEADER_SIZE, length - DictionaryEncoder::HEADER_SIZE);
+    uint64_t previous = 0;
+    for (uint16_t i = 0; i < dictionary_length; ++i)
+    {
+        if (strings)
+        {
+            string_dictionary.push_back(reader.bytes(reader.varint()));
+            continue;
+        }
+        previous += reader.varint();
+        integer_dictionary.push_back(static_cast<int64_t>(previous));
+    }
+    codes = data + DictionaryEncoder::HEADER_SIZE + reader.get_position();
+    codes_length = length - DictionaryEncoder::HEADER_SIZE - reader.get_position();
+
+    if (encoding == DictionaryEncoding::PACKED)
+    {
+        if (codes_length < (static_cast<size_t>(number_of_values) * width + 7) / 8)
+            Reader::malformed();
+        for (size_t row = 0; row < number_of_values; ++row)
+        {
+            if (code(row) >= dictionary_length)
+                Reader::malformed();
+        }
+        return;
+    }
+    Reader runs(codes, codes_length);
+    size_t row = 0;
+    while (row < number_of_values)
+    {
+        auto c = runs.varint();
+        auto run = runs.varint();
+        if (c >= dictionary_length || run == 0 || run > number_of_values - row)
+            Reader::malformed();
+        run_starts.push_back(static_cast<uint16_t>(row));
+        run_codes.push_back(static_cast<uint16_t>(c));
+        row += run;
+    }
+}
+
+int DictionaryColumn::find(std::string_view value) const
+{
+    auto c = lower_bound(value);
+    return c < string_dictionary.size() && string_dictionary[c] == value ? static_cast<int>(c)
+                                                                         : -1;
+}
+
+int DictionaryColumn::find(int64_t value) const
+{
+    auto c = lower_bound(value);
+    return c < integer_dictionary.size() && integer_dictionary[c] == value ? static_cast<int>(c)
+                                                                           : -1;
+}
+
+uint32_t DictionaryColumn::lower_bound(std::string_view value) const
+{
+    return static_cast<uint32_t>(
+        std::lower_bound(string_dictionary.begin(), string_dictionary.end(), value)
+        - string_dictionary.begin());
+}
+
+uint32_t DictionaryColumn::lower_bound(int64_t value) const
+{
+    return static_cast<uint32_t>(
+        std::lower_bound(integer_dictionary.begin(), integer_dictionary.end(), value)
+        - integer_dictionary.begin());
+}
+
+uint32_t DictionaryColumn::code(size_t row) const
+{
+    if (encoding == DictionaryEncoding::RUN_LENGTH)
+    {
+        auto run = std::upper_bound(run_starts.begin(), run_starts.end(), row) - run_starts.begin();
+        return run_codes[run - 1];
+    }
+    if (width == 0)
+        return 0;
+    // A code of atmost 16 bits spans atmost 3 bytes
+    size_t bit = row * width;
+    uint32_t value = 0;
+    for (size_t byte = bit / 8, shift = 0; byte < codes_length && shift < 24; ++byte, shift += 8)
+        value |= static_cast<uint32_t>(codes[byte]) << shift;
+    return (value >> (bit % 8)) & ((1U << width) - 1);
+}
+
+size_t DictionaryColumn::count_in_range(uint32_t first_code, uint32_t last_code) const
+{
+    size_t count = 0;
+    if (encoding == DictionaryEncoding::RUN_LENGTH)
+    {
+        for (size_t i = 0; i < run_starts.size(); ++i)
+        {
+            size_t end = i + 1 < run_starts.size() ? run_starts[i + 1] : number_of_values;
+            if (run_codes[i] >= first_code && run_codes[i] < last_code)
+                count += end - run_starts[i];
+        }
+        return count;
+    }
+    for_each_in_range(first_code, last_code, [&count](size_t) { ++count; });
+    return count;
+}
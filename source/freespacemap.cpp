@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <pinedb/datapacker.h>
+#include <pinedb/freespacemap.h>
+#include <pinedb/page.h>
+#include <stdexcept>
+
+using namespace pinedb;
+
+namespace
+{
+    const size_t NEXT_PAGE_ID_OFFSET = 16;
+
+    // The tree has `leaves` leaves and `2 * leaves - 1` nodes, the children of node `i` are
+    // `2i + 1` and `2i + 2`, and the leaves are the last `leaves` nodes
+
+    // Sets a leaf and updates its ancestors, stops once an ancestor does not change
+    void tree_set(uint8_t *nodes, size_t leaves, size_t index, uint8_t value)
+    {
+        size_t position = leaves - 1 + index;
+        nodes[position] = value;
+        while (position > 0)
+        {
+            position = (position - 1) / 2;
+            auto maximum = std::max(nodes[2 * position + 1], nodes[2 * position + 2]);
+            if (nodes[position] == maximum)
+                break;
+            nodes[position] = maximum;
+        }
+    }
+
+    // Returns a leaf whose value is at least `value`, or -1. When `leaves` is not a power of
+    // two the leaves span two levels of the heap, so it is not always the left-most such leaf
+    int64_t tree_find(const uint8_t *nodes, size_t leaves, uint8_t value)
+    {
+        if (nodes[0] < value)
+            return -1;
+        size_t position = 0;
+        while (position < leaves - 1)
+        {
+            position = 2 * position + 1;
+            if (nodes[position] < value)
+                ++position;
+        }
+        return static_cast<int64_t>(position - (leaves - 1));
+    }
+} // namespace
+
+FreeSpaceMap::FreeSpaceMap(BufferPool &pool, page_id_type first_page_id)
+    : pool(pool),
+      first_page_id(first_page_id),
+      top_leaves(0),
+      leaves_per_page((pool.page_size() - HEADER_SIZE + 1) / 2),
+      category_size(std::max<size_t>(1, pool.page_size() / 256))
+{
+    page_id_type page_id = first_page_id;
+    std::vector<uint8_t> roots;
+    while (page_id != 0)
+    {
+        auto page = fetch(page_id);
+        map_pages.push_back(page_id);
+        roots.push_back(page[HEADER_SIZE]);
+        datapacker::bytes::decode_le(page + NEXT_PAGE_ID_OFFSET, page_id);
+    }
+    top_leaves = 1;
+    while (top_leaves < map_pages.size())
+        top_leaves *= 2;
+    top.assign(2 * top_leaves - 1, 0);
+    for (size_t i = 0; i < roots.size(); ++i)
+        tree_set(top.data(), top_leaves, i, roots[i]);
+}
+
+uint8_t *FreeSpaceMap::fetch(page_id_type page_id)
+{
+    auto page = pool.fetch_page(page_id);
+    if (page == nullptr)
+    {
+        throw std::runtime_error("could not read free space map page " + std::to_string(page_id));
+    }
+    return page;
+}
+
+page_id_type FreeSpaceMap::add_page()
+{
+    auto page_id = pool.new_page();
+    if (page_id == -1)
+    {
+        throw std::runtime_error("could not create a free space map page");
+    }
+    PageHeader header;
+    header.set_page_type(PAGE_TYPE);
+    header.set_page_id(page_id);
+    // New pages are zero filled, so every heap page starts with no free space
+    header.write(fetch(page_id));
+    pool.set_dirty(page_id);
+
+    if (map_pages.empty())
+    {
+        first_page_id = page_id;
+    }
+    else
+    {
+        datapacker::bytes::encode_le(fetch(map_pages.back()) + NEXT_PAGE_ID_OFFSET, page_id);
+        pool.set_dirty(map_pages.back());
+    }
+    map_pages.push_back(page_id);
+
+    // Grow the tree in memory, keeping the roots of the existing pages
+    if (map_pages.size() > top_leaves)
+    {
+        auto old_top = std::move(top);
+        auto old_leaves = top_leaves;
+        top_leaves *= 2;
+        top.assign(2 * top_leaves - 1, 0);
+        for (size_t i = 0; i < old_leaves; ++i)
+            tree_set(top.data(), top_leaves, i, old_top[old_leaves - 1 + i]);
+    }
+    return page_id;
+}
+
+void FreeSpaceMap::set_top(size_t map_page_index, uint8_t value)
+{
+    tree_set(top.data(), top_leaves, map_page_index, value);
+}
+
+uint8_t FreeSpaceMap::category(size_t free_bytes) const
+{
+    return static_cast<uint8_t>(std::min<size_t>(255, free_bytes / category_size));
+}
+
+void FreeSpaceMap::set(size_t index, size_t free_bytes)
+{
+    auto map_page_index = index / leaves_per_page;
+    while (map_pages.size() <= map_page_index)
+        add_page();
+    auto page_id = map_pages[map_page_index];
+    auto nodes = fetch(page_id) + HEADER_SIZE;
+    auto value = category(free_bytes);
+    if (nodes[leaves_per_page - 1 + index % leaves_per_page] == value)
+        return;
+    tree_set(nodes, leaves_per_page, index % leaves_per_page, value);
+    pool.set_dirty(page_id);
+    set_top(map_page_index, nodes[0]);
+}
+
+uint8_t FreeSpaceMap::get(size_t index)
+{
+    auto map_page_index = index / leaves_per_page;
+    if (map_page_index >= map_pages.size())
+        return 0;
+    auto nodes = fetch(map_pages[map_page_index]) + HEADER_SIZE;
+    return nodes[leaves_per_page - 1 + index % leaves_per_page];
+}
+
+int64_t FreeSpaceMap::find(size_t needed)
+{
+    if (needed > 255 * category_size)
+        return -1;
+    // Round up, so that any page in the category has enough space. Category 0 is never searched
+    // for, since it is the value of the leaves which are not used
+    auto value = static_cast<uint8_t>(
+        std::max<size_t>(1, (needed + category_size - 1) / category_size));
+    auto map_page_index = tree_find(top.data(), top_leaves, value);
+    if (map_page_index == -1)
+        return -1;
+    auto nodes = fetch(map_pages[map_page_index]) + HEADER_SIZE;
+    return map_page_index * static_cast<int64_t>(leaves_per_page)
+           + tree_find(nodes, leaves_per_page, value);
+}
@@ -0,0 +1,392 @@
+#include <algorithm>
+#include <cmath>
+#include <pinedb/hashindex.h>
+#include <pinedb/page.h>
+#include <stdexcept>
+#include <string.h>
+
+using namespace pinedb;
+
+namespace
+{
+    uint8_t *fetch_page(BufferPool &pool, page_id_type page_id)
+    {
+        auto page = pool.fetch_page(page_id);
+        if (page == nullptr)
+        {
+            throw std::runtime_error("could not read hash index page " + std::to_string(page_id));
+        }
+        return page;
+    }
+
+    page_id_type create_page(BufferPool &pool)
+    {
+        auto page_id = pool.new_page();
+        if (page_id == -1)
+        {
+            throw std::runtime_error("could not create a hash index page");
+        }
+        return page_id;
+    }
+
+    template <typename T> T read(const uint8_t *page, size_t offset)
+    {
+        T value;
+        datapacker::bytes::decode<datapacker::endian::little>(const_cast<uint8_t *>(page) + offset,
+                                                              value);
+        return value;
+    }
+
+    template <typename T> void write(uint8_t *page, size_t offset, T value)
+    {
+        datapacker::bytes::encode<datapacker::endian::little>(page + offset, value);
+    }
+
+    // Writes the common page header, and clears the rest of the header
+    void init_page(uint8_t *page, uint8_t page_type, page_id_type page_id, int header_size)
+    {
+        PageHeader header;
+        header.set_page_type(page_type);
+        header.set_page_id(page_id);
+        header.write(page);
+        memset(page + 16, 0, header_size - 16);
+    }
+
+    // Largest power of two number of page ids which fit after the header of a page
+    uint32_t page_ids_per_page(page_size_type page_size, int header_size)
+    {
+        auto fit = (static_cast<size_t>(page_size) - header_size) / sizeof(page_id_type);
+        uint32_t slots = 1;
+        while (slots * 2 <= fit)
+            slots *= 2;
+        return slots;
+    }
+} // namespace
+
+template <typename Key>
+void HashBucket<Key>::init(page_id_type page_id, uint32_t local_depth, uint32_t max_entries)
+{
+    init_page(page, PAGE_TYPE, page_id, HEADER_SIZE);
+    write(LOCAL_DEPTH_OFFSET, local_depth);
+    write(MAX_ENTRIES_OFFSET, max_entries);
+    page[KEY_TYPE_OFFSET] = static_cast<uint8_t>(RecordLayout::format_of<Key>());
+}
+
+template <typename Key> void HashBucket<Key>::insert(uint32_t i, Key key, uint64_t value)
+{
+    auto n = size();
+    auto keys = page + HEADER_SIZE;
+    auto values = page + values_offset();
+    memmove(keys + (i + 1) * sizeof(Key), keys + i * sizeof(Key), (n - i) * sizeof(Key));
+    memmove(values + (i + 1) * sizeof(uint64_t), values + i * sizeof(uint64_t),
+            (n - i) * sizeof(uint64_t));
+    write(HEADER_SIZE + i * sizeof(Key), key);
+    set_value(i, value);
+    write(NUMBER_OF_ENTRIES_OFFSET, n + 1);
+}
+
+template <typename Key> void HashBucket<Key>::remove(uint32_t i)
+{
+    auto n = size();
+    auto keys = page + HEADER_SIZE;
+    auto values = page + values_offset();
+    memmove(keys + i * sizeof(Key), keys + (i + 1) * sizeof(Key), (n - i - 1) * sizeof(Key));
+    memmove(values + i * sizeof(uint64_t), values + (i + 1) * sizeof(uint64_t),
+            (n - i - 1) * sizeof(uint64_t));
+    write(NUMBER_OF_ENTRIES_OFFSET, n - 1);
+}
+
+template <typename Key> page_id_type HashIndex<Key>::create(BufferPool &pool, uint32_t max_entries)
+{
+    auto capacity = HashBucket<Key>::capacity(pool.page_size());
+    if (capacity < 2)
+    {
+        throw std::logic_error("page size is too small for a hash index");
+    }
+    if (max_entries != 0 && (max_entries < 2 || max_entries > capacity))
+    {
+        throw std::logic_error("invalid number of entries in a hash index bucket");
+    }
+    if (max_entries == 0)
+        max_entries = capacity;
+
+    auto header_page_id = create_page(pool);
+    auto directory_page_id = create_page(pool);
+    auto bucket_page_id = create_page(pool);
+
+    HashBucket<Key>(fetch_page(pool, bucket_page_id)).init(bucket_page_id, 0, max_entries);
+    pool.set_dirty(bucket_page_id);
+
+    auto directory = fetch_page(pool, directory_page_id);
+    init_page(directory, DIRECTORY_PAGE_TYPE, directory_page_id, HEADER_SIZE);
+    write(directory, HEADER_SIZE, bucket_page_id);
+    pool.set_dirty(directory_page_id);
+
+    auto header = fetch_page(pool, header_page_id);
+    init_page(header, HEADER_PAGE_TYPE, header_page_id, HEADER_SIZE);
+    write<uint32_t>(header, GLOBAL_DEPTH_OFFSET, 0);
+    write<uint32_t>(header, NUMBER_OF_DIRECTORY_PAGES_OFFSET, 1);
+    write(header, MAX_ENTRIES_OFFSET, max_entries);
+    header[KEY_TYPE_OFFSET] = static_cast<uint8_t>(RecordLayout::format_of<Key>());
+    write(header, HEADER_SIZE, directory_page_id);
+    pool.set_dirty(header_page_id);
+    return header_page_id;
+}
+
+template <typename Key> uint64_t HashIndex<Key>::hash(Key key)
+{
+    // -0.0 and 0.0 are equal keys with different bits
+    if (key == 0)
+        key = 0;
+    uint8_t bytes[sizeof(uint64_t)] = {};
+    uint64_t bits;
+    datapacker::bytes::encode<datapacker::endian::little>(bytes, key);
+    datapacker::bytes::decode<datapacker::endian::little>(bytes, bits);
+    // Finalizer of MurmurHash3, every bit of the key changes about half the bits of the hash, so
+    // the low bits used by the directory depend on all of the key
+    bits ^= bits >> 33;
+    bits *= 0xff51afd7ed558ccdULL;
+    bits ^= bits >> 33;
+    bits *= 0xc4ceb9fe1a85ec53ULL;
+    bits ^= bits >> 33;
+    return bits;
+}
+
+template <typename Key> void HashIndex<Key>::check_key(Key key)
+{
+    if constexpr (std::is_floating_point<Key>::value)
+    {
+        if (std::isnan(key))
+        {
+            throw std::logic_error("NaN cannot be used as a hash index key");
+        }
+    }
+}
+
+template <typename Key>
+HashIndex<Key>::HashIndex(BufferPool &pool, page_id_type header_page_id)
+    : pool(pool), header_page_id(header_page_id), max_entries(0),
+      slots_per_page(page_ids_per_page(pool.page_size(), HEADER_SIZE)), global_depth(0)
+{
+    auto header = fetch(header_page_id);
+    if (header[0] != HEADER_PAGE_TYPE
+        || header[KEY_TYPE_OFFSET] != RecordLayout::format_of<Key>())
+    {
+        throw std::runtime_error("page " + std::to_string(header_page_id)
+                                 + " is not the header of a hash index with keys of type '"
+                                 + std::string(1, RecordLayout::format_of<Key>()) + "'");
+    }
+    max_entries = read<uint32_t>(header, MAX_ENTRIES_OFFSET);
+    global_depth = read<uint32_t>(header, GLOBAL_DEPTH_OFFSET);
+    auto pages = read<uint32_t>(header, NUMBER_OF_DIRECTORY_PAGES_OFFSET);
+    for (uint32_t i = 0; i < pages; ++i)
+    {
+        directory_pages.push_back(read<page_id_type>(fetch(header_page_id),
+                                                     HEADER_SIZE + i * sizeof(page_id_type)));
+    }
+    directory.resize(size_t(1) << global_depth);
+    for (size_t slot = 0; slot < directory.size(); ++slot)
+    {
+        auto offset = HEADER_SIZE + (slot % slots_per_page) * sizeof(page_id_type);
+        directory[slot] = read<page_id_type>(fetch(directory_pages[slot / slots_per_page]), offset);
+    }
+}
+
+template <typename Key> uint8_t *HashIndex<Key>::fetch(page_id_type page_id)
+{
+    return fetch_page(pool, page_id);
+}
+
+template <typename Key> uint32_t HashIndex<Key>::get_max_global_depth() const
+{
+    // The header lists at most `slots_per_page` directory pages
+    uint32_t depth = 0;
+    while ((uint64_t(1) << depth) < static_cast<uint64_t>(slots_per_page) * slots_per_page)
+        ++depth;
+    return depth;
+}
+
+template <typename Key> void HashIndex<Key>::set_slot(uint64_t slot, page_id_type bucket_page_id)
+{
+    directory[slot] = bucket_page_id;
+    auto directory_page_id = directory_pages[slot / slots_per_page];
+    write(fetch(directory_page_id), HEADER_SIZE + (slot % slots_per_page) * sizeof(page_id_type),
+          bucket_page_id);
+    pool.set_dirty(directory_page_id);
+}
+
+template <typename Key> void HashIndex<Key>::grow_directory()
+{
+    if (global_depth == get_max_global_depth())
+    {
+        throw std::runtime_error("the directory of the hash index is full, too many keys have "
+                                 "the same hash");
+    }
+    auto slots = directory.size();
+    // Directory pages are added once the slots do not fit in the existing pages
+    while (directory_pages.size() * slots_per_page < 2 * slots)
+    {
+        auto page_id = create_page(pool);
+        init_page(fetch(page_id), DIRECTORY_PAGE_TYPE, page_id, HEADER_SIZE);
+        pool.set_dirty(page_id);
+        write(fetch(header_page_id), HEADER_SIZE + directory_pages.size() * sizeof(page_id_type),
+              page_id);
+        pool.set_dirty(header_page_id);
+        directory_pages.push_back(page_id);
+    }
+    // The new half of the directory is a copy of the old half
+    directory.resize(2 * slots);
+    for (size_t slot = slots; slot < 2 * slots; ++slot)
+        set_slot(slot, directory[slot - slots]);
+    ++global_depth;
+    auto header = fetch(header_page_id);
+    write(header, GLOBAL_DEPTH_OFFSET, global_depth);
+    write(header, NUMBER_OF_DIRECTORY_PAGES_OFFSET, static_cast<uint32_t>(directory_pages.size()));
+    pool.set_dirty(header_page_id);
+}
+
+template <typename Key> void HashIndex<Key>::split_bucket(page_id_type page_id, uint64_t key_hash)
+{
+    auto depth = HashBucket<Key>(fetch(page_id)).get_local_depth();
+    if (depth == global_depth)
+        grow_directory();
+
+    auto page = fetch(page_id);
+    PageCopy old_copy(page, page + pool.page_size());
+    PageCopy left_copy(old_copy.size(), 0), right_copy(old_copy.size(), 0);
+    auto right_page_id = create_page(pool);
+    HashBucket<Key> old(old_copy.data()), left(left_copy.data()), right(right_copy.data());
+    left.init(page_id, depth + 1, max_entries);
+    right.init(right_page_id, depth + 1, max_entries);
+    // The entries are visited in order, so both buckets stay sorted
+    for (uint32_t i = 0; i < old.size(); ++i)
+    {
+        auto &target = ((hash(old.key(i)) >> depth) & 1) == 0 ? left : right;
+        target.insert(target.size(), old.key(i), old.value(i));
+    }
+    memcpy(fetch(page_id), left_copy.data(), left_copy.size());
+    pool.set_dirty(page_id);
+    memcpy(fetch(right_page_id), right_copy.data(), right_copy.size());
+    pool.set_dirty(right_page_id);
+
+    // Half of the slots which pointed to the bucket point to the new bucket
+    uint64_t slots = directory.size();
+    auto first = (key_hash & mask(depth)) | (uint64_t(1) << depth);
+    for (auto slot = first; slot < slots; slot += uint64_t(1) << (depth + 1))
+        set_slot(slot, right_page_id);
+}
+
+template <typename Key> void HashIndex<Key>::merge_bucket(page_id_type page_id, uint64_t key_hash)
+{
+    auto depth = HashBucket<Key>(fetch(page_id)).get_local_depth();
+    if (depth == 0)
+        return;
+    // The other bucket differs in the highest bit of the local depth
+    auto buddy_slot = (key_hash & mask(depth)) ^ (uint64_t(1) << (depth - 1));
+    auto buddy_page_id = directory[buddy_slot];
+    HashBucket<Key> buddy(fetch(buddy_page_id));
+    if (buddy.get_local_depth() != depth)
+        return;
+    buddy.set_local_depth(depth - 1);
+    pool.set_dirty(buddy_page_id);
+    uint64_t slots = directory.size();
+    for (auto slot = key_hash & mask(depth); slot < slots; slot += uint64_t(1) << depth)
+        set_slot(slot, buddy_page_id);
+    pool.delete_page(page_id);
+}
+
+template <typename Key> bool HashIndex<Key>::search(Key key, uint64_t &value)
+{
+    HashBucket<Key> bucket(fetch(find_bucket(hash(key))));
+    auto i = bucket.find(key);
+    if (i == bucket.size())
+        return false;
+    value = bucket.value(i);
+    return true;
+}
+
+template <typename Key> bool HashIndex<Key>::insert(Key key, uint64_t value)
+{
+    check_key(key);
+    auto h = hash(key);
+    while (true)
+    {
+        auto page_id = find_bucket(h);
+        HashBucket<Key> bucket(fetch(page_id));
+        auto i = bucket.lower_bound(key);
+        if (i < bucket.size() && bucket.key(i) == key)
+            return false;
+        if (bucket.size() < bucket.get_max_entries())
+        {
+            bucket.insert(i, key, value);
+            pool.set_dirty(page_id);
+            return true;
+        }
+        // The entries whose hash has the same low `get_max_global_depth()` bits as the key stay
+        // in the bucket of the key however often it is split, so the index is not changed if
+        // they cannot make room for the key
+        auto max_mask = mask(get_max_global_depth());
+        uint32_t same = 1;
+        for (uint32_t j = 0; j < bucket.size(); ++j)
+            same += (hash(bucket.key(j)) & max_mask) == (h & max_mask);
+        if (same > bucket.get_max_entries())
+        {
+            throw std::runtime_error("the directory of the hash index is full, too many keys "
+                                     "have the same hash");
+        }
+        // All the entries may move to the same bucket, in which case it is split again
+        split_bucket(page_id, h);
+    }
+}
+
+template <typename Key> bool HashIndex<Key>::update(Key key, uint64_t value)
+{
+    auto page_id = find_bucket(hash(key));
+    HashBucket<Key> bucket(fetch(page_id));
+    auto i = bucket.find(key);
+    if (i == bucket.size())
+        return false;
+    bucket.set_value(i, value);
+    pool.set_dirty(page_id);
+    return true;
+}
+
+template <typename Key> bool HashIndex<Key>::remove(Key key)
+{
+    auto h = hash(key);
+    auto page_id = find_bucket(h);
+    HashBucket<Key> bucket(fetch(page_id));
+    auto i = bucket.find(key);
+    if (i == bucket.size())
+        return false;
+    bucket.remove(i);
+    pool.set_dirty(page_id);
+    if (bucket.size() == 0)
+        merge_bucket(page_id, h);
+    return true;
+}
+
+namespace pinedb
+{
+    // One instantiation for each fixed width column type
+    template class HashBucket<uint8_t>;
+    template class HashBucket<int8_t>;
+    template class HashBucket<uint16_t>;
+    template class HashBucket<int16_t>;
+    template class HashBucket<uint32_t>;
+    template class HashBucket<int32_t>;
+    template class HashBucket<uint64_t>;
+    template class HashBucket<int64_t>;
+    template class HashBucket<float>;
+    template class HashBucket<double>;
+    template class HashIndex<uint8_t>;
+    template class HashIndex<int8_t>;
+    template class HashIndex<uint16_t>;
+    template class HashIndex<int16_t>;
+    template class HashIndex<uint32_t>;
+    template class HashIndex<int32_t>;
+    template class HashIndex<uint64_t>;
+    template class HashIndex<int64_t>;
+    template class HashIndex<float>;
+    template class HashIndex<double>;
+} // namespace pinedb
@@ -0,0 +1,259 @@
+#include <algorithm>
+#include <pinedb/datapacker.h>
+#include <pinedb/heapfile.h>
+#include <stdexcept>
+
+using namespace pinedb;
+
+namespace
+{
+    // A forwarding tuple contains the RecordId where the row has been moved to
+    const uint16_t FORWARD_LENGTH = sizeof(page_id_type) + sizeof(uint16_t);
+
+    RecordId decode_forward(const uint8_t *data)
+    {
+        RecordId rid{0, 0};
+        datapacker::bytes::decode_le(const_cast<uint8_t *>(data), rid.page_id, rid.slot);
+        return rid;
+    }
+
+    page_id_type free_space_map_page_id(BufferPool &pool, page_id_type first_page_id)
+    {
+        auto page = pool.fetch_page(first_page_id);
+        if (page == nullptr)
+        {
+            throw std::runtime_error("could not read data page " + std::to_string(first_page_id));
+        }
+        return DataPage(page, pool.page_size()).get_free_space_map_page_id();
+    }
+} // namespace
+
+page_id_type HeapFile::create(BufferPool &pool)
+{
+    auto page_id = pool.new_page();
+    auto page = page_id == -1 ? nullptr : pool.fetch_page(page_id);
+    if (page == nullptr)
+    {
+        throw std::runtime_error("could not create the first page of the heap file");
+    }
+    DataPage(page, pool.page_size()).init(page_id);
+    pool.set_dirty(page_id);
+    return page_id;
+}
+
+HeapFile::HeapFile(BufferPool &pool, page_id_type first_page_id)
+    : pool(pool),
+      first_page_id(first_page_id),
+      last_page_id(first_page_id),
+      free_space_map(pool, free_space_map_page_id(pool, first_page_id))
+{
+    bool has_free_space_map = free_space_map.get_first_page_id() != 0;
+    std::vector<size_t> free_bytes;
+    page_id_type page_id = first_page_id;
+    while (page_id != 0)
+    {
+        DataPage page(fetch(page_id), pool.page_size());
+        page_positions[page_id] = static_cast<uint32_t>(pages.size());
+        pages.push_back(page_id);
+        if (!has_free_space_map)
+            free_bytes.push_back(page.max_insert_length());
+        last_page_id = page_id;
+        page_id = page.get_next_page_id();
+    }
+    // The map is created when it is first needed, so build it from the pages
+    for (size_t i = 0; i < free_bytes.size(); ++i)
+        set_free_space(pages[i], free_bytes[i]);
+}
+
+uint8_t *HeapFile::fetch(page_id_type page_id)
+{
+    auto page = pool.fetch_page(page_id);
+    if (page == nullptr)
+    {
+        throw std::runtime_error("could not read data page " + std::to_string(page_id));
+    }
+    return page;
+}
+
+size_t HeapFile::max_row_length() const
+{
+    return std::min<size_t>(DataPage::MAX_TUPLE_LENGTH, pool.page_size() - DataPage::HEADER_SIZE
+                                                            - DataPage::SLOT_SIZE);
+}
+
+void HeapFile::set_free_space(page_id_type page_id, size_t free_bytes)
+{
+    bool had_pages = free_space_map.get_first_page_id() != 0;
+    free_space_map.set(page_positions.at(page_id), free_bytes);
+    if (!had_pages && free_space_map.get_first_page_id() != 0)
+    {
+        DataPage(fetch(first_page_id), pool.page_size())
+            .set_free_space_map_page_id(free_space_map.get_first_page_id());
+        pool.set_dirty(first_page_id);
+    }
+}
+
+RecordId HeapFile::insert_tuple(const uint8_t *data, uint16_t length, uint16_t flags)
+{
+    auto needed = std::max(length, DataPage::MIN_TUPLE_ALLOCATION);
+    int64_t position;
+    while ((position = free_space_map.find(needed)) != -1)
+    {
+        auto page_id = pages[position];
+        DataPage page(fetch(page_id), pool.page_size());
+        auto slot = page.insert(data, length, flags);
+        if (slot != -1)
+        {
+            pool.set_dirty(page_id);
+            return {page_id, static_cast<uint16_t>(slot)};
+        }
+        // Inserts do not update the map, so the page has less space than what the map says
+        set_free_space(page_id, page.max_insert_length());
+    }
+
+    // No page has enough space, append a new page to the chain
+    auto page_id = pool.new_page();
+    if (page_id == -1)
+    {
+        throw std::runtime_error("could not create a data page");
+    }
+    DataPage page(fetch(page_id), pool.page_size());
+    page.init(page_id);
+    auto slot = page.insert(data, length, flags);
+    auto free_bytes = page.max_insert_length();
+    pool.set_dirty(page_id);
+
+    DataPage(fetch(last_page_id), pool.page_size()).set_next_page_id(page_id);
+    pool.set_dirty(last_page_id);
+    last_page_id = page_id;
+    page_positions[page_id] = static_cast<uint32_t>(pages.size());
+    pages.push_back(page_id);
+    set_free_space(page_id, free_bytes);
+    return {page_id, static_cast<uint16_t>(slot)};
+}
+
+RecordId HeapFile::insert(const uint8_t *data, size_t length)
+{
+    if (length > max_row_length())
+    {
+        throw std::runtime_error("row of length " + std::to_string(length)
+                                 + " is larger than the maximum row length");
+    }
+    return insert_tuple(data, static_cast<uint16_t>(length), 0);
+}
+
+bool HeapFile::get(const RecordId &rid, std::vector<uint8_t> &row)
+{
+    DataPage page(fetch(rid.page_id), pool.page_size());
+    const uint8_t *data;
+    uint16_t length;
+    if (!page.get(rid.slot, data, length) || (page.get_flags(rid.slot) & DataPage::FLAG_MOVED_IN))
+        return false;
+    if (page.get_flags(rid.slot) & DataPage::FLAG_FORWARDED)
+    {
+        auto target = decode_forward(data);
+        DataPage target_page(fetch(target.page_id), pool.page_size());
+        if (!target_page.get(target.slot, data, length))
+            return false;
+    }
+    row.assign(data, data + length);
+    return true;
+}
+
+void HeapFile::move_row(const RecordId &home, const RecordId &current, const uint8_t *data,
+                        uint16_t length)
+{
+    auto moved = insert_tuple(data, length, DataPage::FLAG_MOVED_IN);
+    if (current != home)
+    {
+        DataPage current_page(fetch(current.page_id), pool.page_size());
+        current_page.remove(current.slot);
+        pool.set_dirty(current.page_id);
+        set_free_space(current.page_id, current_page.max_insert_length());
+    }
+    // Every tuple has atleast FORWARD_LENGTH bytes, so this is always done in place
+    uint8_t forward[FORWARD_LENGTH];
+    datapacker::bytes::encode_le(forward, moved.page_id, moved.slot);
+    DataPage(fetch(home.page_id), pool.page_size())
+        .update(home.slot, forward, FORWARD_LENGTH, DataPage::FLAG_FORWARDED);
+    pool.set_dirty(home.page_id);
+}
+
+bool HeapFile::update(const RecordId &rid, const uint8_t *data, size_t length)
+{
+    if (length > max_row_length())
+    {
+        throw std::runtime_error("row of length " + std::to_string(length)
+                                 + " is larger than the maximum row length");
+    }
+    DataPage page(fetch(rid.page_id), pool.page_size());
+    const uint8_t *tuple;
+    uint16_t tuple_length;
+    if (!page.get(rid.slot, tuple, tuple_length)
+        || (page.get_flags(rid.slot) & DataPage::FLAG_MOVED_IN))
+        return false;
+
+    auto current = rid;
+    uint16_t flags = 0;
+    if (page.get_flags(rid.slot) & DataPage::FLAG_FORWARDED)
+    {
+        current = decode_forward(tuple);
+        flags = DataPage::FLAG_MOVED_IN;
+    }
+    DataPage current_page(fetch(current.page_id), pool.page_size());
+    if (current_page.update(current.slot, data, static_cast<uint16_t>(length), flags))
+    {
+        pool.set_dirty(current.page_id);
+        return true;
+    }
+    move_row(rid, current, data, static_cast<uint16_t>(length));
+    return true;
+}
+
+bool HeapFile::remove(const RecordId &rid)
+{
+    DataPage page(fetch(rid.page_id), pool.page_size());
+    const uint8_t *data;
+    uint16_t length;
+    if (!page.get(rid.slot, data, length) || (page.get_flags(rid.slot) & DataPage::FLAG_MOVED_IN))
+        return false;
+    bool forwarded = page.get_flags(rid.slot) & DataPage::FLAG_FORWARDED;
+    auto target = forwarded ? decode_forward(data) : rid;
+    page.remove(rid.slot);
+    pool.set_dirty(rid.page_id);
+    set_free_space(rid.page_id, page.max_insert_length());
+    if (forwarded)
+    {
+        DataPage target_page(fetch(target.page_id), pool.page_size());
+        target_page.remove(target.slot);
+        pool.set_dirty(target.page_id);
+        set_free_space(target.page_id, target_page.max_insert_length());
+    }
+    return true;
+}
+
+bool HeapFile::Iterator::next(RecordId &rid, std::vector<uint8_t> &row)
+{
+    while (page_id != 0)
+    {
+        DataPage page(heap.fetch(page_id), heap.pool.page_size());
+        while (slot < page.number_of_slots())
+        {
+            auto current = slot++;
+            const uint8_t *data;
+            uint16_t length;
+            // Moved rows are returned when their forwarding tuple is reached
+            if (!page.get(current, data, length)
+                || (page.get_flags(current) & DataPage::FLAG_MOVED_IN))
+                continue;
+            rid = {page_id, current};
+            if (page.get_flags(current) & DataPage::FLAG_FORWARDED)
+                return heap.get(rid, row);
+            row.assign(data, data + length);
+            return true;
+        }
+        page_id = page.get_next_page_id();
+        slot = 0;
+    }
+    return false;
+}
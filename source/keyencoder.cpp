@@ -0,0 +1,142 @@
+#include <pinedb/keyencoder.h>
+#include <stdexcept>
+
+using namespace pinedb;
+
+void KeyEncoder::append(const uint8_t *data, size_t length, bool descending)
+{
+    auto start = bytes.size();
+    bytes.insert(bytes.end(), data, data + length);
+    if (descending)
+    {
+        for (size_t i = start; i < bytes.size(); ++i)
+            bytes[i] = static_cast<uint8_t>(~bytes[i]);
+    }
+}
+
+KeyEncoder &KeyEncoder::add_string(std::string_view value, bool descending)
+{
+    auto start = bytes.size();
+    bytes.reserve(start + value.size() + 2);
+    for (auto ch : value)
+    {
+        auto byte = static_cast<uint8_t>(ch);
+        bytes.push_back(byte);
+        if (byte == STRING_ESCAPE)
+            bytes.push_back(ESCAPED_ZERO);
+    }
+    bytes.push_back(STRING_ESCAPE);
+    bytes.push_back(STRING_TERMINATOR);
+    if (descending)
+    {
+        for (size_t i = start; i < bytes.size(); ++i)
+            bytes[i] = static_cast<uint8_t>(~bytes[i]);
+    }
+    return *this;
+}
+
+KeyEncoder &KeyEncoder::add_record(const RecordLayout &layout, const uint8_t *record,
+                                   const std::vector<int> &columns,
+                                   const std::vector<bool> &descending)
+{
+    for (size_t i = 0; i < columns.size(); ++i)
+    {
+        auto column = columns[i];
+        bool desc = i < descending.size() && descending[i];
+        switch (layout.field(column).format)
+        {
+        case 'b':
+            add(layout.get<uint8_t>(record, column), desc);
+            break;
+        case 'B':
+            add(layout.get<int8_t>(record, column), desc);
+            break;
+        case 's':
+            add(layout.get<uint16_t>(record, column), desc);
+            break;
+        case 'S':
+            add(layout.get<int16_t>(record, column), desc);
+            break;
+        case 'i':
+            add(layout.get<uint32_t>(record, column), desc);
+            break;
+        case 'I':
+            add(layout.get<int32_t>(record, column), desc);
+            break;
+        case 'l':
+            add(layout.get<uint64_t>(record, column), desc);
+            break;
+        case 'L':
+            add(layout.get<int64_t>(record, column), desc);
+            break;
+        case 'f':
+            add(layout.get<float>(record, column), desc);
+            break;
+        case 'd':
+            add(layout.get<double>(record, column), desc);
+            break;
+        default:
+            if (layout.is_external(record, column))
+            {
+                throw std::logic_error("column " + std::to_string(column)
+                                       + " is stored in overflow pages and cannot be a key");
+            }
+            add_string(layout.get_string(record, column), desc);
+            break;
+        }
+    }
+    return *this;
+}
+
+uint64_t KeyEncoder::prefix(const uint8_t *key, size_t length)
+{
+    uint8_t buffer[8] = {0};
+    memcpy(buffer, key, length < 8 ? length : 8);
+    uint64_t value;
+    datapacker::bytes::decode_be(buffer, value);
+    return value;
+}
+
+int KeyEncoder::compare(const uint8_t *a, size_t a_length, const uint8_t *b, size_t b_length)
+{
+    auto length = a_length < b_length ? a_length : b_length;
+    int result = length == 0 ? 0 : memcmp(a, b, length);
+    if (result != 0)
+        return result;
+    return a_length < b_length ? -1 : (a_length > b_length ? 1 : 0);
+}
+
+void KeyDecoder::read(uint8_t *out, size_t n, bool descending)
+{
+    if (length - position < n)
+    {
+        throw std::runtime_error("normalized key is too short");
+    }
+    for (size_t i = 0; i < n; ++i)
+        out[i] = descending ? static_cast<uint8_t>(~key[position + i]) : key[position + i];
+    position += n;
+}
+
+std::string KeyDecoder::get_string(bool descending)
+{
+    uint8_t mask = descending ? 0xFF : 0x00;
+    std::string value;
+    while (position + 1 < length)
+    {
+        auto byte = static_cast<uint8_t>(key[position] ^ mask);
+        if (byte != KeyEncoder::STRING_ESCAPE)
+        {
+            value.push_back(static_cast<char>(byte));
+            ++position;
+            continue;
+        }
+        auto next = static_cast<uint8_t>(key[position + 1] ^ mask);
+        position += 2;
+        if (next == KeyEncoder::STRING_TERMINATOR)
+            return value;
+        if (next != KeyEncoder::ESCAPED_ZERO)
+            break;
+        value.push_back('\0');
+    }
+    throw std::runtime_error("string in a normalized key is not terminated");
+}
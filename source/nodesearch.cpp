@@ -0,0 +1,389 @@
+#include <pinedb/datapacker.h>
+#include <pinedb/nodesearch.h>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PINEDB_SEARCH_SSE2
+// AVX2 functions are compiled with the target attribute, so that the library itself does not
+// need to be built with -mavx2, they are only called if the CPU supports them
+#if defined(__GNUC__)
+#include <immintrin.h>
+#define PINEDB_SEARCH_AVX2
+#define PINEDB_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define PINEDB_SEARCH_NEON
+#endif
+
+using namespace pinedb;
+
+namespace
+{
+    // The keys are loaded into vectors as they are stored, which needs a little endian host
+    constexpr bool NATIVE_KEYS = datapacker::internal::host_endian_known
+                                 && datapacker::internal::host_endian == datapacker::endian::little;
+
+    template <typename T> T load_key(const uint8_t *keys, uint32_t i)
+    {
+        T value;
+        datapacker::bytes::decode<datapacker::endian::little>(
+            const_cast<uint8_t *>(keys) + static_cast<size_t>(i) * sizeof(T), value);
+        return value;
+    }
+
+    // Number of keys in [begin, end) which are less than `key`, or greater than `key` if `Greater`
+    template <bool Greater, typename T>
+    uint32_t count_scalar(const uint8_t *keys, uint32_t begin, uint32_t end, T key)
+    {
+        uint32_t count = 0;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            auto k = load_key<T>(keys, i);
+            count += Greater ? key < k : k < key;
+        }
+        return count;
+    }
+
+    // Branchless binary search, which narrows the range of `n` keys starting at `base` until it
+    // has at most `window` keys. The position of the key is always in [base, base + n]
+    template <bool Upper, typename T>
+    void narrow(const uint8_t *keys, uint32_t &base, uint32_t &n, T key, uint32_t window)
+    {
+        while (n > window)
+        {
+            uint32_t half = n / 2;
+            auto k = load_key<T>(keys, base + half);
+            base = (Upper ? !(key < k) : k < key) ? base + half : base;
+            n -= half;
+        }
+    }
+
+    template <bool Upper, typename T> uint32_t search_scalar(const uint8_t *keys, uint32_t n, T key)
+    {
+        if (n == 0)
+            return 0;
+        uint32_t base = 0;
+        narrow<Upper>(keys, base, n, key, 1);
+        auto k = load_key<T>(keys, base);
+        return base + (Upper ? !(key < k) : k < key);
+    }
+
+    // SSE2 and AVX2 only have signed integer compares, unsigned keys are compared after flipping
+    // their sign bit, which keeps their order
+    template <typename T> auto to_signed(T value)
+    {
+        using S = typename std::make_signed<T>::type;
+        if constexpr (std::is_signed<T>::value)
+            return value;
+        else
+            return static_cast<S>(value ^ (static_cast<T>(1) << (sizeof(T) * 8 - 1)));
+    }
+
+#ifdef PINEDB_SEARCH_SSE2
+    template <typename T> __m128i sse2_set1(T value)
+    {
+        auto s = to_signed(value);
+        if constexpr (sizeof(T) == 1)
+            return _mm_set1_epi8(s);
+        else if constexpr (sizeof(T) == 2)
+            return _mm_set1_epi16(s);
+        else
+            return _mm_set1_epi32(s);
+    }
+
+    template <bool Greater, typename T> __m128i sse2_compare(__m128i v, __m128i needle)
+    {
+        if constexpr (sizeof(T) == 1)
+            return Greater ? _mm_cmpgt_epi8(v, needle) : _mm_cmpgt_epi8(needle, v);
+        else if constexpr (sizeof(T) == 2)
+            return Greater ? _mm_cmpgt_epi16(v, needle) : _mm_cmpgt_epi16(needle, v);
+        else
+            return Greater ? _mm_cmpgt_epi32(v, needle) : _mm_cmpgt_epi32(needle, v);
+    }
+
+    template <bool Greater, typename T> __m128i sse2_compare_keys(const uint8_t *p, T key)
+    {
+        if constexpr (std::is_same<T, float>::value)
+        {
+            auto v = _mm_loadu_ps(reinterpret_cast<const float *>(p));
+            auto needle = _mm_set1_ps(key);
+            return _mm_castps_si128(Greater ? _mm_cmpgt_ps(v, needle) : _mm_cmplt_ps(v, needle));
+        }
+        else if constexpr (std::is_same<T, double>::value)
+        {
+            auto v = _mm_loadu_pd(reinterpret_cast<const double *>(p));
+            auto needle = _mm_set1_pd(key);
+            return _mm_castpd_si128(Greater ? _mm_cmpgt_pd(v, needle) : _mm_cmplt_pd(v, needle));
+        }
+        else
+        {
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+            // The sign bit of every lane, since zero is converted to the smallest signed value
+            if constexpr (std::is_unsigned<T>::value)
+                v = _mm_xor_si128(v, sse2_set1(static_cast<T>(0)));
+            return sse2_compare<Greater, T>(v, sse2_set1(key));
+        }
+    }
+
+    // Counts the keys of a window which are less than `key`, or greater if `Greater`
+    template <bool Greater, typename T> uint32_t count_sse2(const uint8_t *keys, T key)
+    {
+        // Every byte of a matching lane is 0xFF, subtracting the masks counts the matches in each
+        // byte, which are summed once at the end
+        auto counts = _mm_setzero_si128();
+        for (uint32_t i = 0; i < NodeSearch::WINDOW_BYTES; i += 16)
+            counts = _mm_sub_epi8(counts, sse2_compare_keys<Greater>(keys + i, key));
+        auto sums = _mm_sad_epu8(counts, _mm_setzero_si128());
+        auto bytes = static_cast<uint32_t>(_mm_cvtsi128_si32(sums))
+                     + static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(sums, 8)));
+        return bytes / sizeof(T);
+    }
+#endif
+
+#ifdef PINEDB_SEARCH_AVX2
+    template <typename T> PINEDB_TARGET_AVX2 __m256i avx2_set1(T value)
+    {
+        auto s = to_signed(value);
+        if constexpr (sizeof(T) == 1)
+            return _mm256_set1_epi8(s);
+        else if constexpr (sizeof(T) == 2)
+            return _mm256_set1_epi16(s);
+        else if constexpr (sizeof(T) == 4)
+            return _mm256_set1_epi32(s);
+        else
+            return _mm256_set1_epi64x(s);
+    }
+
+    template <bool Greater, typename T>
+    PINEDB_TARGET_AVX2 __m256i avx2_compare(__m256i v, __m256i needle)
+    {
+        if constexpr (sizeof(T) == 1)
+            return Greater ? _mm256_cmpgt_epi8(v, needle) : _mm256_cmpgt_epi8(needle, v);
+        else if constexpr (sizeof(T) == 2)
+            return Greater ? _mm256_cmpgt_epi16(v, needle) : _mm256_cmpgt_epi16(needle, v);
+        else if constexpr (sizeof(T) == 4)
+            return Greater ? _mm256_cmpgt_epi32(v, needle) : _mm256_cmpgt_epi32(needle, v);
+        else
+            return Greater ? _mm256_cmpgt_epi64(v, needle) : _mm256_cmpgt_epi64(needle, v);
+    }
+
+    template <bool Greater, typename T>
+    PINEDB_TARGET_AVX2 __m256i avx2_compare_keys(const uint8_t *p, T key)
+    {
+        if constexpr (std::is_same<T, float>::value)
+        {
+            auto v = _mm256_loadu_ps(reinterpret_cast<const float *>(p));
+            auto needle = _mm256_set1_ps(key);
+            if constexpr (Greater)
+                return _mm256_castps_si256(_mm256_cmp_ps(v, needle, _CMP_GT_OQ));
+            else
+                return _mm256_castps_si256(_mm256_cmp_ps(v, needle, _CMP_LT_OQ));
+        }
+        else if constexpr (std::is_same<T, double>::value)
+        {
+            auto v = _mm256_loadu_pd(reinterpret_cast<const double *>(p));
+            auto needle = _mm256_set1_pd(key);
+            if constexpr (Greater)
+                return _mm256_castpd_si256(_mm256_cmp_pd(v, needle, _CMP_GT_OQ));
+            else
+                return _mm256_castpd_si256(_mm256_cmp_pd(v, needle, _CMP_LT_OQ));
+        }
+        else
+        {
+            auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+            if constexpr (std::is_unsigned<T>::value)
+                v = _mm256_xor_si256(v, avx2_set1(static_cast<T>(0)));
+            return avx2_compare<Greater, T>(v, avx2_set1(key));
+        }
+    }
+
+    template <bool Greater, typename T>
+    PINEDB_TARGET_AVX2 uint32_t count_avx2(const uint8_t *keys, T key)
+    {
+        auto counts = _mm256_setzero_si256();
+        for (uint32_t i = 0; i < NodeSearch::WINDOW_BYTES; i += 32)
+            counts = _mm256_sub_epi8(counts, avx2_compare_keys<Greater>(keys + i, key));
+        auto sums = _mm256_sad_epu8(counts, _mm256_setzero_si256());
+        auto half = _mm_add_epi64(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+        auto bytes = static_cast<uint32_t>(_mm_cvtsi128_si32(half))
+                     + static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(half, 8)));
+        return bytes / sizeof(T);
+    }
+#endif
+
+#ifdef PINEDB_SEARCH_NEON
+    // Number of lanes of one vector of keys which are less than (or greater than) the key, NEON
+    // has compares for every key type. A lane which matches is all ones, so shifting it right
+    // leaves 1 which is summed across the vector
+#define PINEDB_NEON_COUNT(T, S, U, SHIFT)                                                         \
+    inline uint32_t count_neon_lanes(const uint8_t *p, T key, bool greater)                     \
+    {                                                                                             \
+        auto v = vld1q_##S(reinterpret_cast<const T *>(p));                                       \
+        auto needle = vdupq_n_##S(key);                                                           \
+        auto mask = greater ? vcgtq_##S(v, needle) : vcltq_##S(v, needle);                        \
+        return static_cast<uint32_t>(vaddvq_##U(vshrq_n_##U(mask, SHIFT)));                      \
+    }
+
+    PINEDB_NEON_COUNT(uint8_t, u8, u8, 7)
+    PINEDB_NEON_COUNT(int8_t, s8, u8, 7)
+    PINEDB_NEON_COUNT(uint16_t, u16, u16, 15)
+    PINEDB_NEON_COUNT(int16_t, s16, u16, 15)
+    PINEDB_NEON_COUNT(uint32_t, u32, u32, 31)
+    PINEDB_NEON_COUNT(int32_t, s32, u32, 31)
+    PINEDB_NEON_COUNT(uint64_t, u64, u64, 63)
+    PINEDB_NEON_COUNT(int64_t, s64, u64, 63)
+    PINEDB_NEON_COUNT(float, f32, u32, 31)
+    PINEDB_NEON_COUNT(double, f64, u64, 63)
+#undef PINEDB_NEON_COUNT
+
+    template <bool Greater, typename T> uint32_t count_neon(const uint8_t *keys, T key)
+    {
+        uint32_t count = 0;
+        for (uint32_t i = 0; i < NodeSearch::WINDOW_BYTES; i += 16)
+            count += count_neon_lanes(keys + i, key, Greater);
+        return count;
+    }
+#endif
+
+    SearchKernel detect_kernel()
+    {
+        if (!NATIVE_KEYS)
+            return SearchKernel::SCALAR;
+#ifdef PINEDB_SEARCH_AVX2
+        if (__builtin_cpu_supports("avx2"))
+            return SearchKernel::AVX2;
+#endif
+#ifdef PINEDB_SEARCH_SSE2
+        return SearchKernel::SSE2;
+#elif defined(PINEDB_SEARCH_NEON)
+        return SearchKernel::NEON;
+#else
+        return SearchKernel::SCALAR;
+#endif
+    }
+
+    template <bool Upper, typename T>
+    uint32_t search(const uint8_t *keys, uint32_t n, T key, SearchKernel kernel)
+    {
+        constexpr uint32_t window = NodeSearch::WINDOW_BYTES / sizeof(T);
+        if (kernel == SearchKernel::SCALAR || n < window)
+            return search_scalar<Upper>(keys, n, key);
+        // SSE2 does not compare 64 bit integers
+        if (std::is_integral<T>::value && sizeof(T) == 8 && kernel == SearchKernel::SSE2)
+            return search_scalar<Upper>(keys, n, key);
+
+        uint32_t base = 0, size = n;
+        narrow<Upper>(keys, base, size, key, window);
+        // The keys before `base` are all before the position, so a whole window which ends at or
+        // after `base + size` can be compared, which needs no loop over the remaining keys
+        if (base > n - window)
+            base = n - window;
+        auto start = keys + static_cast<size_t>(base) * sizeof(T);
+        // The lower bound is after the keys which are less than the key, and the upper bound is
+        // before the keys which are greater than the key
+        uint32_t count;
+        switch (kernel)
+        {
+#ifdef PINEDB_SEARCH_SSE2
+        case SearchKernel::SSE2:
+            count = count_sse2<Upper>(start, key);
+            break;
+#endif
+#ifdef PINEDB_SEARCH_AVX2
+        case SearchKernel::AVX2:
+            count = count_avx2<Upper>(start, key);
+            break;
+#endif
+#ifdef PINEDB_SEARCH_NEON
+        case SearchKernel::NEON:
+            count = count_neon<Upper>(start, key);
+            break;
+#endif
+        default:
+            count = count_scalar<Upper>(start, 0, window, key);
+            break;
+        }
+        return Upper ? base + window - count : base + count;
+    }
+} // namespace
+
+SearchKernel NodeSearch::best_kernel()
+{
+    static const SearchKernel kernel = detect_kernel();
+    return kernel;
+}
+
+bool NodeSearch::is_supported(SearchKernel kernel)
+{
+    switch (kernel)
+    {
+    case SearchKernel::SCALAR:
+        return true;
+    case SearchKernel::SSE2:
+        return best_kernel() == SearchKernel::SSE2 || best_kernel() == SearchKernel::AVX2;
+    default:
+        return best_kernel() == kernel;
+    }
+}
+
+const char *NodeSearch::kernel_name(SearchKernel kernel)
+{
+    switch (kernel)
+    {
+    case SearchKernel::SCALAR:
+        return "scalar";
+    case SearchKernel::SSE2:
+        return "sse2";
+    case SearchKernel::AVX2:
+        return "avx2";
+    case SearchKernel::NEON:
+        return "neon";
+    }
+    return "unknown";
+}
+
+template <typename T> uint32_t NodeSearch::lower_bound(const uint8_t *keys, uint32_t n, T key)
+{
+    return search<false>(keys, n, key, best_kernel());
+}
+
+template <typename T> uint32_t NodeSearch::upper_bound(const uint8_t *keys, uint32_t n, T key)
+{
+    return search<true>(keys, n, key, best_kernel());
+}
+
+template <typename T>
+uint32_t NodeSearch::lower_bound(const uint8_t *keys, uint32_t n, T key, SearchKernel kernel)
+{
+    return search<false>(keys, n, key, is_supported(kernel) ? kernel : SearchKernel::SCALAR);
+}
+
+template <typename T>
+uint32_t NodeSearch::upper_bound(const uint8_t *keys, uint32_t n, T key, SearchKernel kernel)
+{
+    return search<true>(keys, n, key, is_supported(kernel) ? kernel : SearchKernel::SCALAR);
+}
+
+namespace pinedb
+{
+#define PINEDB_INSTANTIATE_SEARCH(T)                                                              \
+    template uint32_t NodeSearch::lower_bound<T>(const uint8_t *, uint32_t, T);                   \
+    template uint32_t NodeSearch::upper_bound<T>(const uint8_t *, uint32_t, T);                   \
+    template uint32_t NodeSearch::lower_bound<T>(const uint8_t *, uint32_t, T, SearchKernel);     \
+    template uint32_t NodeSearch::upper_bound<T>(const uint8_t *, uint32_t, T, SearchKernel);
+
+    // One instantiation for each B+ tree key type
+    PINEDB_INSTANTIATE_SEARCH(uint8_t)
+    PINEDB_INSTANTIATE_SEARCH(int8_t)
+    PINEDB_INSTANTIATE_SEARCH(uint16_t)
+    PINEDB_INSTANTIATE_SEARCH(int16_t)
+    PINEDB_INSTANTIATE_SEARCH(uint32_t)
+    PINEDB_INSTANTIATE_SEARCH(int32_t)
+    PINEDB_INSTANTIATE_SEARCH(uint64_t)
+    PINEDB_INSTANTIATE_SEARCH(int64_t)
+    PINEDB_INSTANTIATE_SEARCH(float)
+    PINEDB_INSTANTIATE_SEARCH(double)
+#undef PINEDB_INSTANTIATE_SEARCH
+} // namespace pinedb
@@ -0,0 +1,274 @@
+#include <algorithm>
+#include <pinedb/datapacker.h>
+#include <pinedb/overflow.h>
+#include <pinedb/page.h>
+#include <stdexcept>
+#include <vector>
+
+using namespace pinedb;
+
+namespace
+{
+    const size_t NEXT_PAGE_ID_OFFSET = 16;
+    const size_t DATA_LENGTH_OFFSET = 20;
+
+    // The compressed format is a sequence of tokens. A token byte below 0x80 is followed by
+    // `token + 1` literal bytes, otherwise it is a copy of `(token & 0x7F) + MIN_MATCH` bytes
+    // from a distance (2 bytes) before the current position
+    const size_t MIN_MATCH = 4;
+    const size_t MAX_MATCH = 0x7F + MIN_MATCH;
+    const size_t MAX_LITERALS = 0x80;
+    const size_t MAX_DISTANCE = 0xFFFF;
+    const int HASH_BITS = 12;
+
+    void append_literals(std::vector<uint8_t> &out, const uint8_t *data, size_t length)
+    {
+        while (length > 0)
+        {
+            auto run = std::min(length, MAX_LITERALS);
+            out.push_back(static_cast<uint8_t>(run - 1));
+            out.insert(out.end(), data, data + run);
+            data += run;
+            length -= run;
+        }
+    }
+
+    std::vector<uint8_t> compress(const uint8_t *data, size_t length)
+    {
+        std::vector<uint8_t> out;
+        out.reserve(length);
+        // Position + 1 of the last occurence of each hash of 4 bytes, 0 if there is none
+        std::vector<uint32_t> table(size_t{1} << HASH_BITS, 0);
+        size_t position = 0, literal_start = 0;
+        while (position + MIN_MATCH <= length)
+        {
+            uint32_t sequence;
+            memcpy(&sequence, data + position, sizeof(sequence));
+            auto hash = (sequence * 2654435761U) >> (32 - HASH_BITS);
+            size_t candidate = table[hash];
+            table[hash] = static_cast<uint32_t>(position + 1);
+            if (candidate == 0 || position - (candidate - 1) > MAX_DISTANCE
+                || memcmp(data + candidate - 1, data + position, MIN_MATCH) != 0)
+            {
+                ++position;
+                continue;
+            }
+            auto match_start = candidate - 1;
+            size_t match_length = MIN_MATCH;
+            while (position + match_length < length && match_length < MAX_MATCH
+                   && data[match_start + match_length] == data[position + match_length])
+                ++match_length;
+
+            append_literals(out, data + literal_start, position - literal_start);
+            out.push_back(static_cast<uint8_t>(0x80 | (match_length - MIN_MATCH)));
+            uint8_t distance[2];
+            datapacker::bytes::encode_le(distance, static_cast<uint16_t>(position - match_start));
+            out.insert(out.end(), distance, distance + 2);
+            position += match_length;
+            literal_start = position;
+        }
+        append_literals(out, data + literal_start, length - literal_start);
+        return out;
+    }
+
+    void decompress(const std::string &in, size_t length, std::string &out)
+    {
+        auto corrupt = []() { throw std::runtime_error("compressed overflow value is corrupt"); };
+        out.clear();
+        out.reserve(length);
+        size_t position = 0;
+        while (position < in.size())
+        {
+            auto token = static_cast<uint8_t>(in[position++]);
+            if (token < 0x80)
+            {
+                size_t run = token + 1;
+                if (position + run > in.size() || out.size() + run > length)
+                    corrupt();
+                out.append(in, position, run);
+                position += run;
+                continue;
+            }
+            if (position + 2 > in.size())
+                corrupt();
+            uint16_t distance = 0;
+            datapacker::bytes::decode_le(
+                reinterpret_cast<uint8_t *>(const_cast<char *>(in.data())) + position, distance);
+            position += 2;
+            size_t match_length = (token & 0x7F) + MIN_MATCH;
+            if (distance == 0 || distance > out.size() || out.size() + match_length > length)
+                corrupt();
+            // The match can overlap with the bytes which are being copied
+            auto start = out.size() - distance;
+            for (size_t i = 0; i < match_length; ++i)
+                out.push_back(out[start + i]);
+        }
+        if (out.size() != length)
+            corrupt();
+    }
+} // namespace
+
+OverflowStore::OverflowStore(BufferPool &pool, size_t inline_limit, size_t prefix_length,
+                             bool compression)
+    : pool(pool), inline_limit(inline_limit), prefix_length(prefix_length), compression(compression)
+{
+    if (pool.page_size() <= HEADER_SIZE)
+    {
+        throw std::logic_error("page size is too small for overflow pages");
+    }
+    if (prefix_length + RecordLayout::EXTERNAL_POINTER_LENGTH
+        > RecordLayout::MAX_INLINE_STRING_LENGTH)
+    {
+        throw std::logic_error("prefix of an overflow value is too long");
+    }
+}
+
+uint8_t *OverflowStore::fetch(page_id_type page_id)
+{
+    auto page = pool.fetch_page(page_id);
+    if (page == nullptr)
+    {
+        throw std::runtime_error("could not read overflow page " + std::to_string(page_id));
+    }
+    return page;
+}
+
+page_id_type OverflowStore::write_chain(const uint8_t *data, size_t length)
+{
+    size_t capacity = pool.page_size() - HEADER_SIZE;
+    page_id_type first_page_id = 0, previous_page_id = 0;
+    size_t written = 0;
+    do
+    {
+        auto page_id = pool.new_page();
+        if (page_id == -1)
+        {
+            throw std::runtime_error("could not create an overflow page");
+        }
+        auto page = fetch(page_id);
+        PageHeader header;
+        header.set_page_type(PAGE_TYPE);
+        header.set_page_id(page_id);
+        header.write(page);
+        auto chunk = std::min(capacity, length - written);
+        datapacker::bytes::encode_le(page + NEXT_PAGE_ID_OFFSET, page_id_type{0},
+                                     static_cast<uint32_t>(chunk));
+        if (chunk > 0)
+            memcpy(page + HEADER_SIZE, data + written, chunk);
+        pool.set_dirty(page_id);
+        written += chunk;
+
+        if (previous_page_id == 0)
+        {
+            first_page_id = page_id;
+        }
+        else
+        {
+            datapacker::bytes::encode_le(fetch(previous_page_id) + NEXT_PAGE_ID_OFFSET, page_id);
+            pool.set_dirty(previous_page_id);
+        }
+        previous_page_id = page_id;
+    } while (written < length);
+    return first_page_id;
+}
+
+void OverflowStore::read_chain(page_id_type page_id, std::string &data)
+{
+    size_t capacity = pool.page_size() - HEADER_SIZE;
+    data.clear();
+    while (page_id != 0)
+    {
+        auto page = fetch(page_id);
+        PageHeader header;
+        header.read(page);
+        if (header.get_page_type() != PAGE_TYPE)
+        {
+            throw std::runtime_error("page " + std::to_string(page_id)
+                                     + " is not an overflow page");
+        }
+        uint32_t chunk = 0;
+        datapacker::bytes::decode_le(page + NEXT_PAGE_ID_OFFSET, page_id, chunk);
+        if (chunk > capacity)
+        {
+            throw std::runtime_error("overflow page has an invalid length");
+        }
+        data.append(reinterpret_cast<const char *>(page) + HEADER_SIZE, chunk);
+    }
+}
+
+ExternalString OverflowStore::write(std::string_view value)
+{
+    if (value.size() > UINT32_MAX)
+    {
+        throw std::runtime_error("string is too long to be stored");
+    }
+    ExternalString external{static_cast<uint32_t>(value.size()), 0, 0,
+                            value.substr(0, prefix_length)};
+    auto data = reinterpret_cast<const uint8_t *>(value.data());
+    if (compression)
+    {
+        auto compressed = compress(data, value.size());
+        if (compressed.size() < value.size())
+        {
+            external.flags |= FLAG_COMPRESSED;
+            external.page_id = write_chain(compressed.data(), compressed.size());
+            return external;
+        }
+    }
+    external.page_id = write_chain(data, value.size());
+    return external;
+}
+
+void OverflowStore::read(const ExternalString &external, std::string &value)
+{
+    if (external.flags & FLAG_COMPRESSED)
+    {
+        std::string compressed;
+        read_chain(external.page_id, compressed);
+        decompress(compressed, external.length, value);
+        return;
+    }
+    read_chain(external.page_id, value);
+    if (value.size() != external.length)
+    {
+        throw std::runtime_error("overflow value has an invalid length");
+    }
+}
+
+void OverflowStore::remove(const ExternalString &external)
+{
+    auto page_id = external.page_id;
+    while (page_id != 0)
+    {
+        auto next_page_id = page_id_type{0};
+        datapacker::bytes::decode_le(fetch(page_id) + NEXT_PAGE_ID_OFFSET, next_page_id);
+        pool.delete_page(page_id);
+        page_id = next_page_id;
+    }
+}
+
+void OverflowStore::set_string(RecordBuilder &builder, int index, std::string_view value)
+{
+    if (value.size() <= inline_limit)
+        builder.set_string(index, value);
+    else
+        builder.set_external_string(index, write(value));
+}
+
+void OverflowStore::get_string(const RecordLayout &layout, const uint8_t *record, int index,
+                               std::string &value)
+{
+    if (layout.is_external(record, index))
+        read(layout.get_external(record, index), value);
+    else
+        value.assign(layout.get_string(record, index));
+}
+
+void OverflowStore::remove_strings(const RecordLayout &layout, const uint8_t *record)
+{
+    for (int i = 0; i < layout.number_of_columns(); ++i)
+    {
+        if (layout.field(i).is_variable_length && layout.is_external(record, i))
+            remove(layout.get_external(record, i));
+    }
+}
@@ -0,0 +1,134 @@
+#include <pinedb/paxfile.h>
+#include <stdexcept>
+
+using namespace pinedb;
+
+namespace
+{
+    page_id_type zone_map_page_id(BufferPool &pool, const RecordLayout &layout,
+                                  page_id_type first_page_id)
+    {
+        auto page = pool.fetch_page(first_page_id);
+        if (page == nullptr)
+        {
+            throw std::runtime_error("could not read PAX page " + std::to_string(first_page_id));
+        }
+        return PaxPage(page, pool.page_size(), layout).get_zone_map_page_id();
+    }
+} // namespace
+
+page_id_type PaxFile::create(BufferPool &pool, const RecordLayout &layout)
+{
+    auto page_id = pool.new_page();
+    auto page = page_id == -1 ? nullptr : pool.fetch_page(page_id);
+    if (page == nullptr)
+    {
+        throw std::runtime_error("could not create the first page of the PAX file");
+    }
+    PaxPage(page, pool.page_size(), layout)
+        .init(page_id, PaxPage::default_capacity(layout, pool.page_size()));
+    pool.set_dirty(page_id);
+    return page_id;
+}
+
+PaxFile::PaxFile(BufferPool &pool, const RecordLayout &layout, page_id_type first_page_id)
+    : pool(pool),
+      layout(layout),
+      first_page_id(first_page_id),
+      last_page_id(first_page_id),
+      zone_map(pool, layout, zone_map_page_id(pool, layout, first_page_id))
+{
+    page_id_type page_id = first_page_id;
+    while (page_id != 0)
+    {
+        pages.push_back(page_id);
+        last_page_id = page_id;
+        page_id = PaxPage(fetch(page_id), pool.page_size(), this->layout).get_next_page_id();
+    }
+    if (zone_map.get_first_page_id() != 0)
+        return;
+
+    // The zone map is created with the first record, so build it if the file has records
+    std::vector<uint8_t> record(pool.page_size());
+    for (size_t i = 0; i < pages.size(); ++i)
+    {
+        for (uint16_t row = 0;; ++row)
+        {
+            PaxPage page(fetch(pages[i]), pool.page_size(), this->layout);
+            if (page.get_record(row, record.data(), record.size()) == 0)
+                break;
+            add_to_zone_map(i, record.data());
+        }
+    }
+}
+
+uint8_t *PaxFile::fetch(page_id_type page_id)
+{
+    auto page = pool.fetch_page(page_id);
+    if (page == nullptr)
+    {
+        throw std::runtime_error("could not read PAX page " + std::to_string(page_id));
+    }
+    return page;
+}
+
+page_id_type PaxFile::new_page()
+{
+    auto page_id = pool.new_page();
+    if (page_id == -1)
+    {
+        throw std::runtime_error("could not create a PAX page");
+    }
+    PaxPage(fetch(page_id), pool.page_size(), layout)
+        .init(page_id, PaxPage::default_capacity(layout, pool.page_size()));
+    pool.set_dirty(page_id);
+    return page_id;
+}
+
+void PaxFile::add_to_zone_map(size_t position, const uint8_t *record)
+{
+    bool had_pages = zone_map.get_first_page_id() != 0;
+    zone_map.add(position, record);
+    if (!had_pages)
+    {
+        PaxPage(fetch(first_page_id), pool.page_size(), layout)
+            .set_zone_map_page_id(zone_map.get_first_page_id());
+        pool.set_dirty(first_page_id);
+    }
+}
+
+RecordId PaxFile::insert(const uint8_t *record)
+{
+    auto row = PaxPage(fetch(last_page_id), pool.page_size(), layout).append(record);
+    if (row != -1)
+    {
+        pool.set_dirty(last_page_id);
+        add_to_zone_map(pages.size() - 1, record);
+        return {last_page_id, static_cast<uint16_t>(row)};
+    }
+
+    // The last page is full, append a new page to the chain
+    auto page_id = new_page();
+    row = PaxPage(fetch(page_id), pool.page_size(), layout).append(record);
+    if (row == -1)
+    {
+        pool.delete_page(page_id);
+        throw std::runtime_error("record is too large to be stored in a PAX page");
+    }
+    pool.set_dirty(page_id);
+    PaxPage(fetch(last_page_id), pool.page_size(), layout).set_next_page_id(page_id);
+    pool.set_dirty(last_page_id);
+    last_page_id = page_id;
+    pages.push_back(page_id);
+    add_to_zone_map(pages.size() - 1, record);
+    return {page_id, static_cast<uint16_t>(row)};
+}
+
+bool PaxFile::get(const RecordId &rid, std::vector<uint8_t> &row)
+{
+    PaxPage page(fetch(rid.page_id), pool.page_size(), layout);
+    row.resize(pool.page_size());
+    auto length = page.get_record(rid.slot, row.data(), row.size());
+    row.resize(length);
+    return length != 0;
+}
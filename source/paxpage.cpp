@@ -0,0 +1,246 @@
+#include <algorithm>
+#include <pinedb/dictionary.h>
+#include <pinedb/page.h>
+#include <pinedb/paxpage.h>
+
+using namespace pinedb;
+
+namespace
+{
+    // Offsets of the fields of the PAX page header, after the common page header
+    const size_t NUMBER_OF_ROWS_OFFSET = 16;
+    const size_t CAPACITY_OFFSET = 18;
+    const size_t FREE_SPACE_START_OFFSET = 20;
+    const size_t NEXT_PAGE_ID_OFFSET = 24;
+    const size_t ZONE_MAP_PAGE_ID_OFFSET = 28;
+} // namespace
+
+uint16_t PaxPage::read_u16(size_t offset) const
+{
+    uint16_t value = 0;
+    datapacker::bytes::decode_le(page + offset, value);
+    return value;
+}
+
+void PaxPage::write_u16(size_t offset, uint16_t value)
+{
+    datapacker::bytes::encode_le(page + offset, value);
+}
+
+uint16_t PaxPage::number_of_rows() const { return read_u16(NUMBER_OF_ROWS_OFFSET); }
+
+uint16_t PaxPage::get_capacity() const { return read_u16(CAPACITY_OFFSET); }
+
+uint16_t PaxPage::get_free_space_start() const { return read_u16(FREE_SPACE_START_OFFSET); }
+
+void PaxPage::set_free_space_start(uint16_t offset) { write_u16(FREE_SPACE_START_OFFSET, offset); }
+
+page_id_type PaxPage::get_next_page_id() const
+{
+    page_id_type page_id = 0;
+    datapacker::bytes::decode_le(page + NEXT_PAGE_ID_OFFSET, page_id);
+    return page_id;
+}
+
+void PaxPage::set_next_page_id(page_id_type page_id)
+{
+    datapacker::bytes::encode_le(page + NEXT_PAGE_ID_OFFSET, page_id);
+}
+
+page_id_type PaxPage::get_zone_map_page_id() const
+{
+    page_id_type page_id = 0;
+    datapacker::bytes::decode_le(page + ZONE_MAP_PAGE_ID_OFFSET, page_id);
+    return page_id;
+}
+
+void PaxPage::set_zone_map_page_id(page_id_type page_id)
+{
+    datapacker::bytes::encode_le(page + ZONE_MAP_PAGE_ID_OFFSET, page_id);
+}
+
+const FieldLayout &PaxPage::checked_field(int column, char format) const
+{
+    const auto &f = layout.field(column);
+    if (f.format != format)
+    {
+        throw std::logic_error("column " + std::to_string(column) + " has type '"
+                               + std::string(1, f.format) + "', not '" + std::string(1, format)
+                               + "'");
+    }
+    return f;
+}
+
+uint16_t PaxPage::default_capacity(const RecordLayout &layout, page_size_type page_size)
+{
+    size_t row_width = layout.get_fixed_length();
+    for (int i = 0; i < layout.number_of_columns(); ++i)
+    {
+        if (layout.field(i).is_variable_length)
+            row_width += STRING_RESERVE;
+    }
+    if (row_width == 0 || page_size <= HEADER_SIZE)
+        return 0;
+    return static_cast<uint16_t>(
+        std::min<size_t>(UINT16_MAX, (page_size - HEADER_SIZE) / row_width));
+}
+
+void PaxPage::init(page_id_type page_id, uint16_t capacity)
+{
+    if (page_size > MAX_PAGE_SIZE || layout.number_of_columns() == 0 || capacity == 0
+        || HEADER_SIZE + static_cast<size_t>(capacity) * layout.get_fixed_length()
+               > static_cast<size_t>(page_size))
+    {
+        throw std::logic_error("minipages do not fit in the page");
+    }
+    PageHeader header;
+    header.set_page_type(PAGE_TYPE);
+    header.set_page_id(page_id);
+    header.write(page);
+    memset(page + NUMBER_OF_ROWS_OFFSET, 0, HEADER_SIZE - NUMBER_OF_ROWS_OFFSET);
+    write_u16(CAPACITY_OFFSET, capacity);
+    set_free_space_start(static_cast<uint16_t>(HEADER_SIZE + capacity * layout.get_fixed_length()));
+}
+
+int PaxPage::append(const uint8_t *record)
+{
+    auto row = number_of_rows();
+    if (row >= get_capacity())
+        return -1;
+
+    auto record_data = const_cast<uint8_t *>(record);
+    size_t string_bytes = 0;
+    for (int i = 0; i < layout.number_of_columns(); ++i)
+    {
+        if (!layout.field(i).is_variable_length)
+            continue;
+        uint16_t offset = 0, length = 0;
+        datapacker::bytes::decode_le(record_data + layout.field(i).offset, offset, length);
+        string_bytes += length & ~RecordLayout::EXTERNAL_FLAG;
+    }
+    size_t start = get_free_space_start();
+    if (start + string_bytes > static_cast<size_t>(page_size))
+        return -1;
+
+    for (int i = 0; i < layout.number_of_columns(); ++i)
+    {
+        const auto &f = layout.field(i);
+        if (!f.is_variable_length)
+        {
+            memcpy(page + value_offset(row, i), record + f.offset, f.width);
+            continue;
+        }
+        // The string is copied to the end of the used space, with the flags in its length
+        uint16_t offset = 0, length = 0;
+        datapacker::bytes::decode_le(record_data + f.offset, offset, length);
+        size_t inline_length = length & ~RecordLayout::EXTERNAL_FLAG;
+        if (inline_length > 0)
+            memcpy(page + start, record + offset, inline_length);
+        datapacker::bytes::encode_le(page + value_offset(row, i), static_cast<uint16_t>(start),
+                                     length);
+        start += inline_length;
+    }
+    set_free_space_start(static_cast<uint16_t>(start));
+    write_u16(NUMBER_OF_ROWS_OFFSET, static_cast<uint16_t>(row + 1));
+    return row;
+}
+
+std::string_view PaxPage::get_string(uint16_t row, int column) const
+{
+    checked_field(column, 'c');
+    uint16_t offset = 0, length = 0;
+    datapacker::bytes::decode_le(page + value_offset(row, column), offset, length);
+    if (length & RecordLayout::EXTERNAL_FLAG)
+    {
+        offset = static_cast<uint16_t>(offset + RecordLayout::EXTERNAL_POINTER_LENGTH);
+        length = static_cast<uint16_t>((length & ~RecordLayout::EXTERNAL_FLAG)
+                                       - RecordLayout::EXTERNAL_POINTER_LENGTH);
+    }
+    return std::string_view(reinterpret_cast<const char *>(page) + offset, length);
+}
+
+size_t PaxPage::get_record(uint16_t row, uint8_t *buffer, size_t capacity) const
+{
+    if (row >= number_of_rows())
+        return 0;
+    size_t length = layout.get_fixed_length();
+    for (int i = 0; i < layout.number_of_columns(); ++i)
+    {
+        if (!layout.field(i).is_variable_length)
+            continue;
+        uint16_t offset = 0, string_length = 0;
+        datapacker::bytes::decode_le(page + value_offset(row, i), offset, string_length);
+        length += string_length & ~RecordLayout::EXTERNAL_FLAG;
+    }
+    if (length > capacity)
+        return 0;
+
+    size_t position = layout.get_fixed_length();
+    for (int i = 0; i < layout.number_of_columns(); ++i)
+    {
+        const auto &f = layout.field(i);
+        if (!f.is_variable_length)
+        {
+            memcpy(buffer + f.offset, page + value_offset(row, i), f.width);
+            continue;
+        }
+        uint16_t offset = 0, string_length = 0;
+        datapacker::bytes::decode_le(page + value_offset(row, i), offset, string_length);
+        size_t inline_length = string_length & ~RecordLayout::EXTERNAL_FLAG;
+        if (inline_length > 0)
+            memcpy(buffer + position, page + offset, inline_length);
+        datapacker::bytes::encode_le(buffer + f.offset, static_cast<uint16_t>(position),
+                                     string_length);
+        position += inline_length;
+    }
+    return length;
+}
+
+bool PaxPage::encode_column(int column, std::vector<uint8_t> &out) const
+{
+    auto rows = number_of_rows();
+    auto format = layout.field(column).format;
+    if (format == 'c')
+    {
+        std::vector<std::string_view> values(rows);
+        for (uint16_t row = 0; row < rows; ++row)
+        {
+            uint16_t offset = 0, length = 0;
+            datapacker::bytes::decode_le(page + value_offset(row, column), offset, length);
+            // Only the prefix of the string is in the page
+            if (length & RecordLayout::EXTERNAL_FLAG)
+                return false;
+            values[row] = get_string(row, column);
+        }
+        return DictionaryEncoder::encode(values, out);
+    }
+
+    std::vector<int64_t> values(rows);
+    for (uint16_t row = 0; row < rows; ++row)
+    {
+        switch (format)
+        {
+        case 'b':
+            values[row] = get<uint8_t>(row, column);
+            break;
+        case 'B':
+            values[row] = get<int8_t>(row, column);
+            break;
+        case 's':
+            values[row] = get<uint16_t>(row, column);
+            break;
+        case 'S':
+            values[row] = get<int16_t>(row, column);
+            break;
+        case 'i':
+            values[row] = get<uint32_t>(row, column);
+            break;
+        case 'I':
+            values[row] = get<int32_t>(row, column);
+            break;
+        default:
+            return false;
+        }
+    }
+    return DictionaryEncoder::encode(values, out);
+}
@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <pinedb/page.h>
+#include <pinedb/record.h>
+
+using namespace pinedb;
+
+uint16_t RecordLayout::field_width(char ch)
+{
+    switch (ch)
+    {
+    case 'b':
+    case 'B':
+        return 1;
+    case 's':
+    case 'S':
+        return 2;
+    case 'i':
+    case 'I':
+    case 'f':
+        return 4;
+    case 'l':
+    case 'L':
+    case 'd':
+        return 8;
+    case 'c':
+        return STRING_SLOT_WIDTH;
+    default:
+        throw std::logic_error("invalid format string");
+    }
+}
+
+RecordLayout::RecordLayout(const std::string &format)
+    : format(format), fixed_length(0), variable_length(false)
+{
+    auto invalid = ColumnFormat::validate_format(format);
+    if (invalid != '\0')
+    {
+        throw std::runtime_error("invalid column data type: " + std::string(1, invalid));
+    }
+    fields.resize(format.size());
+    for (size_t i = 0; i < format.size(); ++i)
+    {
+        fields[i].format = format[i];
+        fields[i].width = field_width(format[i]);
+        fields[i].is_variable_length = format[i] == 'c';
+        variable_length = variable_length || fields[i].is_variable_length;
+    }
+
+    // Place the widest fields first, so that every field is aligned to its width. String slots
+    // are aligned to 2 bytes, since they contain two 2 byte values
+    auto alignment = [](const FieldLayout &f)
+    { return f.is_variable_length ? uint16_t{2} : f.width; };
+    std::vector<size_t> order(fields.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                     { return alignment(fields[a]) > alignment(fields[b]); });
+    for (const auto i : order)
+    {
+        fields[i].offset = fixed_length;
+        fixed_length = static_cast<uint16_t>(fixed_length + fields[i].width);
+    }
+}
+
+size_t RecordLayout::record_length(const uint8_t *record) const
+{
+    size_t length = fixed_length;
+    for (int i = 0; i < number_of_columns(); ++i)
+    {
+        if (!fields[i].is_variable_length)
+            continue;
+        uint16_t offset = 0, string_length = 0;
+        datapacker::bytes::decode_le(const_cast<uint8_t *>(record) + fields[i].offset, offset,
+                                     string_length);
+        string_length = static_cast<uint16_t>(string_length & ~EXTERNAL_FLAG);
+        length = std::max(length, static_cast<size_t>(offset) + string_length);
+    }
+    return length;
+}
+
+ExternalString RecordLayout::get_external(const uint8_t *record, int index) const
+{
+    const auto &f = checked_field(index, 'c');
+    uint16_t offset = 0, length = 0;
+    datapacker::bytes::decode_le(const_cast<uint8_t *>(record) + f.offset, offset, length);
+    if (!(length & EXTERNAL_FLAG))
+    {
+        throw std::logic_error("column " + std::to_string(index) + " is stored in the record");
+    }
+    ExternalString value{0, 0, 0, get_string(record, index)};
+    datapacker::bytes::decode_le(const_cast<uint8_t *>(record) + offset, value.length,
+                                 value.page_id, value.flags);
+    return value;
+}
+
+RecordBuilder::RecordBuilder(const RecordLayout &layout, uint8_t *buffer, size_t capacity)
+    : layout(layout), buffer(buffer), capacity(capacity), length(layout.get_fixed_length())
+{
+    if (capacity < length)
+    {
+        throw std::runtime_error("buffer is too small to hold the record");
+    }
+    // Strings which are never set are empty
+    memset(buffer, 0, length);
+    for (int i = 0; i < layout.number_of_columns(); ++i)
+    {
+        if (layout.field(i).is_variable_length)
+        {
+            datapacker::bytes::encode_le(buffer + layout.field(i).offset,
+                                         static_cast<uint16_t>(length), uint16_t{0});
+        }
+    }
+}
+
+namespace
+{
+    const FieldLayout &string_field(const RecordLayout &layout, int index)
+    {
+        const auto &f = layout.field(index);
+        if (!f.is_variable_length)
+        {
+            throw std::logic_error("column " + std::to_string(index) + " is not a string");
+        }
+        return f;
+    }
+} // namespace
+
+RecordBuilder &RecordBuilder::set_string(int index, std::string_view s)
+{
+    const auto &f = string_field(layout, index);
+    if (length + s.size() > capacity || length + s.size() > RecordLayout::MAX_RECORD_LENGTH
+        || s.size() > RecordLayout::MAX_INLINE_STRING_LENGTH)
+    {
+        throw std::runtime_error("string does not fit in the record");
+    }
+    if (!s.empty())
+        memcpy(buffer + length, s.data(), s.size());
+    datapacker::bytes::encode_le(buffer + f.offset, static_cast<uint16_t>(length),
+                                 static_cast<uint16_t>(s.size()));
+    length += s.size();
+    return *this;
+}
+
+RecordBuilder &RecordBuilder::set_external_string(int index, const ExternalString &value)
+{
+    const auto &f = string_field(layout, index);
+    auto inline_length = RecordLayout::EXTERNAL_POINTER_LENGTH + value.prefix.size();
+    if (length + inline_length > capacity
+        || length + inline_length > RecordLayout::MAX_RECORD_LENGTH
+        || inline_length > RecordLayout::MAX_INLINE_STRING_LENGTH)
+    {
+        throw std::runtime_error("string does not fit in the record");
+    }
+    datapacker::bytes::encode_le(buffer + length, value.length, value.page_id, value.flags);
+    if (!value.prefix.empty())
+        memcpy(buffer + length + RecordLayout::EXTERNAL_POINTER_LENGTH, value.prefix.data(),
+               value.prefix.size());
+    datapacker::bytes::encode_le(
+        buffer + f.offset, static_cast<uint16_t>(length),
+        static_cast<uint16_t>(inline_length | RecordLayout::EXTERNAL_FLAG));
+    length += inline_length;
+    return *this;
+}
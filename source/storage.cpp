@@ -9,6 +9,21 @@
 
 using namespace pinedb;
 
+namespace
+{
+    // Largest number of pages which are read by one `readv`, below the minimum IOV_MAX
+    constexpr size_t MAX_PAGES_PER_READ = 16;
+} // namespace
+
+bool StorageBackend::read_pages(const std::vector<page_id_type> &page_ids,
+                                const std::vector<uint8_t *> &buffers)
+{
+    bool status = true;
+    for (size_t i = 0; i < page_ids.size(); ++i)
+        status = read_page(page_ids[i], buffers[i]) && status;
+    return status;
+}
+
 DiskStorageBackend::DiskStorageBackend(const std::string &file_path, page_size_type page_sz)
     : file_path(file_path), page_sz(page_sz), current_page_id_counter(0), zerobuffer(page_sz, 0)
 {
@@ -85,6 +100,57 @@ bool DiskStorageBackend::read_page(page_id_type page_id, uint8_t *buffer)
     return true;
 }
 
+bool DiskStorageBackend::read_pages(const std::vector<page_id_type> &page_ids,
+                                    const std::vector<uint8_t *> &buffers)
+{
+#ifdef _WIN32
+    return StorageBackend::read_pages(page_ids, buffers);
+#else
+    bool status = true;
+    size_t i = 0;
+    while (i < page_ids.size())
+    {
+        // Finds the run of pages with consecutive ids which starts at `i`
+        size_t n = 1;
+        while (i + n < page_ids.size() && n < MAX_PAGES_PER_READ
+               && page_ids[i + n] == page_ids[i] + static_cast<page_id_type>(n))
+            ++n;
+        if (page_ids[i] < 0 || page_ids[i] + static_cast<page_id_type>(n) - 1
+                                   > current_page_id_counter)
+        {
+            // Some of the pages do not exist, they are read one at a time to find out which
+            for (size_t j = i; j < i + n; ++j)
+                status = read_page(page_ids[j], buffers[j]) && status;
+            i += n;
+            continue;
+        }
+
+        struct iovec iov[MAX_PAGES_PER_READ];
+        for (size_t j = 0; j < n; ++j)
+        {
+            iov[j].iov_base = buffers[i + j];
+            iov[j].iov_len = page_sz;
+        }
+        int64_t offset = static_cast<int64_t>(page_ids[i]) * page_sz;
+        ssize_t bytes_read = -1;
+        if (file_handle.seek(offset, SEEK_SET) != -1)
+            bytes_read = file_handle.readv(iov, static_cast<int>(n));
+        if (bytes_read != static_cast<ssize_t>(n * page_sz))
+        {
+            spdlog::info("Could not read {} pages from page {}: {}", n, page_ids[i],
+                         strerror(errno));
+            status = false;
+        }
+        else
+        {
+            spdlog::info("Read {} pages from page {} at 0x{:x}", n, page_ids[i], offset);
+        }
+        i += n;
+    }
+    return status;
+#endif
+}
+
 bool DiskStorageBackend::write_page(page_id_type page_id, uint8_t *buffer)
 {
     // Overwrites the page at offset with the new data
@@ -0,0 +1,608 @@
+#include <algorithm>
+#include <pinedb/page.h>
+#include <pinedb/stringbtree.h>
+#include <stdexcept>
+#include <string.h>
+
+using namespace pinedb;
+
+namespace
+{
+    size_t common_prefix(std::string_view a, std::string_view b)
+    {
+        auto n = std::min(a.size(), b.size());
+        size_t i = 0;
+        while (i < n && a[i] == b[i])
+            ++i;
+        return i;
+    }
+
+    // Split point of keys which do not fit in one node. The keys `[0, i)` stay in the left node,
+    // and the keys after them move to the right node, key `i` moves up into the parent if the
+    // nodes are internal. The split which gives the smallest larger node is found first, then
+    // the split points near it are checked for a shorter separator
+    size_t choose_split(const std::vector<std::string> &keys, bool leaf, size_t capacity)
+    {
+        auto n = keys.size();
+        size_t slot = leaf ? StringBTreeNode::LEAF_SLOT_SIZE : StringBTreeNode::INTERNAL_SLOT_SIZE;
+        std::vector<size_t> lengths(n + 1, 0);
+        for (size_t i = 0; i < n; ++i)
+            lengths[i + 1] = lengths[i] + keys[i].size();
+        auto space = [&](size_t begin, size_t end) -> size_t
+        {
+            if (begin >= end)
+                return 0;
+            auto count = end - begin;
+            auto prefix = common_prefix(keys[begin], keys[end - 1]);
+            return prefix + count * slot + lengths[end] - lengths[begin] - count * prefix;
+        };
+        auto larger = [&](size_t i) { return std::max(space(0, i), space(leaf ? i : i + 1, n)); };
+        auto separator_length = [&](size_t i)
+        { return leaf ? common_prefix(keys[i - 1], keys[i]) + 1 : keys[i].size(); };
+
+        // Both nodes should have keys, an internal node can keep a single child if it has to
+        size_t low = 1, high = leaf ? n - 1 : n - 2;
+        if (n < 3)
+            low = leaf ? 1 : 0, high = n - 1;
+        auto best = low;
+        auto best_space = larger(low);
+        for (auto i = low + 1; i <= high; ++i)
+        {
+            auto s = larger(i);
+            if (s < best_space)
+                best = i, best_space = s;
+        }
+        if (best_space > capacity)
+        {
+            throw std::logic_error("B+ tree node cannot be split into two pages");
+        }
+
+        auto window = std::max<size_t>(1, n / 8);
+        auto chosen = best;
+        auto chosen_length = separator_length(best);
+        for (auto i = best > low + window ? best - window : low; i <= std::min(high, best + window);
+             ++i)
+        {
+            auto length = separator_length(i);
+            auto closer = (i > best ? i - best : best - i) < (chosen > best ? chosen - best
+                                                                             : best - chosen);
+            if ((length < chosen_length || (length == chosen_length && closer))
+                && larger(i) <= capacity)
+            {
+                chosen = i;
+                chosen_length = length;
+            }
+        }
+        return chosen;
+    }
+
+    // Divides the contents of a node at the split point, and returns the separator of the nodes
+    std::string split_contents(const StringBTreeNode::Contents &all, bool leaf, size_t i,
+                               StringBTreeNode::Contents &left, StringBTreeNode::Contents &right)
+    {
+        const auto &keys = all.keys;
+        const auto &links = all.links;
+        left.keys.assign(keys.begin(), keys.begin() + i);
+        if (leaf)
+        {
+            left.links.assign(links.begin(), links.begin() + i);
+            right.keys.assign(keys.begin() + i, keys.end());
+            right.links.assign(links.begin() + i, links.end());
+            // Shortest prefix of the first key of the right leaf which is greater than the last
+            // key of the left leaf
+            const auto &first = right.keys.front();
+            return first.substr(0, common_prefix(left.keys.back(), first) + 1);
+        }
+        left.links.assign(links.begin(), links.begin() + i + 1);
+        right.keys.assign(keys.begin() + i + 1, keys.end());
+        right.links.assign(links.begin() + i + 1, links.end());
+        return keys[i];
+    }
+} // namespace
+
+size_t StringBTreeNode::space_needed(const std::vector<std::string> &keys, size_t begin,
+                                     size_t end, bool leaf)
+{
+    if (begin >= end)
+        return 0;
+    auto prefix = common_prefix(keys[begin], keys[end - 1]);
+    size_t space = prefix;
+    for (auto i = begin; i < end; ++i)
+        space += (leaf ? LEAF_SLOT_SIZE : INTERNAL_SLOT_SIZE) + keys[i].size() - prefix;
+    return space;
+}
+
+uint32_t StringBTreeNode::head(std::string_view suffix)
+{
+    uint8_t buffer[4] = {0};
+    if (!suffix.empty())
+        memcpy(buffer, suffix.data(), std::min<size_t>(suffix.size(), 4));
+    uint32_t value;
+    datapacker::bytes::decode_be(buffer, value);
+    return value;
+}
+
+void StringBTreeNode::init(page_id_type page_id, bool leaf)
+{
+    PageHeader header;
+    header.set_page_type(leaf ? LEAF_PAGE_TYPE : INTERNAL_PAGE_TYPE);
+    header.set_page_id(page_id);
+    header.write(page);
+    memset(page + NEXT_LEAF_OFFSET, 0, HEADER_SIZE - NEXT_LEAF_OFFSET);
+    write(DATA_START_OFFSET, static_cast<uint32_t>(page_size));
+    page[KEY_TYPE_OFFSET] = KEY_TYPE;
+}
+
+int StringBTreeNode::compare_suffix(uint32_t i, std::string_view suffix, uint32_t head) const
+{
+    auto slot_head = read<uint32_t>(slot_offset(i) + 4);
+    if (slot_head != head)
+        return slot_head < head ? -1 : 1;
+    return this->suffix(i).compare(suffix);
+}
+
+int StringBTreeNode::compare_prefix(std::string_view key, std::string_view &suffix) const
+{
+    auto p = prefix();
+    auto n = std::min(key.size(), p.size());
+    int result = n == 0 ? 0 : memcmp(key.data(), p.data(), n);
+    if (result != 0)
+        return result;
+    // A key which is shorter than the prefix comes before all the keys
+    if (key.size() < p.size())
+        return -1;
+    suffix = key.substr(p.size());
+    return 0;
+}
+
+size_t StringBTreeNode::used_space() const
+{
+    auto n = size();
+    size_t space = get_prefix_length() + n * slot_size();
+    for (uint32_t i = 0; i < n; ++i)
+        space += read<uint16_t>(slot_offset(i) + 2);
+    return space;
+}
+
+uint32_t StringBTreeNode::lower_bound(std::string_view key) const
+{
+    std::string_view suffix;
+    auto result = compare_prefix(key, suffix);
+    if (result != 0)
+        return result < 0 ? 0 : size();
+    auto h = head(suffix);
+    uint32_t low = 0, high = size();
+    while (low < high)
+    {
+        auto mid = (low + high) / 2;
+        if (compare_suffix(mid, suffix, h) < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+uint32_t StringBTreeNode::upper_bound(std::string_view key) const
+{
+    std::string_view suffix;
+    auto result = compare_prefix(key, suffix);
+    if (result != 0)
+        return result < 0 ? 0 : size();
+    auto h = head(suffix);
+    uint32_t low = 0, high = size();
+    while (low < high)
+    {
+        auto mid = (low + high) / 2;
+        if (compare_suffix(mid, suffix, h) <= 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+bool StringBTreeNode::insert(uint32_t i, std::string_view key, uint64_t link)
+{
+    auto p = prefix();
+    if (key.size() < p.size() || key.substr(0, p.size()) != p)
+        return false;
+    auto suffix = key.substr(p.size());
+    auto n = size();
+    auto slots_end = slot_offset(n);
+    auto data_start = get_data_start();
+    if (data_start < slots_end + slot_size() + suffix.size())
+        return false;
+
+    data_start -= static_cast<uint32_t>(suffix.size());
+    memcpy(page + data_start, suffix.data(), suffix.size());
+    auto slot = slot_offset(i);
+    memmove(page + slot + slot_size(), page + slot, slots_end - slot);
+    write(slot, static_cast<uint16_t>(data_start));
+    write(slot + 2, static_cast<uint16_t>(suffix.size()));
+    write(slot + 4, head(suffix));
+    if (is_leaf())
+        write(slot + 8, link);
+    else
+        write(slot + 8, static_cast<page_id_type>(link));
+    write(DATA_START_OFFSET, data_start);
+    write(NUMBER_OF_KEYS_OFFSET, n + 1);
+    return true;
+}
+
+void StringBTreeNode::remove(uint32_t i)
+{
+    auto n = size();
+    auto slot = slot_offset(i);
+    memmove(page + slot, page + slot + slot_size(), slot_offset(n) - slot - slot_size());
+    write(NUMBER_OF_KEYS_OFFSET, n - 1);
+}
+
+StringBTreeNode::Contents StringBTreeNode::get_contents() const
+{
+    Contents contents;
+    auto n = size();
+    for (uint32_t i = 0; i < n; ++i)
+        contents.keys.push_back(key(i));
+    if (is_leaf())
+    {
+        for (uint32_t i = 0; i < n; ++i)
+            contents.links.push_back(value(i));
+    }
+    else
+    {
+        for (uint32_t i = 0; i <= n; ++i)
+            contents.links.push_back(static_cast<uint64_t>(child(i)));
+    }
+    return contents;
+}
+
+void StringBTreeNode::load(page_id_type page_id, bool leaf, const Contents &contents)
+{
+    const auto &keys = contents.keys;
+    if (space_needed(keys, 0, keys.size(), leaf) > capacity(page_size))
+    {
+        throw std::logic_error("keys do not fit in a B+ tree node");
+    }
+    init(page_id, leaf);
+    auto prefix = keys.empty() ? 0 : common_prefix(keys.front(), keys.back());
+    if (prefix > 0)
+        memcpy(page + HEADER_SIZE, keys.front().data(), prefix);
+    write(PREFIX_LENGTH_OFFSET, static_cast<uint16_t>(prefix));
+    if (!leaf)
+        write(NEXT_LEAF_OFFSET, static_cast<page_id_type>(contents.links[0]));
+    for (uint32_t i = 0; i < keys.size(); ++i)
+        insert(i, keys[i], contents.links[leaf ? i : i + 1]);
+}
+
+page_id_type StringBTree::create(BufferPool &pool)
+{
+    auto page_size = pool.page_size();
+    if (page_size > StringBTreeNode::MAX_PAGE_SIZE)
+    {
+        throw std::logic_error("page size is too large for a B+ tree with string keys");
+    }
+    if (StringBTreeNode::capacity(page_size) / 4 < StringBTreeNode::LEAF_SLOT_SIZE + 8)
+    {
+        throw std::logic_error("page size is too small for a B+ tree with string keys");
+    }
+    auto page_id = pool.new_page();
+    auto page = page_id == -1 ? nullptr : pool.fetch_page(page_id);
+    if (page == nullptr)
+    {
+        throw std::runtime_error("could not create the root of the B+ tree");
+    }
+    StringBTreeNode(page, page_size).init(page_id, true);
+    pool.set_dirty(page_id);
+    return page_id;
+}
+
+StringBTree::StringBTree(BufferPool &pool, page_id_type root_page_id)
+    : pool(pool), root_page_id(root_page_id)
+{
+    auto page = fetch(root_page_id);
+    bool is_node = page[0] == StringBTreeNode::LEAF_PAGE_TYPE
+                   || page[0] == StringBTreeNode::INTERNAL_PAGE_TYPE;
+    if (!is_node || StringBTreeNode(page, pool.page_size()).get_key_type()
+                        != StringBTreeNode::KEY_TYPE)
+    {
+        throw std::runtime_error("page " + std::to_string(root_page_id)
+                                 + " is not the root of a B+ tree with string keys");
+    }
+}
+
+uint8_t *StringBTree::fetch(page_id_type page_id)
+{
+    auto page = pool.fetch_page(page_id);
+    if (page == nullptr)
+    {
+        throw std::runtime_error("could not read B+ tree page " + std::to_string(page_id));
+    }
+    return page;
+}
+
+StringBTreeNode StringBTree::node(page_id_type page_id)
+{
+    return StringBTreeNode(fetch(page_id), pool.page_size());
+}
+
+void StringBTree::store(page_id_type page_id, bool leaf,
+                        const StringBTreeNode::Contents &contents, page_id_type next_leaf)
+{
+    auto n = node(page_id);
+    n.load(page_id, leaf, contents);
+    if (leaf)
+        n.set_next_leaf(next_leaf);
+    pool.set_dirty(page_id);
+}
+
+void StringBTree::check_key(std::string_view key) const
+{
+    if (key.size() > max_key_size())
+    {
+        throw std::logic_error("key of " + std::to_string(key.size())
+                               + " bytes is longer than the longest key of the B+ tree, "
+                               + std::to_string(max_key_size()) + " bytes");
+    }
+}
+
+page_id_type StringBTree::find_leaf(std::string_view key)
+{
+    page_id_type page_id = root_page_id;
+    while (true)
+    {
+        auto n = node(page_id);
+        if (n.is_leaf())
+            return page_id;
+        page_id = n.child(n.upper_bound(key));
+    }
+}
+
+bool StringBTree::search(std::string_view key, uint64_t &value)
+{
+    auto leaf = node(find_leaf(key));
+    auto i = leaf.lower_bound(key);
+    if (i == leaf.size() || !leaf.has_key(i, key))
+        return false;
+    value = leaf.value(i);
+    return true;
+}
+
+bool StringBTree::update(std::string_view key, uint64_t value)
+{
+    auto page_id = find_leaf(key);
+    auto leaf = node(page_id);
+    auto i = leaf.lower_bound(key);
+    if (i == leaf.size() || !leaf.has_key(i, key))
+        return false;
+    leaf.set_value(i, value);
+    pool.set_dirty(page_id);
+    return true;
+}
+
+StringBTree::Split StringBTree::insert_at(page_id_type page_id, uint32_t i, std::string_view key,
+                                          uint64_t link)
+{
+    auto n = node(page_id);
+    if (n.size() > 0 && n.insert(i, key, link))
+    {
+        pool.set_dirty(page_id);
+        return {false, "", 0};
+    }
+
+    // The node is rebuilt if the key does not start with its prefix or the space of removed
+    // keys is needed, and is split if the keys do not fit. The first key of an empty node is
+    // its prefix, which becomes shorter as keys which do not start with it are inserted
+    bool leaf = n.is_leaf();
+    auto next_leaf = n.get_next_leaf();
+    auto contents = n.get_contents();
+    contents.keys.insert(contents.keys.begin() + i, std::string(key));
+    contents.links.insert(contents.links.begin() + (leaf ? i : i + 1), link);
+    auto capacity = StringBTreeNode::capacity(pool.page_size());
+    if (StringBTreeNode::space_needed(contents.keys, 0, contents.keys.size(), leaf) <= capacity)
+    {
+        store(page_id, leaf, contents, next_leaf);
+        return {false, "", 0};
+    }
+
+    auto split = choose_split(contents.keys, leaf, capacity);
+    StringBTreeNode::Contents left, right;
+    Split result{true, split_contents(contents, leaf, split, left, right), 0};
+    result.right_page_id = pool.new_page();
+    if (result.right_page_id == -1)
+    {
+        throw std::runtime_error("could not create a B+ tree page");
+    }
+    store(page_id, leaf, left, result.right_page_id);
+    store(result.right_page_id, leaf, right, next_leaf);
+    return result;
+}
+
+bool StringBTree::insert_into(page_id_type page_id, std::string_view key, uint64_t value,
+                              Split &split)
+{
+    split.split = false;
+    auto n = node(page_id);
+    if (n.is_leaf())
+    {
+        auto i = n.lower_bound(key);
+        if (i < n.size() && n.has_key(i, key))
+            return false;
+        split = insert_at(page_id, i, key, value);
+        return true;
+    }
+
+    auto i = n.upper_bound(key);
+    Split child_split;
+    if (!insert_into(n.child(i), key, value, child_split))
+        return false;
+    if (child_split.split)
+        split = insert_at(page_id, i, child_split.separator,
+                          static_cast<uint64_t>(child_split.right_page_id));
+    return true;
+}
+
+bool StringBTree::insert(std::string_view key, uint64_t value)
+{
+    check_key(key);
+    Split split;
+    if (!insert_into(root_page_id, key, value, split))
+        return false;
+    if (split.split)
+    {
+        // Move the left half of the root to a new page, so that the root page id does not change
+        auto left_page_id = pool.new_page();
+        if (left_page_id == -1)
+        {
+            throw std::runtime_error("could not create a B+ tree page");
+        }
+        auto root = node(root_page_id);
+        bool leaf = root.is_leaf();
+        auto next_leaf = root.get_next_leaf();
+        store(left_page_id, leaf, root.get_contents(), next_leaf);
+
+        StringBTreeNode::Contents contents;
+        contents.keys.push_back(split.separator);
+        contents.links.push_back(static_cast<uint64_t>(left_page_id));
+        contents.links.push_back(static_cast<uint64_t>(split.right_page_id));
+        store(root_page_id, false, contents);
+    }
+    return true;
+}
+
+bool StringBTree::is_underfull(page_id_type page_id)
+{
+    auto n = node(page_id);
+    return n.size() == 0 || n.used_space() < StringBTreeNode::capacity(pool.page_size()) / 4;
+}
+
+void StringBTree::rebalance(page_id_type page_id, uint32_t child_index)
+{
+    // The child is paired with its left sibling, or with its right sibling if it is the first
+    auto parent = node(page_id).get_contents();
+    auto left_index = child_index > 0 ? child_index - 1 : child_index;
+    auto left_page_id = static_cast<page_id_type>(parent.links[left_index]);
+    auto right_page_id = static_cast<page_id_type>(parent.links[left_index + 1]);
+    auto left_node = node(left_page_id);
+    bool leaf = left_node.is_leaf();
+    auto combined = left_node.get_contents();
+    auto right_node = node(right_page_id);
+    auto next_leaf = right_node.get_next_leaf();
+    auto right = right_node.get_contents();
+    // The separator moves down when internal nodes are combined
+    if (!leaf)
+        combined.keys.push_back(parent.keys[left_index]);
+    combined.keys.insert(combined.keys.end(), right.keys.begin(), right.keys.end());
+    combined.links.insert(combined.links.end(), right.links.begin(), right.links.end());
+
+    auto capacity = StringBTreeNode::capacity(pool.page_size());
+    if (StringBTreeNode::space_needed(combined.keys, 0, combined.keys.size(), leaf) <= capacity)
+    {
+        store(left_page_id, leaf, combined, next_leaf);
+        parent.keys.erase(parent.keys.begin() + left_index);
+        parent.links.erase(parent.links.begin() + left_index + 1);
+        store(page_id, false, parent);
+        pool.delete_page(right_page_id);
+        return;
+    }
+
+    // The keys are divided evenly, unless the new separator does not fit in the parent, the
+    // child then stays underfull
+    StringBTreeNode::Contents left;
+    right = StringBTreeNode::Contents();
+    parent.keys[left_index]
+        = split_contents(combined, leaf, choose_split(combined.keys, leaf, capacity), left, right);
+    if (StringBTreeNode::space_needed(parent.keys, 0, parent.keys.size(), false) > capacity)
+        return;
+    store(left_page_id, leaf, left, right_page_id);
+    store(right_page_id, leaf, right, next_leaf);
+    store(page_id, false, parent);
+}
+
+bool StringBTree::remove_from(page_id_type page_id, std::string_view key)
+{
+    auto n = node(page_id);
+    if (n.is_leaf())
+    {
+        auto i = n.lower_bound(key);
+        if (i == n.size() || !n.has_key(i, key))
+            return false;
+        n.remove(i);
+        pool.set_dirty(page_id);
+        return true;
+    }
+    auto i = n.upper_bound(key);
+    auto child_page_id = n.child(i);
+    if (!remove_from(child_page_id, key))
+        return false;
+    if (is_underfull(child_page_id))
+        rebalance(page_id, i);
+    return true;
+}
+
+bool StringBTree::remove(std::string_view key)
+{
+    if (!remove_from(root_page_id, key))
+        return false;
+    auto root = node(root_page_id);
+    if (!root.is_leaf() && root.size() == 0)
+    {
+        // The root has a single child, move the child into the root page
+        auto child_page_id = root.child(0);
+        auto child = node(child_page_id);
+        store(root_page_id, child.is_leaf(), child.get_contents(), child.get_next_leaf());
+        pool.delete_page(child_page_id);
+    }
+    return true;
+}
+
+int StringBTree::height()
+{
+    int levels = 1;
+    page_id_type page_id = root_page_id;
+    while (true)
+    {
+        auto n = node(page_id);
+        if (n.is_leaf())
+            return levels;
+        page_id = n.child(0);
+        ++levels;
+    }
+}
+
+bool StringBTree::Iterator::next(std::string &key, uint64_t &value)
+{
+    while (page_id != 0)
+    {
+        auto leaf = tree.node(page_id);
+        if (index < leaf.size())
+        {
+            key = leaf.key(index);
+            value = leaf.value(index);
+            ++index;
+            return true;
+        }
+        page_id = leaf.get_next_leaf();
+        index = 0;
+    }
+    return false;
+}
+
+StringBTree::Iterator StringBTree::begin()
+{
+    page_id_type page_id = root_page_id;
+    while (true)
+    {
+        auto n = node(page_id);
+        if (n.is_leaf())
+            return Iterator(*this, page_id, 0);
+        page_id = n.child(0);
+    }
+}
+
+StringBTree::Iterator StringBTree::lower_bound(std::string_view key)
+{
+    auto page_id = find_leaf(key);
+    auto leaf = node(page_id);
+    return Iterator(*this, page_id, leaf.lower_bound(key));
+}
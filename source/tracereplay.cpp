@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <pinedb/tracereplay.h>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace pinedb;
+
+trace::trace_type trace::uniform(page_id_type number_of_pages, size_t length, uint64_t seed)
+{
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<page_id_type> dist(0, number_of_pages - 1);
+    trace_type result(length);
+    for (auto &pageid : result)
+        pageid = dist(rng);
+    return result;
+}
+
+trace::trace_type trace::zipfian(page_id_type number_of_pages, size_t length, double skew,
+                                 uint64_t seed)
+{
+    // Build the cumulative distribution once, then each access is a binary search over it
+    std::vector<double> cdf(number_of_pages);
+    double sum = 0;
+    for (page_id_type i = 0; i < number_of_pages; ++i)
+    {
+        sum += 1.0 / std::pow(static_cast<double>(i + 1), skew);
+        cdf[i] = sum;
+    }
+
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> dist(0.0, sum);
+    trace_type result(length);
+    for (auto &pageid : result)
+    {
+        auto iter = std::lower_bound(cdf.begin(), cdf.end(), dist(rng));
+        if (iter == cdf.end())
+            --iter;
+        pageid = static_cast<page_id_type>(iter - cdf.begin());
+    }
+    return result;
+}
+
+trace::trace_type trace::sequential_scan(page_id_type number_of_pages)
+{
+    trace_type result(number_of_pages);
+    for (page_id_type i = 0; i < number_of_pages; ++i)
+        result[i] = i;
+    return result;
+}
+
+trace::trace_type trace::looping(page_id_type number_of_pages, size_t length)
+{
+    trace_type result(length);
+    for (size_t i = 0; i < length; ++i)
+        result[i] = static_cast<page_id_type>(i % number_of_pages);
+    return result;
+}
+
+trace::trace_type trace::scan_hot_mix(page_id_type number_of_pages, page_id_type hot_pages,
+                                      size_t length, double hot_probability, uint64_t seed)
+{
+    if (hot_pages <= 0 || hot_pages >= number_of_pages)
+    {
+        throw std::logic_error("hot_pages should be between 0 and number_of_pages");
+    }
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<page_id_type> hot_dist(0, hot_pages - 1);
+    std::bernoulli_distribution is_hot(hot_probability);
+    // The scan covers the pages which are not part of the hot set
+    page_id_type scan_position = hot_pages;
+    trace_type result(length);
+    for (auto &pageid : result)
+    {
+        if (is_hot(rng))
+        {
+            pageid = hot_dist(rng);
+        }
+        else
+        {
+            pageid = scan_position++;
+            if (scan_position == number_of_pages)
+                scan_position = hot_pages;
+        }
+    }
+    return result;
+}
+
+bool trace::save(const std::string &file_path, const trace_type &trace)
+{
+    std::ofstream ofs(file_path);
+    if (!ofs)
+        return false;
+    for (const auto pageid : trace)
+        ofs << pageid << '\n';
+    return static_cast<bool>(ofs);
+}
+
+bool trace::load(const std::string &file_path, trace_type &trace)
+{
+    std::ifstream ifs(file_path);
+    if (!ifs)
+        return false;
+    trace_type result;
+    page_id_type pageid;
+    while (ifs >> pageid)
+        result.push_back(pageid);
+    // Stopped before reaching the end, i.e. the file has a line which is not a page id
+    if (!ifs.eof())
+        return false;
+    trace = std::move(result);
+    return true;
+}
+
+ReplayStats pinedb::replay_trace(const trace::trace_type &trace, int number_of_frames,
+                                 CacheReplacer<frame_id_type> &cache_replacer)
+{
+    ReplayStats stats;
+    std::unordered_map<page_id_type, frame_id_type> page_to_frame_map;
+    std::vector<page_id_type> frame_to_page_map(number_of_frames, -1);
+    frame_id_type next_free_frame = 0;
+    page_to_frame_map.reserve(number_of_frames);
+
+    for (const auto pageid : trace)
+    {
+        ++stats.accesses;
+        auto iter = page_to_frame_map.find(pageid);
+        if (iter != page_to_frame_map.end())
+        {
+            ++stats.hits;
+            cache_replacer.access(iter->second);
+            continue;
+        }
+
+        ++stats.misses;
+        frame_id_type frame_id;
+        if (next_free_frame < number_of_frames)
+        {
+            frame_id = next_free_frame++;
+        }
+        else
+        {
+            auto opt = cache_replacer.evict();
+            if (!opt.has_value())
+            {
+                throw std::runtime_error("Cache replacer could not evict a frame during replay");
+            }
+            frame_id = opt.value();
+            page_to_frame_map.erase(frame_to_page_map[frame_id]);
+            ++stats.evictions;
+        }
+        cache_replacer.access(frame_id);
+        page_to_frame_map[pageid] = frame_id;
+        frame_to_page_map[frame_id] = pageid;
+    }
+    return stats;
+}
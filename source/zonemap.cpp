@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <pinedb/page.h>
+#include <pinedb/zonemap.h>
+#include <stdexcept>
+
+using namespace pinedb;
+
+namespace
+{
+    const size_t NEXT_PAGE_ID_OFFSET = 16;
+
+    // Widens the summary at `summary` (minimum followed by maximum) with the value at `field`
+    template <typename T> void widen(uint8_t *summary, const uint8_t *field, bool first)
+    {
+        using namespace datapacker;
+        T value, min, max;
+        bytes::decode<endian::little>(const_cast<uint8_t *>(field), value);
+        bytes::decode<endian::little>(summary, min);
+        bytes::decode<endian::little>(summary + ZoneMap::VALUE_SIZE, max);
+        if (first || value < min)
+            bytes::encode<endian::little>(summary, value);
+        if (first || max < value)
+            bytes::encode<endian::little>(summary + ZoneMap::VALUE_SIZE, value);
+    }
+} // namespace
+
+ZoneMap::ZoneMap(BufferPool &pool, const RecordLayout &layout, page_id_type first_page_id)
+    : pool(pool), layout(layout), first_page_id(first_page_id), number_of_entries(0)
+{
+    int summaries = 0;
+    for (int i = 0; i < layout.number_of_columns(); ++i)
+        summary_index.push_back(layout.field(i).is_variable_length ? -1 : summaries++);
+    entry_size = ROWS_SIZE + summaries * 2 * VALUE_SIZE;
+    entries_per_page = (pool.page_size() - HEADER_SIZE) / entry_size;
+    if (pool.page_size() <= HEADER_SIZE || entries_per_page == 0)
+    {
+        throw std::runtime_error("page size is too small for the zone map of the table");
+    }
+
+    page_id_type page_id = first_page_id;
+    while (page_id != 0)
+    {
+        auto page = fetch(page_id);
+        map_pages.push_back(page_id);
+        entries.insert(entries.end(), page + HEADER_SIZE,
+                       page + HEADER_SIZE + entries_per_page * entry_size);
+        datapacker::bytes::decode_le(page + NEXT_PAGE_ID_OFFSET, page_id);
+    }
+    // Entries after the last one with rows are not used
+    number_of_entries = entries.size() / entry_size;
+    while (number_of_entries > 0 && number_of_rows(number_of_entries - 1) == 0)
+        --number_of_entries;
+}
+
+uint8_t *ZoneMap::fetch(page_id_type page_id)
+{
+    auto page = pool.fetch_page(page_id);
+    if (page == nullptr)
+    {
+        throw std::runtime_error("could not read zone map page " + std::to_string(page_id));
+    }
+    return page;
+}
+
+void ZoneMap::add_page()
+{
+    auto page_id = pool.new_page();
+    if (page_id == -1)
+    {
+        throw std::runtime_error("could not create a zone map page");
+    }
+    PageHeader header;
+    header.set_page_type(PAGE_TYPE);
+    header.set_page_id(page_id);
+    header.write(fetch(page_id));
+    pool.set_dirty(page_id);
+
+    if (map_pages.empty())
+    {
+        first_page_id = page_id;
+    }
+    else
+    {
+        datapacker::bytes::encode_le(fetch(map_pages.back()) + NEXT_PAGE_ID_OFFSET, page_id);
+        pool.set_dirty(map_pages.back());
+    }
+    map_pages.push_back(page_id);
+    entries.resize(map_pages.size() * entries_per_page * entry_size, 0);
+}
+
+void ZoneMap::write_entry(size_t position)
+{
+    auto page_id = map_pages[position / entries_per_page];
+    auto page = fetch(page_id);
+    memcpy(page + HEADER_SIZE + (position % entries_per_page) * entry_size,
+           entries.data() + position * entry_size, entry_size);
+    pool.set_dirty(page_id);
+}
+
+uint32_t ZoneMap::number_of_rows(size_t position) const
+{
+    if ((position + 1) * entry_size > entries.size())
+        return 0;
+    uint32_t rows = 0;
+    datapacker::bytes::decode_le(const_cast<uint8_t *>(entries.data()) + position * entry_size,
+                                 rows);
+    return rows;
+}
+
+void ZoneMap::add(size_t position, const uint8_t *record)
+{
+    while (map_pages.size() * entries_per_page <= position)
+        add_page();
+    number_of_entries = std::max(number_of_entries, position + 1);
+
+    auto rows = number_of_rows(position);
+    bool first = rows == 0;
+    datapacker::bytes::encode_le(entries.data() + position * entry_size, rows + 1);
+    for (int i = 0; i < layout.number_of_columns(); ++i)
+    {
+        const auto &f = layout.field(i);
+        if (f.is_variable_length)
+            continue;
+        auto summary = entries.data() + summary_offset(position, i);
+        auto field = record + f.offset;
+        switch (f.format)
+        {
+        case 'b':
+            widen<uint8_t>(summary, field, first);
+            break;
+        case 'B':
+            widen<int8_t>(summary, field, first);
+            break;
+        case 's':
+            widen<uint16_t>(summary, field, first);
+            break;
+        case 'S':
+            widen<int16_t>(summary, field, first);
+            break;
+        case 'i':
+            widen<uint32_t>(summary, field, first);
+            break;
+        case 'I':
+            widen<int32_t>(summary, field, first);
+            break;
+        case 'l':
+            widen<uint64_t>(summary, field, first);
+            break;
+        case 'L':
+            widen<int64_t>(summary, field, first);
+            break;
+        case 'f':
+            widen<float>(summary, field, first);
+            break;
+        case 'd':
+            widen<double>(summary, field, first);
+            break;
+        }
+    }
+    write_entry(position);
+}
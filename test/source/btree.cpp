@@ -1,10 +1,674 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <doctest/doctest.h>
+#include <map>
+#include <numeric>
 #include <pinedb/btree.h>
 #include <pinedb/bufferpool.h>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
 using namespace pinedb;
 
+namespace
+{
+    // Checks that the tree has the same keys and values as `expected`, by searching for every key
+    // and by iterating over the leaves in both directions
+    template <typename Key>
+    void check_tree(BTree<Key> &tree, const std::map<Key, uint64_t> &expected)
+    {
+        for (const auto &[key, value] : expected)
+        {
+            uint64_t found = 0;
+            REQUIRE(tree.search(key, found));
+            CHECK(found == value);
+        }
+        auto iter = tree.begin();
+        auto expected_iter = expected.begin();
+        Key key;
+        uint64_t value;
+        while (iter.next(key, value))
+        {
+            REQUIRE(expected_iter != expected.end());
+            CHECK(key == expected_iter->first);
+            CHECK(value == expected_iter->second);
+            ++expected_iter;
+        }
+        CHECK(expected_iter == expected.end());
+
+        auto reverse_iter = tree.end();
+        for (auto iter = expected.rbegin(); iter != expected.rend(); ++iter)
+        {
+            REQUIRE(reverse_iter.prev(key, value));
+            CHECK(key == iter->first);
+            CHECK(value == iter->second);
+        }
+        CHECK(!reverse_iter.prev(key, value));
+    }
+
+    // Checks that the root of the tree is a leaf or an internal node with at least one key
+    template <typename Key> void check_root(BufferPool &pool, BTree<Key> &tree)
+    {
+        BTreeNode<Key> root(pool.fetch_page(tree.get_root_page_id()));
+        CHECK((root.is_leaf() || root.size() > 0));
+    }
+
+    // Counts the pages which are read by another thread than the one which created the backend
+    class CountingStorageBackend : public MemoryStorageBackend
+    {
+        std::thread::id owner = std::this_thread::get_id();
+
+      public:
+        std::atomic<int> reads{0};
+        std::atomic<int> background_reads{0};
+
+        using MemoryStorageBackend::MemoryStorageBackend;
+
+        bool read_page(page_id_type page_id, uint8_t *buffer) override
+        {
+            ++reads;
+            if (std::this_thread::get_id() != owner)
+                ++background_reads;
+            return MemoryStorageBackend::read_page(page_id, buffer);
+        }
+    };
+
+    // Inserts and removes random keys, comparing the tree with a std::map after every round
+    template <typename Key> void random_operations(uint32_t max_keys, int64_t low, int64_t high)
+    {
+        MemoryStorageBackend storage(4096);
+        LRUCacheReplacer<frame_id_type> cache_replacer(3);
+        BufferPool pool(3, storage, cache_replacer);
+        BTree<Key> tree(pool, BTree<Key>::create(pool, max_keys));
+        std::map<Key, uint64_t> expected;
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int64_t> distribution(low, high);
+
+        for (int round = 0; round < 4; ++round)
+        {
+            for (int i = 0; i < 300; ++i)
+            {
+                auto key = static_cast<Key>(distribution(rng));
+                auto value = static_cast<uint64_t>(rng());
+                bool inserted = expected.emplace(key, value).second;
+                CHECK(tree.insert(key, value) == inserted);
+            }
+            check_tree(tree, expected);
+            for (int i = 0; i < 200; ++i)
+            {
+                auto key = static_cast<Key>(distribution(rng));
+                bool removed = expected.erase(key) == 1;
+                CHECK(tree.remove(key) == removed);
+            }
+            check_tree(tree, expected);
+        }
+
+        // Reopening the tree finds the same node sizes
+        BTree<Key> reopened(pool, tree.get_root_page_id());
+        check_tree(reopened, expected);
+        for (const auto &entry : std::map<Key, uint64_t>(expected))
+        {
+            CHECK(reopened.remove(entry.first));
+            expected.erase(entry.first);
+        }
+        check_tree(reopened, expected);
+        CHECK(reopened.height() == 1);
+    }
+} // namespace
+
 TEST_SUITE("btree")
 {
-    TEST_CASE("BTree insertion only into root node") {}
-}
\ No newline at end of file
+    TEST_CASE("BTree insertion only into root node")
+    {
+        MemoryStorageBackend storage(128);
+        LRUCacheReplacer<frame_id_type> cache_replacer(2);
+        BufferPool pool(2, storage, cache_replacer);
+        auto root_page_id = BTree<int32_t>::create(pool);
+        BTree<int32_t> tree(pool, root_page_id);
+        CHECK(tree.height() == 1);
+
+        uint64_t value = 0;
+        CHECK(!tree.search(5, value));
+        CHECK(tree.insert(5, 50));
+        CHECK(tree.insert(-3, 30));
+        CHECK(tree.insert(9, 90));
+        CHECK(!tree.insert(5, 55));
+        CHECK(tree.search(5, value));
+        CHECK(value == 50);
+        CHECK(tree.update(5, 55));
+        CHECK(!tree.update(6, 60));
+        CHECK(tree.search(5, value));
+        CHECK(value == 55);
+        CHECK(tree.height() == 1);
+
+        auto iter = tree.lower_bound(0);
+        int32_t key;
+        CHECK(iter.next(key, value));
+        CHECK(key == 5);
+        CHECK(iter.next(key, value));
+        CHECK(key == 9);
+        CHECK(!iter.next(key, value));
+
+        CHECK(tree.remove(-3));
+        CHECK(!tree.remove(-3));
+        CHECK(!tree.search(-3, value));
+    }
+
+    TEST_CASE("BTree splits and merges nodes")
+    {
+        MemoryStorageBackend storage(4096);
+        LRUCacheReplacer<frame_id_type> cache_replacer(2);
+        BufferPool pool(2, storage, cache_replacer);
+        BTree<uint32_t> tree(pool, BTree<uint32_t>::create(pool, 4));
+        std::map<uint32_t, uint64_t> expected;
+        for (uint32_t i = 0; i < 100; ++i)
+        {
+            CHECK(tree.insert(i * 2, i));
+            expected[i * 2] = i;
+        }
+        CHECK(tree.height() > 2);
+        check_tree(tree, expected);
+
+        // Keys between the existing keys go into the middle of the nodes
+        for (uint32_t i = 0; i < 100; ++i)
+        {
+            CHECK(tree.insert(i * 2 + 1, i));
+            expected[i * 2 + 1] = i;
+        }
+        check_tree(tree, expected);
+
+        for (uint32_t i = 0; i < 200; i += 3)
+        {
+            CHECK(tree.remove(i));
+            expected.erase(i);
+        }
+        check_tree(tree, expected);
+
+        auto iter = tree.lower_bound(100);
+        uint32_t key;
+        uint64_t value;
+        CHECK(iter.next(key, value));
+        CHECK(key == 100);
+        CHECK(iter.next(key, value));
+        CHECK(key == 101);
+        CHECK(iter.next(key, value));
+        CHECK(key == 103);
+    }
+
+    TEST_CASE("BTree with every key type")
+    {
+        random_operations<uint8_t>(3, 0, 255);
+        random_operations<int8_t>(4, -128, 127);
+        random_operations<uint16_t>(5, 0, 2000);
+        random_operations<int16_t>(3, -1000, 1000);
+        random_operations<uint32_t>(4, 0, 3000);
+        random_operations<int32_t>(7, -1500, 1500);
+        random_operations<uint64_t>(3, 0, 5000);
+        random_operations<int64_t>(6, -2500, 2500);
+        random_operations<float>(4, -1000, 1000);
+        random_operations<double>(0, -1000, 1000);
+    }
+
+    TEST_CASE("BTree bulk load from sorted entries")
+    {
+        for (auto fill_factor : {1.0, 0.9, 0.5, 0.01})
+        {
+            for (int64_t n : {0, 1, 4, 5, 6, 7, 50, 51, 310, 1000, 3001})
+            {
+                MemoryStorageBackend storage(4096);
+                LRUCacheReplacer<frame_id_type> cache_replacer(3);
+                BufferPool pool(3, storage, cache_replacer);
+                std::map<int64_t, uint64_t> expected;
+                int64_t next_key = 0;
+                auto root_page_id = BTree<int64_t>::bulk_load(
+                    pool,
+                    [&](int64_t &key, uint64_t &value)
+                    {
+                        if (next_key == n)
+                            return false;
+                        key = next_key * 3 - 1000;
+                        value = static_cast<uint64_t>(next_key++);
+                        expected[key] = value;
+                        return true;
+                    },
+                    fill_factor, 6);
+                BTree<int64_t> tree(pool, root_page_id);
+                check_tree(tree, expected);
+                // The last leaf may be merged into the previous one, which is then the root
+                if (n <= 5)
+                    CHECK(tree.height() == 1);
+                check_root(pool, tree);
+
+                // The tree can be modified after it is built
+                for (int64_t key = -1100; key < 10000; key += 7)
+                {
+                    bool inserted = expected.emplace(key, 1).second;
+                    CHECK(tree.insert(key, 1) == inserted);
+                }
+                for (int64_t key = -1100; key < 10000; key += 5)
+                {
+                    bool removed = expected.erase(key) == 1;
+                    CHECK(tree.remove(key) == removed);
+                }
+                check_tree(tree, expected);
+            }
+        }
+    }
+
+    TEST_CASE("BTree bulk load fills the leaves")
+    {
+        MemoryStorageBackend storage(4096);
+        LRUCacheReplacer<frame_id_type> cache_replacer(4);
+        BufferPool pool(4, storage, cache_replacer);
+        uint32_t n = 0;
+        auto next = [&](uint32_t &key, uint64_t &value)
+        {
+            if (n == 10000)
+                return false;
+            key = n;
+            value = n++;
+            return true;
+        };
+        BTree<uint32_t> full(pool, BTree<uint32_t>::bulk_load(pool, next, 1.0, 10));
+        // 1000 full leaves, then 91, 9 and 1 internal nodes with 11 children
+        CHECK(full.height() == 4);
+
+        // Keys inserted in increasing order fill the nodes nearly as much, so they are shuffled
+        std::vector<uint32_t> keys(10000);
+        std::iota(keys.begin(), keys.end(), 0);
+        std::shuffle(keys.begin(), keys.end(), std::mt19937(1));
+        BTree<uint32_t> inserted(pool, BTree<uint32_t>::create(pool, 10));
+        for (auto key : keys)
+            inserted.insert(key, key);
+        CHECK(inserted.height() > full.height());
+
+        n = 0;
+        auto root_page_id = BTree<uint32_t>::bulk_load(pool, next, 0.5, 10);
+        // 2000 leaves with 5 keys, and 334, 56 and 10 internal nodes with 6 children, the last
+        // two nodes of the next level are merged into the root
+        BTree<uint32_t> half(pool, root_page_id);
+        CHECK(half.height() == 5);
+        check_root(pool, half);
+
+        uint32_t key = 5;
+        uint64_t value;
+        auto backwards = [&](uint32_t &k, uint64_t &v)
+        {
+            if (key == 0)
+                return false;
+            k = v = --key;
+            return true;
+        };
+        // 338 keys fit in a leaf, the loader starts a second leaf after 305 keys (90%), and
+        // merges it into the first one
+        for (int32_t count : {305, 310, 338, 339})
+        {
+            int32_t k32 = 0;
+            BTree<int32_t> tree(pool, BTree<int32_t>::bulk_load(pool,
+                                                                [&](int32_t &k, uint64_t &v)
+                                                                {
+                                                                    if (k32 == count)
+                                                                        return false;
+                                                                    v = static_cast<uint64_t>(k32);
+                                                                    k = k32++;
+                                                                    return true;
+                                                                }));
+            CHECK(tree.height() == (count <= 338 ? 1 : 2));
+            check_root(pool, tree);
+            CHECK(tree.search(count - 1, value));
+        }
+
+        CHECK_THROWS_AS(BTree<uint32_t>::bulk_load(pool, backwards), std::logic_error);
+        CHECK_THROWS_AS(BTree<uint32_t>::bulk_load(pool, next, 0.0), std::logic_error);
+        CHECK(full.search(9999, value));
+    }
+
+    TEST_CASE("BTree appends increasing keys to the right-most leaf")
+    {
+        MemoryStorageBackend storage(4096);
+        LRUCacheReplacer<frame_id_type> cache_replacer(4);
+        BufferPool pool(4, storage, cache_replacer);
+        BTree<uint32_t> tree(pool, BTree<uint32_t>::create(pool, 10));
+        std::map<uint32_t, uint64_t> expected;
+        // Only the right-most leaf is read, unless it is full and the tree is descended to split it
+        int fetches = 0, descents = 0;
+        pool.set_trace_hook([&](page_id_type) { ++fetches; });
+        for (uint32_t key = 0; key < 10000; ++key)
+        {
+            fetches = 0;
+            CHECK(tree.insert(key, key));
+            expected[key] = key;
+            descents += fetches > 1;
+        }
+        pool.set_trace_hook({});
+        check_tree(tree, expected);
+
+        // The leaves and internal nodes which are split by appends keep 9 of their 10 keys, so the
+        // tree is as high as a full bulk loaded tree
+        CHECK(tree.height() == 4);
+        uint32_t leaves = 0;
+        for (page_id_type page_id = tree.get_root_page_id(); page_id != 0;)
+        {
+            BTreeNode<uint32_t> node(pool.fetch_page(page_id));
+            if (node.is_leaf())
+            {
+                ++leaves;
+                CHECK((node.size() >= 9 || node.get_next_leaf() == 0));
+            }
+            page_id = node.is_leaf() ? node.get_next_leaf() : node.child(0);
+        }
+        // 1110 leaves with 9 keys, and the last leaf with 10 keys
+        CHECK(leaves == 1111);
+        CHECK(descents == static_cast<int>(leaves) - 1);
+
+        // Merges delete the right-most leaf, which is then found again by the next insert
+        for (uint32_t key = 9999; key >= 8000; --key)
+        {
+            CHECK(tree.remove(key));
+            expected.erase(key);
+        }
+        CHECK(!tree.insert(7999, 0));
+        for (uint32_t key = 8500; key < 11000; ++key)
+        {
+            CHECK(tree.insert(key, key + 1));
+            expected[key] = key + 1;
+        }
+        CHECK(tree.insert(8200, 1));
+        expected[8200] = 1;
+        check_tree(tree, expected);
+    }
+
+    TEST_CASE("BTreeSorter sorts runs which do not fit in memory")
+    {
+        MemoryStorageBackend storage(256);
+        LRUCacheReplacer<frame_id_type> cache_replacer(4);
+        BufferPool pool(4, storage, cache_replacer);
+        std::mt19937 rng(3);
+        std::vector<std::pair<int32_t, uint64_t>> expected;
+        {
+            BTreeSorter<int32_t> sorter(pool, 100);
+            for (uint64_t i = 0; i < 2000; ++i)
+            {
+                auto key = static_cast<int32_t>(rng() % 100000) - 50000;
+                sorter.add(key, i);
+                expected.emplace_back(key, i);
+            }
+            CHECK(sorter.number_of_runs() == 20);
+            std::stable_sort(expected.begin(), expected.end(),
+                             [](const auto &a, const auto &b) { return a.first < b.first; });
+
+            int32_t key;
+            uint64_t value;
+            size_t i = 0;
+            while (sorter.next(key, value))
+            {
+                REQUIRE(i < expected.size());
+                CHECK(key == expected[i].first);
+                ++i;
+            }
+            CHECK(i == expected.size());
+            CHECK_THROWS_AS(sorter.add(1, 1), std::logic_error);
+        }
+
+        // Duplicate keys are removed before the tree is built
+        BTreeSorter<int32_t> sorter(pool, 64);
+        std::map<int32_t, uint64_t> unique;
+        for (const auto &[key, value] : expected)
+        {
+            sorter.add(key, value);
+            unique.emplace(key, value);
+        }
+        bool has_previous = false;
+        int32_t previous = 0;
+        auto root_page_id = BTree<int32_t>::bulk_load(
+            pool,
+            [&](int32_t &key, uint64_t &value)
+            {
+                while (sorter.next(key, value))
+                {
+                    if (!has_previous || previous != key)
+                    {
+                        has_previous = true;
+                        previous = key;
+                        return true;
+                    }
+                }
+                return false;
+            });
+        BTree<int32_t> tree(pool, root_page_id);
+        int32_t key;
+        uint64_t value;
+        auto iter = tree.begin();
+        for (const auto &entry : unique)
+        {
+            REQUIRE(iter.next(key, value));
+            CHECK(key == entry.first);
+        }
+        CHECK(!iter.next(key, value));
+    }
+
+    TEST_CASE("BTree iterators move in both directions and prefetch leaves")
+    {
+        CountingStorageBackend storage(4096);
+        LRUCacheReplacer<frame_id_type> cache_replacer(16);
+        BufferPool pool(16, storage, cache_replacer);
+        int32_t next_key = 0;
+        auto root_page_id = BTree<int32_t>::bulk_load(pool,
+                                                      [&](int32_t &key, uint64_t &value)
+                                                      {
+                                                          if (next_key == 4000)
+                                                              return false;
+                                                          key = next_key * 2;
+                                                          value = static_cast<uint64_t>(key);
+                                                          ++next_key;
+                                                          return true;
+                                                      },
+                                                      1.0, 8);
+        pool.flush_all();
+        BTree<int32_t> tree(pool, root_page_id);
+        REQUIRE(tree.height() == 4);
+        int32_t key;
+        uint64_t value;
+
+        // Prefetching a page which does not exist frees its frame
+        CHECK(pool.prefetch_page(100000));
+        CHECK(pool.fetch_page(100000) == nullptr);
+
+        // The pool holds 16 of the 500 leaves, most of them are read by the prefetch thread
+        for (bool forward : {true, false})
+        {
+            storage.reads = 0;
+            storage.background_reads = 0;
+            auto iter = forward ? tree.begin() : tree.end();
+            int32_t expected = forward ? 0 : 7998;
+            while (forward ? iter.next(key, value) : iter.prev(key, value))
+            {
+                REQUIRE(key == expected);
+                expected += forward ? 2 : -2;
+            }
+            CHECK(expected == (forward ? 8000 : -2));
+            CHECK(storage.reads >= 500);
+            CHECK(storage.background_reads > storage.reads / 2);
+        }
+
+        // Without prefetching every page is read when it is fetched
+        storage.background_reads = 0;
+        auto unprefetched = tree.begin(0);
+        while (unprefetched.next(key, value))
+            ;
+        CHECK(storage.background_reads == 0);
+
+        // The direction can change in the middle of a leaf and at the edges of the leaves
+        auto iter = tree.lower_bound(101);
+        REQUIRE(iter.prev(key, value));
+        CHECK(key == 100);
+        for (int32_t expected = 100; expected < 140; expected += 2)
+        {
+            REQUIRE(iter.next(key, value));
+            CHECK(key == expected);
+        }
+        for (int32_t expected = 138; expected >= 0; expected -= 2)
+        {
+            REQUIRE(iter.prev(key, value));
+            CHECK(key == expected);
+        }
+        CHECK(!iter.prev(key, value));
+        REQUIRE(iter.next(key, value));
+        CHECK(key == 0);
+        auto last = tree.lower_bound(9000);
+        CHECK(!last.next(key, value));
+        REQUIRE(last.prev(key, value));
+        CHECK(key == 7998);
+    }
+
+    TEST_CASE("BTree finds many keys with one descent")
+    {
+        CountingStorageBackend storage(4096);
+        LRUCacheReplacer<frame_id_type> cache_replacer(8);
+        BufferPool pool(8, storage, cache_replacer);
+        BTree<double> tree(pool, BTree<double>::create(pool, 6));
+        std::mt19937 rng(3);
+        for (int i = 0; i < 3000; ++i)
+            tree.insert(static_cast<double>(rng() % 6000) / 4, static_cast<uint64_t>(i));
+
+        // Keys in random order, with duplicates, keys which are not in the tree and NaN
+        std::vector<double> keys;
+        for (int i = 0; i < 2000; ++i)
+            keys.push_back(static_cast<double>(rng() % 7000) / 4 - 100);
+        keys.push_back(std::nan(""));
+        keys.push_back(keys.front());
+        std::vector<uint64_t> values;
+        std::vector<bool> found;
+        auto count = tree.multi_get(keys, values, found);
+        REQUIRE(values.size() == keys.size());
+        REQUIRE(found.size() == keys.size());
+        size_t expected_count = 0;
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            uint64_t value = 0;
+            bool expected_found = !std::isnan(keys[i]) && tree.search(keys[i], value);
+            CHECK(found[i] == expected_found);
+            CHECK(values[i] == value);
+            expected_count += expected_found;
+        }
+        CHECK(count == expected_count);
+        CHECK(!found[keys.size() - 2]);
+        CHECK(found.back() == found.front());
+
+        // Every page is read at most once, searching the keys one at a time reads the upper
+        // levels again for every key
+        pool.flush_all();
+        int reads[2];
+        for (bool batched : {true, false})
+        {
+            LRUCacheReplacer<frame_id_type> cold_replacer(64);
+            BufferPool cold(64, storage, cold_replacer);
+            BTree<double> cold_tree(cold, tree.get_root_page_id());
+            storage.reads = 0;
+            if (batched)
+            {
+                CHECK(cold_tree.multi_get(keys, values, found) == count);
+            }
+            else
+            {
+                uint64_t value;
+                for (auto key : keys)
+                    cold_tree.search(key, value);
+            }
+            reads[batched] = storage.reads;
+        }
+        CHECK(reads[1] * 2 < reads[0]);
+
+        CHECK(tree.multi_get({}, values, found) == 0);
+        CHECK(values.empty());
+    }
+
+    TEST_CASE("BTree follows swizzled children while nodes are split and merged")
+    {
+        // The pool holds the whole tree, so the children stay swizzled between operations
+        MemoryStorageBackend storage(4096);
+        LRUCacheReplacer<frame_id_type> cache_replacer(512);
+        BufferPool pool(512, storage, cache_replacer);
+        BTree<int64_t> tree(pool, BTree<int64_t>::create(pool, 4));
+        std::map<int64_t, uint64_t> expected;
+        std::mt19937 rng(11);
+        for (int round = 0; round < 6; ++round)
+        {
+            for (int i = 0; i < 2000; ++i)
+            {
+                auto key = static_cast<int64_t>(rng() % 1500);
+                uint64_t value = 0;
+                CHECK(tree.search(key, value) == (expected.find(key) != expected.end()));
+                // Most operations insert in even rounds and remove in odd rounds
+                if (rng() % 4 < (round % 2 == 0 ? 3u : 1u))
+                {
+                    value = rng();
+                    CHECK(tree.insert(key, value) == expected.emplace(key, value).second);
+                }
+                else
+                {
+                    CHECK(tree.remove(key) == (expected.erase(key) == 1));
+                }
+            }
+            check_tree(tree, expected);
+        }
+
+        // A search fetches one page per level
+        int fetches = 0;
+        pool.set_trace_hook([&](page_id_type) { ++fetches; });
+        uint64_t value;
+        tree.search(expected.begin()->first, value);
+        pool.set_trace_hook({});
+        CHECK(fetches == tree.height());
+
+        // Searches from many threads follow the swizzled children without the pool mutex
+        std::vector<std::pair<int64_t, uint64_t>> entries(expected.begin(), expected.end());
+        std::atomic<int> mismatches{0};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back(
+                [&, t]()
+                {
+                    BTree<int64_t> reader(pool, tree.get_root_page_id());
+                    for (int pass = 0; pass < 20; ++pass)
+                    {
+                        for (size_t i = t; i < entries.size(); i += 4)
+                        {
+                            uint64_t found = 0;
+                            if (!reader.search(entries[i].first, found)
+                                || found != entries[i].second)
+                                ++mismatches;
+                        }
+                    }
+                });
+        }
+        for (auto &thread : threads)
+            thread.join();
+        CHECK(mismatches == 0);
+    }
+
+    TEST_CASE("BTree rejects invalid trees and keys")
+    {
+        MemoryStorageBackend storage(128);
+        LRUCacheReplacer<frame_id_type> cache_replacer(2);
+        BufferPool pool(2, storage, cache_replacer);
+        CHECK_THROWS_AS(BTree<int32_t>::create(pool, 2), std::logic_error);
+        CHECK_THROWS_AS(BTree<int32_t>::create(pool, 100), std::logic_error);
+
+        auto root_page_id = BTree<int32_t>::create(pool, 3);
+        CHECK_THROWS_AS(BTree<int64_t>(pool, root_page_id), std::runtime_error);
+        CHECK_THROWS_AS(BTree<uint32_t>(pool, root_page_id), std::runtime_error);
+        BTree<int32_t> tree(pool, root_page_id);
+
+        auto other_page_id = pool.new_page();
+        CHECK_THROWS_AS(BTree<int32_t>(pool, other_page_id), std::runtime_error);
+
+        BTree<double> doubles(pool, BTree<double>::create(pool));
+        CHECK_THROWS_AS(doubles.insert(std::nan(""), 1), std::logic_error);
+        CHECK(doubles.insert(-0.5, 1));
+    }
+}
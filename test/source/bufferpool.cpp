@@ -245,4 +245,58 @@ TEST_SUITE("bufferpool")
         CHECK(storage.read_page(page6, buffer.data()));
         CHECK(buffer[0] == '6');
     }
+
+    TEST_CASE("BufferPool swizzles child references")
+    {
+        MemoryStorageBackend storage(4096);
+        LRUCacheReplacer<frame_id_type> cache_replacer(3);
+        BufferPool pool(3, storage, cache_replacer);
+        std::vector<page_id_type> pages;
+        for (int i = 0; i < 6; ++i)
+        {
+            pages.push_back(pool.new_page());
+            pool.fetch_page(pages.back())[0] = static_cast<uint8_t>('a' + i);
+            pool.set_dirty(pages.back());
+        }
+        auto parent = pages[0], child = pages[1], other = pages[2];
+
+        auto page = pool.fetch_page(parent);
+        auto child_page = pool.fetch_child(page, 0, child);
+        REQUIRE(child_page != nullptr);
+        CHECK(child_page[0] == 'b');
+        CHECK(pool.fetch_child(page, 0, child) == child_page);
+
+        // The slot is cleared when the parent is marked dirty, as it may reference another child
+        pool.set_dirty(parent);
+        CHECK(pool.fetch_child(page, 0, other)[0] == 'c');
+        page = pool.fetch_page(parent);
+        CHECK(pool.fetch_child(page, 0, other)[0] == 'c');
+
+        // A deleted child is unswizzled
+        pool.set_dirty(parent);
+        CHECK(pool.fetch_child(page, 1, child)[0] == 'b');
+        CHECK(pool.delete_page(child));
+        CHECK(pool.fetch_child(page, 1, child) == nullptr);
+
+        // The pool holds the parent, `other` which is swizzled, and `pages[3]`. `other` is the
+        // least recently used in the replacer, it is unswizzled instead of being evicted, and the
+        // parent is evicted
+        page = pool.fetch_page(parent);
+        pool.fetch_child(page, 0, other);
+        pool.fetch_page(parent);
+        pool.fetch_page(pages[3]);
+        CHECK(pool.fetch_page(pages[4])[0] == 'e');
+        CHECK(pool.resident_page(parent) == nullptr);
+        CHECK(pool.resident_page(other) != nullptr);
+        // It is evicted when it is chosen again, as it was not fetched since
+        pool.fetch_page(pages[5]);
+        CHECK(pool.resident_page(pages[3]) == nullptr);
+        pool.fetch_page(parent);
+        CHECK(pool.resident_page(other) == nullptr);
+
+        // The evicted parent starts with empty swizzle slots
+        page = pool.fetch_page(parent);
+        CHECK(pool.fetch_child(page, 0, other)[0] == 'c');
+        CHECK(pool.fetch_child(page, 0, other)[0] == 'c');
+    }
 }
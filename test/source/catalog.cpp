@@ -0,0 +1,92 @@
+#include <doctest/doctest.h>
+#include <pinedb/catalog.h>
+#include <pinedb/page.h>
+
+using namespace pinedb;
+
+TEST_SUITE("catalog")
+{
+    TEST_CASE("Create, alter and drop tables")
+    {
+        page_size_type page_size = 4096;
+        int number_of_frames = 4;
+        MemoryStorageBackend storage(page_size);
+        LRUCacheReplacer<frame_id_type> cache_replacer(number_of_frames);
+        BufferPool pool(number_of_frames, storage, cache_replacer);
+
+        page_id_type sys_tables_page_id;
+        {
+            Catalog catalog(pool);
+            sys_tables_page_id = catalog.get_sys_tables_page_id();
+            CHECK(catalog.number_of_tables() == 0);
+            CHECK(catalog.find("users") == nullptr);
+
+            auto &users = catalog.create_table("users", {{"id", 'I'}, {"name", 'c'}});
+            CHECK(users.name == "users");
+            CHECK(users.layout.get_format() == "Ic");
+            CHECK(users.column_names[1] == "name");
+            catalog.create_table("orders", {{"id", 'L'}, {"user_id", 'I'}, {"amount", 'd'}});
+            catalog.create_table("temp", {{"id", 'I'}});
+            catalog.create_table("events", {{"id", 'L'}, {"value", 'd'}}, TableStorage::PAX);
+            CHECK(users.storage == TableStorage::ROW);
+
+            // Column names are interned
+            CHECK(catalog.find("orders")->column_names[0].data()
+                  == catalog.find("users")->column_names[0].data());
+
+            CHECK_THROWS_AS(catalog.create_table("users", {{"id", 'I'}}), std::runtime_error);
+            CHECK_THROWS_AS(catalog.create_table("bad", {{"id", 'x'}}), std::runtime_error);
+            CHECK_THROWS_AS(catalog.create_table("", {{"id", 'I'}}), std::runtime_error);
+            CHECK_THROWS_AS(catalog.create_table(Catalog::SYS_TABLES_NAME, {}),
+                            std::runtime_error);
+            CHECK(catalog.find("bad") == nullptr);
+
+            catalog.add_column("users", "email", 'c');
+            CHECK(catalog.find("users")->layout.get_format() == "Icc");
+            catalog.rename_table("orders", "purchases");
+            CHECK(catalog.find("orders") == nullptr);
+            CHECK(catalog.find("purchases")->column_names[2] == "amount");
+            catalog.set_table_page_id("purchases", 42);
+            CHECK_THROWS_AS(catalog.add_column("purchases", "note", 'c'), std::runtime_error);
+
+            CHECK(catalog.drop_table("temp"));
+            CHECK(!catalog.drop_table("temp"));
+            CHECK(catalog.number_of_tables() == 3);
+            CHECK(catalog.list_tables()[0]->name == "users");
+            CHECK(catalog.list_tables()[1]->name == "purchases");
+        }
+
+        // The catalog is loaded again from the pages, some of which have been evicted
+        pool.flush_all();
+        Catalog catalog(pool, sys_tables_page_id);
+        REQUIRE(catalog.number_of_tables() == 3);
+        CHECK(catalog.find("events")->storage == TableStorage::PAX);
+        auto users = catalog.find("users");
+        REQUIRE(users != nullptr);
+        CHECK(users->layout.get_format() == "Icc");
+        CHECK(users->column_names.size() == 3);
+        CHECK(users->column_names[2] == "email");
+        auto purchases = catalog.find("purchases");
+        REQUIRE(purchases != nullptr);
+        CHECK(purchases->table_page_id == 42);
+        CHECK(purchases->layout.get_fixed_length() == 8 + 8 + 4);
+        CHECK(catalog.list_tables()[1] == purchases);
+
+        // Drop the first table in the chain, then add another one after the remaining table
+        CHECK(catalog.drop_table("users"));
+        catalog.create_table("users", {{"id", 'l'}});
+        Catalog reloaded(pool, sys_tables_page_id);
+        REQUIRE(reloaded.number_of_tables() == 3);
+        CHECK(reloaded.list_tables()[0]->name == "purchases");
+        CHECK(reloaded.list_tables()[2]->layout.get_format() == "l");
+        CHECK(reloaded.list_tables()[2]->storage == TableStorage::ROW);
+    }
+
+    TEST_CASE("Catalog needs pages large enough for the metadata")
+    {
+        MemoryStorageBackend storage(128);
+        LRUCacheReplacer<frame_id_type> cache_replacer(2);
+        BufferPool pool(2, storage, cache_replacer);
+        CHECK_THROWS_AS(Catalog catalog(pool), std::runtime_error);
+    }
+}
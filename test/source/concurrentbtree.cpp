@@ -0,0 +1,166 @@
+#include <atomic>
+#include <cmath>
+#include <doctest/doctest.h>
+#include <map>
+#include <pinedb/btree.h>
+#include <pinedb/bufferpool.h>
+#include <pinedb/concurrentbtree.h>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace pinedb;
+
+namespace
+{
+    // Checks the keys of the tree by iterating over its leaves with a BTree
+    template <typename Key>
+    void check_leaves(BufferPool &pool, page_id_type root_page_id,
+                      const std::map<Key, uint64_t> &expected)
+    {
+        BTree<Key> tree(pool, root_page_id);
+        auto iter = tree.begin();
+        auto expected_iter = expected.begin();
+        Key key;
+        uint64_t value;
+        while (iter.next(key, value))
+        {
+            REQUIRE(expected_iter != expected.end());
+            CHECK(key == expected_iter->first);
+            CHECK(value == expected_iter->second);
+            ++expected_iter;
+        }
+        CHECK(expected_iter == expected.end());
+    }
+} // namespace
+
+TEST_SUITE("concurrentbtree")
+{
+    TEST_CASE("ConcurrentBTree operations from one thread")
+    {
+        MemoryStorageBackend storage(4096);
+        LRUCacheReplacer<frame_id_type> cache_replacer(4);
+        BufferPool pool(4, storage, cache_replacer);
+        auto root_page_id = BTree<int32_t>::create(pool, 4);
+        ConcurrentBTree<int32_t> tree(pool, root_page_id);
+        std::map<int32_t, uint64_t> expected;
+        std::mt19937 rng(1);
+        for (int i = 0; i < 3000; ++i)
+        {
+            auto key = static_cast<int32_t>(rng() % 2000) - 1000;
+            auto value = static_cast<uint64_t>(rng());
+            switch (rng() % 4)
+            {
+            case 0:
+            case 1: {
+                bool inserted = expected.emplace(key, value).second;
+                CHECK(tree.insert(key, value) == inserted);
+                break;
+            }
+            case 2: {
+                bool found = expected.find(key) != expected.end();
+                if (found)
+                    expected[key] = value;
+                CHECK(tree.update(key, value) == found);
+                break;
+            }
+            default:
+                CHECK(tree.remove(key) == (expected.erase(key) == 1));
+            }
+        }
+        for (int32_t key = -1000; key < 1000; ++key)
+        {
+            uint64_t value = 0;
+            auto iter = expected.find(key);
+            REQUIRE(tree.search(key, value) == (iter != expected.end()));
+            if (iter != expected.end())
+                CHECK(value == iter->second);
+        }
+        CHECK(tree.height() > 3);
+        check_leaves(pool, root_page_id, expected);
+
+        BTree<double> doubles(pool, BTree<double>::create(pool));
+        ConcurrentBTree<double> concurrent_doubles(pool, doubles.get_root_page_id());
+        CHECK_THROWS_AS(concurrent_doubles.insert(std::nan(""), 1), std::logic_error);
+        CHECK_THROWS_AS(ConcurrentBTree<float>(pool, root_page_id), std::runtime_error);
+    }
+
+    TEST_CASE("ConcurrentBTree with concurrent readers and writers")
+    {
+        // The pool is smaller than the tree, so frames are evicted while they are read
+        MemoryStorageBackend storage(512);
+        LRUCacheReplacer<frame_id_type> cache_replacer(24);
+        BufferPool pool(24, storage, cache_replacer);
+        auto root_page_id = BTree<uint64_t>::create(pool, 6);
+        ConcurrentBTree<uint64_t> tree(pool, root_page_id);
+        constexpr int writers = 4;
+        constexpr uint64_t keys_per_writer = 3000;
+
+        // The even keys are inserted before the threads start, and are never removed
+        for (uint64_t key = 0; key < writers * keys_per_writer; key += 2)
+            CHECK(tree.insert(key, key * 10));
+
+        std::atomic<bool> done(false);
+        std::atomic<uint64_t> errors(0);
+        std::vector<std::thread> threads;
+        for (int w = 0; w < writers; ++w)
+        {
+            // Each writer inserts the odd keys of its range, then removes a third of them
+            threads.emplace_back(
+                [&, w]()
+                {
+                    auto first = static_cast<uint64_t>(w) * keys_per_writer;
+                    for (auto key = first + 1; key < first + keys_per_writer; key += 2)
+                    {
+                        if (!tree.insert(key, key * 10))
+                            ++errors;
+                    }
+                    for (auto key = first + 1; key < first + keys_per_writer; key += 6)
+                    {
+                        if (!tree.remove(key) || !tree.update(key + 2, key + 2))
+                            ++errors;
+                    }
+                });
+        }
+        for (int r = 0; r < 2; ++r)
+        {
+            threads.emplace_back(
+                [&, r]()
+                {
+                    std::mt19937_64 rng(static_cast<uint64_t>(r));
+                    while (!done)
+                    {
+                        auto key = (rng() % (writers * keys_per_writer)) & ~1ULL;
+                        uint64_t value = 0;
+                        if (!tree.search(key, value) || value != key * 10)
+                            ++errors;
+                    }
+                });
+        }
+        for (int w = 0; w < writers; ++w)
+            threads[w].join();
+        done = true;
+        for (size_t i = writers; i < threads.size(); ++i)
+            threads[i].join();
+        CHECK(errors == 0);
+
+        std::map<uint64_t, uint64_t> expected;
+        for (uint64_t key = 0; key < writers * keys_per_writer; ++key)
+        {
+            auto offset = key % keys_per_writer;
+            if (key % 2 == 0)
+                expected[key] = key * 10;
+            else if (offset % 6 == 1)
+                continue;
+            else
+                expected[key] = offset % 6 == 3 ? key : key * 10;
+        }
+        for (const auto &[key, value] : expected)
+        {
+            uint64_t found = 0;
+            REQUIRE(tree.search(key, found));
+            CHECK(found == value);
+        }
+        check_leaves(pool, root_page_id, expected);
+    }
+}
@@ -0,0 +1,615 @@
+#include <algorithm>
+#include <cmath>
+#include <doctest/doctest.h>
+#include <limits>
+#include <pinedb/datapacker.h>
+#include <random>
+#include <sstream>
+#include <string.h>
+#include <vector>
+
+using namespace datapacker;
+
+TEST_SUITE("datapacker")
+{
+    TEST_CASE("Little endian encoding of all integer widths")
+    {
+        uint8_t buffer[8] = {0};
+        CHECK(bytes::encode_le(buffer, static_cast<uint8_t>(0xAB)) == 1);
+        CHECK(buffer[0] == 0xAB);
+
+        CHECK(bytes::encode_le(buffer, static_cast<uint16_t>(0x1234)) == 2);
+        CHECK(buffer[0] == 0x34);
+        CHECK(buffer[1] == 0x12);
+
+        CHECK(bytes::encode_le(buffer, static_cast<uint32_t>(0x12345678)) == 4);
+        CHECK(buffer[0] == 0x78);
+        CHECK(buffer[1] == 0x56);
+        CHECK(buffer[2] == 0x34);
+        CHECK(buffer[3] == 0x12);
+
+        CHECK(bytes::encode_le(buffer, static_cast<uint64_t>(0x0102030405060708)) == 8);
+        for (int i = 0; i < 8; ++i)
+            CHECK(buffer[i] == 8 - i);
+
+        uint64_t u64 = 0;
+        CHECK(bytes::decode_le(buffer, u64) == 8);
+        CHECK(u64 == 0x0102030405060708);
+
+        CHECK(bytes::encode_le(buffer, static_cast<int16_t>(-2)) == 2);
+        CHECK(buffer[0] == 0xFE);
+        CHECK(buffer[1] == 0xFF);
+        int16_t i16 = 0;
+        CHECK(bytes::decode_le(buffer, i16) == 2);
+        CHECK(i16 == -2);
+    }
+
+    TEST_CASE("Big endian encoding of all integer widths")
+    {
+        uint8_t buffer[8] = {0};
+        CHECK(bytes::encode_be(buffer, static_cast<uint16_t>(0x1234)) == 2);
+        CHECK(buffer[0] == 0x12);
+        CHECK(buffer[1] == 0x34);
+
+        CHECK(bytes::encode_be(buffer, static_cast<int32_t>(0x12345678)) == 4);
+        CHECK(buffer[0] == 0x12);
+        CHECK(buffer[1] == 0x34);
+        CHECK(buffer[2] == 0x56);
+        CHECK(buffer[3] == 0x78);
+
+        CHECK(bytes::encode_be(buffer, static_cast<uint64_t>(0x0102030405060708)) == 8);
+        for (int i = 0; i < 8; ++i)
+            CHECK(buffer[i] == i + 1);
+
+        int64_t i64 = 0;
+        CHECK(bytes::encode_be(buffer, std::numeric_limits<int64_t>::min()) == 8);
+        CHECK(buffer[0] == 0x80);
+        CHECK(bytes::decode_be(buffer, i64) == 8);
+        CHECK(i64 == std::numeric_limits<int64_t>::min());
+
+        int8_t i8 = 0;
+        CHECK(bytes::encode_be(buffer, static_cast<int8_t>(-5)) == 1);
+        CHECK(bytes::decode_be(buffer, i8) == 1);
+        CHECK(i8 == -5);
+    }
+
+    TEST_CASE("Variadic encode and decode")
+    {
+        uint8_t buffer[32] = {0};
+        uint8_t a = 7;
+        int16_t b = -300;
+        uint32_t c = 0xDEADBEEF;
+        int64_t d = -1234567890123;
+        CHECK(bytes::encode_le(buffer, a, b, c, d) == 15);
+        CHECK(buffer[0] == 7);
+        CHECK(buffer[3] == 0xEF);
+
+        uint8_t a2;
+        int16_t b2;
+        uint32_t c2;
+        int64_t d2;
+        CHECK(bytes::decode_le(buffer, a2, b2, c2, d2) == 15);
+        CHECK(a2 == a);
+        CHECK(b2 == b);
+        CHECK(c2 == c);
+        CHECK(d2 == d);
+
+        CHECK(bytes::encode_be(buffer, d, c, b, a) == 15);
+        CHECK(buffer[8] == 0xDE);
+        CHECK(bytes::decode_be(buffer, d2, c2, b2, a2) == 15);
+        CHECK(a2 == a);
+        CHECK(b2 == b);
+        CHECK(c2 == c);
+        CHECK(d2 == d);
+
+        CHECK(bytes::encode<endian::big>(buffer, c, a) == 5);
+        CHECK(buffer[0] == 0xDE);
+        CHECK(buffer[4] == 7);
+        CHECK(bytes::decode<endian::big>(buffer, c2, a2) == 5);
+        CHECK(c2 == c);
+        CHECK(a2 == a);
+    }
+
+    TEST_CASE("Float and double encoding layout")
+    {
+        uint8_t buffer[8] = {0};
+        CHECK(bytes::encode_float(buffer, 1.0f) == 4);
+        CHECK(buffer[0] == 0x00);
+        CHECK(buffer[1] == 0x00);
+        CHECK(buffer[2] == 0x80);
+        CHECK(buffer[3] == 0x3F);
+
+        CHECK(bytes::encode_double(buffer, -2.0) == 8);
+        CHECK(buffer[7] == 0xC0);
+        for (int i = 0; i < 7; ++i)
+            CHECK(buffer[i] == 0);
+    }
+
+    TEST_CASE("Float and double special values round trip")
+    {
+        // The bits of the decoded value should be identical to the bits of the encoded value
+        auto float_round_trip = [](float value)
+        {
+            uint8_t buffer[4];
+            float decoded = 0;
+            bytes::encode_float(buffer, value);
+            bytes::decode_float(buffer, decoded);
+            return memcmp(&value, &decoded, sizeof(float)) == 0;
+        };
+        auto double_round_trip = [](double value)
+        {
+            uint8_t buffer[8];
+            double decoded = 0;
+            bytes::encode_double(buffer, value);
+            bytes::decode_double(buffer, decoded);
+            return memcmp(&value, &decoded, sizeof(double)) == 0;
+        };
+
+        using flim = std::numeric_limits<float>;
+        for (auto value : {0.0f, -0.0f, 1.0f, -1.0f, flim::min(), flim::max(), flim::lowest(),
+                           flim::epsilon(), flim::denorm_min(), -flim::denorm_min(),
+                           flim::infinity(), -flim::infinity(), flim::quiet_NaN(),
+                           -flim::quiet_NaN(), flim::signaling_NaN(), 3.14159265f, 1e-40f})
+        {
+            CHECK(float_round_trip(value));
+        }
+
+        using dlim = std::numeric_limits<double>;
+        for (auto value : {0.0, -0.0, 1.0, -1.0, dlim::min(), dlim::max(), dlim::lowest(),
+                           dlim::epsilon(), dlim::denorm_min(), -dlim::denorm_min(),
+                           dlim::infinity(), -dlim::infinity(), dlim::quiet_NaN(),
+                           -dlim::quiet_NaN(), dlim::signaling_NaN(), 2.718281828459045, 1e-310})
+        {
+            CHECK(double_round_trip(value));
+        }
+
+        // Sweep over the bit patterns of floats, this covers every exponent, both signs,
+        // subnormals, infinities and NaN payloads
+        bool all_floats_ok = true;
+        for (uint64_t bits = 0; bits <= 0xFFFFFFFF; bits += 65521)
+        {
+            float value;
+            uint32_t b = static_cast<uint32_t>(bits);
+            memcpy(&value, &b, sizeof(float));
+            all_floats_ok = all_floats_ok && float_round_trip(value);
+        }
+        CHECK(all_floats_ok);
+
+        bool all_doubles_ok = true;
+        for (uint64_t i = 0; i < (1 << 16); ++i)
+        {
+            double value;
+            uint64_t b = i * 0x0001000100010001ULL ^ (i << 48);
+            memcpy(&value, &b, sizeof(double));
+            all_doubles_ok = all_doubles_ok && double_round_trip(value);
+        }
+        CHECK(all_doubles_ok);
+
+        uint8_t buffer[8];
+        float f = 0;
+        bytes::encode<endian::little>(buffer, flim::infinity());
+        bytes::decode<endian::little>(buffer, f);
+        CHECK(std::isinf(f));
+        double d = 0;
+        bytes::encode<endian::big>(buffer, dlim::quiet_NaN());
+        bytes::decode<endian::big>(buffer, d);
+        CHECK(std::isnan(d));
+    }
+
+    TEST_CASE("Bulk array encoding matches element by element encoding")
+    {
+        auto check_type = [](auto sample)
+        {
+            using T = decltype(sample);
+            std::vector<T> values;
+            for (int i = 0; i < 70; ++i)
+                values.push_back(static_cast<T>(sample + static_cast<T>(i * 3)));
+
+            // Every length upto 70 is tested, so that the tails of the SIMD loops are covered
+            for (size_t n = 0; n <= values.size(); ++n)
+            {
+                std::vector<uint8_t> expected(n * sizeof(T) + 1, 0xAA);
+                std::vector<uint8_t> actual(n * sizeof(T) + 1, 0xAA);
+                std::vector<T> decoded(n);
+
+                for (size_t i = 0; i < n; ++i)
+                    bytes::encode<endian::little>(expected.data() + i * sizeof(T), values[i]);
+                CHECK(bytes::encode_array<endian::little>(actual.data(), values.data(), n)
+                      == static_cast<int>(n * sizeof(T)));
+                CHECK(actual == expected);
+                CHECK(bytes::decode_array<endian::little>(actual.data(), decoded.data(), n)
+                      == static_cast<int>(n * sizeof(T)));
+                CHECK(std::equal(decoded.begin(), decoded.end(), values.begin()));
+
+                for (size_t i = 0; i < n; ++i)
+                    bytes::encode<endian::big>(expected.data() + i * sizeof(T), values[i]);
+                bytes::encode_array<endian::big>(actual.data(), values.data(), n);
+                CHECK(actual == expected);
+                bytes::decode_array<endian::big>(actual.data(), decoded.data(), n);
+                CHECK(std::equal(decoded.begin(), decoded.end(), values.begin()));
+            }
+        };
+        check_type(static_cast<int8_t>(-3));
+        check_type(static_cast<uint16_t>(0x1234));
+        check_type(static_cast<int32_t>(-123456789));
+        check_type(static_cast<uint64_t>(0x0123456789ABCDEF));
+        check_type(static_cast<int64_t>(-1));
+        check_type(1.5f);
+        check_type(-3.25);
+    }
+
+    TEST_CASE("Byte swap kernels")
+    {
+        std::vector<uint8_t> src(259);
+        for (size_t i = 0; i < src.size(); ++i)
+            src[i] = static_cast<uint8_t>(i * 7 + 1);
+
+        auto check_kernels = [&](auto size_constant)
+        {
+            constexpr size_t size = decltype(size_constant)::value;
+            size_t n = src.size() / size;
+            std::vector<uint8_t> expected(n * size);
+            for (size_t i = 0; i < n * size; ++i)
+                expected[i] = src[(i / size) * size + (size - 1 - i % size)];
+
+            std::vector<uint8_t> dst(n * size);
+            internal::byteswap_copy_scalar<size>(dst.data(), src.data(), n);
+            CHECK(dst == expected);
+            std::fill(dst.begin(), dst.end(), 0);
+            internal::byteswap_copy<size>(dst.data(), src.data(), n);
+            CHECK(dst == expected);
+#if defined(DATAPACKER_X86_SIMD)
+            if (__builtin_cpu_supports("ssse3"))
+            {
+                std::fill(dst.begin(), dst.end(), 0);
+                internal::byteswap_copy_ssse3<size>(dst.data(), src.data(), n);
+                CHECK(dst == expected);
+            }
+            if (__builtin_cpu_supports("avx2"))
+            {
+                std::fill(dst.begin(), dst.end(), 0);
+                internal::byteswap_copy_avx2<size>(dst.data(), src.data(), n);
+                CHECK(dst == expected);
+            }
+#endif
+        };
+        check_kernels(std::integral_constant<size_t, 2>{});
+        check_kernels(std::integral_constant<size_t, 4>{});
+        check_kernels(std::integral_constant<size_t, 8>{});
+    }
+
+    TEST_CASE("Length prefixed arrays, strings and vectors")
+    {
+        uint8_t buffer[256];
+        uint32_t arr[5] = {1, 2, 3, 0xFFFFFFFF, 5};
+        uint32_t decoded[5] = {0};
+        CHECK(bytes::encode_length_prefixed<endian::big>(buffer, arr, static_cast<uint16_t>(5))
+              == 22);
+        CHECK(buffer[0] == 0);
+        CHECK(buffer[1] == 5);
+        CHECK(buffer[5] == 1);
+        CHECK(bytes::decode_length_prefixed<endian::big>(buffer, decoded,
+                                                         static_cast<uint16_t>(5))
+              == 22);
+        CHECK(std::equal(decoded, decoded + 5, arr));
+        CHECK(bytes::decode_length_prefixed<endian::big>(buffer, decoded,
+                                                         static_cast<uint16_t>(4))
+              == -1);
+
+        std::string str = "hello world";
+        std::string str2;
+        CHECK(bytes::encode_length_prefixed<endian::little>(buffer, str)
+              == static_cast<int>(sizeof(size_t) + str.size()));
+        CHECK(bytes::decode_length_prefixed<endian::little>(buffer, str2, 100)
+              == static_cast<int>(sizeof(size_t) + str.size()));
+        CHECK(str2 == str);
+
+        std::vector<double> vec = {1.0, -2.5, 1e300};
+        std::vector<double> vec2;
+        CHECK(bytes::encode_length_prefixed<endian::big>(buffer, vec)
+              == static_cast<int>(sizeof(size_t) + 3 * sizeof(double)));
+        CHECK(bytes::decode_length_prefixed<endian::big>(buffer, vec2, 10)
+              == static_cast<int>(sizeof(size_t) + 3 * sizeof(double)));
+        CHECK(vec2 == vec);
+    }
+
+    TEST_CASE("Varint and zigzag encoding")
+    {
+        uint8_t buffer[16];
+        CHECK(bytes::encode_varint(buffer, 300u) == 2);
+        CHECK(buffer[0] == 0xAC);
+        CHECK(buffer[1] == 0x02);
+        CHECK(bytes::encode_varint(buffer, static_cast<uint8_t>(0)) == 1);
+        CHECK(buffer[0] == 0);
+
+        // Zigzag: 0 -> 0, -1 -> 1, 1 -> 2, -2 -> 3
+        CHECK(bytes::encode_varint(buffer, -1) == 1);
+        CHECK(buffer[0] == 1);
+        CHECK(bytes::encode_varint(buffer, 1) == 1);
+        CHECK(buffer[0] == 2);
+        CHECK(bytes::encode_varint(buffer, -2) == 1);
+        CHECK(buffer[0] == 3);
+        CHECK(bytes::encode_varint(buffer, -64) == 1);
+        CHECK(bytes::encode_varint(buffer, 64) == 2);
+
+        CHECK(bytes::max_varint_length<uint8_t> == 2);
+        CHECK(bytes::max_varint_length<uint32_t> == 5);
+        CHECK(bytes::max_varint_length<uint64_t> == 10);
+
+        auto round_trip = [&](auto value)
+        {
+            using T = decltype(value);
+            T decoded;
+            int length = bytes::encode_varint(buffer, value);
+            CHECK(length == bytes::varint_length(value));
+            CHECK(length <= bytes::max_varint_length<T>);
+            CHECK(bytes::decode_varint(buffer, decoded) == length);
+            CHECK(decoded == value);
+        };
+        for (uint64_t value : {0ULL, 1ULL, 127ULL, 128ULL, 16383ULL, 16384ULL, 0xFFFFFFFFULL,
+                               0xFFFFFFFFFFFFFFFFULL})
+        {
+            round_trip(value);
+            round_trip(static_cast<int64_t>(value));
+            round_trip(static_cast<uint32_t>(value));
+            round_trip(static_cast<int32_t>(value));
+            round_trip(static_cast<int16_t>(value));
+            round_trip(static_cast<uint8_t>(value));
+        }
+        round_trip(std::numeric_limits<int64_t>::min());
+        round_trip(std::numeric_limits<int64_t>::max());
+        round_trip(std::numeric_limits<int8_t>::min());
+
+        SUBCASE("Malformed varints")
+        {
+            uint8_t too_long[11] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 1};
+            uint64_t u64;
+            CHECK(bytes::decode_varint(too_long, u64) == -1);
+            // Does not fit in 64 bits
+            uint8_t overflow[10] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x02};
+            CHECK(bytes::decode_varint(overflow, u64) == -1);
+            // 256 does not fit in a uint8_t
+            uint8_t u8;
+            bytes::encode_varint(buffer, 256u);
+            CHECK(bytes::decode_varint(buffer, u8) == -1);
+        }
+    }
+
+    TEST_CASE("Delta block encoding")
+    {
+        std::vector<uint64_t> sorted;
+        for (uint64_t i = 0; i < 1000; ++i)
+            sorted.push_back(1000000000000ULL + i * 3);
+        std::vector<uint8_t> buffer(sorted.size() * bytes::max_varint_length<uint64_t>);
+        int length = bytes::encode_delta_block(buffer.data(), sorted.data(), sorted.size());
+        // The first value takes 6 bytes, the deltas take a byte each
+        CHECK(length == 6 + 999);
+        std::vector<uint64_t> decoded(sorted.size());
+        CHECK(bytes::decode_delta_block(buffer.data(), decoded.data(), decoded.size()) == length);
+        CHECK(decoded == sorted);
+
+        std::vector<int64_t> mixed = {0, std::numeric_limits<int64_t>::max(),
+                                      std::numeric_limits<int64_t>::min(), -5, 7, -5};
+        std::vector<int64_t> mixed_decoded(mixed.size());
+        length = bytes::encode_delta_block(buffer.data(), mixed.data(), mixed.size());
+        CHECK(bytes::decode_delta_block(buffer.data(), mixed_decoded.data(), mixed.size())
+              == length);
+        CHECK(mixed_decoded == mixed);
+    }
+
+    TEST_CASE("Frame of reference block encoding")
+    {
+        std::mt19937_64 rng(7);
+        // Every bit width is tested, with full blocks of 128 values and a partial block
+        for (unsigned bits = 0; bits <= 64; ++bits)
+        {
+            for (size_t n : {1, 5, 128, 256, 300})
+            {
+                std::vector<uint64_t> values(n);
+                uint64_t base = bits == 64 ? 0 : 12345;
+                for (auto &value : values)
+                {
+                    uint64_t offset = bits == 0 ? 0 : rng() >> (64 - bits);
+                    value = base + offset;
+                }
+                int expected_length = bytes::for_block_length(values.data(), n);
+                std::vector<uint8_t> buffer(expected_length + 1);
+                int length = bytes::encode_for_block(buffer.data(), values.data(), n);
+                CHECK(length == expected_length);
+                // The width byte follows the smallest value, and no value needs more bits
+                auto min = *std::min_element(values.begin(), values.end());
+                CHECK(buffer[bytes::varint_length(min)] <= bits);
+                std::vector<uint64_t> decoded(n);
+                CHECK(bytes::decode_for_block(buffer.data(), decoded.data(), n) == length);
+                CHECK(decoded == values);
+            }
+        }
+
+        std::vector<int32_t> signed_values = {-100, 50, -7, 3, 0, 1000};
+        std::vector<uint8_t> buffer(bytes::for_block_length(signed_values.data(), 6));
+        int length = bytes::encode_for_block(buffer.data(), signed_values.data(), 6);
+        // min is -100, the largest difference is 1100 which needs 11 bits
+        CHECK(buffer[2] == 11);
+        std::vector<int32_t> decoded(6);
+        CHECK(bytes::decode_for_block(buffer.data(), decoded.data(), 6) == length);
+        CHECK(decoded == signed_values);
+        CHECK(bytes::encode_for_block(buffer.data(), signed_values.data(), 0) == 0);
+
+        // A bit width larger than the type is rejected
+        buffer[2] = 33;
+        CHECK(bytes::decode_for_block(buffer.data(), decoded.data(), 6) == -1);
+    }
+
+    TEST_CASE("Varint and block stream api")
+    {
+        std::stringstream ss;
+        std::vector<uint32_t> sorted = {3, 5, 8, 13, 21, 34, 55, 89, 144};
+        std::vector<int16_t> small = {-3, 4, -1, 0, 7};
+        stream::write_varint(ss, 300u);
+        stream::write_varint(ss, -12345678901LL);
+        stream::write_delta_block(ss, sorted);
+        stream::write_for_block(ss, small);
+        stream::write_for_block(ss, std::vector<uint64_t>{});
+
+        unsigned u = 0;
+        long long ll = 0;
+        std::vector<uint32_t> sorted2;
+        std::vector<int16_t> small2;
+        std::vector<uint64_t> empty = {1};
+        CHECK(stream::read_varint(ss, u));
+        CHECK(u == 300);
+        CHECK(stream::read_varint(ss, ll));
+        CHECK(ll == -12345678901LL);
+        CHECK(stream::read_delta_block(ss, sorted2));
+        CHECK(sorted2 == sorted);
+        CHECK(stream::read_for_block(ss, small2));
+        CHECK(small2 == small);
+        CHECK(stream::read_for_block(ss, empty));
+        CHECK(empty.empty());
+        CHECK(!stream::read_varint(ss, u));
+
+        std::stringstream ss2;
+        stream::write_delta_block(ss2, sorted);
+        CHECK_THROWS(stream::read_delta_block(ss2, sorted2, 3));
+    }
+
+    TEST_CASE("Zero copy views over length prefixed data")
+    {
+        uint8_t buffer[64];
+        std::string str = "hello world";
+        int length = bytes::encode_length_prefixed<endian::big>(buffer, str);
+        std::string_view view;
+        CHECK(bytes::decode_length_prefixed_view<endian::big>(buffer, sizeof(buffer), view)
+              == length);
+        CHECK(view == str);
+        CHECK(reinterpret_cast<const uint8_t *>(view.data()) == buffer + sizeof(size_t));
+        // The string is cut short
+        CHECK(bytes::decode_length_prefixed_view<endian::big>(buffer, length - 1, view) == -1);
+        CHECK(bytes::decode_length_prefixed_view<endian::big>(buffer, 3, view) == -1);
+
+        std::vector<uint32_t> values = {1, 0xDEADBEEF, 3};
+        // Unaligned on purpose, elements are decoded on access
+        length = bytes::encode_length_prefixed<endian::big>(buffer + 1, values);
+        bytes::array_view<endian::big, uint32_t> array;
+        CHECK(bytes::decode_length_prefixed_view(buffer + 1, sizeof(buffer) - 1, array)
+              == length);
+        REQUIRE(array.size() == 3);
+        CHECK(array[1] == 0xDEADBEEF);
+        std::vector<uint32_t> copied(array.size());
+        array.copy_to(copied.data());
+        CHECK(copied == values);
+        CHECK(bytes::decode_length_prefixed_view(buffer + 1, length - 1, array) == -1);
+    }
+
+    TEST_CASE("Buffered stream writer and reader")
+    {
+        std::stringstream ss;
+        std::vector<double> doubles = {1.5, -2.25, 1e300};
+        // Larger than the buffer, so that the writer has to flush in the middle of it
+        std::vector<uint64_t> large(stream::StreamWriter::BUFFER_SIZE / 3);
+        for (size_t i = 0; i < large.size(); ++i)
+            large[i] = i * 0x0101010101ULL;
+        std::string long_string(stream::StreamWriter::BUFFER_SIZE * 2, 'x');
+        {
+            stream::StreamWriter writer(ss);
+            for (uint32_t i = 0; i < 10000; ++i)
+                writer.write<endian::big>(i);
+            writer.write<endian::little>(std::string("hello"));
+            writer.write<endian::little>("literal");
+            writer.write<endian::little>(doubles);
+            writer.write<endian::big>(large);
+            writer.write_varint(-300);
+            writer.write<endian::little>(long_string);
+            writer.write<endian::little>(std::string_view("view"));
+            CHECK(writer.bytes_written()
+                  == 10000 * 4 + 3 * sizeof(size_t) + 12 + 3 * 8 + sizeof(size_t) + large.size() * 8
+                         + 2 + sizeof(size_t) + long_string.size() + sizeof(size_t) + 4);
+        }
+
+        // The writer uses the same format as the unbuffered functions
+        std::stringstream copy(ss.str());
+        uint32_t first;
+        std::string hello;
+        stream::read<endian::big>(copy, first);
+        CHECK(first == 0);
+
+        stream::StreamReader reader(ss);
+        for (uint32_t i = 0; i < 10000; ++i)
+        {
+            uint32_t value = 0;
+            REQUIRE(reader.read<endian::big>(value));
+            CHECK(value == i);
+        }
+        CHECK(reader.read<endian::little>(hello));
+        CHECK(hello == "hello");
+        std::string_view view;
+        CHECK(reader.read_view<endian::little>(view));
+        CHECK(view == "literal");
+        std::vector<double> doubles2;
+        CHECK(reader.read<endian::little>(doubles2));
+        CHECK(doubles2 == doubles);
+        std::vector<uint64_t> large2;
+        CHECK(reader.read<endian::big>(large2));
+        CHECK(large2 == large);
+        int varint = 0;
+        CHECK(reader.read_varint(varint));
+        CHECK(varint == -300);
+        std::string long_string2;
+        CHECK(reader.read<endian::little>(long_string2));
+        CHECK(long_string2 == long_string);
+        CHECK(reader.read_view<endian::little>(view));
+        CHECK(view == "view");
+
+        // End of the stream
+        uint8_t byte;
+        CHECK(!reader.read<endian::little>(byte));
+        CHECK(!reader.read_varint(varint));
+    }
+
+    TEST_CASE("Buffered stream reader errors")
+    {
+        SUBCASE("Truncated data")
+        {
+            std::stringstream ss;
+            stream::write<endian::little>(ss, std::string("truncated"));
+            std::string data = ss.str();
+            std::stringstream truncated(data.substr(0, data.size() - 1));
+            stream::StreamReader reader(truncated);
+            std::string str;
+            CHECK(!reader.read<endian::little>(str));
+            CHECK(str.empty());
+        }
+        SUBCASE("Too many elements")
+        {
+            std::stringstream ss;
+            stream::write<endian::little>(ss, std::vector<int32_t>(100));
+            stream::StreamReader reader(ss);
+            std::vector<int32_t> v;
+            CHECK_THROWS(reader.read<endian::little>(v, 10));
+        }
+        SUBCASE("String too long for a view")
+        {
+            std::stringstream ss;
+            {
+                stream::StreamWriter writer(ss);
+                writer.write<endian::little>(std::string(stream::StreamReader::BUFFER_SIZE, 'a'));
+            }
+            stream::StreamReader reader(ss);
+            std::string_view view;
+            CHECK_THROWS(reader.read_view<endian::little>(view));
+        }
+        SUBCASE("Raw bytes")
+        {
+            std::string data(stream::StreamReader::BUFFER_SIZE * 2 + 10, 'z');
+            data[0] = 'a';
+            data.back() = 'b';
+            std::stringstream ss(data);
+            stream::StreamReader reader(ss);
+            std::string out(data.size(), ' ');
+            CHECK(reader.read_bytes(out.data(), 5));
+            CHECK(reader.read_bytes(out.data() + 5, out.size() - 5));
+            CHECK(out == data);
+            CHECK(!reader.read_bytes(out.data(), 1));
+        }
+    }
+}
@@ -0,0 +1,121 @@
+#include <doctest/doctest.h>
+#include <pinedb/datapage.h>
+#include <string>
+#include <vector>
+
+using namespace pinedb;
+
+namespace
+{
+    std::string get_string(const DataPage &page, uint16_t slot)
+    {
+        const uint8_t *data;
+        uint16_t length;
+        if (!page.get(slot, data, length))
+            return "<free>";
+        return std::string(reinterpret_cast<const char *>(data), length);
+    }
+
+    int insert_string(DataPage &page, const std::string &s)
+    {
+        return page.insert(reinterpret_cast<const uint8_t *>(s.data()),
+                           static_cast<uint16_t>(s.size()));
+    }
+
+    bool update_string(DataPage &page, uint16_t slot, const std::string &s)
+    {
+        return page.update(slot, reinterpret_cast<const uint8_t *>(s.data()),
+                           static_cast<uint16_t>(s.size()));
+    }
+} // namespace
+
+TEST_SUITE("datapage")
+{
+    TEST_CASE("Insert, get, update and remove tuples")
+    {
+        std::vector<uint8_t> buffer(4096);
+        DataPage page(buffer.data(), 4096);
+        page.init(7);
+        CHECK(page.number_of_slots() == 0);
+        CHECK(page.get_next_page_id() == 0);
+        CHECK(page.max_insert_length() == 4096 - DataPage::HEADER_SIZE - DataPage::SLOT_SIZE);
+
+        CHECK(insert_string(page, "first") == 0);
+        CHECK(insert_string(page, "second") == 1);
+        CHECK(insert_string(page, "") == 2);
+        CHECK(page.number_of_slots() == 3);
+        CHECK(get_string(page, 0) == "first");
+        CHECK(get_string(page, 1) == "second");
+        CHECK(get_string(page, 2) == "");
+        CHECK(get_string(page, 3) == "<free>");
+
+        // Shrinking and growing updates keep the slot number
+        CHECK(update_string(page, 0, "1st"));
+        CHECK(get_string(page, 0) == "1st");
+        CHECK(update_string(page, 0, "the first tuple, which is now longer"));
+        CHECK(get_string(page, 0) == "the first tuple, which is now longer");
+        CHECK(get_string(page, 1) == "second");
+
+        CHECK(page.remove(1));
+        CHECK(!page.remove(1));
+        CHECK(get_string(page, 1) == "<free>");
+        CHECK(!update_string(page, 1, "x"));
+        // The free slot is reused
+        CHECK(insert_string(page, "third") == 1);
+
+        // Removing the last slot shrinks the directory
+        CHECK(page.remove(2));
+        CHECK(page.number_of_slots() == 2);
+    }
+
+    TEST_CASE("Compaction reclaims fragmented space")
+    {
+        std::vector<uint8_t> buffer(512);
+        DataPage page(buffer.data(), 512);
+        page.init(1);
+        std::string tuple(100, 'a');
+        std::vector<int> slots;
+        int slot;
+        char ch = 'a';
+        while ((slot = insert_string(page, std::string(100, ch))) != -1)
+        {
+            slots.push_back(slot);
+            ++ch;
+        }
+        CHECK(slots.size() == 4);
+        CHECK(page.max_insert_length() < 100);
+
+        // Free two tuples in the middle, the free space is not contiguous
+        CHECK(page.remove(1));
+        CHECK(page.remove(2));
+        CHECK(insert_string(page, std::string(150, 'x')) == 1);
+        CHECK(get_string(page, 0) == std::string(100, 'a'));
+        CHECK(get_string(page, 1) == std::string(150, 'x'));
+        CHECK(get_string(page, 3) == std::string(100, 'd'));
+
+        // Growing a tuple compacts the page as well
+        CHECK(update_string(page, 0, std::string(140, 'y')));
+        CHECK(get_string(page, 0) == std::string(140, 'y'));
+        CHECK(get_string(page, 1) == std::string(150, 'x'));
+        CHECK(get_string(page, 3) == std::string(100, 'd'));
+        CHECK(!update_string(page, 3, std::string(300, 'z')));
+        CHECK(get_string(page, 3) == std::string(100, 'd'));
+    }
+
+    TEST_CASE("Tuple flags and record ids")
+    {
+        std::vector<uint8_t> buffer(256);
+        DataPage page(buffer.data(), 256);
+        page.init(1);
+        uint8_t data[2] = {1, 2};
+        CHECK(page.insert(data, 2, DataPage::FLAG_MOVED_IN) == 0);
+        CHECK(page.get_flags(0) == DataPage::FLAG_MOVED_IN);
+        CHECK(get_string(page, 0).size() == 2);
+        CHECK(page.update(0, data, 1, DataPage::FLAG_FORWARDED));
+        CHECK(page.get_flags(0) == DataPage::FLAG_FORWARDED);
+
+        RecordId rid{123456, 789};
+        CHECK(RecordId::from_uint64(rid.to_uint64()) == rid);
+        CHECK(rid != RecordId{123456, 788});
+    }
+}
@@ -0,0 +1,160 @@
+#include <doctest/doctest.h>
+#include <pinedb/dictionary.h>
+#include <pinedb/paxpage.h>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace pinedb;
+
+TEST_SUITE("dictionary")
+{
+    TEST_CASE("Strings with few distinct values are bit packed")
+    {
+        std::vector<std::string_view> statuses = {"active", "blocked", "deleted", "pending",
+                                                  "new"};
+        std::mt19937 rng(1);
+        std::vector<std::string_view> values;
+        for (int i = 0; i < 1000; ++i)
+            values.push_back(statuses[rng() % statuses.size()]);
+
+        std::vector<uint8_t> encoded = {0xAA};
+        REQUIRE(DictionaryEncoder::encode(values, encoded));
+        CHECK(encoded[0] == 0xAA);
+        DictionaryColumn column(encoded.data() + 1, encoded.size() - 1);
+        CHECK(column.get_encoding() == DictionaryEncoding::PACKED);
+        CHECK(column.has_strings());
+        CHECK(column.size() == 1000);
+        CHECK(column.dictionary_size() == 5);
+        CHECK(column.code_width() == 3);
+        // 3 bits per value, instead of the strings
+        CHECK(encoded.size() < 1 + DictionaryEncoder::HEADER_SIZE + 40 + 1000 * 3 / 8 + 1);
+
+        // The dictionary is sorted
+        CHECK(column.string_at(0) == "active");
+        CHECK(column.string_at(4) == "pending");
+        for (size_t row = 0; row < values.size(); ++row)
+            CHECK(column.string_at(column.code(row)) == values[row]);
+
+        // Predicates are evaluated on the codes
+        CHECK(column.find("missing") == -1);
+        auto blocked = column.find("blocked");
+        REQUIRE(blocked == 1);
+        std::vector<size_t> rows;
+        column.for_each_equal(blocked, [&](size_t row) { rows.push_back(row); });
+        std::vector<size_t> expected;
+        for (size_t row = 0; row < values.size(); ++row)
+        {
+            if (values[row] == "blocked")
+                expected.push_back(row);
+        }
+        CHECK(rows == expected);
+
+        // Values in ["b", "o")
+        auto first = column.lower_bound("b"), last = column.lower_bound("o");
+        CHECK(first == 1);
+        CHECK(last == 4);
+        size_t count = 0;
+        for (auto value : values)
+            count += value >= "b" && value < "o";
+        CHECK(column.count_in_range(first, last) == count);
+    }
+
+    TEST_CASE("Sorted values are run length encoded")
+    {
+        std::vector<int64_t> values;
+        for (auto value : std::vector<int64_t>{-5, 3, 100000, 7000000000})
+        {
+            for (int i = 0; i < 500; ++i)
+                values.push_back(value);
+        }
+        std::vector<uint8_t> encoded;
+        REQUIRE(DictionaryEncoder::encode(values, encoded));
+        CHECK(encoded.size() < 40);
+        DictionaryColumn column(encoded.data(), encoded.size());
+        CHECK(column.get_encoding() == DictionaryEncoding::RUN_LENGTH);
+        CHECK(!column.has_strings());
+        CHECK(column.size() == 2000);
+        CHECK(column.integer_at(0) == -5);
+        CHECK(column.integer_at(3) == 7000000000);
+        for (size_t row = 0; row < values.size(); row += 37)
+            CHECK(column.integer_at(column.code(row)) == values[row]);
+
+        CHECK(column.find(3) == 1);
+        CHECK(column.find(4) == -1);
+        CHECK(column.count_in_range(column.lower_bound(0), column.lower_bound(1000000)) == 1000);
+        size_t first_row = 0, rows = 0;
+        column.for_each_equal(3,
+                              [&](size_t row)
+                              {
+                                  if (rows++ == 0)
+                                      first_row = row;
+                              });
+        CHECK(first_row == 1500);
+        CHECK(rows == 500);
+    }
+
+    TEST_CASE("Columns which cannot be encoded")
+    {
+        std::vector<int64_t> values;
+        for (int i = 0; i < 300; ++i)
+            values.push_back(i);
+        std::vector<uint8_t> encoded;
+        CHECK(!DictionaryEncoder::encode(values, encoded));
+        CHECK(encoded.empty());
+        CHECK(DictionaryEncoder::encode(values, encoded, 512));
+        DictionaryColumn column(encoded.data(), encoded.size());
+        CHECK(column.code_width() == 9);
+        for (size_t row = 0; row < values.size(); ++row)
+            CHECK(column.code(row) == row);
+
+        // Single value, and no values
+        encoded.clear();
+        REQUIRE(DictionaryEncoder::encode(std::vector<int64_t>(10, 42), encoded));
+        DictionaryColumn single(encoded.data(), encoded.size());
+        CHECK(single.code(9) == 0);
+        CHECK(single.count_in_range(0, 1) == 10);
+        encoded.clear();
+        REQUIRE(DictionaryEncoder::encode(std::vector<std::string_view>(), encoded));
+        CHECK(DictionaryColumn(encoded.data(), encoded.size()).size() == 0);
+
+        // Malformed data
+        CHECK_THROWS_AS(DictionaryColumn(encoded.data(), 3), std::runtime_error);
+        std::vector<uint8_t> bad = {9, 0, 1, 0, 1, 0, 0};
+        CHECK_THROWS_AS(DictionaryColumn(bad.data(), bad.size()), std::runtime_error);
+        bad = {2, 0, 10, 0, 1, 0, 0, 0, 5};
+        CHECK_THROWS_AS(DictionaryColumn(bad.data(), bad.size()), std::runtime_error);
+    }
+
+    TEST_CASE("Encode a column of a PAX page")
+    {
+        RecordLayout layout("Ics");
+        std::vector<uint8_t> buffer(4096);
+        PaxPage page(buffer.data(), 4096, layout);
+        page.init(1, PaxPage::default_capacity(layout, 4096));
+        const char *countries[] = {"IN", "US", "DE"};
+        std::vector<uint8_t> record(64);
+        for (int i = 0; i < 100; ++i)
+        {
+            RecordBuilder builder(layout, record.data(), record.size());
+            builder.set<int32_t>(0, i).set_string(1, countries[i % 3]);
+            builder.set<uint16_t>(2, static_cast<uint16_t>(i / 10));
+            REQUIRE(page.append(record.data()) == i);
+        }
+
+        std::vector<uint8_t> encoded;
+        REQUIRE(page.encode_column(1, encoded));
+        DictionaryColumn country(encoded.data(), encoded.size());
+        CHECK(country.count_in_range(country.find("US"), country.find("US") + 1) == 33);
+
+        encoded.clear();
+        REQUIRE(page.encode_column(2, encoded));
+        DictionaryColumn group(encoded.data(), encoded.size());
+        CHECK(group.get_encoding() == DictionaryEncoding::RUN_LENGTH);
+        CHECK(group.dictionary_size() == 10);
+
+        // 100 distinct values are still encoded
+        encoded.clear();
+        CHECK(page.encode_column(0, encoded));
+    }
+}
@@ -0,0 +1,86 @@
+#include <doctest/doctest.h>
+#include <pinedb/freespacemap.h>
+#include <random>
+#include <vector>
+
+using namespace pinedb;
+
+TEST_SUITE("freespacemap")
+{
+    TEST_CASE("Categories")
+    {
+        MemoryStorageBackend storage(4096);
+        LRUCacheReplacer<frame_id_type> cache_replacer(2);
+        BufferPool pool(2, storage, cache_replacer);
+        FreeSpaceMap map(pool, 0);
+        CHECK(map.get_first_page_id() == 0);
+        CHECK(map.get_leaves_per_page() == (4096 - FreeSpaceMap::HEADER_SIZE + 1) / 2);
+        CHECK(map.category(0) == 0);
+        CHECK(map.category(15) == 0);
+        CHECK(map.category(16) == 1);
+        CHECK(map.category(4095) == 255);
+
+        // An empty map does not have any page with free space
+        CHECK(map.find(1) == -1);
+        CHECK(map.get(10) == 0);
+        CHECK(map.get_first_page_id() == 0);
+
+        map.set(3, 100);
+        CHECK(map.get_first_page_id() != 0);
+        CHECK(map.get(3) == 6);
+        // 100 bytes are not guaranteed by category 6, so the page is found only for 96 bytes
+        CHECK(map.find(96) == 3);
+        CHECK(map.find(97) == -1);
+        CHECK(map.find(0) == 3);
+        CHECK(map.find(100000) == -1);
+    }
+
+    TEST_CASE("Find a page with enough space")
+    {
+        page_size_type page_size = 128;
+        int number_of_frames = 3;
+        MemoryStorageBackend storage(page_size);
+        LRUCacheReplacer<frame_id_type> cache_replacer(number_of_frames);
+        BufferPool pool(number_of_frames, storage, cache_replacer);
+
+        // Uses many map pages, since each page has only 48 leaves
+        size_t number_of_pages = 1000;
+        std::vector<size_t> free_bytes(number_of_pages, 0);
+        page_id_type first_page_id;
+        {
+            FreeSpaceMap map(pool, 0);
+            std::mt19937 rng(5);
+            for (int i = 0; i < 5000; ++i)
+            {
+                auto index = rng() % number_of_pages;
+                free_bytes[index] = rng() % page_size;
+                map.set(index, free_bytes[index]);
+            }
+            first_page_id = map.get_first_page_id();
+        }
+
+        FreeSpaceMap map(pool, first_page_id);
+        for (size_t needed = 1; needed < static_cast<size_t>(page_size); ++needed)
+        {
+            auto index = map.find(needed);
+            bool exists = false;
+            for (size_t i = 0; i < number_of_pages; ++i)
+                exists = exists || map.category(free_bytes[i]) >= needed;
+            if (!exists)
+            {
+                CHECK(index == -1);
+                continue;
+            }
+            REQUIRE(index != -1);
+            CHECK(free_bytes[index] >= needed);
+            CHECK(map.get(index) == map.category(free_bytes[index]));
+        }
+
+        // Fill every page, nothing should be found
+        for (size_t i = 0; i < number_of_pages; ++i)
+            map.set(i, 0);
+        CHECK(map.find(1) == -1);
+        map.set(number_of_pages - 1, 50);
+        CHECK(map.find(50) == static_cast<int64_t>(number_of_pages - 1));
+    }
+}
@@ -0,0 +1,161 @@
+#include <cmath>
+#include <doctest/doctest.h>
+#include <map>
+#include <pinedb/btree.h>
+#include <pinedb/bufferpool.h>
+#include <pinedb/hashindex.h>
+#include <random>
+#include <stdexcept>
+
+using namespace pinedb;
+
+namespace
+{
+    // Checks that the index has the same keys and values as `expected`
+    template <typename Key>
+    void check_index(HashIndex<Key> &index, const std::map<Key, uint64_t> &expected)
+    {
+        for (const auto &[key, value] : expected)
+        {
+            uint64_t found = 0;
+            REQUIRE(index.search(key, found));
+            CHECK(found == value);
+        }
+    }
+} // namespace
+
+TEST_SUITE("hashindex")
+{
+    TEST_CASE("HashIndex operations")
+    {
+        MemoryStorageBackend storage(4096);
+        LRUCacheReplacer<frame_id_type> cache_replacer(4);
+        BufferPool pool(4, storage, cache_replacer);
+        auto header_page_id = HashIndex<int32_t>::create(pool, 4);
+        HashIndex<int32_t> index(pool, header_page_id);
+        CHECK(index.get_global_depth() == 0);
+        std::map<int32_t, uint64_t> expected;
+        std::mt19937 rng(1);
+        for (int i = 0; i < 5000; ++i)
+        {
+            auto key = static_cast<int32_t>(rng() % 2000) - 1000;
+            auto value = static_cast<uint64_t>(rng());
+            switch (rng() % 4)
+            {
+            case 0:
+            case 1: {
+                bool inserted = expected.emplace(key, value).second;
+                CHECK(index.insert(key, value) == inserted);
+                break;
+            }
+            case 2: {
+                bool found = expected.find(key) != expected.end();
+                if (found)
+                    expected[key] = value;
+                CHECK(index.update(key, value) == found);
+                break;
+            }
+            default:
+                CHECK(index.remove(key) == (expected.erase(key) == 1));
+            }
+        }
+        CHECK(index.get_global_depth() > 5);
+        for (int32_t key = -1000; key < 1000; ++key)
+        {
+            uint64_t value = 0;
+            CHECK(index.search(key, value) == (expected.find(key) != expected.end()));
+        }
+
+        HashIndex<int32_t> reopened(pool, header_page_id);
+        check_index(reopened, expected);
+        CHECK(reopened.get_max_entries() == 4);
+
+        // Removing every key merges the buckets, and the index can be filled again
+        for (const auto &entry : expected)
+            CHECK(reopened.remove(entry.first));
+        CHECK(!reopened.remove(0));
+        for (int32_t key = 0; key < 1000; ++key)
+            CHECK(reopened.insert(key, key));
+        expected.clear();
+        for (int32_t key = 0; key < 1000; ++key)
+            expected[key] = key;
+        HashIndex<int32_t> reopened_again(pool, header_page_id);
+        check_index(reopened_again, expected);
+    }
+
+    TEST_CASE("HashIndex directory spans many pages")
+    {
+        // 64 slots in a directory page, so the directory has at most 4096 slots
+        MemoryStorageBackend storage(512);
+        LRUCacheReplacer<frame_id_type> cache_replacer(3);
+        BufferPool pool(3, storage, cache_replacer);
+        HashIndex<uint64_t> index(pool, HashIndex<uint64_t>::create(pool, 8));
+        CHECK(index.get_max_global_depth() == 12);
+        std::map<uint64_t, uint64_t> expected;
+        int fetches = 0;
+        pool.set_trace_hook([&](page_id_type) { ++fetches; });
+        for (uint64_t i = 0; i < 3000; ++i)
+        {
+            auto key = i * 7919;
+            CHECK(index.insert(key, i));
+            expected[key] = i;
+        }
+        CHECK(index.get_global_depth() > 6);
+        check_index(index, expected);
+
+        // The directory is in memory, so a lookup only reads the bucket
+        fetches = 0;
+        uint64_t value;
+        CHECK(index.search(7919 * 1234, value));
+        CHECK(value == 1234);
+        CHECK(fetches == 1);
+        HashIndex<uint64_t> reopened(pool, index.get_header_page_id());
+        pool.set_trace_hook({});
+        CHECK(reopened.get_global_depth() == index.get_global_depth());
+        check_index(reopened, expected);
+
+        CHECK(HashIndex<double>::hash(0.0) == HashIndex<double>::hash(-0.0));
+        HashIndex<double> doubles(pool, HashIndex<double>::create(pool));
+        CHECK(doubles.insert(0.0, 1));
+        CHECK(!doubles.insert(-0.0, 2));
+        CHECK(doubles.search(-0.0, value));
+        CHECK(value == 1);
+        CHECK_THROWS_AS(doubles.insert(std::nan(""), 1), std::logic_error);
+    }
+
+    TEST_CASE("HashIndex rejects invalid indexes and full directories")
+    {
+        MemoryStorageBackend storage(512);
+        LRUCacheReplacer<frame_id_type> cache_replacer(4);
+        BufferPool pool(4, storage, cache_replacer);
+        auto header_page_id = HashIndex<uint32_t>::create(pool, 2);
+        CHECK_THROWS_AS(HashIndex<int32_t>(pool, header_page_id), std::runtime_error);
+        CHECK_THROWS_AS(HashIndex<uint32_t>(pool, BTree<uint32_t>::create(pool)),
+                        std::runtime_error);
+        CHECK_THROWS_AS(HashIndex<uint32_t>::create(pool, 1), std::logic_error);
+        CHECK_THROWS_AS(HashIndex<uint32_t>::create(pool, 1000), std::logic_error);
+
+        // With 2 entries in a bucket, three keys soon have the same low 12 bits of their hash
+        HashIndex<uint32_t> index(pool, header_page_id);
+        std::map<uint32_t, uint64_t> expected;
+        uint32_t key = 0, depth = 0;
+        auto fill = [&]()
+        {
+            for (;; ++key)
+            {
+                depth = index.get_global_depth();
+                index.insert(key, key);
+                expected[key] = key;
+            }
+        };
+        CHECK_THROWS_AS(fill(), std::runtime_error);
+        // The insert which failed did not grow the directory or split buckets
+        CHECK(index.get_global_depth() == depth);
+        CHECK(depth <= index.get_max_global_depth());
+        HashIndex<uint32_t> reopened(pool, header_page_id);
+        CHECK(reopened.get_global_depth() == depth);
+        check_index(reopened, expected);
+        uint64_t value;
+        CHECK(!reopened.search(key, value));
+    }
+}
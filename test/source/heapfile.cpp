@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <doctest/doctest.h>
+#include <map>
+#include <pinedb/heapfile.h>
+#include <random>
+#include <string>
+
+using namespace pinedb;
+
+namespace
+{
+    std::vector<uint8_t> to_row(const std::string &s) { return {s.begin(), s.end()}; }
+} // namespace
+
+TEST_SUITE("heapfile")
+{
+    TEST_CASE("Insert, get, update and remove rows")
+    {
+        page_size_type page_size = 256;
+        int number_of_frames = 3;
+        MemoryStorageBackend storage(page_size);
+        LRUCacheReplacer<frame_id_type> cache_replacer(number_of_frames);
+        BufferPool pool(number_of_frames, storage, cache_replacer);
+
+        auto first_page_id = HeapFile::create(pool);
+        std::map<uint64_t, std::vector<uint8_t>> expected;
+        {
+            HeapFile heap(pool, first_page_id);
+            CHECK(heap.max_row_length() == 256 - DataPage::HEADER_SIZE - DataPage::SLOT_SIZE);
+            CHECK_THROWS_AS(heap.insert(nullptr, 1000), std::runtime_error);
+
+            std::mt19937 rng(1);
+            for (int i = 0; i < 100; ++i)
+            {
+                auto row = to_row(std::string(rng() % 40, static_cast<char>('a' + i % 26)));
+                auto rid = heap.insert(row.data(), row.size());
+                CHECK(expected.count(rid.to_uint64()) == 0);
+                expected[rid.to_uint64()] = row;
+            }
+
+            std::vector<uint8_t> row;
+            for (const auto &[key, value] : expected)
+            {
+                REQUIRE(heap.get(RecordId::from_uint64(key), row));
+                CHECK(row == value);
+            }
+
+            // Grow some rows so that they no longer fit in their page, they are moved to
+            // another page but keep their record id
+            int i = 0;
+            for (auto &[key, value] : expected)
+            {
+                if (i++ % 3 != 0)
+                    continue;
+                value = to_row(std::string(100 + i % 50, 'z'));
+                CHECK(heap.update(RecordId::from_uint64(key), value.data(), value.size()));
+            }
+            // Update the moved rows again, both smaller and larger
+            i = 0;
+            for (auto &[key, value] : expected)
+            {
+                if (i++ % 6 != 0)
+                    continue;
+                value = to_row(std::string(i % 2 == 0 ? 5 : 180, 'q'));
+                CHECK(heap.update(RecordId::from_uint64(key), value.data(), value.size()));
+            }
+
+            // Remove every fourth row
+            i = 0;
+            for (auto iter = expected.begin(); iter != expected.end();)
+            {
+                if (i++ % 4 == 0)
+                {
+                    CHECK(heap.remove(RecordId::from_uint64(iter->first)));
+                    CHECK(!heap.get(RecordId::from_uint64(iter->first), row));
+                    CHECK(!heap.remove(RecordId::from_uint64(iter->first)));
+                    iter = expected.erase(iter);
+                }
+                else
+                {
+                    ++iter;
+                }
+            }
+        }
+
+        // Open the heap file again, and check the rows using a sequential scan
+        HeapFile heap(pool, first_page_id);
+        std::map<uint64_t, std::vector<uint8_t>> scanned;
+        auto iter = heap.scan();
+        RecordId rid{0, 0};
+        std::vector<uint8_t> row;
+        while (iter.next(rid, row))
+        {
+            CHECK(scanned.count(rid.to_uint64()) == 0);
+            scanned[rid.to_uint64()] = row;
+        }
+        CHECK(scanned == expected);
+
+        // New rows reuse the space freed by the deletes
+        auto new_row = to_row("new row");
+        auto new_rid = heap.insert(new_row.data(), new_row.size());
+        CHECK(heap.get(new_rid, row));
+        CHECK(row == new_row);
+        CHECK(!heap.update({new_rid.page_id, 500}, new_row.data(), new_row.size()));
+    }
+
+    TEST_CASE("Inserts reuse the space freed by deletes")
+    {
+        MemoryStorageBackend storage(512);
+        LRUCacheReplacer<frame_id_type> cache_replacer(4);
+        BufferPool pool(4, storage, cache_replacer);
+        auto first_page_id = HeapFile::create(pool);
+
+        auto row = to_row(std::string(60, 'r'));
+        std::vector<RecordId> rids;
+        {
+            HeapFile heap(pool, first_page_id);
+            for (int i = 0; i < 200; ++i)
+                rids.push_back(heap.insert(row.data(), row.size()));
+        }
+        // Pages are created with increasing ids, so a new data page would have a larger id
+        page_id_type last_page_id = 0;
+        for (const auto &rid : rids)
+            last_page_id = std::max(last_page_id, rid.page_id);
+
+        // Delete every other row, and insert as many rows again, the file should not grow
+        HeapFile heap(pool, first_page_id);
+        for (size_t i = 0; i < rids.size(); i += 2)
+            CHECK(heap.remove(rids[i]));
+        for (size_t i = 0; i < rids.size(); i += 2)
+            CHECK(heap.insert(row.data(), row.size()).page_id <= last_page_id);
+
+        // The free space map is stored in the pages, so it is used after opening the file again
+        HeapFile reopened(pool, first_page_id);
+        for (size_t i = 1; i < rids.size(); i += 4)
+            CHECK(reopened.remove(rids[i]));
+        for (size_t i = 1; i < rids.size(); i += 4)
+            CHECK(reopened.insert(row.data(), row.size()).page_id <= last_page_id);
+
+        size_t rows = 0;
+        auto iter = reopened.scan();
+        RecordId rid{0, 0};
+        std::vector<uint8_t> scanned;
+        while (iter.next(rid, scanned))
+        {
+            CHECK(scanned == row);
+            ++rows;
+        }
+        CHECK(rows == rids.size());
+    }
+
+    TEST_CASE("Empty heap file")
+    {
+        MemoryStorageBackend storage(4096);
+        LRUCacheReplacer<frame_id_type> cache_replacer(2);
+        BufferPool pool(2, storage, cache_replacer);
+        HeapFile heap(pool, HeapFile::create(pool));
+        auto iter = heap.scan();
+        RecordId rid{0, 0};
+        std::vector<uint8_t> row;
+        CHECK(!iter.next(rid, row));
+    }
+}
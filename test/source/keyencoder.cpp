@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <cmath>
+#include <doctest/doctest.h>
+#include <limits>
+#include <pinedb/keyencoder.h>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace pinedb;
+
+namespace
+{
+    int sign(int x) { return (x > 0) - (x < 0); }
+
+    template <typename T> std::vector<uint8_t> encode(T value, bool descending = false)
+    {
+        KeyEncoder encoder;
+        encoder.add(value, descending);
+        return encoder.get_bytes();
+    }
+
+    int compare(const std::vector<uint8_t> &a, const std::vector<uint8_t> &b)
+    {
+        return sign(KeyEncoder::compare(a.data(), a.size(), b.data(), b.size()));
+    }
+
+    // Checks that the encoded values are ordered like the values, and that they decode back
+    template <typename T> void check_order(std::vector<T> values)
+    {
+        std::mt19937_64 rng(11);
+        for (int i = 0; i < 200; ++i)
+        {
+            if constexpr (std::is_floating_point<T>::value)
+                values.push_back(
+                    static_cast<T>(std::uniform_real_distribution<double>(-1e9, 1e9)(rng)));
+            else
+                values.push_back(static_cast<T>(rng()));
+        }
+        for (auto a : values)
+        {
+            auto encoded = encode(a);
+            KeyDecoder decoder(encoded.data(), encoded.size());
+            CHECK(decoder.get<T>() == a);
+            CHECK(decoder.at_end());
+            for (auto b : values)
+            {
+                int expected = (a > b) - (a < b);
+                CHECK(compare(encoded, encode(b)) == expected);
+                CHECK(compare(encode(a, true), encode(b, true)) == -expected);
+            }
+        }
+    }
+} // namespace
+
+TEST_SUITE("keyencoder")
+{
+    TEST_CASE("Integers are ordered")
+    {
+        check_order<uint8_t>({0, 1, 127, 128, 255});
+        check_order<int8_t>({-128, -1, 0, 1, 127});
+        check_order<uint16_t>({0, 255, 256, 65535});
+        check_order<int16_t>({-32768, -256, -1, 0, 1, 256, 32767});
+        check_order<uint32_t>({0, 1, 0x80000000u, 0xFFFFFFFFu});
+        check_order<int32_t>({std::numeric_limits<int32_t>::min(), -1, 0, 1,
+                              std::numeric_limits<int32_t>::max()});
+        check_order<uint64_t>({0, 1, 1ULL << 63, std::numeric_limits<uint64_t>::max()});
+        check_order<int64_t>({std::numeric_limits<int64_t>::min(), -1, 0, 1,
+                              std::numeric_limits<int64_t>::max()});
+        CHECK(encode<int32_t>(-1) == std::vector<uint8_t>{0x7F, 0xFF, 0xFF, 0xFF});
+        CHECK(encode<uint16_t>(0x1234) == std::vector<uint8_t>{0x12, 0x34});
+    }
+
+    TEST_CASE("Floating point numbers are in total order")
+    {
+        auto inf = std::numeric_limits<double>::infinity();
+        check_order<double>({-inf, -1e300, -1.5, -std::numeric_limits<double>::denorm_min(), 0.0,
+                             std::numeric_limits<double>::denorm_min(), 1.5, 1e300, inf});
+        check_order<float>({-std::numeric_limits<float>::infinity(), -3.5f, 0.0f, 2.25f,
+                            std::numeric_limits<float>::max()});
+        CHECK(compare(encode(-0.0), encode(0.0)) < 0);
+        CHECK(compare(encode(inf), encode(std::nan(""))) < 0);
+    }
+
+    TEST_CASE("Strings are ordered like std::string")
+    {
+        std::vector<std::string> values = {"",   std::string(1, '\0'), std::string("a\0", 2),
+                                           "a",  "ab", std::string("a\0b", 3), "b", "\xff",
+                                           "\x01"};
+        for (const auto &a : values)
+        {
+            KeyEncoder ea;
+            ea.add_string(a);
+            KeyDecoder decoder(ea.data(), ea.size());
+            CHECK(decoder.get_string() == a);
+            CHECK(decoder.at_end());
+            for (const auto &b : values)
+            {
+                KeyEncoder eb;
+                eb.add_string(b);
+                CHECK(compare(ea.get_bytes(), eb.get_bytes()) == sign(a.compare(b)));
+            }
+        }
+        std::vector<uint8_t> unterminated = {'a', 'b'};
+        KeyDecoder decoder(unterminated.data(), unterminated.size());
+        CHECK_THROWS_AS(decoder.get_string(), std::runtime_error);
+    }
+
+    TEST_CASE("Composite keys are ordered column by column")
+    {
+        struct Row
+        {
+            std::string name;
+            int32_t age;
+            double score;
+        };
+        std::vector<Row> rows = {{"bob", 30, 1.0},   {"bob", 30, 2.0}, {"bob", -5, 0.0},
+                                 {"alice", 99, 0.0}, {"al", 100, 0.0}, {"bobby", 0, 0.0},
+                                 {"", 0, 0.0}};
+        // Ascending name, descending age, ascending score
+        auto key = [](const Row &row)
+        {
+            KeyEncoder encoder;
+            encoder.add_string(row.name).add(row.age, true).add(row.score);
+            return encoder.get_bytes();
+        };
+        for (const auto &a : rows)
+        {
+            for (const auto &b : rows)
+            {
+                int expected = sign(a.name.compare(b.name));
+                if (expected == 0)
+                    expected = (a.age < b.age) - (a.age > b.age);
+                if (expected == 0)
+                    expected = (a.score > b.score) - (a.score < b.score);
+                CHECK(compare(key(a), key(b)) == expected);
+            }
+        }
+
+        auto encoded = key(rows[0]);
+        KeyDecoder decoder(encoded.data(), encoded.size());
+        CHECK(decoder.get_string() == "bob");
+        CHECK(decoder.get<int32_t>(true) == 30);
+        CHECK(decoder.get<double>() == 1.0);
+        CHECK(decoder.at_end());
+        CHECK_THROWS_AS(decoder.get<uint8_t>(), std::runtime_error);
+    }
+
+    TEST_CASE("Keys of records")
+    {
+        RecordLayout layout("Icd");
+        std::vector<uint8_t> a(64), b(64);
+        RecordBuilder(layout, a.data(), a.size()).set<int32_t>(0, 7).set<double>(2, 1.5)
+            .set_string(1, "pine");
+        RecordBuilder(layout, b.data(), b.size()).set<int32_t>(0, 7).set<double>(2, -1.5)
+            .set_string(1, "pine");
+        KeyEncoder ka, kb;
+        ka.add_record(layout, a.data(), {1, 0, 2});
+        kb.add_record(layout, b.data(), {1, 0, 2});
+        CHECK(compare(ka.get_bytes(), kb.get_bytes()) > 0);
+
+        KeyDecoder decoder(ka.data(), ka.size());
+        CHECK(decoder.get_string() == "pine");
+        CHECK(decoder.get<int32_t>() == 7);
+        CHECK(decoder.get<double>() == 1.5);
+
+        kb.clear();
+        kb.add_record(layout, b.data(), {2}, {true});
+        ka.clear();
+        ka.add_record(layout, a.data(), {2}, {true});
+        CHECK(compare(ka.get_bytes(), kb.get_bytes()) < 0);
+    }
+
+    TEST_CASE("Prefixes are ordered like the keys")
+    {
+        std::vector<std::vector<uint8_t>> keys;
+        for (const char *s : {"", "a", "abcdefgh", "abcdefghi", "abcdefgz", "b", "zzzzzzzzzz"})
+        {
+            KeyEncoder encoder;
+            encoder.add_string(s);
+            keys.push_back(encoder.get_bytes());
+        }
+        for (int64_t v : std::vector<int64_t>{-3, 0, 5})
+            keys.push_back(encode(v));
+        for (const auto &a : keys)
+        {
+            for (const auto &b : keys)
+            {
+                auto pa = KeyEncoder::prefix(a.data(), a.size());
+                auto pb = KeyEncoder::prefix(b.data(), b.size());
+                if (pa != pb)
+                    CHECK((pa < pb) == (compare(a, b) < 0));
+            }
+        }
+    }
+}
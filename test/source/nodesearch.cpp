@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <doctest/doctest.h>
+#include <limits>
+#include <pinedb/datapacker.h>
+#include <pinedb/nodesearch.h>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace pinedb;
+
+namespace
+{
+    const SearchKernel kernels[]
+        = {SearchKernel::SCALAR, SearchKernel::SSE2, SearchKernel::AVX2, SearchKernel::NEON};
+
+    // Compares every kernel with std::lower_bound and std::upper_bound, on sorted keys of every
+    // length up to 600, which include the smallest and the largest value of the type
+    template <typename T> void check_kernels()
+    {
+        std::mt19937_64 rng(7);
+        for (uint32_t n = 0; n <= 600; n += (n < 40 ? 1 : 37))
+        {
+            std::vector<T> keys(n);
+            for (auto &key : keys)
+            {
+                if constexpr (std::is_floating_point<T>::value)
+                    key = static_cast<T>(std::uniform_real_distribution<double>(-1e3, 1e3)(rng));
+                else
+                    key = static_cast<T>(rng());
+            }
+            if (n >= 2)
+            {
+                keys[0] = std::numeric_limits<T>::lowest();
+                keys[1] = std::numeric_limits<T>::max();
+            }
+            std::sort(keys.begin(), keys.end());
+            std::vector<uint8_t> encoded(n * sizeof(T) + 1);
+            // Keys in a page need not be aligned
+            for (uint32_t i = 0; i < n; ++i)
+                datapacker::bytes::encode<datapacker::endian::little>(
+                    encoded.data() + 1 + i * sizeof(T), keys[i]);
+
+            std::vector<T> needles(keys.begin(), keys.end());
+            needles.push_back(std::numeric_limits<T>::lowest());
+            needles.push_back(std::numeric_limits<T>::max());
+            needles.push_back(static_cast<T>(0));
+            for (int i = 0; i < 20; ++i)
+                needles.push_back(static_cast<T>(rng()));
+
+            for (auto kernel : kernels)
+            {
+                for (auto needle : needles)
+                {
+                    auto lower = std::lower_bound(keys.begin(), keys.end(), needle) - keys.begin();
+                    auto upper = std::upper_bound(keys.begin(), keys.end(), needle) - keys.begin();
+                    REQUIRE(NodeSearch::lower_bound(encoded.data() + 1, n, needle, kernel)
+                            == static_cast<uint32_t>(lower));
+                    REQUIRE(NodeSearch::upper_bound(encoded.data() + 1, n, needle, kernel)
+                            == static_cast<uint32_t>(upper));
+                }
+            }
+        }
+    }
+} // namespace
+
+TEST_SUITE("nodesearch")
+{
+    TEST_CASE("Kernels")
+    {
+        CHECK(NodeSearch::is_supported(SearchKernel::SCALAR));
+        CHECK(NodeSearch::is_supported(NodeSearch::best_kernel()));
+        CHECK(std::string(NodeSearch::kernel_name(SearchKernel::AVX2)) == "avx2");
+    }
+
+    TEST_CASE("Every kernel matches std::lower_bound and std::upper_bound")
+    {
+        check_kernels<uint8_t>();
+        check_kernels<int8_t>();
+        check_kernels<uint16_t>();
+        check_kernels<int16_t>();
+        check_kernels<uint32_t>();
+        check_kernels<int32_t>();
+        check_kernels<uint64_t>();
+        check_kernels<int64_t>();
+        check_kernels<float>();
+        check_kernels<double>();
+    }
+}
@@ -0,0 +1,127 @@
+#include <doctest/doctest.h>
+#include <pinedb/overflow.h>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace pinedb;
+
+namespace
+{
+    std::string random_string(std::mt19937 &rng, size_t length)
+    {
+        std::string s(length, '\0');
+        for (auto &ch : s)
+            ch = static_cast<char>(rng());
+        return s;
+    }
+} // namespace
+
+TEST_SUITE("overflow")
+{
+    TEST_CASE("Write, read and remove values")
+    {
+        page_size_type page_size = 256;
+        int number_of_frames = 3;
+        MemoryStorageBackend storage(page_size);
+        LRUCacheReplacer<frame_id_type> cache_replacer(number_of_frames);
+        BufferPool pool(number_of_frames, storage, cache_replacer);
+        OverflowStore store(pool);
+        std::mt19937 rng(3);
+
+        std::vector<std::string> values = {"", "short", random_string(rng, 232),
+                                           random_string(rng, 233), random_string(rng, 10000)};
+        std::string text;
+        while (text.size() < 20000)
+            text += "the quick brown fox jumps over the lazy dog " + std::to_string(rng() % 10);
+        values.push_back(text);
+        values.push_back(std::string(5000, 'a'));
+
+        std::vector<ExternalString> externals;
+        for (const auto &value : values)
+        {
+            auto first_page_id = pool.new_page();
+            auto external = store.write(value);
+            CHECK(external.length == value.size());
+            CHECK(external.prefix == value.substr(0, OverflowStore::DEFAULT_PREFIX_LENGTH));
+            CHECK(external.page_id == first_page_id + 1);
+            auto pages_used = pool.new_page() - external.page_id;
+            size_t uncompressed_pages = std::max<size_t>(
+                1, (value.size() + page_size - OverflowStore::HEADER_SIZE - 1)
+                       / (page_size - OverflowStore::HEADER_SIZE));
+            if (external.flags & OverflowStore::FLAG_COMPRESSED)
+                CHECK(static_cast<size_t>(pages_used) < uncompressed_pages);
+            else
+                CHECK(static_cast<size_t>(pages_used) == uncompressed_pages);
+            externals.push_back(external);
+        }
+        // Random bytes are not compressible, but repeated text is
+        CHECK(!(externals[4].flags & OverflowStore::FLAG_COMPRESSED));
+        CHECK(externals[5].flags & OverflowStore::FLAG_COMPRESSED);
+        CHECK(externals[6].flags & OverflowStore::FLAG_COMPRESSED);
+
+        std::string value;
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            store.read(externals[i], value);
+            CHECK(value == values[i]);
+        }
+
+        store.remove(externals[5]);
+        CHECK(pool.fetch_page(externals[5].page_id) == nullptr);
+        CHECK_THROWS_AS(store.read(externals[5], value), std::runtime_error);
+        store.read(externals[6], value);
+        CHECK(value == values[6]);
+
+        // Without compression every value uses the pages it needs
+        OverflowStore uncompressed(pool, 100, 8, false);
+        auto external = uncompressed.write(values[6]);
+        CHECK(external.flags == 0);
+        CHECK(external.prefix == "aaaaaaaa");
+        uncompressed.read(external, value);
+        CHECK(value == values[6]);
+    }
+
+    TEST_CASE("Large strings in records")
+    {
+        MemoryStorageBackend storage(4096);
+        LRUCacheReplacer<frame_id_type> cache_replacer(4);
+        BufferPool pool(4, storage, cache_replacer);
+        OverflowStore store(pool, 64, 10);
+
+        RecordLayout layout("Icc");
+        std::vector<uint8_t> buffer(256);
+        std::string large(100000, '\0');
+        std::mt19937 rng(7);
+        for (auto &ch : large)
+            ch = static_cast<char>('a' + rng() % 4);
+
+        RecordBuilder builder(layout, buffer.data(), buffer.size());
+        builder.set<int32_t>(0, 42);
+        store.set_string(builder, 1, "a small string");
+        store.set_string(builder, 2, large);
+        // The row holds only the pointer and the prefix
+        size_t inline_length = 14 + RecordLayout::EXTERNAL_POINTER_LENGTH + 10;
+        CHECK(builder.get_length() == layout.get_fixed_length() + inline_length);
+        CHECK(layout.record_length(buffer.data()) == builder.get_length());
+
+        CHECK(!layout.is_external(buffer.data(), 1));
+        CHECK(layout.is_external(buffer.data(), 2));
+        CHECK(layout.get<int32_t>(buffer.data(), 0) == 42);
+        CHECK(layout.get_string(buffer.data(), 1) == "a small string");
+        CHECK(layout.get_string(buffer.data(), 2) == large.substr(0, 10));
+        CHECK_THROWS_AS(layout.get_external(buffer.data(), 1), std::logic_error);
+        auto external = layout.get_external(buffer.data(), 2);
+        CHECK(external.length == large.size());
+        CHECK(external.prefix == large.substr(0, 10));
+
+        std::string value;
+        store.get_string(layout, buffer.data(), 1, value);
+        CHECK(value == "a small string");
+        store.get_string(layout, buffer.data(), 2, value);
+        CHECK(value == large);
+
+        store.remove_strings(layout, buffer.data());
+        CHECK(pool.fetch_page(external.page_id) == nullptr);
+    }
+}
@@ -0,0 +1,141 @@
+#include <doctest/doctest.h>
+#include <pinedb/paxfile.h>
+#include <pinedb/paxpage.h>
+#include <string>
+#include <vector>
+
+using namespace pinedb;
+
+namespace
+{
+    std::vector<uint8_t> make_record(const RecordLayout &layout, int32_t id, double amount,
+                                     const std::string &name, uint8_t flag)
+    {
+        std::vector<uint8_t> buffer(256);
+        RecordBuilder builder(layout, buffer.data(), buffer.size());
+        builder.set<int32_t>(0, id).set<double>(1, amount).set_string(2, name);
+        builder.set<uint8_t>(3, flag);
+        buffer.resize(builder.get_length());
+        return buffer;
+    }
+} // namespace
+
+TEST_SUITE("paxpage")
+{
+    TEST_CASE("Append and read rows column by column")
+    {
+        RecordLayout layout("Idcb");
+        page_size_type page_size = 512;
+        std::vector<uint8_t> buffer(page_size);
+        PaxPage page(buffer.data(), page_size, layout);
+        auto capacity = PaxPage::default_capacity(layout, page_size);
+        CHECK(capacity == (512 - PaxPage::HEADER_SIZE) / (17 + PaxPage::STRING_RESERVE));
+        page.init(7, capacity);
+        CHECK(page.number_of_rows() == 0);
+        CHECK(page.get_capacity() == capacity);
+        CHECK(page.get_next_page_id() == 0);
+        CHECK_THROWS_AS(page.init(7, 100), std::logic_error);
+
+        std::vector<std::vector<uint8_t>> records;
+        for (int i = 0; i < capacity; ++i)
+        {
+            records.push_back(make_record(layout, i * 10, i * 0.5, std::string(i % 5, 'x'),
+                                          static_cast<uint8_t>(i % 2)));
+            CHECK(page.append(records.back().data()) == i);
+        }
+        // The page is full
+        CHECK(page.append(records[0].data()) == -1);
+
+        for (uint16_t row = 0; row < capacity; ++row)
+        {
+            CHECK(page.get<int32_t>(row, 0) == row * 10);
+            CHECK(page.get<double>(row, 1) == row * 0.5);
+            CHECK(page.get_string(row, 2) == std::string(row % 5, 'x'));
+            CHECK(page.get<uint8_t>(row, 3) == row % 2);
+
+            std::vector<uint8_t> record(256);
+            auto length = page.get_record(row, record.data(), record.size());
+            record.resize(length);
+            CHECK(record == records[row]);
+        }
+        CHECK_THROWS_AS(page.get<int64_t>(0, 0), std::logic_error);
+        CHECK_THROWS_AS(page.get_string(0, 0), std::logic_error);
+        uint8_t small[4];
+        CHECK(page.get_record(0, small, sizeof(small)) == 0);
+        CHECK(page.get_record(capacity, buffer.data(), 0) == 0);
+
+        // Values of a column are contiguous and aligned to their width
+        auto amounts = page.column_data(1) - buffer.data();
+        CHECK(amounts % 8 == 0);
+        double sum = 0;
+        page.for_each<double>(1, [&](uint16_t, double value) { sum += value; });
+        CHECK(sum == (capacity - 1) * capacity * 0.25);
+    }
+
+    TEST_CASE("Strings fill the page before the rows do")
+    {
+        RecordLayout layout("Ic");
+        std::vector<uint8_t> buffer(256);
+        PaxPage page(buffer.data(), 256, layout);
+        page.init(1, PaxPage::default_capacity(layout, 256));
+        std::vector<uint8_t> record(256);
+        RecordBuilder builder(layout, record.data(), record.size());
+        builder.set<int32_t>(0, 1).set_string(1, std::string(100, 'a'));
+        CHECK(page.append(record.data()) == 0);
+        CHECK(page.append(record.data()) == -1);
+        CHECK(page.number_of_rows() == 1);
+    }
+
+    TEST_CASE("PAX file")
+    {
+        page_size_type page_size = 256;
+        int number_of_frames = 2;
+        MemoryStorageBackend storage(page_size);
+        LRUCacheReplacer<frame_id_type> cache_replacer(number_of_frames);
+        BufferPool pool(number_of_frames, storage, cache_replacer);
+        RecordLayout layout("Idcb");
+
+        auto first_page_id = PaxFile::create(pool, layout);
+        std::vector<RecordId> rids;
+        {
+            PaxFile file(pool, layout, first_page_id);
+            for (int i = 0; i < 100; ++i)
+            {
+                auto record = make_record(layout, i, i * 2.0, std::to_string(i), 1);
+                rids.push_back(file.insert(record.data()));
+            }
+            auto too_large = make_record(layout, 0, 0, std::string(200, 'z'), 0);
+            CHECK_THROWS_AS(file.insert(too_large.data()), std::runtime_error);
+        }
+
+        PaxFile file(pool, layout, first_page_id);
+        std::vector<uint8_t> row;
+        for (int i = 0; i < 100; ++i)
+        {
+            REQUIRE(file.get(rids[i], row));
+            CHECK(row == make_record(layout, i, i * 2.0, std::to_string(i), 1));
+        }
+        CHECK(!file.get({rids[0].page_id, 500}, row));
+
+        // Scan two columns only
+        int pages = 0, rows = 0;
+        double sum = 0;
+        file.for_each_page(
+            [&](page_id_type, const PaxPage &page)
+            {
+                ++pages;
+                page.for_each<int32_t>(0,
+                                       [&](uint16_t row, int32_t id)
+                                       {
+                                           CHECK(id == rows++);
+                                           sum += page.get<double>(row, 1);
+                                       });
+            });
+        CHECK(pages > 1);
+        CHECK(rows == 100);
+        CHECK(sum == 99 * 100);
+
+        auto record = make_record(layout, 100, 0, "", 0);
+        CHECK(file.insert(record.data()).page_id == rids.back().page_id);
+    }
+}
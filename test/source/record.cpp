@@ -0,0 +1,89 @@
+#include <doctest/doctest.h>
+#include <pinedb/page.h>
+#include <pinedb/record.h>
+
+using namespace pinedb;
+
+TEST_SUITE("record")
+{
+    TEST_CASE("Layout of fixed width fields")
+    {
+        RecordLayout layout("bIdSlf");
+        CHECK(layout.number_of_columns() == 6);
+        CHECK(!layout.has_variable_length());
+        CHECK(layout.get_fixed_length() == 1 + 4 + 8 + 2 + 8 + 4);
+        // Widest fields first, in column order within the same width
+        CHECK(layout.field(2).offset == 0);
+        CHECK(layout.field(4).offset == 8);
+        CHECK(layout.field(1).offset == 16);
+        CHECK(layout.field(5).offset == 20);
+        CHECK(layout.field(3).offset == 24);
+        CHECK(layout.field(0).offset == 26);
+        for (int i = 0; i < layout.number_of_columns(); ++i)
+            CHECK(layout.field(i).offset % layout.field(i).width == 0);
+
+        CHECK_THROWS_AS(RecordLayout("iix"), std::runtime_error);
+        RecordLayout empty("");
+        CHECK(empty.number_of_columns() == 0);
+        CHECK(empty.get_fixed_length() == 0);
+    }
+
+    TEST_CASE("Read and write fields")
+    {
+        RecordLayout layout("IcdbcL");
+        CHECK(layout.has_variable_length());
+        CHECK(layout.get_fixed_length() == 4 + 4 + 8 + 1 + 4 + 8);
+        uint8_t buffer[128];
+        RecordBuilder builder(layout, buffer, sizeof(buffer));
+        builder.set(0, int32_t{-42}).set(2, 3.5).set(3, uint8_t{7}).set(5, int64_t{1} << 40);
+        builder.set_string(4, "second").set_string(1, "first");
+        CHECK(builder.get_length() == layout.encoded_length(11));
+        CHECK(layout.record_length(buffer) == builder.get_length());
+
+        CHECK(layout.get<int32_t>(buffer, 0) == -42);
+        CHECK(layout.get<double>(buffer, 2) == 3.5);
+        CHECK(layout.get<uint8_t>(buffer, 3) == 7);
+        CHECK(layout.get<int64_t>(buffer, 5) == int64_t{1} << 40);
+        CHECK(layout.get_string(buffer, 1) == "first");
+        CHECK(layout.get_string(buffer, 4) == "second");
+
+        // Updating a field in place does not change the others
+        layout.set(buffer, 2, -1.25);
+        CHECK(layout.get<double>(buffer, 2) == -1.25);
+        CHECK(layout.get<int32_t>(buffer, 0) == -42);
+        CHECK(layout.get<uint8_t>(buffer, 3) == 7);
+        CHECK(layout.get_string(buffer, 1) == "first");
+
+        CHECK_THROWS_AS(layout.get<uint32_t>(buffer, 0), std::logic_error);
+        CHECK_THROWS_AS(layout.get_string(buffer, 0), std::logic_error);
+        CHECK_THROWS_AS(builder.set_string(0, "x"), std::logic_error);
+        CHECK_THROWS(layout.get<int32_t>(buffer, 10));
+    }
+
+    TEST_CASE("Strings which are not set are empty")
+    {
+        RecordLayout layout("cc");
+        uint8_t buffer[16];
+        RecordBuilder builder(layout, buffer, sizeof(buffer));
+        CHECK(builder.get_length() == 8);
+        CHECK(layout.get_string(buffer, 0).empty());
+        CHECK(layout.record_length(buffer) == 8);
+        CHECK_THROWS_AS(builder.set_string(1, "this is too long"), std::runtime_error);
+        CHECK_THROWS_AS(RecordBuilder(layout, buffer, 4), std::runtime_error);
+    }
+
+    TEST_CASE("Layout from table metadata")
+    {
+        uint8_t buffer[4096] = {0};
+        TableMetadataPage meta(buffer + 16);
+        CHECK(meta.number_of_columns() == 0);
+        meta.set_column_format("iiSSdf");
+        CHECK(meta.number_of_columns() == 6);
+        auto layout = meta.get_record_layout();
+        CHECK(layout.get_format() == "iiSSdf");
+        CHECK(layout.get_fixed_length() == 4 + 4 + 2 + 2 + 8 + 4);
+        meta.set_column_format(std::string(TableMetadataPage::MAX_NUMBER_OF_COLUMNS, 'b'));
+        int max_columns = TableMetadataPage::MAX_NUMBER_OF_COLUMNS;
+        CHECK(meta.number_of_columns() == max_columns);
+    }
+}
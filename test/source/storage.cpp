@@ -184,6 +184,43 @@ TEST_CASE("DiskStorageBackend returns false for invalid page")
     std::filesystem::remove("tmpfile");
 }
 
+TEST_CASE("DiskStorageBackend reads many pages")
+{
+    std::string tempFilename = "temp_test_file.dat";
+    size_t pageSize = 4096;
+    DiskStorageBackend storageBackend(tempFilename, pageSize);
+
+    std::vector<page_id_type> page_ids;
+    std::vector<uint8_t> buffer(pageSize);
+    for (int i = 0; i < 40; ++i)
+    {
+        page_ids.push_back(storageBackend.create_new_page());
+        std::fill(buffer.begin(), buffer.end(), static_cast<uint8_t>(i));
+        CHECK(storageBackend.write_page(page_ids.back(), buffer.data()));
+    }
+
+    // Runs of consecutive pages, longer than one read, and single pages
+    std::vector<page_id_type> to_read(page_ids.begin(), page_ids.begin() + 35);
+    to_read.push_back(page_ids[39]);
+    to_read.push_back(page_ids[37]);
+    std::vector<std::vector<uint8_t>> buffers(to_read.size(), std::vector<uint8_t>(pageSize));
+    std::vector<uint8_t *> pointers;
+    for (auto &b : buffers)
+        pointers.push_back(b.data());
+    CHECK(storageBackend.read_pages(to_read, pointers));
+    for (size_t i = 0; i < to_read.size(); ++i)
+    {
+        CHECK(buffers[i][0] == to_read[i] - page_ids[0]);
+        CHECK(buffers[i][pageSize - 1] == to_read[i] - page_ids[0]);
+    }
+
+    to_read.push_back(page_ids[39] + 100);
+    pointers.push_back(buffer.data());
+    CHECK(storageBackend.read_pages(to_read, pointers) == false);
+    storageBackend.close();
+    std::filesystem::remove(tempFilename);
+}
+
 TEST_CASE("MemoryStorageBackend create/read/write/delete")
 {
     page_size_type pageSize = 4096;
@@ -215,6 +252,11 @@ TEST_CASE("MemoryStorageBackend create/read/write/delete")
     CHECK(buffer[2] == 97);
     CHECK(buffer[4095] == 36);
 
+    std::vector<uint8_t> buffer2(4096, 0);
+    CHECK(backend.read_pages({page2, page1}, {buffer.data(), buffer2.data()}));
+    CHECK(buffer[0] == 99);
+    CHECK(buffer2[0] == 111);
+
     CHECK(backend.delete_page(page1));
     CHECK(backend.read_page(page1, buffer.data()) == false);
     CHECK(backend.delete_page(page2));
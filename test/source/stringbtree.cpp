@@ -0,0 +1,246 @@
+#include <doctest/doctest.h>
+#include <map>
+#include <pinedb/bufferpool.h>
+#include <pinedb/keyencoder.h>
+#include <pinedb/stringbtree.h>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+using namespace pinedb;
+
+namespace
+{
+    // Checks that the tree has the same keys and values as `expected`, by searching for every key
+    // and by iterating over the leaves
+    void check_tree(StringBTree &tree, const std::map<std::string, uint64_t> &expected)
+    {
+        for (const auto &[key, value] : expected)
+        {
+            uint64_t found = 0;
+            REQUIRE(tree.search(key, found));
+            CHECK(found == value);
+        }
+        auto iter = tree.begin();
+        auto expected_iter = expected.begin();
+        std::string key;
+        uint64_t value;
+        while (iter.next(key, value))
+        {
+            REQUIRE(expected_iter != expected.end());
+            CHECK(key == expected_iter->first);
+            CHECK(value == expected_iter->second);
+            ++expected_iter;
+        }
+        CHECK(expected_iter == expected.end());
+    }
+
+    // Random key which shares a long prefix with many other keys, and may contain zero bytes
+    std::string random_key(std::mt19937 &rng, size_t max_length)
+    {
+        static const std::string prefixes[] = {"", "customer/", "customer/orders/",
+                                               std::string("\0\0\0", 3), "zzzzzzzzzzzzzzzz"};
+        std::string key = prefixes[rng() % 5];
+        auto length = rng() % (max_length - key.size() + 1);
+        for (size_t i = 0; i < length; ++i)
+            key.push_back(static_cast<char>(rng() % 4 == 0 ? 0 : 'a' + rng() % 26));
+        return key;
+    }
+} // namespace
+
+TEST_SUITE("stringbtree")
+{
+    TEST_CASE("StringBTree insertion only into root node")
+    {
+        MemoryStorageBackend storage(4096);
+        LRUCacheReplacer<frame_id_type> cache_replacer(2);
+        BufferPool pool(2, storage, cache_replacer);
+        StringBTree tree(pool, StringBTree::create(pool));
+        CHECK(tree.height() == 1);
+
+        uint64_t value = 0;
+        CHECK(!tree.search("apple", value));
+        CHECK(tree.insert("apple", 1));
+        CHECK(tree.insert("", 2));
+        CHECK(tree.insert(std::string("apple\0", 6), 3));
+        CHECK(tree.insert("applesauce", 4));
+        CHECK(!tree.insert("apple", 5));
+        CHECK(tree.search("apple", value));
+        CHECK(value == 1);
+        CHECK(tree.search("", value));
+        CHECK(value == 2);
+        CHECK(!tree.search("appl", value));
+        CHECK(tree.update("applesauce", 40));
+        CHECK(!tree.update("pear", 40));
+
+        auto iter = tree.lower_bound("apple\x01");
+        std::string key;
+        CHECK(iter.next(key, value));
+        CHECK(key == "applesauce");
+        CHECK(value == 40);
+        CHECK(!iter.next(key, value));
+
+        CHECK(tree.remove(""));
+        CHECK(!tree.remove(""));
+        check_tree(tree, {{"apple", 1}, {std::string("apple\0", 6), 3}, {"applesauce", 40}});
+    }
+
+    TEST_CASE("StringBTree nodes store the common prefix once")
+    {
+        MemoryStorageBackend storage(4096);
+        LRUCacheReplacer<frame_id_type> cache_replacer(2);
+        BufferPool pool(2, storage, cache_replacer);
+        auto root_page_id = StringBTree::create(pool);
+        StringBTree tree(pool, root_page_id);
+        std::string prefix = "tenant-00042/documents/";
+        for (int i = 0; i < 50; ++i)
+            CHECK(tree.insert(prefix + std::to_string(i), static_cast<uint64_t>(i)));
+
+        StringBTreeNode root(pool.fetch_page(root_page_id), 4096);
+        CHECK(root.prefix() == prefix);
+        CHECK(root.size() == 50);
+        CHECK(root.suffix(0) == "0");
+        CHECK(root.key(1) == prefix + "1");
+        CHECK(root.used_space() < 50 * (StringBTreeNode::LEAF_SLOT_SIZE + 3) + prefix.size());
+
+        // A key without the prefix rebuilds the node with a shorter prefix
+        CHECK(tree.insert("tenant-00043", 100));
+        StringBTreeNode rebuilt(pool.fetch_page(root_page_id), 4096);
+        CHECK(rebuilt.prefix() == "tenant-0004");
+        uint64_t value;
+        CHECK(tree.search(prefix + "49", value));
+        CHECK(value == 49);
+    }
+
+    TEST_CASE("StringBTree separators are truncated")
+    {
+        MemoryStorageBackend storage(1024);
+        LRUCacheReplacer<frame_id_type> cache_replacer(3);
+        BufferPool pool(3, storage, cache_replacer);
+        auto root_page_id = StringBTree::create(pool);
+        StringBTree tree(pool, root_page_id);
+        std::map<std::string, uint64_t> expected;
+        // Long keys which differ early
+        std::mt19937 rng(5);
+        for (uint64_t i = 0; i < 2000; ++i)
+        {
+            std::string key;
+            for (int j = 0; j < 100; ++j)
+                key.push_back(static_cast<char>('a' + rng() % 26));
+            expected[key] = i;
+            CHECK(tree.insert(key, i));
+        }
+        check_tree(tree, expected);
+        // Leaves hold about 8 keys, and the internal nodes about 60 separators of a few bytes
+        CHECK(tree.height() == 3);
+        StringBTreeNode root(pool.fetch_page(root_page_id), 1024);
+        REQUIRE(!root.is_leaf());
+        for (uint32_t i = 0; i < root.size(); ++i)
+            CHECK(root.key(i).size() < 5);
+    }
+
+    TEST_CASE("StringBTree with composite keys")
+    {
+        MemoryStorageBackend storage(512);
+        LRUCacheReplacer<frame_id_type> cache_replacer(3);
+        BufferPool pool(3, storage, cache_replacer);
+        StringBTree tree(pool, StringBTree::create(pool));
+        std::map<std::pair<int32_t, std::string>, uint64_t> expected;
+        std::mt19937 rng(9);
+        auto encode = [](int32_t tenant_id, const std::string &name)
+        {
+            KeyEncoder encoder;
+            encoder.add(tenant_id).add_string(name);
+            return std::string(encoder.view());
+        };
+        for (uint64_t i = 0; i < 1500; ++i)
+        {
+            auto tenant_id = static_cast<int32_t>(rng() % 20) - 10;
+            auto name = "user" + std::to_string(rng() % 300);
+            bool inserted = expected.emplace(std::make_pair(tenant_id, name), i).second;
+            auto key = encode(tenant_id, name);
+            CHECK(tree.insert(key, i) == inserted);
+        }
+
+        // All the names of tenant -3, in order
+        auto iter = tree.lower_bound(encode(-3, ""));
+        auto expected_iter = expected.lower_bound({-3, ""});
+        std::string key;
+        uint64_t value;
+        while (iter.next(key, value))
+        {
+            KeyDecoder decoder(reinterpret_cast<const uint8_t *>(key.data()), key.size());
+            if (decoder.get<int32_t>() != -3)
+                break;
+            REQUIRE(expected_iter != expected.end());
+            CHECK(decoder.get_string() == expected_iter->first.second);
+            CHECK(value == expected_iter->second);
+            ++expected_iter;
+        }
+        CHECK(expected_iter->first.first == -2);
+    }
+
+    TEST_CASE("StringBTree random operations")
+    {
+        for (int page_size : {256, 512, 4096})
+        {
+            MemoryStorageBackend storage(page_size);
+            LRUCacheReplacer<frame_id_type> cache_replacer(3);
+            BufferPool pool(3, storage, cache_replacer);
+            StringBTree tree(pool, StringBTree::create(pool));
+            std::map<std::string, uint64_t> expected;
+            std::mt19937 rng(static_cast<unsigned>(page_size));
+            auto max_length = std::min<size_t>(tree.max_key_size(), 60);
+
+            for (int round = 0; round < 4; ++round)
+            {
+                for (int i = 0; i < 600; ++i)
+                {
+                    auto key = random_key(rng, max_length);
+                    auto value = static_cast<uint64_t>(rng());
+                    bool inserted = expected.emplace(key, value).second;
+                    CHECK(tree.insert(key, value) == inserted);
+                }
+                check_tree(tree, expected);
+                for (int i = 0; i < 400; ++i)
+                {
+                    auto key = random_key(rng, max_length);
+                    if (i % 2 == 0 && !expected.empty())
+                        key = std::next(expected.begin(), rng() % expected.size())->first;
+                    bool removed = expected.erase(key) == 1;
+                    CHECK(tree.remove(key) == removed);
+                }
+                check_tree(tree, expected);
+            }
+
+            StringBTree reopened(pool, tree.get_root_page_id());
+            for (const auto &entry : std::map<std::string, uint64_t>(expected))
+            {
+                CHECK(reopened.remove(entry.first));
+                expected.erase(entry.first);
+            }
+            check_tree(reopened, expected);
+            CHECK(reopened.height() == 1);
+        }
+    }
+
+    TEST_CASE("StringBTree rejects invalid trees and keys")
+    {
+        MemoryStorageBackend storage(256);
+        LRUCacheReplacer<frame_id_type> cache_replacer(2);
+        BufferPool pool(2, storage, cache_replacer);
+        StringBTree tree(pool, StringBTree::create(pool));
+        CHECK(tree.max_key_size() == (256 - 32) / 4 - 16);
+        CHECK(tree.insert(std::string(tree.max_key_size(), 'x'), 1));
+        CHECK_THROWS_AS(tree.insert(std::string(tree.max_key_size() + 1, 'x'), 1),
+                        std::logic_error);
+
+        auto other_page_id = pool.new_page();
+        CHECK_THROWS_AS(StringBTree(pool, other_page_id), std::runtime_error);
+
+        MemoryStorageBackend small_storage(64);
+        LRUCacheReplacer<frame_id_type> small_replacer(2);
+        BufferPool small_pool(2, small_storage, small_replacer);
+        CHECK_THROWS_AS(StringBTree::create(small_pool), std::logic_error);
+    }
+}
@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <doctest/doctest.h>
+#include <filesystem>
+#include <pinedb/bufferpool.h>
+#include <pinedb/tracereplay.h>
+
+using namespace pinedb;
+
+TEST_SUITE("tracereplay")
+{
+    TEST_CASE("Synthetic traces stay within the page range")
+    {
+        page_id_type number_of_pages = 100;
+        auto check_range = [&](const trace::trace_type &t)
+        {
+            for (const auto pageid : t)
+            {
+                CHECK(pageid >= 0);
+                CHECK(pageid < number_of_pages);
+            }
+        };
+        auto uniform = trace::uniform(number_of_pages, 1000);
+        CHECK(uniform.size() == 1000);
+        check_range(uniform);
+
+        auto zipfian = trace::zipfian(number_of_pages, 1000, 0.99);
+        CHECK(zipfian.size() == 1000);
+        check_range(zipfian);
+        // The first page is the most popular one
+        auto count_first = std::count(zipfian.begin(), zipfian.end(), 0);
+        auto count_last = std::count(zipfian.begin(), zipfian.end(), number_of_pages - 1);
+        CHECK(count_first > count_last);
+
+        auto mix = trace::scan_hot_mix(number_of_pages, 10, 1000, 0.5);
+        CHECK(mix.size() == 1000);
+        check_range(mix);
+        CHECK_THROWS(trace::scan_hot_mix(number_of_pages, 0, 1000, 0.5));
+
+        auto scan = trace::sequential_scan(number_of_pages);
+        CHECK(scan.size() == static_cast<size_t>(number_of_pages));
+        CHECK(scan.front() == 0);
+        CHECK(scan.back() == number_of_pages - 1);
+
+        auto loop = trace::looping(10, 25);
+        CHECK(loop.size() == 25);
+        CHECK(loop[10] == 0);
+        CHECK(loop[24] == 4);
+    }
+
+    TEST_CASE("Replay trace using LRU")
+    {
+        SUBCASE("Working set fits in the pool")
+        {
+            LRUCacheReplacer<frame_id_type> replacer(10);
+            auto stats = replay_trace(trace::looping(10, 100), 10, replacer);
+            CHECK(stats.accesses == 100);
+            CHECK(stats.misses == 10);
+            CHECK(stats.hits == 90);
+            CHECK(stats.evictions == 0);
+            CHECK(stats.hit_ratio() == doctest::Approx(0.9));
+        }
+        SUBCASE("Looping over one page more than the pool never hits")
+        {
+            LRUCacheReplacer<frame_id_type> replacer(10);
+            auto stats = replay_trace(trace::looping(11, 110), 10, replacer);
+            CHECK(stats.hits == 0);
+            CHECK(stats.misses == 110);
+            CHECK(stats.evictions == 100);
+        }
+        SUBCASE("Empty trace")
+        {
+            LRUCacheReplacer<frame_id_type> replacer(10);
+            auto stats = replay_trace({}, 10, replacer);
+            CHECK(stats.accesses == 0);
+            CHECK(stats.hit_ratio() == 0.0);
+        }
+    }
+
+    TEST_CASE("Save and load trace")
+    {
+        std::string file_path = "temp_trace_file.txt";
+        auto t = trace::zipfian(50, 500, 0.8);
+        CHECK(trace::save(file_path, t));
+        trace::trace_type loaded;
+        CHECK(trace::load(file_path, loaded));
+        CHECK(loaded == t);
+        std::filesystem::remove(file_path);
+        CHECK(!trace::load(file_path, loaded));
+    }
+
+    TEST_CASE("Record trace from BufferPool")
+    {
+        page_size_type page_size = 128;
+        int number_of_frames = 2;
+        MemoryStorageBackend storage(page_size);
+        LRUCacheReplacer<frame_id_type> cache_replacer(number_of_frames);
+        BufferPool pool(number_of_frames, storage, cache_replacer);
+
+        trace::trace_type recorded;
+        pool.set_trace_hook([&](page_id_type pageid) { recorded.push_back(pageid); });
+
+        auto page1 = pool.new_page();
+        auto page2 = pool.new_page();
+        auto page3 = pool.new_page();
+        pool.fetch_page(page1);
+        pool.fetch_page(page3);
+        pool.fetch_page(page2);
+
+        trace::trace_type expected = {page1, page2, page3, page1, page3, page2};
+        CHECK(recorded == expected);
+
+        pool.set_trace_hook(nullptr);
+        pool.fetch_page(page1);
+        CHECK(recorded.size() == expected.size());
+    }
+}
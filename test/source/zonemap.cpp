@@ -0,0 +1,139 @@
+#include <doctest/doctest.h>
+#include <pinedb/page.h>
+#include <pinedb/paxfile.h>
+#include <pinedb/zonemap.h>
+#include <set>
+#include <vector>
+
+using namespace pinedb;
+
+namespace
+{
+    std::vector<uint8_t> make_event(const RecordLayout &layout, int64_t timestamp, uint8_t kind,
+                                    double value)
+    {
+        std::vector<uint8_t> buffer(64);
+        RecordBuilder builder(layout, buffer.data(), buffer.size());
+        builder.set<int64_t>(0, timestamp).set<uint8_t>(1, kind).set<double>(2, value);
+        builder.set_string(3, "event");
+        buffer.resize(builder.get_length());
+        return buffer;
+    }
+} // namespace
+
+TEST_SUITE("zonemap")
+{
+    TEST_CASE("Minimum and maximum of each page")
+    {
+        MemoryStorageBackend storage(128);
+        LRUCacheReplacer<frame_id_type> cache_replacer(2);
+        BufferPool pool(2, storage, cache_replacer);
+        RecordLayout layout("LbdcS");
+
+        page_id_type first_page_id;
+        {
+            ZoneMap map(pool, layout, 0);
+            CHECK(map.get_first_page_id() == 0);
+            CHECK(map.size() == 0);
+            int64_t min, max;
+            CHECK(!map.get(0, 0, min, max));
+            CHECK(!map.may_contain<int64_t>(0, 0, 0, 100));
+
+            map.add(0, make_event(layout, 100, 1, -2.5).data());
+            map.add(0, make_event(layout, 50, 7, 10.0).data());
+            // Entries for positions 1 to 4 are empty, and span more than one page
+            map.add(5, make_event(layout, -3, 0, 0.0).data());
+            first_page_id = map.get_first_page_id();
+            CHECK(first_page_id != 0);
+            CHECK(map.size() == 6);
+            CHECK(map.number_of_rows(0) == 2);
+            CHECK(map.number_of_rows(3) == 0);
+        }
+
+        ZoneMap map(pool, layout, first_page_id);
+        CHECK(map.size() == 6);
+        int64_t min = 0, max = 0;
+        REQUIRE(map.get(0, 0, min, max));
+        CHECK(min == 50);
+        CHECK(max == 100);
+        uint8_t kind_min = 0, kind_max = 0;
+        REQUIRE(map.get(0, 1, kind_min, kind_max));
+        CHECK(kind_min == 1);
+        CHECK(kind_max == 7);
+        double value_min = 0, value_max = 0;
+        REQUIRE(map.get(0, 2, value_min, value_max));
+        CHECK(value_min == -2.5);
+        CHECK(value_max == 10.0);
+        CHECK_THROWS_AS(map.get(0, 1, min, max), std::logic_error);
+        CHECK_THROWS_AS(map.get(0, 3, min, max), std::logic_error);
+
+        CHECK(map.may_contain<int64_t>(0, 0, 0, 50));
+        CHECK(map.may_contain<int64_t>(0, 0, 60, 70));
+        CHECK(!map.may_contain<int64_t>(0, 0, 101, 200));
+        CHECK(!map.may_contain<int64_t>(2, 0, 0, 200));
+        CHECK(map.may_contain<int64_t>(5, 0, -10, -3));
+        CHECK(!map.may_contain<double>(0, 2, 10.5, 20.0));
+    }
+
+    TEST_CASE("Range scans skip pages of a PAX file")
+    {
+        page_size_type page_size = 512;
+        int number_of_frames = 4;
+        MemoryStorageBackend storage(page_size);
+        LRUCacheReplacer<frame_id_type> cache_replacer(number_of_frames);
+        BufferPool pool(number_of_frames, storage, cache_replacer);
+        RecordLayout layout("Lbdc");
+
+        // Events are inserted in the order of their timestamp
+        auto first_page_id = PaxFile::create(pool, layout);
+        {
+            PaxFile file(pool, layout, first_page_id);
+            for (int64_t t = 0; t < 2000; ++t)
+            {
+                auto event = make_event(layout, 1000 + t, static_cast<uint8_t>(t % 5), t * 0.5);
+                file.insert(event.data());
+            }
+        }
+
+        PaxFile file(pool, layout, first_page_id);
+        REQUIRE(file.number_of_pages() > 20);
+        CHECK(file.get_zone_map().size() == file.number_of_pages());
+
+        std::set<page_id_type> fetched;
+        pool.set_trace_hook([&](page_id_type page_id) { fetched.insert(page_id); });
+        std::set<page_id_type> scanned;
+        int64_t matches = 0;
+        file.for_each_page_in_range<int64_t>(
+            0, 1500, 1599,
+            [&](page_id_type page_id, const PaxPage &page)
+            {
+                scanned.insert(page_id);
+                page.for_each<int64_t>(0,
+                                       [&](uint16_t, int64_t t)
+                                       { matches += t >= 1500 && t <= 1599; });
+            });
+        pool.set_trace_hook({});
+        CHECK(matches == 100);
+        // Only the pages which have the range are read, and no other data page is fetched
+        CHECK(scanned.size() <= static_cast<size_t>(100 / (page_size / 64) + 3));
+        CHECK(scanned.size() < file.number_of_pages() / 4);
+        for (auto page_id : fetched)
+        {
+            auto page = pool.fetch_page(page_id);
+            PageHeader header;
+            header.read(page);
+            if (header.get_page_type() == PaxPage::PAGE_TYPE)
+                CHECK(scanned.count(page_id) == 1);
+        }
+
+        // A predicate on a column which is not clustered reads every page
+        size_t pages = 0;
+        file.for_each_page_in_range<uint8_t>(1, 4, 4, [&](page_id_type, const PaxPage &)
+                                             { ++pages; });
+        CHECK(pages == file.number_of_pages());
+        pages = 0;
+        file.for_each_page_in_range<uint8_t>(1, 5, 200, [&](page_id_type, const PaxPage &)
+                                             { ++pages; });
+        CHECK(pages == 0);
+    }
+}